@@ -0,0 +1,447 @@
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <thread>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "agentbridge.h"
+
+const unsigned int bridgeSpin = 2000; // proby przed zasnieciem, gdy jest wiecej niz jeden rdzen
+
+static_assert(std::atomic<unsigned int>::is_always_lock_free, "futeksy wymagaja atomowych slow bez blokad");
+
+// slowo futeksa pod atomowa zmienna w pamieci wspoldzielonej
+static unsigned int* futexWord(std::atomic<unsigned int>& value)
+{
+	return reinterpret_cast<unsigned int*>(&value);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja usypiajaca proces, dopoki value == expected (najdluzej bridgeWaitMs); futeks bez
+** FUTEX_PRIVATE_FLAG, bo czekaja na nim rozne procesy
+**------------------------------------------------------------------------------------------*/
+static void futexWait(std::atomic<unsigned int>& value, unsigned int expected)
+{
+	timespec timeout = { 0, bridgeWaitMs * 1000000L };
+	syscall(SYS_futex, futexWord(value), FUTEX_WAIT, expected, &timeout, nullptr, 0);
+}
+
+static void futexWake(std::atomic<unsigned int>& value)
+{
+	syscall(SYS_futex, futexWord(value), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+}
+
+static size_t alignLine(size_t offset)
+{
+	return (offset + bridgeLineSize - 1) / bridgeLineSize * bridgeLineSize;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja liczaca uklad tablic kanalu (kazda tablica od nowej linii pamieci podrecznej)
+** envs - srodowiska w kanale
+** agents - agenci na srodowisko
+**------------------------------------------------------------------------------------------*/
+BridgeLayout bridgeLayout(unsigned int envs, unsigned int agents)
+{
+	const size_t slots = (size_t)envs * agents;
+	BridgeLayout layout;
+
+	layout.actions = alignLine(sizeof(BridgeChannel));
+	layout.seeds = alignLine(layout.actions + slots);
+	layout.observations = alignLine(layout.seeds + envs * sizeof(unsigned int));
+	layout.rewards = alignLine(layout.observations + slots * PONG_ENV_OBSERVATION_SIZE * sizeof(float));
+	layout.dones = alignLine(layout.rewards + slots * sizeof(float));
+	layout.finalObservations = alignLine(layout.dones + envs);
+	layout.channelSize = alignLine(layout.finalObservations + slots * PONG_ENV_OBSERVATION_SIZE * sizeof(float));
+
+	return layout;
+}
+
+static BridgeChannel* channelAt(BridgeHeader* header, unsigned int index)
+{
+	return (BridgeChannel*)((unsigned char*)header + alignLine(sizeof(BridgeHeader)) + index * header->channelSize);
+}
+
+template <typename T>
+static T* channelArray(BridgeChannel* channel, size_t offset)
+{
+	return (T*)((unsigned char*)channel + offset);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja tworzaca most: obiekt pamieci wspoldzielonej z kanalami i srodowisko na kanal
+** name - nazwa dla shm_open (np. "/pong_bridge"); istniejacy obiekt jest zastepowany
+** channels - liczba kanalow (procesow agentow), najwiecej bridgeMaxChannels
+** envs - srodowiska w kanale
+** options - parametry srodowisk
+** funkcja zwraca false, jesli nie mozna utworzyc pamieci albo srodowisk
+**------------------------------------------------------------------------------------------*/
+bool createBridge(BridgeServer& server, const char* name, unsigned int channels, unsigned int envs, const PongEnvOptions& options)
+{
+	server.memory = nullptr;
+	server.envs = nullptr;
+	server.handled = nullptr;
+	server.stats = BridgeStats();
+	server.spin = std::thread::hardware_concurrency() > 1 ? bridgeSpin : 0;
+	strncpy(server.name, name, sizeof(server.name) - 1);
+	server.name[sizeof(server.name) - 1] = 0;
+
+	if (channels == 0 || channels > bridgeMaxChannels || envs == 0)
+		return false;
+
+	PongEnv* probe = pongEnvCreate(&options);
+	if (!probe)
+		return false;
+	unsigned int agents = pongEnvAgents(probe);
+	pongEnvDestroy(probe);
+
+	server.layout = bridgeLayout(envs, agents);
+	server.size = alignLine(sizeof(BridgeHeader)) + channels * server.layout.channelSize;
+
+	shm_unlink(name);
+	int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+	if (fd < 0)
+		return false;
+	if (ftruncate(fd, (off_t)server.size) != 0)
+	{
+		close(fd);
+		shm_unlink(name);
+		return false;
+	}
+
+	void* memory = mmap(nullptr, server.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (memory == MAP_FAILED)
+	{
+		shm_unlink(name);
+		return false;
+	}
+	server.memory = memory;
+
+	// pamiec z ftruncate jest wyzerowana - atomowe pola tworzone w miejscu
+	BridgeHeader* header = new (memory) BridgeHeader();
+	header->channels = channels;
+	header->envs = envs;
+	header->agents = agents;
+	header->observationSize = PONG_ENV_OBSERVATION_SIZE;
+	header->channelSize = server.layout.channelSize;
+	header->running.store(1);
+	server.header = header;
+
+	server.envs = new PongEnv*[channels];
+	server.handled = new unsigned int[channels];
+	for (unsigned int c = 0; c < channels; c++)
+	{
+		new (channelAt(header, c)) BridgeChannel();
+		server.envs[c] = pongEnvCreate(&options);
+		server.handled[c] = 0;
+	}
+
+	// naglowek kompletny - agenci sprawdzaja magic na koncu
+	std::atomic_thread_fence(std::memory_order_release);
+	header->version = bridgeVersion;
+	header->magic = bridgeMagic;
+
+	return true;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zamykajaca most (czekajacy agenci dowiaduja sie z header->running)
+**------------------------------------------------------------------------------------------*/
+void closeBridge(BridgeServer& server)
+{
+	if (!server.memory)
+		return;
+
+	server.header->running.store(0);
+	for (unsigned int c = 0; c < server.header->channels; c++)
+	{
+		futexWake(channelAt(server.header, c)->response);
+		pongEnvDestroy(server.envs[c]);
+	}
+	delete[] server.envs;
+	delete[] server.handled;
+	server.envs = nullptr;
+	server.handled = nullptr;
+
+	munmap(server.memory, server.size);
+	shm_unlink(server.name);
+	server.memory = nullptr;
+}
+
+// zlecenie kanalu c: srodowisko czyta i zapisuje tablice kanalu bez kopiowania
+static void handleRequest(BridgeServer& server, unsigned int c, BridgeChannel* channel, unsigned int request)
+{
+	const BridgeLayout& layout = server.layout;
+	PongEnv* env = server.envs[c];
+
+	float* observations = channelArray<float>(channel, layout.observations);
+	if (channel->command == BRIDGE_RESET)
+	{
+		channel->status = pongEnvReset(env, server.header->envs, channelArray<unsigned int>(channel, layout.seeds), observations);
+	}
+	else if (channel->command == BRIDGE_STEP)
+	{
+		channel->status = pongEnvStep(env, channelArray<unsigned char>(channel, layout.actions), observations,
+			channelArray<float>(channel, layout.rewards), channelArray<unsigned char>(channel, layout.dones),
+			channelArray<float>(channel, layout.finalObservations));
+		if (channel->status == 0)
+			server.stats.envSteps += server.header->envs;
+	}
+	else
+	{
+		channel->status = -1;
+	}
+
+	server.handled[c] = request;
+	server.stats.requests++;
+
+	channel->response.store(request);
+	if (channel->agentWaiting.load())
+	{
+		futexWake(channel->response);
+		server.stats.wakes++;
+	}
+}
+
+// obsluga wszystkich czekajacych zlecen; zwraca ich liczbe
+static unsigned int handleRequests(BridgeServer& server)
+{
+	unsigned int handled = 0;
+
+	for (unsigned int c = 0; c < server.header->channels; c++)
+	{
+		BridgeChannel* channel = channelAt(server.header, c);
+		unsigned int request = channel->request.load(std::memory_order_acquire);
+		if (request != server.handled[c])
+		{
+			handleRequest(server, c, channel, request);
+			handled++;
+		}
+	}
+
+	return handled;
+}
+
+// zwolnienie kanalow, ktorych agenci zakonczyli sie bez detachBridge()
+static void releaseStaleOwners(BridgeServer& server)
+{
+	for (unsigned int c = 0; c < server.header->channels; c++)
+	{
+		BridgeChannel* channel = channelAt(server.header, c);
+		unsigned int owner = channel->owner.load();
+		if (owner != 0 && kill((pid_t)owner, 0) != 0 && errno == ESRCH)
+		{
+			channel->owner.compare_exchange_strong(owner, 0);
+			server.stats.staleOwners++;
+		}
+	}
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja obslugujaca zlecenia agentow; bez zlecen czeka (najpierw aktywnie, potem na
+** futeksie doorbell) najdluzej bridgeWaitMs
+** funkcja zwraca liczbe obsluzonych zlecen (0 - uplynal czas oczekiwania)
+**------------------------------------------------------------------------------------------*/
+unsigned int serveBridge(BridgeServer& server)
+{
+	BridgeHeader* header = server.header;
+
+	for (unsigned int attempt = 0; attempt <= server.spin; attempt++)
+	{
+		unsigned int doorbell = header->doorbell.load();
+		unsigned int handled = handleRequests(server);
+		if (handled > 0)
+			return handled;
+
+		if (attempt < server.spin)
+			continue;
+
+		// zgloszenie snu przed ponownym sprawdzeniem - agent, ktory zadzwoni pozniej, zobaczy
+		// serverWaiting, a wczesniejszy zmienil doorbell i futeks nie zasnie
+		header->serverWaiting.store(1);
+		handled = handleRequests(server);
+		if (handled == 0)
+		{
+			futexWait(header->doorbell, doorbell);
+			server.stats.sleeps++;
+			handled = handleRequests(server);
+		}
+		header->serverWaiting.store(0);
+
+		if (handled == 0)
+			releaseStaleOwners(server);
+
+		return handled;
+	}
+
+	return 0;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwracajaca liczbe kanalow z dolaczonym agentem
+**------------------------------------------------------------------------------------------*/
+unsigned int attachedAgents(const BridgeServer& server)
+{
+	unsigned int attached = 0;
+	for (unsigned int c = 0; c < server.header->channels; c++)
+	{
+		if (channelAt(server.header, c)->owner.load() != 0)
+			attached++;
+	}
+
+	return attached;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja dolaczajaca proces agenta do wolnego kanalu mostu
+** name - nazwa mostu podana serwerowi
+** funkcja zwraca false, jesli mostu nie ma albo wszystkie kanaly sa zajete
+**------------------------------------------------------------------------------------------*/
+bool attachBridge(BridgeAgent& agent, const char* name)
+{
+	agent.memory = nullptr;
+	agent.channel = nullptr;
+	agent.sleeps = 0;
+	agent.spin = std::thread::hardware_concurrency() > 1 ? bridgeSpin : 0;
+
+	int fd = shm_open(name, O_RDWR, 0);
+	if (fd < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(BridgeHeader))
+	{
+		close(fd);
+		return false;
+	}
+
+	void* memory = mmap(nullptr, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (memory == MAP_FAILED)
+		return false;
+
+	BridgeHeader* header = (BridgeHeader*)memory;
+	if (header->magic != bridgeMagic || header->version != bridgeVersion || header->observationSize != PONG_ENV_OBSERVATION_SIZE)
+	{
+		munmap(memory, (size_t)info.st_size);
+		return false;
+	}
+	std::atomic_thread_fence(std::memory_order_acquire);
+
+	agent.memory = memory;
+	agent.size = (size_t)info.st_size;
+	agent.header = header;
+
+	unsigned int pid = (unsigned int)getpid();
+	for (unsigned int c = 0; c < header->channels && !agent.channel; c++)
+	{
+		BridgeChannel* channel = channelAt(header, c);
+		unsigned int free = 0;
+		if (channel->owner.compare_exchange_strong(free, pid))
+			agent.channel = channel;
+	}
+
+	if (!agent.channel)
+	{
+		munmap(memory, agent.size);
+		agent.memory = nullptr;
+		return false;
+	}
+
+	BridgeLayout layout = bridgeLayout(header->envs, header->agents);
+	agent.envs = header->envs;
+	agent.agents = header->agents;
+	agent.actions = channelArray<unsigned char>(agent.channel, layout.actions);
+	agent.seeds = channelArray<unsigned int>(agent.channel, layout.seeds);
+	agent.observations = channelArray<float>(agent.channel, layout.observations);
+	agent.rewards = channelArray<float>(agent.channel, layout.rewards);
+	agent.dones = channelArray<unsigned char>(agent.channel, layout.dones);
+	agent.finalObservations = channelArray<float>(agent.channel, layout.finalObservations);
+
+	// poprzedni wlasciciel kanalu mogl zostawic zlecenie - numeracja od obsluzonego
+	agent.sequence = agent.channel->response.load();
+	while (agent.channel->request.load() != agent.sequence && header->running.load())
+	{
+		futexWait(agent.channel->response, agent.sequence);
+		agent.sequence = agent.channel->response.load();
+	}
+
+	return true;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwalniajaca kanal agenta
+**------------------------------------------------------------------------------------------*/
+void detachBridge(BridgeAgent& agent)
+{
+	if (!agent.memory)
+		return;
+
+	agent.channel->owner.store(0);
+	munmap(agent.memory, agent.size);
+	agent.memory = nullptr;
+	agent.channel = nullptr;
+}
+
+// zlecenie polecenia i czekanie na odpowiedz serwera
+static bool bridgeCall(BridgeAgent& agent, BridgeCommand command)
+{
+	BridgeHeader* header = agent.header;
+	BridgeChannel* channel = agent.channel;
+	if (!agent.memory || !header->running.load())
+		return false;
+
+	unsigned int sequence = ++agent.sequence;
+	channel->command = command;
+	channel->request.store(sequence, std::memory_order_release);
+
+	header->doorbell.fetch_add(1);
+	if (header->serverWaiting.load())
+		futexWake(header->doorbell);
+
+	for (unsigned int attempt = 0; channel->response.load(std::memory_order_acquire) != sequence; attempt++)
+	{
+		if (attempt < agent.spin)
+			continue;
+
+		channel->agentWaiting.store(1);
+		if (channel->response.load() != sequence)
+		{
+			futexWait(channel->response, sequence - 1);
+			agent.sleeps++;
+		}
+		channel->agentWaiting.store(0);
+
+		if (!header->running.load())
+			return false;
+	}
+
+	return channel->status == 0;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja rozpoczynajaca epizody wszystkich srodowisk kanalu z ziarnami z agent.seeds;
+** pierwsze obserwacje sa w agent.observations
+**------------------------------------------------------------------------------------------*/
+bool bridgeReset(BridgeAgent& agent)
+{
+	return bridgeCall(agent, BRIDGE_RESET);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja wykonujaca krok srodowisk kanalu z akcjami z agent.actions; wyniki w tablicach
+** agenta jak w pongEnvStep
+**------------------------------------------------------------------------------------------*/
+bool bridgeStep(BridgeAgent& agent)
+{
+	return bridgeCall(agent, BRIDGE_STEP);
+}
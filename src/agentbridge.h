@@ -0,0 +1,114 @@
+#ifndef __AGENTBRIDGE_H__
+#define __AGENTBRIDGE_H__
+
+#include <atomic>
+#include <cstddef>
+
+#include "pong_env.h"
+
+constexpr unsigned int bridgeMagic = 0x504F4E47u; // "PONG"
+constexpr unsigned int bridgeVersion = 1;
+constexpr unsigned int bridgeMaxChannels = 64; // najwiecej procesow agentow na jeden most
+constexpr unsigned int bridgeLineSize = 64; // wyrownanie pol zapisywanych przez rozne procesy (linia pamieci podrecznej)
+constexpr int bridgeWaitMs = 100; // najdluzszy sen na futeksie (sprawdzanie, czy druga strona zyje)
+
+// POLECENIA KANALU
+enum BridgeCommand {
+	BRIDGE_RESET = 1, // poczatek epizodow z ziarnami z tablicy seeds
+	BRIDGE_STEP = 2 // krok z akcjami z tablicy actions
+};
+
+// NAGLOWEK PAMIECI WSPOLDZIELONEJ (/dev/shm/<nazwa>) - za nim kanaly co channelSize bajtow
+struct BridgeHeader {
+	unsigned int magic;
+	unsigned int version;
+	unsigned int channels; // liczba kanalow (procesow agentow)
+	unsigned int envs; // srodowiska w kanale
+	unsigned int agents; // agenci na srodowisko (pongEnvAgents)
+	unsigned int observationSize; // PONG_ENV_OBSERVATION_SIZE
+	unsigned long long channelSize; // odstep kolejnych kanalow
+	std::atomic<unsigned int> running; // 0 - serwer zakonczyl prace
+
+	alignas(bridgeLineSize) std::atomic<unsigned int> doorbell; // futeks serwera - zwiekszany przy kazdym zleceniu
+	std::atomic<unsigned int> serverWaiting; // serwer spi na doorbell - agent musi go obudzic
+};
+
+// KANAL JEDNEGO PROCESU AGENTA - zlecenie i odpowiedz to numery w osobnych liniach (futeksy),
+// dane w tablicach za kanalem (przesuniecia z bridgeLayout())
+struct BridgeChannel {
+	std::atomic<unsigned int> owner; // pid dolaczonego agenta (0 - wolny)
+	unsigned int command; // BridgeCommand zlecenia
+	int status; // wynik pongEnvReset/pongEnvStep ostatniego zlecenia
+
+	alignas(bridgeLineSize) std::atomic<unsigned int> request; // numer zlecenia (zapisuje agent)
+	std::atomic<unsigned int> agentWaiting; // agent spi na response - serwer musi go obudzic
+
+	alignas(bridgeLineSize) std::atomic<unsigned int> response; // numer obsluzonego zlecenia (zapisuje serwer)
+};
+
+// PRZESUNIECIA TABLIC W KANALE (bajty od poczatku BridgeChannel), uklad jak w pongEnvStep
+struct BridgeLayout {
+	size_t actions; // unsigned char [envs][agenci]
+	size_t seeds; // unsigned int [envs]
+	size_t observations; // float [envs][agenci][observationSize]
+	size_t rewards; // float [envs][agenci]
+	size_t dones; // unsigned char [envs]
+	size_t finalObservations; // float [envs][agenci][observationSize]
+	size_t channelSize;
+};
+
+// STATYSTYKI SERWERA
+struct BridgeStats {
+	unsigned long long requests;
+	unsigned long long envSteps;
+	unsigned long long sleeps; // zasniecia na futeksie
+	unsigned long long wakes; // budzenia agentow
+	unsigned long long staleOwners; // kanaly zwolnione po zakonczonych procesach agentow
+};
+
+// SERWER MOSTU - srodowiska wszystkich kanalow krokowane w miejscu, w pamieci wspoldzielonej
+struct BridgeServer {
+	char name[64]; // nazwa obiektu shm_open
+	void* memory;
+	size_t size;
+	BridgeHeader* header;
+	BridgeLayout layout;
+	PongEnv** envs; // srodowisko kanalu
+	unsigned int* handled; // ostatni obsluzony numer zlecenia kanalu
+	unsigned int spin; // proby przed zasnieciem na futeksie
+	BridgeStats stats;
+};
+
+// AGENT DOLACZONY DO KANALU - akcje i ziarna zapisuje wprost do tablic, wyniki czyta z tablic
+struct BridgeAgent {
+	void* memory;
+	size_t size;
+	BridgeHeader* header;
+	BridgeChannel* channel;
+	unsigned int envs;
+	unsigned int agents;
+
+	unsigned char* actions;
+	unsigned int* seeds;
+	float* observations;
+	float* rewards;
+	unsigned char* dones;
+	float* finalObservations;
+
+	unsigned int sequence; // numer ostatniego zlecenia
+	unsigned int spin;
+	unsigned long long sleeps;
+};
+
+BridgeLayout bridgeLayout(unsigned int envs, unsigned int agents);
+bool createBridge(BridgeServer& server, const char* name, unsigned int channels, unsigned int envs, const PongEnvOptions& options);
+void closeBridge(BridgeServer& server);
+unsigned int serveBridge(BridgeServer& server);
+unsigned int attachedAgents(const BridgeServer& server);
+
+bool attachBridge(BridgeAgent& agent, const char* name);
+void detachBridge(BridgeAgent& agent);
+bool bridgeReset(BridgeAgent& agent);
+bool bridgeStep(BridgeAgent& agent);
+
+#endif /* __AGENTBRIDGE_H__ */
@@ -0,0 +1,302 @@
+#define GLM_FORCE_INTRINSICS
+#include <glm/simd/platform.h>
+
+#include "batchlanes.h"
+
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+#	include <emmintrin.h>
+#endif
+
+/*------------------------------------------------------------------------------------------
+** funkcja przydzielajaca wyrownana tablice dla paczki
+**------------------------------------------------------------------------------------------*/
+template <typename T>
+static T* allocLanes(unsigned int capacity)
+{
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+	return (T*)_mm_malloc(capacity * sizeof(T), batchAlignment);
+#else
+	return new T[capacity];
+#endif
+}
+
+template <typename T>
+static void freeLanes(T*& lanes)
+{
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+	_mm_free(lanes);
+#else
+	delete[] lanes;
+#endif
+	lanes = nullptr;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja tworzaca paczke meczow
+** batch - inicjowana paczka
+** count - liczba meczow
+** firstSeed - ziarno pierwszego meczu (kolejne mecze: firstSeed + i)
+**------------------------------------------------------------------------------------------*/
+void initBatch(MatchBatch& batch, unsigned int count, unsigned int firstSeed)
+{
+	batch.count = count;
+	batch.capacity = (count + batchLanes - 1) / batchLanes * batchLanes;
+	batch.tick = 0;
+
+	batch.ballX = allocLanes<float>(batch.capacity);
+	batch.ballY = allocLanes<float>(batch.capacity);
+	batch.ballVX = allocLanes<float>(batch.capacity);
+	batch.ballVY = allocLanes<float>(batch.capacity);
+	for (int s = 0; s < 2; s++)
+	{
+		batch.racketY[s] = allocLanes<float>(batch.capacity);
+		batch.racketVY[s] = allocLanes<float>(batch.capacity);
+	}
+	batch.scoreForLeft = allocLanes<unsigned int>(batch.capacity);
+	batch.scoreForRight = allocLanes<unsigned int>(batch.capacity);
+	batch.hits = allocLanes<unsigned int>(batch.capacity);
+	batch.seed = allocLanes<unsigned int>(batch.capacity);
+
+	// nieuzywane elementy na koncu tablic tez dostaja poprawny stan
+	for (unsigned int i = 0; i < batch.capacity; i++)
+	{
+		resetMatch(batch, i, firstSeed + i);
+	}
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwalniajaca pamiec paczki meczow
+**------------------------------------------------------------------------------------------*/
+void freeBatch(MatchBatch& batch)
+{
+	freeLanes(batch.ballX);
+	freeLanes(batch.ballY);
+	freeLanes(batch.ballVX);
+	freeLanes(batch.ballVY);
+	for (int s = 0; s < 2; s++)
+	{
+		freeLanes(batch.racketY[s]);
+		freeLanes(batch.racketVY[s]);
+	}
+	freeLanes(batch.scoreForLeft);
+	freeLanes(batch.scoreForRight);
+	freeLanes(batch.hits);
+	freeLanes(batch.seed);
+
+	batch.count = 0;
+	batch.capacity = 0;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja kopiujaca stan jednego meczu z paczki do struktury World
+**------------------------------------------------------------------------------------------*/
+void loadWorld(const MatchBatch& batch, unsigned int index, World& world)
+{
+	world.ball = { batch.ballX[index], batch.ballY[index] };
+	world.ballVelocity = { batch.ballVX[index], batch.ballVY[index] };
+	world.rackets[0] = { leftRacketX, batch.racketY[0][index] };
+	world.rackets[1] = { rightRacketX, batch.racketY[1][index] };
+	world.racketsVelocity[0] = batch.racketVY[0][index];
+	world.racketsVelocity[1] = batch.racketVY[1][index];
+	world.scoreForLeft = batch.scoreForLeft[index];
+	world.scoreForRight = batch.scoreForRight[index];
+	world.hits = batch.hits[index];
+	world.seed = batch.seed[index];
+	world.tick = batch.tick;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja kopiujaca stan jednego meczu ze struktury World do paczki
+**------------------------------------------------------------------------------------------*/
+void storeWorld(MatchBatch& batch, unsigned int index, const World& world)
+{
+	batch.ballX[index] = world.ball.x;
+	batch.ballY[index] = world.ball.y;
+	batch.ballVX[index] = world.ballVelocity.x;
+	batch.ballVY[index] = world.ballVelocity.y;
+	batch.racketY[0][index] = world.rackets[0].y;
+	batch.racketY[1][index] = world.rackets[1].y;
+	batch.racketVY[0][index] = world.racketsVelocity[0];
+	batch.racketVY[1][index] = world.racketsVelocity[1];
+	batch.scoreForLeft[index] = world.scoreForLeft;
+	batch.scoreForRight[index] = world.scoreForRight;
+	batch.hits[index] = world.hits;
+	batch.seed[index] = world.seed;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja rozpoczynajaca od nowa jeden mecz w paczce
+**------------------------------------------------------------------------------------------*/
+void resetMatch(MatchBatch& batch, unsigned int index, unsigned int seed)
+{
+	World world;
+	initWorld(world, seed);
+	storeWorld(batch, index, world);
+}
+
+/*------------------------------------------------------------------------------------------
+** kernel skalarny - mecz po meczu przez step(), uzywany tez dla koncowki paczki
+**------------------------------------------------------------------------------------------*/
+static void stepScalar(MatchBatch& batch, const unsigned int* keys, float dt, unsigned int begin, unsigned int end)
+{
+	for (unsigned int i = begin; i < end; i++)
+	{
+		World world;
+		loadWorld(batch, i, world);
+
+		Inputs inputs = { keys[i] };
+		step(world, inputs, dt);
+
+		storeWorld(batch, i, world);
+	}
+}
+
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+// OPERACJE NA 4 MECZACH NARAZ (SSE2)
+struct Sse2Lanes {
+	typedef __m128 F;
+	typedef __m128i I;
+	static const unsigned int width = 4;
+
+	static F loadF(const float* p) { return _mm_load_ps(p); }
+	static void storeF(float* p, F a) { _mm_store_ps(p, a); }
+	static I loadI(const void* p) { return _mm_load_si128((const __m128i*)p); }
+	static I loadUnalignedI(const void* p) { return _mm_loadu_si128((const __m128i*)p); }
+	static void storeI(void* p, I a) { _mm_store_si128((__m128i*)p, a); }
+	static F setF(float a) { return _mm_set1_ps(a); }
+	static I setI(int a) { return _mm_set1_epi32(a); }
+
+	static F add(F a, F b) { return _mm_add_ps(a, b); }
+	static F sub(F a, F b) { return _mm_sub_ps(a, b); }
+	static F mul(F a, F b) { return _mm_mul_ps(a, b); }
+	static F div(F a, F b) { return _mm_div_ps(a, b); }
+	static F neg(F a) { return _mm_xor_ps(a, _mm_set1_ps(-0.0f)); }
+	static F abs(F a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+	static F cmpLe(F a, F b) { return _mm_cmple_ps(a, b); }
+	static F cmpLt(F a, F b) { return _mm_cmplt_ps(a, b); }
+	static F cmpGe(F a, F b) { return _mm_cmpge_ps(a, b); }
+	static F cmpGt(F a, F b) { return _mm_cmpgt_ps(a, b); }
+	static F andF(F a, F b) { return _mm_and_ps(a, b); }
+	static F orF(F a, F b) { return _mm_or_ps(a, b); }
+	static F andNotF(F a, F b) { return _mm_andnot_ps(a, b); } // ~a & b
+	static F select(F mask, F a, F b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+	static bool any(F mask) { return _mm_movemask_ps(mask) != 0; }
+
+	static I addI(I a, I b) { return _mm_add_epi32(a, b); }
+	static I subI(I a, I b) { return _mm_sub_epi32(a, b); }
+	static I andI(I a, I b) { return _mm_and_si128(a, b); }
+	static I xorI(I a, I b) { return _mm_xor_si128(a, b); }
+	static I cmpEqI(I a, I b) { return _mm_cmpeq_epi32(a, b); }
+	static I cmpGtI(I a, I b) { return _mm_cmpgt_epi32(a, b); }
+	static I selectI(I mask, I a, I b) { return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); }
+	template <int n> static I shl(I a) { return _mm_slli_epi32(a, n); }
+	template <int n> static I shr(I a) { return _mm_srli_epi32(a, n); }
+	static void mulHiLo(I a, I b, I& hi, I& lo) // pelne iloczyny 32x32 -> 64 bez znaku (SSE2 nie ma mullo_epi32)
+	{
+		__m128i even = _mm_mul_epu32(a, b);
+		__m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+		lo = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+		hi = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 3, 1)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 3, 1)));
+	}
+	static F toF(I a) { return _mm_cvtepi32_ps(a); }
+	static F asF(I a) { return _mm_castsi128_ps(a); }
+	static I asI(F a) { return _mm_castps_si128(a); }
+};
+#endif
+
+/*------------------------------------------------------------------------------------------
+** funkcja sprawdzajaca, czy kernel jest w tej kompilacji i czy procesor ma potrzebne
+** instrukcje (kernel AVX2 jest w osobnym pliku batchavx2.cpp, budowanym z PONG_BATCH_AVX2)
+**------------------------------------------------------------------------------------------*/
+bool batchKernelAvailable(BatchKernel kernel)
+{
+	switch (kernel)
+	{
+	case BATCH_KERNEL_SCALAR:
+		return true;
+	case BATCH_KERNEL_SSE2:
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+		return true;
+#else
+		return false;
+#endif
+	case BATCH_KERNEL_AVX2:
+#if defined(PONG_BATCH_AVX2) && (defined(__GNUC__) || defined(__clang__))
+		static const bool avx2 = __builtin_cpu_supports("avx2") != 0;
+		return avx2;
+#else
+		return false;
+#endif
+	default:
+		return true;
+	}
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwracajaca najszybszy kernel dostepny w tej kompilacji i na tym procesorze
+**------------------------------------------------------------------------------------------*/
+BatchKernel bestBatchKernel()
+{
+	if (batchKernelAvailable(BATCH_KERNEL_AVX2))
+		return BATCH_KERNEL_AVX2;
+	if (batchKernelAvailable(BATCH_KERNEL_SSE2))
+		return BATCH_KERNEL_SSE2;
+
+	return BATCH_KERNEL_SCALAR;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwracajaca nazwe kernela
+**------------------------------------------------------------------------------------------*/
+const char* batchKernelName(BatchKernel kernel)
+{
+	switch (kernel)
+	{
+	case BATCH_KERNEL_SCALAR: return "scalar";
+	case BATCH_KERNEL_SSE2: return "sse2";
+	case BATCH_KERNEL_AVX2: return "avx2";
+	default: return batchKernelName(bestBatchKernel());
+	}
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja wykonujaca jeden krok wszystkich meczow w paczce
+** batch - paczka meczow
+** keys - maski klawiszy (InputKeys), jedna na mecz, batch.count elementow
+** dt - dlugosc kroku w sekundach
+** kernel - wybrany kernel; niedostepny w tej kompilacji lub na tym procesorze zastepowany
+** jest skalarnym
+**------------------------------------------------------------------------------------------*/
+void stepBatch(MatchBatch& batch, const unsigned int* keys, float dt, BatchKernel kernel)
+{
+	if (kernel == BATCH_KERNEL_BEST)
+	{
+		kernel = bestBatchKernel();
+	}
+	else if (!batchKernelAvailable(kernel))
+	{
+		kernel = BATCH_KERNEL_SCALAR;
+	}
+
+	unsigned int done = 0;
+
+#ifdef PONG_BATCH_AVX2
+	if (kernel == BATCH_KERNEL_AVX2)
+	{
+		done = batch.count / 8 * 8; // 8 meczow na rejestr AVX2
+		stepBatchAvx2(batch, keys, dt, 0, done);
+	}
+#endif
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+	if (kernel == BATCH_KERNEL_SSE2)
+	{
+		done = batch.count / Sse2Lanes::width * Sse2Lanes::width;
+		stepLanes<Sse2Lanes>(batch, keys, dt, 0, done);
+	}
+#endif
+
+	// koncowka paczki (niepelny rejestr) liczona skalarnie
+	stepScalar(batch, keys, dt, done, batch.count);
+
+	batch.tick++;
+}
@@ -0,0 +1,46 @@
+#ifndef __BATCH_H__
+#define __BATCH_H__
+
+#include "sim.h"
+
+// RODZAJE KERNELI KROKU PACZKI MECZOW
+enum BatchKernel {
+	BATCH_KERNEL_SCALAR = 0, // mecz po meczu przez step()
+	BATCH_KERNEL_SSE2 = 1, // 4 mecze na instrukcje
+	BATCH_KERNEL_AVX2 = 2, // 8 meczow na instrukcje
+	BATCH_KERNEL_BEST = 3 // najszybszy kernel dostepny w tej kompilacji i na tym procesorze
+};
+
+constexpr unsigned int batchAlignment = 32; // wyrownanie tablic (szerokosc rejestru AVX)
+constexpr unsigned int batchLanes = 8; // liczba meczow, do ktorej zaokraglana jest pojemnosc paczki
+
+// PACZKA N MECZOW W UKLADZIE STRUKTURY TABLIC (SoA)
+struct MatchBatch {
+	unsigned int count; // liczba meczow
+	unsigned int capacity; // liczba elementow tablic (wielokrotnosc batchLanes)
+
+	float* ballX; // pozycje pileczek
+	float* ballY;
+	float* ballVX; // predkosci pileczek
+	float* ballVY;
+	float* racketY[2]; // pozycje rakietek w pionie (lewa, prawa)
+	float* racketVY[2]; // predkosci rakietek
+	unsigned int* scoreForLeft; // punkty
+	unsigned int* scoreForRight;
+	unsigned int* hits; // liczba odbic od rakietek w meczu
+	unsigned int* seed; // ziarna meczow (klucze generatora serwu)
+
+	unsigned long long tick; // numer kroku wspolny dla calej paczki
+};
+
+void initBatch(MatchBatch& batch, unsigned int count, unsigned int firstSeed);
+void freeBatch(MatchBatch& batch);
+void loadWorld(const MatchBatch& batch, unsigned int index, World& world);
+void storeWorld(MatchBatch& batch, unsigned int index, const World& world);
+void resetMatch(MatchBatch& batch, unsigned int index, unsigned int seed);
+void stepBatch(MatchBatch& batch, const unsigned int* keys, float dt, BatchKernel kernel = BATCH_KERNEL_BEST);
+bool batchKernelAvailable(BatchKernel kernel);
+BatchKernel bestBatchKernel();
+const char* batchKernelName(BatchKernel kernel);
+
+#endif /* __BATCH_H__ */
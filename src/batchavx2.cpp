@@ -0,0 +1,70 @@
+// KERNEL AVX2 PACZKI MECZOW - jedyny plik kompilowany z -mavx2 (CMakeLists.txt); wywolywany
+// z stepBatch() tylko wtedy, gdy procesor ma AVX2 (sprawdzane w czasie dzialania)
+#define GLM_FORCE_INTRINSICS
+#include <glm/simd/platform.h>
+
+#include "batchlanes.h"
+
+#if GLM_ARCH & GLM_ARCH_AVX2_BIT
+#	include <immintrin.h>
+
+// OPERACJE NA 8 MECZACH NARAZ (AVX2)
+struct Avx2Lanes {
+	typedef __m256 F;
+	typedef __m256i I;
+	static const unsigned int width = 8;
+
+	static F loadF(const float* p) { return _mm256_load_ps(p); }
+	static void storeF(float* p, F a) { _mm256_store_ps(p, a); }
+	static I loadI(const void* p) { return _mm256_load_si256((const __m256i*)p); }
+	static I loadUnalignedI(const void* p) { return _mm256_loadu_si256((const __m256i*)p); }
+	static void storeI(void* p, I a) { _mm256_store_si256((__m256i*)p, a); }
+	static F setF(float a) { return _mm256_set1_ps(a); }
+	static I setI(int a) { return _mm256_set1_epi32(a); }
+
+	static F add(F a, F b) { return _mm256_add_ps(a, b); }
+	static F sub(F a, F b) { return _mm256_sub_ps(a, b); }
+	static F mul(F a, F b) { return _mm256_mul_ps(a, b); }
+	static F div(F a, F b) { return _mm256_div_ps(a, b); }
+	static F neg(F a) { return _mm256_xor_ps(a, _mm256_set1_ps(-0.0f)); }
+	static F abs(F a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+	static F cmpLe(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+	static F cmpLt(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	static F cmpGe(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+	static F cmpGt(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+	static F andF(F a, F b) { return _mm256_and_ps(a, b); }
+	static F orF(F a, F b) { return _mm256_or_ps(a, b); }
+	static F andNotF(F a, F b) { return _mm256_andnot_ps(a, b); } // ~a & b
+	static F select(F mask, F a, F b) { return _mm256_blendv_ps(b, a, mask); }
+	static bool any(F mask) { return _mm256_movemask_ps(mask) != 0; }
+
+	static I addI(I a, I b) { return _mm256_add_epi32(a, b); }
+	static I subI(I a, I b) { return _mm256_sub_epi32(a, b); }
+	static I andI(I a, I b) { return _mm256_and_si256(a, b); }
+	static I xorI(I a, I b) { return _mm256_xor_si256(a, b); }
+	static I cmpEqI(I a, I b) { return _mm256_cmpeq_epi32(a, b); }
+	static I cmpGtI(I a, I b) { return _mm256_cmpgt_epi32(a, b); }
+	static I selectI(I mask, I a, I b) { return _mm256_blendv_epi8(b, a, mask); }
+	template <int n> static I shl(I a) { return _mm256_slli_epi32(a, n); }
+	template <int n> static I shr(I a) { return _mm256_srli_epi32(a, n); }
+	static void mulHiLo(I a, I b, I& hi, I& lo) // jak w Sse2Lanes, osobno w kazdej polowce rejestru
+	{
+		__m256i even = _mm256_mul_epu32(a, b);
+		__m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+		lo = _mm256_unpacklo_epi32(_mm256_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm256_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+		hi = _mm256_unpacklo_epi32(_mm256_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 3, 1)), _mm256_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 3, 1)));
+	}
+	static F toF(I a) { return _mm256_cvtepi32_ps(a); }
+	static F asF(I a) { return _mm256_castsi256_ps(a); }
+	static I asI(F a) { return _mm256_castps_si256(a); }
+};
+
+/*------------------------------------------------------------------------------------------
+** funkcja krokujaca mecze begin..end kernelem AVX2 (begin i end wyrownane do 8)
+**------------------------------------------------------------------------------------------*/
+void stepBatchAvx2(MatchBatch& batch, const unsigned int* keys, float dt, unsigned int begin, unsigned int end)
+{
+	stepLanes<Avx2Lanes>(batch, keys, dt, begin, end);
+}
+
+#endif
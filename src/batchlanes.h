@@ -0,0 +1,246 @@
+#ifndef __BATCHLANES_H__
+#define __BATCHLANES_H__
+
+// KERNEL WEKTOROWY PACZKI MECZOW - wspolny szablon dla batch.cpp (SSE2) i batchavx2.cpp (AVX2).
+// Plik dolaczany tylko przez te dwa pliki: kazdy z nich konkretyzuje szablon wlasnym zestawem
+// operacji i wlasnymi opcjami kompilatora, a wszystkie funkcje sa static, wiec kod AVX2 nie
+// trafia do zadnego innego pliku.
+
+#include "batch.h"
+
+void stepBatchAvx2(MatchBatch& batch, const unsigned int* keys, float dt, unsigned int begin, unsigned int end);
+
+// STALE KERNELA WEKTOROWEGO
+template <class L>
+struct LaneConstants {
+	typedef typename L::F F;
+	typedef typename L::I I;
+
+	F zero = L::setF(0.0f);
+	F noEvent = L::setF(1e30f);
+	F wallMin = L::setF(ballRadius);
+	F wallMax = L::setF(WIN_HEIGHT - ballRadius);
+	F goalMin = L::setF(ballRadius);
+	F goalMax = L::setF(WIN_WIDTH - ballRadius);
+	F extentX = L::setF(halfRacketsWidth + ballRadius);
+	F extentY = L::setF(halfRacketsHeight + ballRadius);
+	F racketsX[2] = { L::setF(leftRacketX), L::setF(rightRacketX) };
+	F centerX = L::setF(WIN_WIDTH / 2.0f);
+	F centerY = L::setF(WIN_HEIGHT / 2.0f);
+	F upperLimit = L::setF(WIN_HEIGHT - racketLimit);
+	F lowerLimit = L::setF(racketLimit);
+	F lowerClamp = L::setF(halfRacketsHeight);
+	F speed = L::setF(racketsSpeed);
+	F minusSpeed = L::setF(-racketsSpeed);
+	F serveSpeed = L::setF(ballServeSpeed);
+	F minusServeSpeed = L::setF(-ballServeSpeed);
+	F serveRange = L::setF(ballServeMaxY - (-ballServeMaxY));
+	F serveMin = L::setF(-ballServeMaxY);
+	F randomScale = L::setF(1.0f / (float)(1u << 24));
+	F speedup = L::setF(ballSpeedup);
+	I allOnes = L::setI(-1);
+	I philoxMultiplier = L::setI((int)::philoxMultiplier);
+	I philoxWeyl = L::setI((int)::philoxWeyl);
+	I noKeys = L::setI(0);
+	I upKeys[2] = { L::setI(INPUT_LEFT_UP), L::setI(INPUT_RIGHT_UP) };
+	I downKeys[2] = { L::setI(INPUT_LEFT_DOWN), L::setI(INPUT_RIGHT_DOWN) };
+};
+
+/*------------------------------------------------------------------------------------------
+** wektorowy odpowiednik timeToWall()/timeToGoal() z sim.cpp
+**------------------------------------------------------------------------------------------*/
+template <class L>
+static typename L::F laneTimeToBound(typename L::F p, typename L::F v, typename L::F low, typename L::F high, const LaneConstants<L>& c)
+{
+	typedef typename L::F F;
+
+	F negative = L::cmpLt(v, c.zero);
+	F positive = L::cmpGt(v, c.zero);
+	F t = L::select(negative, L::div(L::sub(low, p), v), L::div(L::sub(high, p), v));
+	t = L::select(L::cmpLt(t, c.zero), c.zero, t);
+
+	return L::select(L::orF(negative, positive), t, c.noEvent);
+}
+
+/*------------------------------------------------------------------------------------------
+** wektorowy odpowiednik timeToRacket() z sim.cpp
+**------------------------------------------------------------------------------------------*/
+template <class L>
+static typename L::F laneTimeToRacket(typename L::F dx, typename L::F dy, typename L::F vx, typename L::F vy, typename L::F& edge, const LaneConstants<L>& c)
+{
+	typedef typename L::F F;
+
+	F distanceX = L::abs(dx);
+	F distanceY = L::abs(dy);
+	F closingX = L::select(L::cmpGe(dx, c.zero), L::neg(vx), vx);
+	F closingY = L::select(L::cmpGe(dy, c.zero), L::neg(vy), vy);
+
+	// BOK RAKIETKI
+	F tx = L::div(L::sub(distanceX, c.extentX), closingX);
+	F hitX = L::andF(L::andF(L::cmpGe(distanceX, c.extentX), L::cmpGt(closingX, c.zero)),
+		L::cmpLe(L::abs(L::add(dy, L::mul(vy, tx))), c.extentY));
+	F t = L::select(hitX, tx, c.noEvent);
+
+	// GORNA LUB DOLNA KRAWEDZ RAKIETKI
+	F ty = L::div(L::sub(distanceY, c.extentY), closingY);
+	edge = L::andF(L::andF(L::cmpGe(distanceY, c.extentY), L::cmpGt(closingY, c.zero)),
+		L::andF(L::cmpLe(L::abs(L::add(dx, L::mul(vx, ty))), c.extentX), L::cmpLt(ty, t)));
+
+	return L::select(edge, ty, t);
+}
+
+/*------------------------------------------------------------------------------------------
+** kernel wektorowy - te same reguly i ta sama kolejnosc dzialan co step() w sim.cpp, ale bez
+** rozgalezien: kazdy warunek to maska, a zmiany stanu sa wybierane (blend) tylko dla meczow,
+** ktorych dotycza; petla zdarzen trwa, dopoki ktorykolwiek mecz ma nierozliczony czas
+** L - zestaw operacji (Sse2Lanes / Avx2Lanes)
+** begin, end - zakres meczow, begin i end wyrownane do L::width
+**------------------------------------------------------------------------------------------*/
+template <class L>
+static void stepLanes(MatchBatch& batch, const unsigned int* keys, float dt, unsigned int begin, unsigned int end)
+{
+	typedef typename L::F F;
+	typedef typename L::I I;
+
+	const LaneConstants<L> c;
+
+	for (unsigned int i = begin; i < end; i += L::width)
+	{
+		F bx = L::loadF(batch.ballX + i);
+		F by = L::loadF(batch.ballY + i);
+		F vx = L::loadF(batch.ballVX + i);
+		F vy = L::loadF(batch.ballVY + i);
+		F ry[2] = { L::loadF(batch.racketY[0] + i), L::loadF(batch.racketY[1] + i) };
+		F rv[2];
+		I scoreLeft = L::loadI(batch.scoreForLeft + i);
+		I scoreRight = L::loadI(batch.scoreForRight + i);
+		I hits = L::loadI(batch.hits + i);
+		I seed = L::loadI(batch.seed + i);
+		I k = L::loadUnalignedI(keys + i); // tablica klawiszy nalezy do wywolujacego i nie musi byc wyrownana
+
+		// STEROWANIE RAKIETKAMI
+		for (int s = 0; s < 2; s++)
+		{
+			F up = L::asF(L::xorI(L::cmpEqI(L::andI(k, c.upKeys[s]), c.noKeys), c.allOnes));
+			F down = L::asF(L::xorI(L::cmpEqI(L::andI(k, c.downKeys[s]), c.noKeys), c.allOnes));
+
+			F upOk = L::cmpLt(ry[s], c.upperLimit);
+			rv[s] = L::andF(L::andF(up, upOk), c.speed);
+			ry[s] = L::select(L::andNotF(upOk, up), c.upperLimit, ry[s]);
+
+			F downOk = L::cmpGt(ry[s], c.lowerLimit);
+			rv[s] = L::select(L::andF(down, downOk), c.minusSpeed, rv[s]);
+			ry[s] = L::select(L::andNotF(downOk, down), c.lowerClamp, ry[s]);
+		}
+
+		F remaining = L::setF(dt);
+		for (int e = 0; e < maxEventsPerStep; e++)
+		{
+			F active = L::cmpGt(remaining, c.zero);
+			if (!L::any(active))
+				break;
+
+			// NAJBLIZSZE ZDARZENIE W POZOSTALEJ CZESCI KROKU
+			F t = remaining;
+
+			F tWall = laneTimeToBound<L>(by, vy, c.wallMin, c.wallMax, c);
+			F isWall = L::cmpLe(tWall, t);
+			t = L::select(isWall, tWall, t);
+
+			F isFace = c.zero;
+			F isEdge = c.zero;
+			F rightSide = c.zero;
+			for (int s = 0; s < 2; s++)
+			{
+				F edge;
+				F tRacket = laneTimeToRacket<L>(L::sub(bx, c.racketsX[s]), L::sub(by, ry[s]), vx, L::sub(vy, rv[s]), edge, c);
+				F isRacket = L::cmpLe(tRacket, t);
+				t = L::select(isRacket, tRacket, t);
+				isWall = L::andNotF(isRacket, isWall);
+				isFace = L::select(isRacket, L::andNotF(edge, isRacket), isFace);
+				isEdge = L::select(isRacket, edge, isEdge);
+				rightSide = L::select(isRacket, s == 0 ? c.zero : L::asF(c.allOnes), rightSide);
+			}
+
+			F tGoal = laneTimeToBound<L>(bx, vx, c.goalMin, c.goalMax, c);
+			F isGoal = L::cmpLt(tGoal, t);
+			t = L::select(isGoal, tGoal, t);
+			isWall = L::andF(active, L::andNotF(isGoal, isWall));
+			isFace = L::andF(active, L::andNotF(isGoal, isFace));
+			isEdge = L::andF(active, L::andNotF(isGoal, isEdge));
+			isGoal = L::andF(active, isGoal);
+
+			// RUCH DO CHWILI ZDARZENIA
+			for (int s = 0; s < 2; s++)
+			{
+				ry[s] = L::select(active, L::add(ry[s], L::mul(rv[s], t)), ry[s]);
+			}
+			bx = L::select(active, L::add(bx, L::mul(vx, t)), bx);
+			by = L::select(active, L::add(by, L::mul(vy, t)), by);
+			remaining = L::select(active, L::sub(remaining, t), remaining);
+
+			// ODBICIA
+			vy = L::select(isWall, L::neg(vy), vy);
+			vx = L::select(isFace, L::mul(L::neg(vx), c.speedup), vx);
+
+			F racketV = L::select(rightSide, rv[1], rv[0]);
+			vy = L::select(isEdge, L::sub(L::add(racketV, racketV), vy), vy);
+			vx = L::select(isEdge, L::mul(vx, c.speedup), vx);
+			hits = L::subI(hits, L::asI(L::orF(isFace, isEdge)));
+
+			// PUNKTY - reset 1: punkt dla prawego, reset 2: punkt dla lewego
+			if (L::any(isGoal))
+			{
+				F resetRight = L::andF(isGoal, L::cmpLt(vx, c.zero));
+				F resetLeft = L::andNotF(resetRight, isGoal);
+
+				scoreRight = L::subI(scoreRight, L::asI(resetRight));
+				scoreLeft = L::subI(scoreLeft, L::asI(resetLeft));
+
+				bx = L::select(isGoal, c.centerX, bx);
+				by = L::select(isGoal, c.centerY, by);
+				vx = L::select(resetRight, c.serveSpeed, L::select(resetLeft, c.minusServeSpeed, vx));
+
+				// Philox2x32-10 - ten sam generator co serveRandom() w sim.cpp, licznik: numer serwu
+				I counter0 = L::addI(scoreLeft, scoreRight);
+				I counter1 = c.noKeys;
+				I key = seed;
+				for (int r = 0; r < philoxRounds; r++)
+				{
+					I hi, lo;
+					L::mulHiLo(counter0, c.philoxMultiplier, hi, lo);
+					counter0 = L::xorI(L::xorI(hi, key), counter1);
+					counter1 = lo;
+					key = L::addI(key, c.philoxWeyl);
+				}
+
+				F random = L::mul(L::toF(L::template shr<8>(counter1)), c.randomScale);
+				vy = L::select(isGoal, L::add(L::mul(c.serveRange, random), c.serveMin), vy);
+			}
+		}
+
+		// przy nadmiarze zdarzen reszta kroku bez sprawdzania zderzen
+		F rest = L::cmpGt(remaining, c.zero);
+		for (int s = 0; s < 2; s++)
+		{
+			ry[s] = L::select(rest, L::add(ry[s], L::mul(rv[s], remaining)), ry[s]);
+		}
+		bx = L::select(rest, L::add(bx, L::mul(vx, remaining)), bx);
+		by = L::select(rest, L::add(by, L::mul(vy, remaining)), by);
+
+		for (int s = 0; s < 2; s++)
+		{
+			L::storeF(batch.racketY[s] + i, ry[s]);
+			L::storeF(batch.racketVY[s] + i, rv[s]);
+		}
+		L::storeF(batch.ballX + i, bx);
+		L::storeF(batch.ballY + i, by);
+		L::storeF(batch.ballVX + i, vx);
+		L::storeF(batch.ballVY + i, vy);
+		L::storeI(batch.scoreForLeft + i, scoreLeft);
+		L::storeI(batch.scoreForRight + i, scoreRight);
+		L::storeI(batch.hits + i, hits);
+	}
+}
+
+#endif /* __BATCHLANES_H__ */
@@ -0,0 +1,242 @@
+#include <cmath>
+
+#include "bots.h"
+
+const float trackingDeadZone = halfRacketsHeight / 4.0f; // strefa, w ktorej stojaca rakietka nie rusza sie
+const float never = 1e30f; // czas decyzji, ktora sie nie zmieni
+
+/*------------------------------------------------------------------------------------------
+** decyzja bota podazajacego za pileczka z histereza: stojaca rakietka rusza, gdy pileczka
+** wyjdzie poza strefe martwa, a jadaca jedzie, dopoki nie zrowna sie z pileczka
+** diff - wysokosc pileczki wzgledem srodka rakietki
+** velocity - obecna predkosc rakietki
+** funkcja zwraca 1 - do gory, -1 - w dol, 0 - stop
+**------------------------------------------------------------------------------------------*/
+static int trackingDecision(float diff, float velocity)
+{
+	if (velocity > 0 && diff > 0)
+		return 1;
+	if (velocity < 0 && diff < 0)
+		return -1;
+	if (diff > trackingDeadZone)
+		return 1;
+	if (diff < -trackingDeadZone)
+		return -1;
+
+	return 0;
+}
+
+/*------------------------------------------------------------------------------------------
+** prosty bot podazajacy za pileczka w pionie
+** world - stan meczu
+** side - 0: lewa rakietka, 1: prawa rakietka
+** funkcja zwraca maske klawiszy (InputKeys) dla wybranej rakietki
+**------------------------------------------------------------------------------------------*/
+unsigned int trackingBot(const World& world, int side)
+{
+	const unsigned int up = side == 0 ? INPUT_LEFT_UP : INPUT_RIGHT_UP;
+	const unsigned int down = side == 0 ? INPUT_LEFT_DOWN : INPUT_RIGHT_DOWN;
+
+	int decision = trackingDecision(world.ball.y - world.rackets[side].y, world.racketsVelocity[side]);
+
+	if (decision > 0)
+	{
+		return up;
+	}
+	if (decision < 0)
+	{
+		return down;
+	}
+
+	return 0;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja liczaca, po jakim czasie trackingBot zmieni decyzje - roznica wysokosci pileczki
+** i rakietki zmienia sie liniowo, wiec wystarczy czas dojscia do progu decyzji
+** world - stan meczu z predkosciami rakietek ustawionymi przez applyInputs()
+** side - 0: lewa rakietka, 1: prawa rakietka
+**------------------------------------------------------------------------------------------*/
+float trackingBotNextDecision(const World& world, int side)
+{
+	float velocity = world.racketsVelocity[side];
+	float diff = world.ball.y - world.rackets[side].y;
+	float closing = world.ballVelocity.y - velocity; // predkosc zmiany diff
+
+	// jadaca rakietka zatrzyma sie po zrownaniu z pileczka
+	if (velocity > 0 && diff > 0)
+		return closing < 0 ? -diff / closing : never;
+	if (velocity < 0 && diff < 0)
+		return closing > 0 ? -diff / closing : never;
+
+	// stojaca rakietka ruszy po wyjsciu pileczki ze strefy martwej
+	if (diff > trackingDeadZone)
+		return closing < 0 ? (trackingDeadZone - diff) / closing : never;
+	if (diff < -trackingDeadZone)
+		return closing > 0 ? (-trackingDeadZone - diff) / closing : never;
+	if (closing > 0)
+		return (trackingDeadZone - diff) / closing;
+	if (closing < 0)
+		return (-trackingDeadZone - diff) / closing;
+
+	return never;
+}
+
+/*------------------------------------------------------------------------------------------
+** bot podazajacy za pileczka sterujacy obiema rakietkami we wszystkich meczach paczki
+** batch - paczka meczow
+** keys - wypelniana tablica masek klawiszy, batch.count elementow
+**------------------------------------------------------------------------------------------*/
+void trackingBotBatch(const MatchBatch& batch, unsigned int* keys)
+{
+	for (unsigned int i = 0; i < batch.count; i++)
+	{
+		int left = trackingDecision(batch.ballY[i] - batch.racketY[0][i], batch.racketVY[0][i]);
+		int right = trackingDecision(batch.ballY[i] - batch.racketY[1][i], batch.racketVY[1][i]);
+
+		keys[i] = (left > 0 ? (unsigned int)INPUT_LEFT_UP : 0u) | (left < 0 ? (unsigned int)INPUT_LEFT_DOWN : 0u)
+			| (right > 0 ? (unsigned int)INPUT_RIGHT_UP : 0u) | (right < 0 ? (unsigned int)INPUT_RIGHT_DOWN : 0u);
+	}
+}
+
+// PLASZCZYZNY UDERZENIA - srodek pileczki dotyka boku rakietki (lewej, prawej)
+const float interceptPlaneX[2] = { leftRacketX + halfRacketsWidth + ballRadius, rightRacketX - halfRacketsWidth - ballRadius };
+const float interceptSpan = WIN_HEIGHT - 2.0f * ballRadius; // pionowy zakres srodka pileczki miedzy odbiciami od scian
+
+/*------------------------------------------------------------------------------------------
+** funkcja liczaca wysokosc pileczki po czasie t bez symulowania odbic: tor rozlozony za gorna
+** i dolna sciane jest prosta, a pozycje na boisku daje zlozenie go z powrotem (okres 2 * zakres)
+** y, vy - wysokosc i pionowa predkosc pileczki
+**------------------------------------------------------------------------------------------*/
+static float foldedY(float y, float vy, float t)
+{
+	float unfolded = fmodf(y - ballRadius + vy * t, 2.0f * interceptSpan);
+	if (unfolded < 0.0f)
+		unfolded += 2.0f * interceptSpan;
+
+	return ballRadius + (unfolded <= interceptSpan ? unfolded : 2.0f * interceptSpan - unfolded);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja przewidujaca, na jakiej wysokosci pileczka dotrze do plaszczyzny uderzenia rakietki;
+** pileczka lecaca do przeciwnika odbija sie od boku jego rakietki jak w step() (pozioma
+** predkosc zmienia znak i rosnie o ballSpeedup, pionowa bez zmian) i wraca; odbicia od naroznika
+** (EVENT_RACKET_EDGE) zmieniaja pionowa predkosc zaleznie od ruchu rakietki przeciwnika, wiec
+** taki cel jest tylko wstepnym ustawieniem - po odbiciu przeciwnika bot liczy cel od nowa
+** z prawdziwej predkosci i dojezdza roznice (powrot na srodek boiska przegrywa kazdy mecz, bo
+** przy szybkiej pileczce rakietka nie zdazy dojechac ze srodka)
+** x, y, vx, vy - polozenie i predkosc pileczki
+** side - 0: lewa rakietka, 1: prawa rakietka
+** funkcja zwraca wysokosc srodka pileczki (ze stalym kosztem, bez wzgledu na liczbe odbic)
+**------------------------------------------------------------------------------------------*/
+static float interceptY(float x, float y, float vx, float vy, int side)
+{
+	if (vx == 0.0f)
+		return y;
+
+	float t;
+	if (side == 0 ? vx < 0.0f : vx > 0.0f)
+	{
+		t = (interceptPlaneX[side] - x) / vx;
+	}
+	else
+	{
+		float returned = -vx * ballSpeedup;
+		t = (interceptPlaneX[1 - side] - x) / vx + (interceptPlaneX[side] - interceptPlaneX[1 - side]) / returned;
+	}
+
+	return foldedY(y, vy, t > 0.0f ? t : 0.0f);
+}
+
+// cel rakietki: miejsce przeciecia w zasiegu srodka rakietki
+static float interceptTarget(float x, float y, float vx, float vy, int side)
+{
+	float target = interceptY(x, y, vx, vy, side);
+	if (target < racketLimit)
+		return racketLimit;
+	if (target > WIN_HEIGHT - racketLimit)
+		return WIN_HEIGHT - racketLimit;
+
+	return target;
+}
+
+/*------------------------------------------------------------------------------------------
+** decyzja interceptBot: jak trackingDecision(), ale cel na granicy zasiegu rakietki (pileczka
+** przy scianie) jest dojezdzany do konca - rakietka zatrzymana w strefie martwej kilka pikseli
+** przed granica nie siegnelaby pileczki tuz przy scianie
+** target - cel rakietki z interceptTarget()
+** y, velocity - wysokosc i obecna predkosc rakietki
+**------------------------------------------------------------------------------------------*/
+static int interceptDecision(float target, float y, float velocity)
+{
+	if (target >= WIN_HEIGHT - racketLimit && y < target)
+		return 1;
+	if (target <= racketLimit && y > target)
+		return -1;
+
+	return trackingDecision(target - y, velocity);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwracajaca wysokosc, na ktora interceptBot ustawia srodek rakietki side
+**------------------------------------------------------------------------------------------*/
+float interceptBotTarget(const World& world, int side)
+{
+	return interceptTarget(world.ball.x, world.ball.y, world.ballVelocity.x, world.ballVelocity.y, side);
+}
+
+/*------------------------------------------------------------------------------------------
+** bot ustawiajacy rakietke tam, gdzie pileczka przetnie jej plaszczyzne uderzenia (odbicia od
+** scian liczone analitycznie, wiec decyzja kosztuje tyle samo przy kazdej predkosci pileczki)
+** world - stan meczu
+** side - 0: lewa rakietka, 1: prawa rakietka
+** funkcja zwraca maske klawiszy (InputKeys) dla wybranej rakietki
+**------------------------------------------------------------------------------------------*/
+unsigned int interceptBot(const World& world, int side)
+{
+	int decision = interceptDecision(interceptBotTarget(world, side), world.rackets[side].y, world.racketsVelocity[side]);
+
+	if (decision > 0)
+		return side == 0 ? INPUT_LEFT_UP : INPUT_RIGHT_UP;
+	if (decision < 0)
+		return side == 0 ? INPUT_LEFT_DOWN : INPUT_RIGHT_DOWN;
+
+	return 0;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja liczaca, po jakim czasie interceptBot zmieni decyzje - miejsce przeciecia zmienia sie
+** tylko przy odbiciu od rakietki i po punkcie (zdarzenia), wiec do tego czasu liczy sie tylko
+** dojazd rakietki do celu
+** world - stan meczu z predkosciami rakietek ustawionymi przez applyInputs()
+** side - 0: lewa rakietka, 1: prawa rakietka
+**------------------------------------------------------------------------------------------*/
+float interceptBotNextDecision(const World& world, int side)
+{
+	float velocity = world.racketsVelocity[side];
+	float diff = interceptBotTarget(world, side) - world.rackets[side].y;
+
+	if ((velocity > 0 && diff > 0) || (velocity < 0 && diff < 0))
+		return diff / velocity;
+
+	return never;
+}
+
+/*------------------------------------------------------------------------------------------
+** bot przewidujacy miejsce przeciecia sterujacy obiema rakietkami we wszystkich meczach paczki
+** batch - paczka meczow
+** keys - wypelniana tablica masek klawiszy, batch.count elementow
+**------------------------------------------------------------------------------------------*/
+void interceptBotBatch(const MatchBatch& batch, unsigned int* keys)
+{
+	for (unsigned int i = 0; i < batch.count; i++)
+	{
+		float leftTarget = interceptTarget(batch.ballX[i], batch.ballY[i], batch.ballVX[i], batch.ballVY[i], 0);
+		float rightTarget = interceptTarget(batch.ballX[i], batch.ballY[i], batch.ballVX[i], batch.ballVY[i], 1);
+		int left = interceptDecision(leftTarget, batch.racketY[0][i], batch.racketVY[0][i]);
+		int right = interceptDecision(rightTarget, batch.racketY[1][i], batch.racketVY[1][i]);
+
+		keys[i] = (left > 0 ? (unsigned int)INPUT_LEFT_UP : 0u) | (left < 0 ? (unsigned int)INPUT_LEFT_DOWN : 0u)
+			| (right > 0 ? (unsigned int)INPUT_RIGHT_UP : 0u) | (right < 0 ? (unsigned int)INPUT_RIGHT_DOWN : 0u);
+	}
+}
@@ -0,0 +1,24 @@
+#ifndef __BOTS_H__
+#define __BOTS_H__
+
+#include "sim.h"
+#include "batch.h"
+
+// STEROWNIK RAKIETKI
+struct Bot {
+	unsigned int (*decide)(const World& world, int side); // maska klawiszy dla rakietki side
+	float (*nextDecision)(const World& world, int side); // czas, po ktorym decyzja moze sie zmienic (przy obecnych predkosciach)
+};
+
+unsigned int trackingBot(const World& world, int side);
+float trackingBotNextDecision(const World& world, int side);
+void trackingBotBatch(const MatchBatch& batch, unsigned int* keys);
+float interceptBotTarget(const World& world, int side);
+unsigned int interceptBot(const World& world, int side);
+float interceptBotNextDecision(const World& world, int side);
+void interceptBotBatch(const MatchBatch& batch, unsigned int* keys);
+
+const Bot trackingBotController = { trackingBot, trackingBotNextDecision };
+const Bot interceptBotController = { interceptBot, interceptBotNextDecision };
+
+#endif /* __BOTS_H__ */
@@ -0,0 +1,119 @@
+#include <cmath>
+
+#include "fastforward.h"
+
+/*------------------------------------------------------------------------------------------
+** funkcja liczaca czas, po jakim poruszajaca sie rakietka dojdzie do granicy boiska;
+** applyInputs() zatrzymuje ja dopiero przy kolejnej decyzji, wiec trzeba sie tam zatrzymac
+**------------------------------------------------------------------------------------------*/
+static float timeToRacketLimit(const World& world)
+{
+	float t = 1e30f;
+
+	for (int i = 0; i < 2; i++)
+	{
+		float v = world.racketsVelocity[i];
+		float limit = v > 0 ? (WIN_HEIGHT - racketLimit - world.rackets[i].y) / v
+			: v < 0 ? (racketLimit - world.rackets[i].y) / v : t;
+		if (limit < t)
+			t = limit;
+	}
+
+	return t;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja liczaca, o ile krokow dt mozna przesunac mecz jednym skokiem:
+** - do granicy kroku, na ktorej sterownik moze zmienic decyzje, lub pierwszej po dojsciu rakietki
+**   do granicy boiska (tam applyInputs() ja zatrzymuje) - petla krok po kroku tez widzi te zmiany
+**   dopiero na granicy kroku, wiec ostatni krok przed nia nie wymaga step()
+** - do poczatku kroku ze zderzeniem, ktory musi policzyc step()
+** czasy sa pomniejszane o blad zaokraglenia (eventTimeError), zeby skok nie minal zdarzenia
+** world - stan meczu z predkosciami rakietek ustawionymi przez applyInputs()
+** horizon - czas do najblizszej mozliwej zmiany decyzji sterownikow
+** dt - dlugosc kroku w sekundach
+** funkcja zwraca 0, jesli juz ten krok musi policzyc step()
+**------------------------------------------------------------------------------------------*/
+unsigned long long quietTicks(const World& world, float horizon, float dt)
+{
+	float limit = timeToRacketLimit(world);
+	if (horizon < limit)
+		limit = horizon;
+
+	float decisionTicks = ceilf(limit * (1.0f - eventTimeError) / dt);
+	float eventTicks = floorf(timeToNextEvent(world) * (1.0f - eventTimeError) / dt);
+
+	float ticks = decisionTicks < eventTicks ? decisionTicks : eventTicks;
+	if (!(ticks >= 1.0f))
+		return 0;
+	if (ticks >= 1e18f)
+		return 1000000000000000000ull;
+
+	return (unsigned long long)ticks;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja przesuwajaca mecz od razu o ticks krokow, w ktorych nic sie nie dzieje (quietTicks());
+** ruch jest jednostajny, wiec wystarcza jedno przesuniecie o predkosc razy caly czas - koszt nie
+** zalezy od liczby krokow; wynik rozni sie od ticks wywolan step() tylko zaokragleniami
+** world - stan meczu z predkosciami rakietek ustawionymi przez applyInputs()
+** ticks - liczba krokow
+** dt - dlugosc kroku w sekundach
+**------------------------------------------------------------------------------------------*/
+void advanceQuietTicks(World& world, unsigned long long ticks, float dt)
+{
+	float t = (float)ticks * dt;
+
+	world.rackets[0].y += world.racketsVelocity[0] * t;
+	world.rackets[1].y += world.racketsVelocity[1] * t;
+	world.ball.x += world.ballVelocity.x * t;
+	world.ball.y += world.ballVelocity.y * t;
+	world.tick += ticks;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja rozgrywajaca mecz botow skokami od zdarzenia do zdarzenia w krokach dt petli krok po
+** kroku: sterowniki pytane sa tylko na granicach krokow, na ktorych decyzja moze sie zmienic,
+** kroki bez zdarzen przeskakiwane sa jednym przesunieciem, a krok ze zdarzeniem liczy step();
+** mecz nie jest bit w bit taki sam jak krok po kroku (inne zaokraglenia), ale ma ten sam rozklad
+** wynikow, dlugosci wymian i liczby odbic
+** world - stan meczu
+** bots - sterowniki lewej i prawej rakietki
+** points - do ilu punktow gra sie mecz
+** dt - dlugosc kroku w sekundach
+** maxTicks - limit krokow meczu
+** funkcja zwraca liczbe skokow (decyzji sterownikow)
+**------------------------------------------------------------------------------------------*/
+unsigned long long playPointsEventDriven(World& world, const Bot bots[2], unsigned int points, float dt, unsigned long long maxTicks)
+{
+	unsigned long long jumps = 0;
+
+	while (world.scoreForLeft < points && world.scoreForRight < points && world.tick < maxTicks)
+	{
+		Inputs inputs = { bots[0].decide(world, 0) | bots[1].decide(world, 1) };
+		jumps++;
+
+		// predkosci rakietek wynikajace z decyzji sa potrzebne do przewidzenia kolejnej decyzji
+		applyInputs(world, inputs.keys);
+
+		float horizon = bots[0].nextDecision(world, 0);
+		float next = bots[1].nextDecision(world, 1);
+		if (next < horizon)
+			horizon = next;
+
+		unsigned long long ticks = quietTicks(world, horizon, dt);
+		if (ticks > maxTicks - world.tick)
+			ticks = maxTicks - world.tick;
+
+		if (ticks == 0)
+		{
+			step(world, inputs, dt);
+		}
+		else
+		{
+			advanceQuietTicks(world, ticks, dt);
+		}
+	}
+
+	return jumps;
+}
@@ -0,0 +1,17 @@
+#ifndef __FASTFORWARD_H__
+#define __FASTFORWARD_H__
+
+#include <cfloat>
+
+#include "sim.h"
+#include "bots.h"
+
+// WZGLEDNY BLAD CZASU ZDARZENIA - odejmowanie polozen, dzielenie przez predkosc i mnozenie
+// liczby krokow przez dt, kazde do pol ulp (z zapasem)
+const float eventTimeError = 8.0f * FLT_EPSILON;
+
+unsigned long long quietTicks(const World& world, float horizon, float dt);
+void advanceQuietTicks(World& world, unsigned long long ticks, float dt);
+unsigned long long playPointsEventDriven(World& world, const Bot bots[2], unsigned int points, float dt, unsigned long long maxTicks);
+
+#endif /* __FASTFORWARD_H__ */
@@ -0,0 +1,352 @@
+#include <cmath>
+
+#include "fixed.h"
+
+// STALE BOISKA I OBIEKTOW W LICZBACH STALOPRZECINKOWYCH (te same wartosci co w sim.h)
+const fixed_t fixedWidth = toFixed(WIN_WIDTH);
+const fixed_t fixedHeight = toFixed(WIN_HEIGHT);
+const fixed_t fixedBallRadius = toFixedHalf(5); // 2.5
+const fixed_t fixedHalfRacketsWidth = toFixed(5);
+const fixed_t fixedHalfRacketsHeight = toFixedHalf(75); // 37.5
+const fixed_t fixedRacketLimit = fixedHalfRacketsHeight + fixedBallRadius;
+const fixed_t fixedRacketsX[2] = { toFixed(20), toFixed(WIN_WIDTH - 20) };
+const fixed_t fixedRacketsSpeed = toFixed(300);
+const fixed_t fixedServeSpeed = toFixed(200);
+const fixed_t fixedServeMaxY = toFixed(200);
+const fixed_t fixedMaxSpeed = toFixed(10000000); // powyzej tej predkosci pileczka juz nie przyspiesza (ochrona przed przepelnieniem)
+const fixed_t fixedNoEvent = (fixed_t)1 << 60; // czas zdarzenia, ktore nie nastapi
+
+/*------------------------------------------------------------------------------------------
+** mnozenie i dzielenie liczb staloprzecinkowych; iloczyny mieszcza sie w 64 bitach dla
+** pozycji na boisku, predkosci do fixedMaxSpeed i czasow do kilku sekund
+**------------------------------------------------------------------------------------------*/
+static fixed_t fixedMul(fixed_t a, fixed_t b)
+{
+	return a * b / fixedOne;
+}
+
+static fixed_t fixedDiv(fixed_t a, fixed_t b)
+{
+	return a * fixedOne / b;
+}
+
+static fixed_t fixedAbs(fixed_t a)
+{
+	return a < 0 ? -a : a;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zamieniajaca czas w sekundach na liczbe staloprzecinkowa (zaokraglenie do 1/65536 s)
+**------------------------------------------------------------------------------------------*/
+fixed_t secondsToFixed(double seconds)
+{
+	return (fixed_t)std::llround(seconds * fixedOne);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja ustalajaca kierunek pileczki - odpowiednik ballDirection() z sim.cpp
+** direction - 1: w prawo, 2: w lewo, inna wartosc: losowo
+**------------------------------------------------------------------------------------------*/
+static void ballDirectionFixed(FixedWorld& world, unsigned int direction)
+{
+	unsigned int random[2];
+	serveRandom(world.seed, world.scoreForLeft + world.scoreForRight, random);
+
+	if (direction == 1)
+	{
+		world.ballVX = fixedServeSpeed;
+	}
+	else if (direction == 2)
+	{
+		world.ballVX = -fixedServeSpeed;
+	}
+	else
+	{
+		world.ballVX = (random[0] >> 8) < (1u << 23) ? fixedServeSpeed : -fixedServeSpeed;
+	}
+
+	// (yMax - yMin) * [0, 1) + yMin, losowe 24 bity
+	world.ballVY = ((2 * fixedServeMaxY) * (fixed_t)(random[1] >> 8) >> 24) - fixedServeMaxY;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja ustawiajaca stan poczatkowy meczu
+**------------------------------------------------------------------------------------------*/
+void initFixedWorld(FixedWorld& world, unsigned int seed)
+{
+	world.ballX = fixedWidth / 2;
+	world.ballY = fixedHeight / 2;
+	world.ballVX = 0;
+	world.ballVY = 0;
+	for (int i = 0; i < 2; i++)
+	{
+		world.racketY[i] = fixedHeight / 2;
+		world.racketVY[i] = 0;
+	}
+	world.scoreForLeft = 0;
+	world.scoreForRight = 0;
+	world.hits = 0;
+	world.seed = seed;
+	world.tick = 0;
+
+	ballDirectionFixed(world, 0);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja nadajaca predkosci rakietkom - odpowiednik applyInputs() z sim.cpp
+**------------------------------------------------------------------------------------------*/
+static void applyInputsFixed(FixedWorld& world, unsigned int keys)
+{
+	const unsigned int upKeys[2] = { INPUT_LEFT_UP, INPUT_RIGHT_UP };
+	const unsigned int downKeys[2] = { INPUT_LEFT_DOWN, INPUT_RIGHT_DOWN };
+
+	for (int i = 0; i < 2; i++)
+	{
+		world.racketVY[i] = 0;
+
+		if (keys & upKeys[i])
+		{
+			if (world.racketY[i] < fixedHeight - fixedRacketLimit)
+				world.racketVY[i] = fixedRacketsSpeed;
+			else
+				world.racketY[i] = fixedHeight - fixedRacketLimit;
+		}
+
+		if (keys & downKeys[i])
+		{
+			if (world.racketY[i] > fixedRacketLimit)
+				world.racketVY[i] = -fixedRacketsSpeed;
+			else
+				world.racketY[i] = fixedHalfRacketsHeight;
+		}
+	}
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja liczaca czas dojscia punktu p do granicy low (przy v < 0) lub high (przy v > 0)
+**------------------------------------------------------------------------------------------*/
+static fixed_t timeToBoundFixed(fixed_t p, fixed_t v, fixed_t low, fixed_t high)
+{
+	fixed_t t;
+	if (v < 0)
+		t = fixedDiv(low - p, v);
+	else if (v > 0)
+		t = fixedDiv(high - p, v);
+	else
+		return fixedNoEvent;
+
+	return t < 0 ? 0 : t;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja liczaca czas zderzenia z rakietka - odpowiednik timeToRacket() z sim.cpp;
+** trafienia pozniejsze niz horizon sa pomijane, zeby iloczyny nie wychodzily poza 64 bity
+**------------------------------------------------------------------------------------------*/
+static fixed_t timeToRacketFixed(fixed_t dx, fixed_t dy, fixed_t vx, fixed_t vy, fixed_t horizon, bool& edge)
+{
+	const fixed_t extentX = fixedHalfRacketsWidth + fixedBallRadius;
+	const fixed_t extentY = fixedHalfRacketsHeight + fixedBallRadius;
+
+	fixed_t distanceX = fixedAbs(dx);
+	fixed_t distanceY = fixedAbs(dy);
+	fixed_t closingX = dx >= 0 ? -vx : vx;
+	fixed_t closingY = dy >= 0 ? -vy : vy;
+
+	fixed_t t = fixedNoEvent;
+	edge = false;
+
+	// BOK RAKIETKI
+	if (distanceX >= extentX && closingX > 0)
+	{
+		fixed_t tx = fixedDiv(distanceX - extentX, closingX);
+		if (tx <= horizon && fixedAbs(dy + fixedMul(vy, tx)) <= extentY)
+		{
+			t = tx;
+		}
+	}
+
+	// GORNA LUB DOLNA KRAWEDZ RAKIETKI
+	if (distanceY >= extentY && closingY > 0)
+	{
+		fixed_t ty = fixedDiv(distanceY - extentY, closingY);
+		if (ty <= horizon && ty < t && fixedAbs(dx + fixedMul(vx, ty)) <= extentX)
+		{
+			t = ty;
+			edge = true;
+		}
+	}
+
+	return t;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja przyspieszajaca pileczke po odbiciu (x 1.01)
+**------------------------------------------------------------------------------------------*/
+static fixed_t speedupFixed(fixed_t v)
+{
+	return fixedAbs(v) < fixedMaxSpeed ? v * 101 / 100 : v;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja wykonujaca jeden krok symulacji w liczbach staloprzecinkowych - te same reguly
+** co step() w sim.cpp; po zderzeniu pileczka jest ustawiana dokladnie w punkcie styku,
+** zeby obciecia przy dzieleniu nie pozwolily jej wejsc w rakietke lub sciane
+** world - stan meczu
+** inputs - klawisze wcisniete w tym kroku
+** dt - dlugosc kroku (np. secondsToFixed(1.0 / 120))
+** funkcja zwraca 0 jesli nikt nie zdobyl punktu, 1 - punkt dla prawego, 2 - punkt dla lewego
+**------------------------------------------------------------------------------------------*/
+unsigned int stepFixed(FixedWorld& world, const Inputs& inputs, fixed_t dt)
+{
+	const fixed_t extentX = fixedHalfRacketsWidth + fixedBallRadius;
+	const fixed_t extentY = fixedHalfRacketsHeight + fixedBallRadius;
+
+	unsigned int reset = 0;
+
+	applyInputsFixed(world, inputs.keys);
+
+	fixed_t remaining = dt;
+	for (int e = 0; e < maxEventsPerStep && remaining > 0; e++)
+	{
+		// NAJBLIZSZE ZDARZENIE W POZOSTALEJ CZESCI KROKU
+		fixed_t t = remaining;
+		int event = 0; // 0 - brak, 1 - sciana, 2 - bok rakietki, 3 - krawedz rakietki, 4 - bramka
+		int side = 0;
+
+		fixed_t tWall = timeToBoundFixed(world.ballY, world.ballVY, fixedBallRadius, fixedHeight - fixedBallRadius);
+		if (tWall <= t)
+		{
+			t = tWall;
+			event = 1;
+		}
+
+		for (int i = 0; i < 2; i++)
+		{
+			bool edge;
+			fixed_t tRacket = timeToRacketFixed(world.ballX - fixedRacketsX[i], world.ballY - world.racketY[i],
+				world.ballVX, world.ballVY - world.racketVY[i], t, edge);
+			if (tRacket <= t)
+			{
+				t = tRacket;
+				event = edge ? 3 : 2;
+				side = i;
+			}
+		}
+
+		fixed_t tGoal = timeToBoundFixed(world.ballX, world.ballVX, fixedBallRadius, fixedWidth - fixedBallRadius);
+		if (tGoal < t)
+		{
+			t = tGoal;
+			event = 4;
+		}
+
+		// RUCH DO CHWILI ZDARZENIA
+		world.racketY[0] += fixedMul(world.racketVY[0], t);
+		world.racketY[1] += fixedMul(world.racketVY[1], t);
+		world.ballX += fixedMul(world.ballVX, t);
+		world.ballY += fixedMul(world.ballVY, t);
+		remaining -= t;
+
+		switch (event)
+		{
+		case 1:
+			world.ballY = world.ballVY < 0 ? fixedBallRadius : fixedHeight - fixedBallRadius;
+			world.ballVY = -world.ballVY;
+			break;
+
+		case 2:
+			world.ballX = world.ballX >= fixedRacketsX[side] ? fixedRacketsX[side] + extentX : fixedRacketsX[side] - extentX;
+			world.ballVX = speedupFixed(-world.ballVX);
+			world.hits++;
+			break;
+
+		case 3:
+			world.ballY = world.ballY >= world.racketY[side] ? world.racketY[side] + extentY : world.racketY[side] - extentY;
+			world.ballVY = world.racketVY[side] + world.racketVY[side] - world.ballVY;
+			world.ballVX = speedupFixed(world.ballVX);
+			world.hits++;
+			break;
+
+		case 4:
+			if (world.ballVX < 0)
+			{
+				world.scoreForRight++;
+				reset = 1;
+			}
+			else
+			{
+				world.scoreForLeft++;
+				reset = 2;
+			}
+
+			world.ballX = fixedWidth / 2;
+			world.ballY = fixedHeight / 2;
+
+			ballDirectionFixed(world, reset);
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	// przy nadmiarze zdarzen reszta kroku bez sprawdzania zderzen
+	if (remaining > 0)
+	{
+		world.racketY[0] += fixedMul(world.racketVY[0], remaining);
+		world.racketY[1] += fixedMul(world.racketVY[1], remaining);
+		world.ballX += fixedMul(world.ballVX, remaining);
+		world.ballY += fixedMul(world.ballVY, remaining);
+	}
+
+	world.tick++;
+
+	return reset;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zamieniajaca stan staloprzecinkowy na zmiennoprzecinkowy (np. do rysowania)
+**------------------------------------------------------------------------------------------*/
+void fixedToWorld(const FixedWorld& fixedWorld, World& world)
+{
+	const float scale = 1.0f / fixedOne;
+
+	world.ball = { fixedWorld.ballX * scale, fixedWorld.ballY * scale };
+	world.ballVelocity = { fixedWorld.ballVX * scale, fixedWorld.ballVY * scale };
+	world.rackets[0] = { leftRacketX, fixedWorld.racketY[0] * scale };
+	world.rackets[1] = { rightRacketX, fixedWorld.racketY[1] * scale };
+	world.racketsVelocity[0] = fixedWorld.racketVY[0] * scale;
+	world.racketsVelocity[1] = fixedWorld.racketVY[1] * scale;
+	world.scoreForLeft = fixedWorld.scoreForLeft;
+	world.scoreForRight = fixedWorld.scoreForRight;
+	world.hits = fixedWorld.hits;
+	world.seed = fixedWorld.seed;
+	world.tick = fixedWorld.tick;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja liczaca skrot stanu meczu (FNV-1a po wartosciach pol, bez wypelnienia struktury)
+** - dwa procesy z tym samym ziarnem i wejsciem musza dostac ten sam skrot
+**------------------------------------------------------------------------------------------*/
+unsigned long long hashFixedWorld(const FixedWorld& world)
+{
+	const unsigned long long values[] = {
+		(unsigned long long)world.ballX, (unsigned long long)world.ballY,
+		(unsigned long long)world.ballVX, (unsigned long long)world.ballVY,
+		(unsigned long long)world.racketY[0], (unsigned long long)world.racketY[1],
+		(unsigned long long)world.racketVY[0], (unsigned long long)world.racketVY[1],
+		world.scoreForLeft, world.scoreForRight, world.hits, world.seed, world.tick
+	};
+
+	unsigned long long hash = 14695981039346656037ull;
+	for (unsigned long long value : values)
+	{
+		for (int b = 0; b < 8; b++)
+		{
+			hash ^= (value >> (8 * b)) & 0xFF;
+			hash *= 1099511628211ull;
+		}
+	}
+
+	return hash;
+}
@@ -0,0 +1,35 @@
+#ifndef __FIXED_H__
+#define __FIXED_H__
+
+#include "sim.h"
+
+// LICZBA STALOPRZECINKOWA 48.16 - tylko dzialania calkowitoliczbowe, wiec wynik jest ten sam
+// niezaleznie od kompilatora, optymalizacji (FMA, x87/SSE) i procesora
+typedef long long fixed_t;
+
+constexpr int fixedShift = 16;
+constexpr fixed_t fixedOne = (fixed_t)1 << fixedShift;
+
+constexpr fixed_t toFixed(int value) { return (fixed_t)value * fixedOne; }
+constexpr fixed_t toFixedHalf(int value) { return (fixed_t)value * fixedOne / 2; } // value / 2
+
+// PELNY STAN MECZU W LICZBACH STALOPRZECINKOWYCH (pozycje w px, predkosci w px/s, czas w s)
+struct FixedWorld {
+	fixed_t ballX, ballY;
+	fixed_t ballVX, ballVY;
+	fixed_t racketY[2];
+	fixed_t racketVY[2];
+	unsigned int scoreForLeft;
+	unsigned int scoreForRight;
+	unsigned int hits;
+	unsigned int seed;
+	unsigned long long tick;
+};
+
+fixed_t secondsToFixed(double seconds);
+void initFixedWorld(FixedWorld& world, unsigned int seed);
+unsigned int stepFixed(FixedWorld& world, const Inputs& inputs, fixed_t dt);
+void fixedToWorld(const FixedWorld& fixedWorld, World& world);
+unsigned long long hashFixedWorld(const FixedWorld& world);
+
+#endif /* __FIXED_H__ */
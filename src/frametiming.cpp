@@ -0,0 +1,483 @@
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "frametiming.h"
+
+const char* const framePhaseNames[PHASE_COUNT] = { "input", "physics", "upload", "render", "swap", "events" };
+const char* const gpuRangeNames[GPU_RANGE_COUNT] = { "gpu_upload", "gpu_ball", "gpu_rackets" };
+
+/*------------------------------------------------------------------------------------------
+** funkcja przydzielajaca pamiec pomiaru klatek i wlaczajaca pomiar
+** windowSize - liczba ostatnich klatek w ruchomym oknie
+** recordCapacity - liczba ostatnich klatek zachowywanych do zapisu w pliku
+** budgetSeconds - limit czasu klatki, po ktorego przekroczeniu endFrame() zwraca true (0 - bez limitu)
+**------------------------------------------------------------------------------------------*/
+void initFrameTiming(FrameTiming& timing, unsigned int windowSize, unsigned int recordCapacity, double budgetSeconds)
+{
+	timing.windowSize = windowSize ? windowSize : 1;
+	timing.window = new unsigned long long[(size_t)timing.windowSize * (PHASE_COUNT + 1)];
+	memset(timing.window, 0, (size_t)timing.windowSize * (PHASE_COUNT + 1) * sizeof(unsigned long long));
+	memset(timing.windowSum, 0, sizeof(timing.windowSum));
+	timing.windowCount = 0;
+
+	timing.gpuWindow = new unsigned long long[(size_t)timing.windowSize * GPU_RANGE_COUNT];
+	memset(timing.gpuWindow, 0, (size_t)timing.windowSize * GPU_RANGE_COUNT * sizeof(unsigned long long));
+	memset(timing.gpuWindowSum, 0, sizeof(timing.gpuWindowSum));
+	timing.gpuWindowCount = 0;
+	timing.gpuFrames = 0;
+
+	timing.recordCapacity = recordCapacity ? recordCapacity : 1;
+	timing.records = new FrameRecord[timing.recordCapacity];
+	timing.frames = 0;
+
+	memset(&timing.current, 0, sizeof(timing.current));
+
+	initHistogram(timing.frameHistogram);
+	initHistogram(timing.stepHistogram);
+	timing.budget = budgetSeconds > 0.0 ? (unsigned long long)(budgetSeconds * 1e9) : 0;
+	timing.overBudget = 0;
+
+	// koszt odczytu zegara - do oszacowania narzutu pomiaru
+	const unsigned int calls = 1000;
+	unsigned long long start = timingNow();
+	unsigned long long last = start;
+	for (unsigned int i = 0; i < calls; i++)
+	{
+		last = timingNow();
+	}
+	timing.clockCost = (last - start) / calls;
+
+	timing.origin = timingNow();
+	timing.frameStart = timing.origin;
+	timing.phaseStart = timing.origin;
+	timing.enabled = true;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwalniajaca pamiec pomiaru klatek
+**------------------------------------------------------------------------------------------*/
+void freeFrameTiming(FrameTiming& timing)
+{
+	delete[] timing.window;
+	delete[] timing.gpuWindow;
+	delete[] timing.records;
+	freeHistogram(timing.frameHistogram);
+	freeHistogram(timing.stepHistogram);
+
+	timing.window = nullptr;
+	timing.gpuWindow = nullptr;
+	timing.records = nullptr;
+	timing.enabled = false;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja konczaca pomiar klatki - czas calej klatki to czas do ostatniego znacznika fazy
+** steps - liczba krokow fizyki wykonanych w tej klatce
+** funkcja zwraca true, jesli klatka trwala dluzej niz budget (do wypisania rozkladu faz)
+**------------------------------------------------------------------------------------------*/
+bool endFrame(FrameTiming& timing, unsigned int steps)
+{
+	if (!timing.enabled)
+		return false;
+
+	FrameRecord& record = timing.current;
+	record.frame = timing.frames;
+	record.start = timing.frameStart - timing.origin;
+	record.total = timing.phaseStart - timing.frameStart;
+	record.steps = steps;
+	record.gpuValid = false;
+
+	// ruchome okno - nowy czas zastepuje najstarszy w sumie
+	unsigned long long* row = timing.window + (size_t)(timing.frames % timing.windowSize) * (PHASE_COUNT + 1);
+	for (unsigned int p = 0; p <= PHASE_COUNT; p++)
+	{
+		unsigned long long value = p < PHASE_COUNT ? record.phases[p] : record.total;
+		timing.windowSum[p] += value - row[p];
+		row[p] = value;
+	}
+	if (timing.windowCount < timing.windowSize)
+	{
+		timing.windowCount++;
+	}
+
+	timing.records[timing.frames % timing.recordCapacity] = record;
+	timing.frames++;
+
+	recordHistogram(timing.frameHistogram, record.total);
+
+	bool over = timing.budget && record.total > timing.budget;
+	if (over)
+	{
+		timing.overBudget++;
+	}
+
+	return over;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja dopisujaca czasy GPU do zakonczonej klatki (wyniki zapytan czasowych przychodza
+** kilka klatek pozniej; klatka juz nadpisana w pierscieniu liczy sie tylko do okna)
+** frame - numer klatki, w ktorej wyslano zapytania
+** gpu - czasy odcinkow w nanosekundach
+**------------------------------------------------------------------------------------------*/
+void setFrameGpu(FrameTiming& timing, unsigned long long frame, const unsigned long long gpu[GPU_RANGE_COUNT])
+{
+	if (!timing.enabled || frame >= timing.frames)
+		return;
+
+	if (frame + recordedFrames(timing) >= timing.frames)
+	{
+		FrameRecord& record = timing.records[frame % timing.recordCapacity];
+		memcpy(record.gpu, gpu, sizeof(record.gpu));
+		record.gpuValid = true;
+	}
+
+	unsigned long long* row = timing.gpuWindow + (size_t)(timing.gpuFrames % timing.windowSize) * GPU_RANGE_COUNT;
+	for (unsigned int r = 0; r < GPU_RANGE_COUNT; r++)
+	{
+		timing.gpuWindowSum[r] += gpu[r] - row[r];
+		row[r] = gpu[r];
+	}
+	if (timing.gpuWindowCount < timing.windowSize)
+	{
+		timing.gpuWindowCount++;
+	}
+	timing.gpuFrames++;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja liczaca sredni i najdluzszy czas fazy w ruchomym oknie
+** phase - faza lub PHASE_COUNT dla calej klatki
+**------------------------------------------------------------------------------------------*/
+PhaseWindowStats phaseWindowStats(const FrameTiming& timing, int phase)
+{
+	PhaseWindowStats stats = { 0.0, 0.0, 0.0 };
+	if (!timing.windowCount)
+		return stats;
+
+	unsigned long long max = 0;
+	for (unsigned int i = 0; i < timing.windowCount; i++)
+	{
+		unsigned long long value = timing.window[(size_t)i * (PHASE_COUNT + 1) + phase];
+		if (value > max)
+		{
+			max = value;
+		}
+	}
+
+	stats.mean = timing.windowSum[phase] / 1e6 / timing.windowCount;
+	stats.max = max / 1e6;
+	stats.share = timing.windowSum[PHASE_COUNT] ? (double)timing.windowSum[phase] / timing.windowSum[PHASE_COUNT] : 0.0;
+
+	return stats;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja liczaca sredni i najdluzszy czas odcinka GPU w ruchomym oknie (share - udzial
+** w sredniej calej klatki CPU)
+**------------------------------------------------------------------------------------------*/
+PhaseWindowStats gpuWindowStats(const FrameTiming& timing, int range)
+{
+	PhaseWindowStats stats = { 0.0, 0.0, 0.0 };
+	if (!timing.gpuWindowCount)
+		return stats;
+
+	unsigned long long max = 0;
+	for (unsigned int i = 0; i < timing.gpuWindowCount; i++)
+	{
+		unsigned long long value = timing.gpuWindow[(size_t)i * GPU_RANGE_COUNT + range];
+		if (value > max)
+		{
+			max = value;
+		}
+	}
+
+	stats.mean = timing.gpuWindowSum[range] / 1e6 / timing.gpuWindowCount;
+	stats.max = max / 1e6;
+
+	PhaseWindowStats total = phaseWindowStats(timing, PHASE_COUNT);
+	stats.share = total.mean > 0.0 ? stats.mean / total.mean : 0.0;
+
+	return stats;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwracajaca liczbe klatek zachowanych do zapisu
+**------------------------------------------------------------------------------------------*/
+unsigned long long recordedFrames(const FrameTiming& timing)
+{
+	return timing.frames < timing.recordCapacity ? timing.frames : timing.recordCapacity;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwracajaca zachowana klatke (0 - najstarsza)
+**------------------------------------------------------------------------------------------*/
+const FrameRecord& recordedFrame(const FrameTiming& timing, unsigned long long index)
+{
+	unsigned long long first = timing.frames - recordedFrames(timing);
+
+	return timing.records[(first + index) % timing.recordCapacity];
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja szacujaca narzut pomiaru jako czesc czasu klatek (PHASE_COUNT + 1 odczytow
+** zegara na klatke)
+**------------------------------------------------------------------------------------------*/
+double timingOverhead(const FrameTiming& timing)
+{
+	unsigned long long elapsed = timing.phaseStart - timing.origin;
+	if (!elapsed)
+		return 0.0;
+
+	return (double)timing.frames * (PHASE_COUNT + 1) * timing.clockCost / elapsed;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zapisujaca klatke jako wiersz CSV lub tablice JSON (czasy w mikrosekundach)
+**------------------------------------------------------------------------------------------*/
+static void writeRecord(FILE* file, const FrameRecord& record, bool json)
+{
+	fprintf(file, json ? "    [%llu, %.3f, %u" : "%llu,%.3f,%u", record.frame, record.start / 1e6, record.steps);
+
+	unsigned long long measured = 0;
+	for (unsigned int p = 0; p < PHASE_COUNT; p++)
+	{
+		fprintf(file, json ? ", %.3f" : ",%.3f", record.phases[p] / 1e3);
+		measured += record.phases[p];
+	}
+
+	fprintf(file, json ? ", %.3f, %.3f" : ",%.3f,%.3f", (record.total - measured) / 1e3, record.total / 1e3);
+
+	// czasy GPU - puste pola (null), jesli wynik zapytan nie dotarl
+	for (unsigned int r = 0; r < GPU_RANGE_COUNT; r++)
+	{
+		if (record.gpuValid)
+			fprintf(file, json ? ", %.3f" : ",%.3f", record.gpu[r] / 1e3);
+		else
+			fprintf(file, json ? ", null" : ",");
+	}
+
+	fprintf(file, json ? "]" : "\n");
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zapisujaca histogram jako obiekt JSON (percentyle i niepuste kubelki [od_ns, do_ns, liczba])
+**------------------------------------------------------------------------------------------*/
+static void writeHistogramJson(FILE* file, const char* name, const TimeHistogram& histogram)
+{
+	fprintf(file, "    \"%s\": {\"count\": %llu, \"min_ns\": %llu, \"max_ns\": %llu, \"mean_ns\": %.1f, "
+		"\"p50_ns\": %llu, \"p90_ns\": %llu, \"p99_ns\": %llu, \"p999_ns\": %llu, \"buckets\": [",
+		name, histogram.count, histogram.count ? histogram.min : 0, histogram.max,
+		histogram.count ? (double)histogram.sum / histogram.count : 0.0,
+		histogramPercentile(histogram, 0.5), histogramPercentile(histogram, 0.9),
+		histogramPercentile(histogram, 0.99), histogramPercentile(histogram, 0.999));
+
+	bool first = true;
+	for (unsigned int b = 0; b < histogramBuckets; b++)
+	{
+		if (!histogram.counts[b])
+			continue;
+
+		fprintf(file, "%s[%llu, %llu, %llu]", first ? "" : ", ", histogramBucketLow(b), histogramBucketHigh(b), histogram.counts[b]);
+		first = false;
+	}
+
+	fprintf(file, "]}");
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zapisujaca histogramy klatek i krokow jako CSV (histogram, od_ns, do_ns, liczba)
+** path - plik wynikowy
+**------------------------------------------------------------------------------------------*/
+static bool writeHistogramsCsv(const FrameTiming& timing, const std::string& path)
+{
+	FILE* file = fopen(path.c_str(), "w");
+	if (!file)
+		return false;
+
+	fprintf(file, "histogram,low_ns,high_ns,count\n");
+
+	const TimeHistogram* histograms[2] = { &timing.frameHistogram, &timing.stepHistogram };
+	const char* names[2] = { "frame", "step" };
+	for (unsigned int h = 0; h < 2; h++)
+	{
+		for (unsigned int b = 0; b < histogramBuckets; b++)
+		{
+			if (histograms[h]->counts[b])
+			{
+				fprintf(file, "%s,%llu,%llu,%llu\n", names[h], histogramBucketLow(b), histogramBucketHigh(b), histograms[h]->counts[b]);
+			}
+		}
+	}
+
+	return fclose(file) == 0;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zapisujaca zachowane klatki do pliku
+** path - plik wynikowy; rozszerzenie .json - JSON, kazde inne - CSV
+** kolumny: frame, start_ms, steps, <faza>_us..., other_us, total_us, gpu_<odcinek>_us...
+** histogramy klatek i krokow sa w JSON w polu "histograms", a przy CSV w osobnym pliku
+** <nazwa>-histogram.csv
+**------------------------------------------------------------------------------------------*/
+bool writeFrameTiming(const FrameTiming& timing, const char* path)
+{
+	FILE* file = fopen(path, "w");
+	if (!file)
+		return false;
+
+	size_t length = strlen(path);
+	bool json = length >= 5 && strcmp(path + length - 5, ".json") == 0;
+
+	if (json)
+	{
+		fprintf(file, "{\n  \"frames_total\": %llu,\n  \"frames_kept\": %llu,\n  \"frames_gpu\": %llu,\n  \"clock_cost_ns\": %llu,\n  \"overhead\": %.6f,\n",
+			timing.frames, recordedFrames(timing), timing.gpuFrames, timing.clockCost, timingOverhead(timing));
+		fprintf(file, "  \"budget_ms\": %.3f,\n  \"over_budget\": %llu,\n", timing.budget / 1e6, timing.overBudget);
+
+		fprintf(file, "  \"histograms\": {\n");
+		writeHistogramJson(file, "frame", timing.frameHistogram);
+		fprintf(file, ",\n");
+		writeHistogramJson(file, "step", timing.stepHistogram);
+		fprintf(file, "\n  },\n");
+
+		fprintf(file, "  \"window\": {");
+		for (int p = 0; p <= PHASE_COUNT; p++)
+		{
+			PhaseWindowStats stats = phaseWindowStats(timing, p);
+			fprintf(file, "%s\"%s\": {\"mean_ms\": %.4f, \"max_ms\": %.4f}", p ? ", " : "",
+				p < PHASE_COUNT ? framePhaseNames[p] : "total", stats.mean, stats.max);
+		}
+		for (int r = 0; r < GPU_RANGE_COUNT; r++)
+		{
+			PhaseWindowStats stats = gpuWindowStats(timing, r);
+			fprintf(file, ", \"%s\": {\"mean_ms\": %.4f, \"max_ms\": %.4f}", gpuRangeNames[r], stats.mean, stats.max);
+		}
+		fprintf(file, "},\n");
+
+		fprintf(file, "  \"columns\": [\"frame\", \"start_ms\", \"steps\"");
+		for (unsigned int p = 0; p < PHASE_COUNT; p++)
+		{
+			fprintf(file, ", \"%s_us\"", framePhaseNames[p]);
+		}
+		fprintf(file, ", \"other_us\", \"total_us\"");
+		for (unsigned int r = 0; r < GPU_RANGE_COUNT; r++)
+		{
+			fprintf(file, ", \"%s_us\"", gpuRangeNames[r]);
+		}
+		fprintf(file, "],\n  \"frames\": [\n");
+	}
+	else
+	{
+		fprintf(file, "frame,start_ms,steps");
+		for (unsigned int p = 0; p < PHASE_COUNT; p++)
+		{
+			fprintf(file, ",%s_us", framePhaseNames[p]);
+		}
+		fprintf(file, ",other_us,total_us");
+		for (unsigned int r = 0; r < GPU_RANGE_COUNT; r++)
+		{
+			fprintf(file, ",%s_us", gpuRangeNames[r]);
+		}
+		fprintf(file, "\n");
+	}
+
+	unsigned long long count = recordedFrames(timing);
+	for (unsigned long long i = 0; i < count; i++)
+	{
+		writeRecord(file, recordedFrame(timing, i), json);
+		if (json)
+		{
+			fprintf(file, i + 1 < count ? ",\n" : "\n");
+		}
+	}
+
+	if (json)
+	{
+		fprintf(file, "  ]\n}\n");
+	}
+
+	if (fclose(file) != 0)
+		return false;
+
+	if (json)
+		return true;
+
+	// timing.csv -> timing-histogram.csv
+	std::string histogramPath = path;
+	if (length >= 4 && strcmp(path + length - 4, ".csv") == 0)
+	{
+		histogramPath.resize(length - 4);
+	}
+	histogramPath += "-histogram.csv";
+
+	return writeHistogramsCsv(timing, histogramPath);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja wypisujaca srednie i najdluzsze czasy faz z ruchomego okna oraz percentyle sesji
+**------------------------------------------------------------------------------------------*/
+void printFrameTiming(const FrameTiming& timing)
+{
+	PhaseWindowStats total = phaseWindowStats(timing, PHASE_COUNT);
+
+	char line[384];
+	int length = snprintf(line, sizeof(line), "klatka %.2f ms (max %.2f):", total.mean, total.max);
+	for (int p = 0; p < PHASE_COUNT && length < (int)sizeof(line); p++)
+	{
+		PhaseWindowStats stats = phaseWindowStats(timing, p);
+		length += snprintf(line + length, sizeof(line) - length, " %s %.2f/%.2f", framePhaseNames[p], stats.mean, stats.max);
+	}
+
+	// czasy GPU obok czasow CPU tych samych faz
+	for (int r = 0; r < GPU_RANGE_COUNT && timing.gpuWindowCount && length < (int)sizeof(line); r++)
+	{
+		PhaseWindowStats stats = gpuWindowStats(timing, r);
+		length += snprintf(line + length, sizeof(line) - length, " %s %.3f/%.3f", gpuRangeNames[r], stats.mean, stats.max);
+	}
+
+	std::cout << line << std::endl;
+
+	formatPercentiles(timing, line, sizeof(line));
+	std::cout << line << std::endl;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja wypisujaca rozklad faz jednej klatki (np. klatki ponad limitem czasu)
+**------------------------------------------------------------------------------------------*/
+void printFrameRecord(const FrameRecord& record)
+{
+	char line[384];
+	int length = snprintf(line, sizeof(line), "klatka %llu: %.2f ms, kroki %u:", record.frame, record.total / 1e6, record.steps);
+
+	unsigned long long measured = 0;
+	for (int p = 0; p < PHASE_COUNT && length < (int)sizeof(line); p++)
+	{
+		length += snprintf(line + length, sizeof(line) - length, " %s %.2f", framePhaseNames[p], record.phases[p] / 1e6);
+		measured += record.phases[p];
+	}
+	if (length < (int)sizeof(line))
+	{
+		snprintf(line + length, sizeof(line) - length, " inne %.2f", (record.total - measured) / 1e6);
+	}
+
+	std::cout << line << std::endl;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja opisujaca percentyle czasow klatek i krokow calej sesji (np. do tytulu okna)
+** text - bufor na opis
+** size - rozmiar bufora
+**------------------------------------------------------------------------------------------*/
+void formatPercentiles(const FrameTiming& timing, char* text, unsigned int size)
+{
+	const TimeHistogram& frames = timing.frameHistogram;
+	const TimeHistogram& steps = timing.stepHistogram;
+
+	snprintf(text, size, "klatka p50 %.2f p99 %.2f p99.9 %.2f ms, krok p50 %.1f p99 %.1f p99.9 %.1f us, ponad limit %llu",
+		histogramPercentile(frames, 0.5) / 1e6, histogramPercentile(frames, 0.99) / 1e6, histogramPercentile(frames, 0.999) / 1e6,
+		histogramPercentile(steps, 0.5) / 1e3, histogramPercentile(steps, 0.99) / 1e3, histogramPercentile(steps, 0.999) / 1e3,
+		timing.overBudget);
+}
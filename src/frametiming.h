@@ -0,0 +1,156 @@
+#ifndef __FRAMETIMING_H__
+#define __FRAMETIMING_H__
+
+#include <chrono>
+
+#include "histogram.h"
+
+// FAZY KLATKI GLOWNEJ PETLI GRY (kolejnosc jak w petli)
+enum FramePhase {
+	PHASE_INPUT, // processInput()
+	PHASE_PHYSICS, // kroki symulacji, siec i interpolacja pozycji
+	PHASE_UPLOAD, // glBufferSubData() pozycji pilki i rakietek
+	PHASE_RENDER, // glClear() i renderScene()
+	PHASE_SWAP, // glfwSwapBuffers() (z czekaniem na v-sync)
+	PHASE_EVENTS, // glfwPollEvents()
+	PHASE_COUNT
+};
+
+extern const char* const framePhaseNames[PHASE_COUNT];
+
+// ODCINKI MIERZONE NA GPU (zapytania czasowe OpenGL, gputiming.cpp)
+enum GpuRange {
+	GPU_UPLOAD, // glBufferSubData() pozycji
+	GPU_BALL, // rysowanie pilki
+	GPU_RACKETS, // rysowanie rakietek
+	GPU_RANGE_COUNT
+};
+
+extern const char* const gpuRangeNames[GPU_RANGE_COUNT];
+
+// POMIAR JEDNEJ KLATKI (czasy w nanosekundach)
+struct FrameRecord {
+	unsigned long long frame; // numer klatki od poczatku pomiaru
+	unsigned long long start; // poczatek klatki od poczatku pomiaru
+	unsigned long long total; // cala klatka
+	unsigned long long phases[PHASE_COUNT];
+	unsigned long long gpu[GPU_RANGE_COUNT]; // czasy na GPU - uzupelniane kilka klatek pozniej
+	unsigned int steps; // kroki fizyki w tej klatce
+	bool gpuValid; // czy wynik zapytan GPU dotarl
+};
+
+// CZASY KLATEK - cala pamiec przydzielana raz w initFrameTiming(), w trakcie gry
+// tylko odczyty zegara i zapis do tablic
+struct FrameTiming {
+	bool enabled;
+
+	// ruchome okno ostatnich windowSize klatek dla kazdej fazy (i calej klatki)
+	unsigned long long* window; // windowSize wierszy po PHASE_COUNT + 1 czasow
+	unsigned long long windowSum[PHASE_COUNT + 1];
+	unsigned int windowSize;
+	unsigned int windowCount;
+
+	// ruchome okno czasow GPU (osobno - wyniki przychodza z opoznieniem i nie dla kazdej klatki)
+	unsigned long long* gpuWindow; // windowSize wierszy po GPU_RANGE_COUNT czasow
+	unsigned long long gpuWindowSum[GPU_RANGE_COUNT];
+	unsigned int gpuWindowCount;
+	unsigned long long gpuFrames; // klatki z wynikiem GPU
+
+	// zapis klatek do pliku - pierscien, po zapelnieniu nadpisywane sa najstarsze
+	FrameRecord* records;
+	unsigned int recordCapacity;
+	unsigned long long frames; // zmierzone klatki (numer nastepnej)
+
+	// biezaca klatka
+	unsigned long long origin; // odczyt zegara przy initFrameTiming()
+	unsigned long long frameStart;
+	unsigned long long phaseStart;
+	FrameRecord current;
+
+	unsigned long long clockCost; // sredni koszt jednego odczytu zegara
+
+	// rozklad czasow calej sesji - percentyle zamiast srednich, ktore ukrywaja szarpniecia
+	TimeHistogram frameHistogram; // cale klatki
+	TimeHistogram stepHistogram; // pojedyncze kroki fizyki
+	unsigned long long budget; // limit czasu klatki (0 - bez limitu)
+	unsigned long long overBudget; // klatki dluzsze niz budget
+};
+
+// STATYSTYKI FAZY Z RUCHOMEGO OKNA
+struct PhaseWindowStats {
+	double mean; // w milisekundach
+	double max;
+	double share; // udzial w czasie calej klatki
+};
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwracajaca odczyt zegara monotonicznego w nanosekundach
+**------------------------------------------------------------------------------------------*/
+inline unsigned long long timingNow()
+{
+	return (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zaczynajaca pomiar klatki
+**------------------------------------------------------------------------------------------*/
+inline void beginFrame(FrameTiming& timing)
+{
+	if (!timing.enabled)
+		return;
+
+	timing.frameStart = timingNow();
+	timing.phaseStart = timing.frameStart;
+	for (unsigned int p = 0; p < PHASE_COUNT; p++)
+	{
+		timing.current.phases[p] = 0;
+	}
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja doliczajaca do fazy czas od poprzedniego znacznika (faza moze wystapic
+** w klatce kilka razy - czasy sie sumuja)
+**------------------------------------------------------------------------------------------*/
+inline void markPhase(FrameTiming& timing, FramePhase phase)
+{
+	if (!timing.enabled)
+		return;
+
+	unsigned long long now = timingNow();
+	timing.current.phases[phase] += now - timing.phaseStart;
+	timing.phaseStart = now;
+}
+
+// POMIAR JEDNEGO KROKU FIZYKI - od konstruktora do konca zasiegu (dziala tez przy continue i break)
+struct StepTimer {
+	FrameTiming& timing;
+	unsigned long long start;
+
+	explicit StepTimer(FrameTiming& frameTiming) : timing(frameTiming), start(frameTiming.enabled ? timingNow() : 0)
+	{
+	}
+
+	~StepTimer()
+	{
+		if (timing.enabled)
+		{
+			recordHistogram(timing.stepHistogram, timingNow() - start);
+		}
+	}
+};
+
+void initFrameTiming(FrameTiming& timing, unsigned int windowSize, unsigned int recordCapacity, double budgetSeconds = 0.0);
+void freeFrameTiming(FrameTiming& timing);
+bool endFrame(FrameTiming& timing, unsigned int steps); // zwraca true, jesli klatka przekroczyla budget
+void setFrameGpu(FrameTiming& timing, unsigned long long frame, const unsigned long long gpu[GPU_RANGE_COUNT]);
+PhaseWindowStats phaseWindowStats(const FrameTiming& timing, int phase); // phase == PHASE_COUNT - cala klatka
+PhaseWindowStats gpuWindowStats(const FrameTiming& timing, int range);
+unsigned long long recordedFrames(const FrameTiming& timing);
+const FrameRecord& recordedFrame(const FrameTiming& timing, unsigned long long index); // 0 - najstarsza zachowana
+double timingOverhead(const FrameTiming& timing);
+bool writeFrameTiming(const FrameTiming& timing, const char* path); // .json - JSON, inaczej CSV
+void printFrameTiming(const FrameTiming& timing);
+void printFrameRecord(const FrameRecord& record);
+void formatPercentiles(const FrameTiming& timing, char* text, unsigned int size);
+
+#endif /* __FRAMETIMING_H__ */
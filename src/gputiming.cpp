@@ -0,0 +1,105 @@
+#include "gputiming.h"
+
+/*------------------------------------------------------------------------------------------
+** funkcja tworzaca zapytania czasowe GPU
+** funkcja zwraca false jesli sterownik nie ma licznika GL_TIMESTAMP (pomiar GPU jest wtedy
+** wylaczony, a gpuMark() nic nie robi)
+**------------------------------------------------------------------------------------------*/
+bool initGpuTiming(GpuTiming& timing)
+{
+	timing.enabled = false;
+	timing.slot = 0;
+	timing.read = 0;
+	timing.lost = 0;
+
+	// zapytania czasowe sa w rdzeniu OpenGL 3.3 (ARB_timer_query); llvmpipe tez je ma
+	if (!GLEW_VERSION_3_3 && !GLEW_ARB_timer_query)
+		return false;
+
+	GLint bits = 0;
+	glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+	if (bits == 0)
+		return false;
+
+	glGenQueries(gpuTimingFrames * gpuTimingMarks, &timing.queries[0][0]);
+	for (unsigned int i = 0; i < gpuTimingFrames; i++)
+	{
+		timing.frames[i] = 0;
+		timing.pending[i] = false;
+	}
+
+	timing.enabled = true;
+
+	return true;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja usuwajaca zapytania czasowe GPU
+**------------------------------------------------------------------------------------------*/
+void freeGpuTiming(GpuTiming& timing)
+{
+	if (!timing.enabled)
+		return;
+
+	glDeleteQueries(gpuTimingFrames * gpuTimingMarks, &timing.queries[0][0]);
+	timing.enabled = false;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja odczytujaca gotowe wyniki starszych klatek (od najstarszej) i dopisujaca je
+** do pomiaru klatek; wynik jeszcze niegotowy zostaje w pierscieniu do nastepnej klatki
+**------------------------------------------------------------------------------------------*/
+void collectGpuTiming(GpuTiming& timing, FrameTiming& frames)
+{
+	if (!timing.enabled)
+		return;
+
+	for (unsigned int n = 1; n <= gpuTimingFrames; n++)
+	{
+		unsigned int slot = (timing.slot + n) % gpuTimingFrames;
+		if (!timing.pending[slot])
+			continue;
+
+		// ostatni znacznik jest gotowy tylko wtedy, gdy gotowe sa wszystkie wczesniejsze
+		GLuint available = 0;
+		glGetQueryObjectuiv(timing.queries[slot][GPU_RANGE_COUNT], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			break;
+
+		GLuint64 stamps[gpuTimingMarks];
+		for (unsigned int m = 0; m < gpuTimingMarks; m++)
+		{
+			glGetQueryObjectui64v(timing.queries[slot][m], GL_QUERY_RESULT, &stamps[m]);
+		}
+
+		unsigned long long gpu[GPU_RANGE_COUNT];
+		for (unsigned int r = 0; r < GPU_RANGE_COUNT; r++)
+		{
+			gpu[r] = stamps[r + 1] > stamps[r] ? stamps[r + 1] - stamps[r] : 0;
+		}
+
+		setFrameGpu(frames, timing.frames[slot], gpu);
+		timing.pending[slot] = false;
+		timing.read++;
+	}
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja wybierajaca komplet zapytan dla biezacej klatki (przed pierwszym gpuMark())
+**------------------------------------------------------------------------------------------*/
+void beginGpuFrame(GpuTiming& timing, FrameTiming& frames)
+{
+	if (!timing.enabled)
+		return;
+
+	collectGpuTiming(timing, frames);
+
+	timing.slot = (timing.slot + 1) % gpuTimingFrames;
+	if (timing.pending[timing.slot])
+	{
+		timing.lost++; // GPU spoznia sie o caly pierscien - wynik tej klatki przepada
+	}
+
+	timing.frames[timing.slot] = frames.frames;
+	timing.pending[timing.slot] = true;
+}
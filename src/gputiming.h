@@ -0,0 +1,40 @@
+#ifndef __GPUTIMING_H__
+#define __GPUTIMING_H__
+
+#include <GL/glew.h>
+
+#include "frametiming.h"
+
+constexpr unsigned int gpuTimingFrames = 4; // klatki w pierscieniu zapytan (wynik czytany najwczesniej po tylu klatkach)
+constexpr unsigned int gpuTimingMarks = GPU_RANGE_COUNT + 1; // znaczniki czasu na poczatku kazdego odcinka i na koncu ostatniego
+
+// ZAPYTANIA CZASOWE GPU (GL_TIMESTAMP) - kazda klatka dostaje swoj komplet zapytan z pierscienia,
+// wyniki odczytywane sa dopiero gdy GL_QUERY_RESULT_AVAILABLE, wiec pomiar nigdy nie czeka na GPU
+struct GpuTiming {
+	bool enabled;
+	GLuint queries[gpuTimingFrames][gpuTimingMarks];
+	unsigned long long frames[gpuTimingFrames]; // numer klatki, w ktorej wyslano komplet
+	bool pending[gpuTimingFrames]; // komplet wyslany, wynik jeszcze nieodczytany
+	unsigned int slot; // komplet biezacej klatki
+	unsigned long long read; // odczytane klatki
+	unsigned long long lost; // komplety nadpisane przed dotarciem wyniku
+};
+
+bool initGpuTiming(GpuTiming& timing);
+void freeGpuTiming(GpuTiming& timing);
+void beginGpuFrame(GpuTiming& timing, FrameTiming& frames);
+void collectGpuTiming(GpuTiming& timing, FrameTiming& frames);
+
+/*------------------------------------------------------------------------------------------
+** funkcja zapisujaca znacznik czasu GPU na poczatku odcinka range
+** (range == GPU_RANGE_COUNT - koniec ostatniego odcinka)
+**------------------------------------------------------------------------------------------*/
+inline void gpuMark(GpuTiming& timing, int range)
+{
+	if (!timing.enabled)
+		return;
+
+	glQueryCounter(timing.queries[timing.slot][range], GL_TIMESTAMP);
+}
+
+#endif /* __GPUTIMING_H__ */
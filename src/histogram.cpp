@@ -0,0 +1,109 @@
+#include <cstring>
+
+#include "histogram.h"
+
+/*------------------------------------------------------------------------------------------
+** funkcja przydzielajaca pamiec histogramu
+**------------------------------------------------------------------------------------------*/
+void initHistogram(TimeHistogram& histogram)
+{
+	histogram.counts = new unsigned long long[histogramBuckets];
+
+	clearHistogram(histogram);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwalniajaca pamiec histogramu
+**------------------------------------------------------------------------------------------*/
+void freeHistogram(TimeHistogram& histogram)
+{
+	delete[] histogram.counts;
+
+	histogram.counts = nullptr;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zerujaca histogram
+**------------------------------------------------------------------------------------------*/
+void clearHistogram(TimeHistogram& histogram)
+{
+	memset(histogram.counts, 0, histogramBuckets * sizeof(unsigned long long));
+	histogram.count = 0;
+	histogram.sum = 0;
+	histogram.min = ~0ull;
+	histogram.max = 0;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwracajaca najmniejszy czas w kubelku
+**------------------------------------------------------------------------------------------*/
+unsigned long long histogramBucketLow(unsigned int bucket)
+{
+	const unsigned int exact = 1u << histogramSubBits;
+	if (bucket < exact)
+		return bucket;
+
+	unsigned int shift = (bucket >> histogramSubBits) - 1;
+	unsigned long long sub = bucket & (exact - 1);
+
+	return (exact + sub) << shift;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwracajaca najwiekszy czas w kubelku
+**------------------------------------------------------------------------------------------*/
+unsigned long long histogramBucketHigh(unsigned int bucket)
+{
+	if (bucket < (1u << histogramSubBits))
+		return bucket;
+
+	unsigned int shift = (bucket >> histogramSubBits) - 1;
+
+	return histogramBucketLow(bucket) + (1ull << shift) - 1;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwracajaca percentyl czasu (gorna granice kubelka, w ktorym wypada, ale nie
+** wiecej niz najwiekszy zapisany czas)
+** fraction - np. 0.5, 0.99, 0.999
+**------------------------------------------------------------------------------------------*/
+unsigned long long histogramPercentile(const TimeHistogram& histogram, double fraction)
+{
+	if (!histogram.count)
+		return 0;
+
+	unsigned long long rank = (unsigned long long)(fraction * histogram.count + 0.5);
+	if (rank < 1)
+		rank = 1;
+
+	unsigned long long seen = 0;
+	for (unsigned int b = 0; b < histogramBuckets; b++)
+	{
+		seen += histogram.counts[b];
+		if (seen >= rank)
+		{
+			unsigned long long high = histogramBucketHigh(b);
+			return high < histogram.max ? high : histogram.max;
+		}
+	}
+
+	return histogram.max;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja dodajaca histogram part do total (np. do porownania kilku sesji)
+**------------------------------------------------------------------------------------------*/
+void mergeHistogram(TimeHistogram& total, const TimeHistogram& part)
+{
+	for (unsigned int b = 0; b < histogramBuckets; b++)
+	{
+		total.counts[b] += part.counts[b];
+	}
+
+	total.count += part.count;
+	total.sum += part.sum;
+	if (part.min < total.min)
+		total.min = part.min;
+	if (part.max > total.max)
+		total.max = part.max;
+}
@@ -0,0 +1,63 @@
+#ifndef __HISTOGRAM_H__
+#define __HISTOGRAM_H__
+
+constexpr unsigned int histogramSubBits = 7; // 128 kubelkow na kazda potege dwojki - blad wzgledny ponizej 0.8%
+constexpr unsigned int histogramMaxBits = 40; // najwiekszy rozrozniany czas: 2^40 ns (ok. 18 minut)
+constexpr unsigned int histogramBuckets = (histogramMaxBits - histogramSubBits + 1) << histogramSubBits;
+
+// HISTOGRAM CZASOW O STALEJ DOKLADNOSCI WZGLEDNEJ (jak HdrHistogram) - czasy ponizej 128 ns
+// maja kubelek na kazda nanosekunde, dluzsze po 128 kubelkow na kazda potege dwojki;
+// zapis to kilka przesuniec bitowych i inkrementacja, bez przydzielania pamieci
+struct TimeHistogram {
+	unsigned long long* counts; // histogramBuckets licznikow
+	unsigned long long count;
+	unsigned long long sum; // w nanosekundach
+	unsigned long long min;
+	unsigned long long max;
+};
+
+void initHistogram(TimeHistogram& histogram);
+void freeHistogram(TimeHistogram& histogram);
+void clearHistogram(TimeHistogram& histogram);
+unsigned long long histogramBucketLow(unsigned int bucket);
+unsigned long long histogramBucketHigh(unsigned int bucket);
+unsigned long long histogramPercentile(const TimeHistogram& histogram, double fraction);
+void mergeHistogram(TimeHistogram& total, const TimeHistogram& part);
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwracajaca kubelek czasu value (w nanosekundach); czasy od 2^histogramMaxBits
+** trafiaja do ostatniego kubelka
+**------------------------------------------------------------------------------------------*/
+inline unsigned int histogramBucket(unsigned long long value)
+{
+	const unsigned long long exact = 1ull << histogramSubBits;
+	if (value < exact)
+		return (unsigned int)value;
+
+	unsigned int shift = 0;
+	while ((value >> shift) >= 2 * exact)
+	{
+		shift++;
+	}
+
+	unsigned long long bucket = ((unsigned long long)(shift + 1) << histogramSubBits) + ((value >> shift) - exact);
+
+	return bucket < histogramBuckets ? (unsigned int)bucket : histogramBuckets - 1;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja dopisujaca czas do histogramu
+** value - czas w nanosekundach
+**------------------------------------------------------------------------------------------*/
+inline void recordHistogram(TimeHistogram& histogram, unsigned long long value)
+{
+	histogram.counts[histogramBucket(value)]++;
+	histogram.count++;
+	histogram.sum += value;
+	if (value < histogram.min)
+		histogram.min = value;
+	if (value > histogram.max)
+		histogram.max = value;
+}
+
+#endif /* __HISTOGRAM_H__ */
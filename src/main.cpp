@@ -3,29 +3,20 @@
 #include <iostream>
 #include <vector>
 #include <array>
+#include <string>
 #include <stdlib.h>     
 #include <time.h> 
 
 #include "shaders.h"
-
-constexpr int WIN_WIDTH = 800; // SZEROKO OKNA
-constexpr int WIN_HEIGHT = 600; // WYSOKO OKNA
-
-// DEKLARACJA STRUKTURY WEKTORA DWUWYMIAROWEGO
-struct vec2 {
-	float x;
-	float y;
-};
-
-// ZMIENNE OKRELAJCE STAE WACIWOCI OBIEKTW
-const float racketsSpeed = 300.0f; // SZYKBO PORUSZANIA SI RAKIETEK
-const float racketsHeight = 75.0f; // WYSOKO RAKIETEK
-const float halfRacketsHeight = racketsHeight / 2.0f; // POOWA WYSOKOCI RAKIETEK
-const float racketsWidth = 10.0f; // SZEROKOC RAKIETEK
-const float halfRacketsWidth = racketsWidth / 2.0f; // POOWA SZEROKOCI RAKIETEK
-const float ballDiameter = 5.0f; // EDNICA PIECZKI
-const float ballRadius = 2.5f; // PROMIE PIECZKI
-const float racketLimit = halfRacketsHeight + ballRadius; // GRANICA PRZESUWANIA SI RAKIETEK DO GRY I W Dӣ EKRANU
+#include "sim.h"
+#include "fixed.h"
+#include "replay.h"
+#include "snapshot.h"
+#include "rollback.h"
+#include "netclient.h"
+#include "frametiming.h"
+#include "gputiming.h"
+#include "trace.h"
 
 // TABLICA WIERZCHOKW RAKIETEK
 float verticesForRackets[] =
@@ -43,13 +34,6 @@ unsigned int indicesForRackets[] =
 	2, 3, 0
 };
 
-// TABLICA POZYCJI RAKIETEK
-vec2 offsetsForRackets[] =
-{
-	20.0f, WIN_HEIGHT / 2.0f,
-	WIN_WIDTH - 20.0f, WIN_HEIGHT / 2.0f
-};
-
 // TABLICA WYMIARW RAKIETEK
 vec2 sizesForRackets = { racketsWidth, racketsHeight };
 
@@ -59,17 +43,62 @@ unsigned int* indicesForBall;
 
 unsigned int numOfTraingles = 20; // LICZBA TRJKTW TWORZCYCH PIECZK
 
-vec2 offsetsForBall = { WIN_WIDTH / 2.0f, WIN_HEIGHT / 2.0f }; // POZYCJA PIECZKI
-
 vec2 sizesForBall = { ballDiameter, ballDiameter }; //WYMIARY PIECZKI
 
-// PRDKO PIECZKI ORAZ RAKIETEK
-vec2 velocityForBall;
-float velocityForRackets[2];
-
-// PUNKTY 
-unsigned int scoreForLeft = 0;
-unsigned int scoreForRight = 0;
+// STAN MECZU (POZYCJE, PRDKOCI, PUNKTY) - LOGIKA GRY W sim.cpp
+World world;
+World previousWorld; // stan z poprzedniego kroku - do interpolacji przy rysowaniu
+
+// TRYB STAOPRZECINKOWY (opcja --fixed) - ten sam wynik na kadym kompilatorze i procesorze
+bool fixedMode = false;
+FixedWorld fixedWorld; // stan meczu w trybie staoprzecinkowym; world jest wtedy tylko jego kopi do rysowania
+
+// POWTRKI (opcje --record i --play)
+const char* recordPath = nullptr; // plik, do ktrego zapisywany jest mecz
+const char* playPath = nullptr; // plik odtwarzanej powtrki - klawisze brane s z pliku zamiast z klawiatury
+unsigned long long playFromTick = 0; // krok, od ktrego zaczyna si odtwarzanie (opcja --seek)
+ReplayWriter recorder;
+ReplayReader player;
+
+// HISTORIA DO COFANIA (BACKSPACE) - migawki z ostatnich krokw, bez przydzielania pamici w trakcie gry
+const unsigned int historyTicks = 1200;
+SnapshotRing history;
+
+// GRA SIECIOWA Z COFANIEM (opcje --peer, --port, --side, --seed, --input-delay, --shim-rtt, --shim-loss)
+const char* peerAddress = nullptr; // HOST:PORT drugiego gracza; nullptr - gra na jednej klawiaturze
+unsigned short localPort = 7777;
+int localSide = 0; // 0 - lewa rakietka, 1 - prawa
+unsigned int netSeed = 1; // ziarno meczu - obaj gracze musz poda to samo
+unsigned int inputDelay = 0;
+double shimRtt = 0.0; // sztuczne opnienie i straty do testw (0 - bez symulatora)
+double shimLoss = 0.0;
+UdpLink udp;
+NetShim shim;
+RollbackSession session;
+
+// GRA NA SERWERZE MECZW Z PRZEWIDYWANIEM WASNEJ RAKIETKI (opcja --server; --shim-rtt i --shim-loss dziaaj tak samo)
+const char* serverAddress = nullptr; // HOST:PORT serwera (pong_server serve); nullptr - bez serwera
+ServerConnection connection;
+
+// STAY KROK FIZYKI
+double tickRate = 120.0; // liczba krokw fizyki na sekund (opcja --tick-rate)
+const int maxStepsPerFrame = 8; // limit krokw na klatk - po duszej przerwie zalegy czas jest porzucany
+
+// POMIAR CZASW FAZ KLATKI (opcje --timing, --timing-window, --timing-frames, --frame-budget)
+const char* timingPath = nullptr; // plik CSV lub JSON z czasami klatek; nullptr - bez pomiaru
+unsigned int timingWindow = 600; // liczba klatek ruchomego okna (co tyle klatek wypisywane s rednie)
+unsigned int timingFrames = 36000; // liczba ostatnich klatek zapisywanych do pliku
+double frameBudget = 0.0; // limit czasu klatki w sekundach - dusze klatki s wypisywane z rozkadem faz (0 - 1.5 okresu odwieania)
+FrameTiming frameTiming;
+GpuTiming gpuTiming; // czasy wysyania pozycji i rysowania na GPU (razem z --timing, jeli sterownik ma GL_TIMESTAMP)
+
+// LEDZENIE STREF DO PODGLDU W chrome://tracing LUB ui.perfetto.dev (opcje --trace, --trace-events; tylko z PONG_TRACE)
+const char* tracePath = nullptr; // plik JSON ze strefami; nullptr - bez ledzenia
+unsigned int traceEvents = 262144; // pojemno bufora stref na wtek
+
+// POZYCJE DO NARYSOWANIA (INTERPOLOWANE MIDZY DWOMA OSTATNIMI KROKAMI)
+vec2 renderBall;
+vec2 renderRackets[2];
 
 //******************************************************************************************
 GLuint shaderProgram; // identyfikator programu cieniowania
@@ -89,19 +118,46 @@ void setupShaders();
 void setupBuffers();
 void renderScene();
 void setOrthographicProjection(int shaderProgram, float left, float right, float bottom, float top, float near, float far);
-void processInput(GLFWwindow* window, double dt);
+Inputs processInput(GLFWwindow* window);
 void generateCircleArray(float*& vertices, unsigned int*& indices, unsigned int numOfTriangles, float radius);
 void displayScore();
-void ballDirection(unsigned int direction, float x, float yMin, float yMax);
+void parseArguments(int argc, char* argv[]);
 
 int main(int argc, char* argv[])
 {
 	// wartoci potrzebene do oblicze czasu midzy klatkami
-	double dt = 0.0;
+	double frameTime = 0.0;
 	double lastFrame = 0.0;
+	double accumulator = 0.0; // czas, ktry jeszcze nie zosta zasymulowany
+
+	parseArguments(argc, argv);
+
+	if (tracePath)
+	{
+		if (startTrace(traceEvents))
+		{
+			TRACE_THREAD("main");
+		}
+		else
+		{
+			std::cerr << "Sledzenie niedostepne - zbuduj z PONG_TRACE" << std::endl;
+			tracePath = nullptr;
+		}
+	}
+
+	double tickDt = 1.0 / tickRate;
+
+	// powtrka narzuca dugo kroku i rodzaj fizyki, z ktrymi bya nagrana
+	if (playPath)
+	{
+		if (!openReplay(player, playPath))
+			exit(EXIT_FAILURE);
+
+		tickDt = player.header->tickSeconds;
+		fixedMode = (player.header->flags & REPLAY_FIXED) != 0;
+	}
 
-	int framesWhenLastCollision = -1; // ile klatek temu wystpia poprzednia kolizja
-	int framesToWaitForNextColision = 10; // ile klatek naley odczeka midzy kolizjami
+	const fixed_t fixedTickDt = secondsToFixed(tickDt);
 
 	GLFWwindow* window;
 
@@ -145,121 +201,367 @@ int main(int argc, char* argv[])
 
 	setOrthographicProjection(shaderProgram, 0, WIN_WIDTH, 0, WIN_HEIGHT, 0.0f, 1.0f);
 
-	srand(time(NULL));
-	ballDirection(0, 200.0f, -200.0f, 200.0f);
+	unsigned int seed = (unsigned int)time(NULL);
 
-	displayScore();
-
-	// glowna petla programu
-	while( !glfwWindowShouldClose( window ) )
+	if (peerAddress)
 	{
-		dt = glfwGetTime() - lastFrame;
-		lastFrame += dt;
+		std::string peer = peerAddress;
+		size_t colon = peer.rfind(':');
+		if (colon == std::string::npos || !openUdpLink(udp, localPort, peer.substr(0, colon).c_str(), (unsigned short)atoi(peer.c_str() + colon + 1)))
+		{
+			std::cerr << "Niepoprawny adres drugiego gracza: " << peer << std::endl;
+			exit(EXIT_FAILURE);
+		}
 
-		unsigned int reset = 0; // zmienna inforumjca, kto zdoby punkt 
+		NetLink link = udpNetLink(udp);
+		if (shimRtt > 0.0 || shimLoss > 0.0)
+		{
+			initShim(shim, link, shimRtt / 2.0, 0.0, shimLoss, seed);
+			link = shimNetLink(shim);
+		}
 
-		if (framesWhenLastCollision != -1) {
-			framesWhenLastCollision++;
+		// gra sieciowa zawsze w liczbach staoprzecinkowych - ten sam wynik u obu graczy
+		fixedMode = true;
+		seed = netSeed;
+		recordPath = nullptr;
+		playPath = nullptr;
+		initRollbackSession(session, link, localSide, seed, fixedTickDt, inputDelay);
+	}
+	else if (serverAddress)
+	{
+		std::string server = serverAddress;
+		size_t colon = server.rfind(':');
+		if (colon == std::string::npos || !openUdpLink(udp, 0, server.substr(0, colon).c_str(), (unsigned short)atoi(server.c_str() + colon + 1)))
+		{
+			std::cerr << "Niepoprawny adres serwera: " << server << std::endl;
+			exit(EXIT_FAILURE);
 		}
 
-		// Sterowanie
-		processInput(window, dt);
+		NetLink link = udpNetLink(udp);
+		if (shimRtt > 0.0 || shimLoss > 0.0)
+		{
+			initShim(shim, link, shimRtt / 2.0, 0.0, shimLoss, seed);
+			link = shimNetLink(shim);
+		}
 
-		//SPRAWDZANIE KOLIZJI PIECZKI Z GR I DOEM OKNA
-		if (offsetsForBall.y - ballRadius <= 0 || offsetsForBall.y + ballRadius >= WIN_HEIGHT)
+		// stan meczu przychodzi z serwera - bez powtrek i trybu staoprzecinkowego
+		fixedMode = false;
+		recordPath = nullptr;
+		playPath = nullptr;
+		initServerConnection(connection, link, seed);
+	}
+
+	initWorld(world, seed);
+	if (fixedMode)
+	{
+		initFixedWorld(fixedWorld, seed);
+		fixedToWorld(fixedWorld, world);
+	}
+
+	if (playPath)
+	{
+		bool restored = fixedMode ? seekReplay(player, playFromTick, fixedWorld) : seekReplay(player, playFromTick, world);
+		if (!restored)
+		{
+			std::cerr << "Nie mozna przewinac powtorki do kroku " << playFromTick << std::endl;
+			exit(EXIT_FAILURE);
+		}
+		if (fixedMode)
 		{
-			velocityForBall.y *= -1;
+			fixedToWorld(fixedWorld, world);
 		}
+	}
+	else if (recordPath)
+	{
+		if (!openReplayWriter(recorder, recordPath, seed, tickDt, fixedMode ? REPLAY_FIXED : 0))
+			exit(EXIT_FAILURE);
+	}
+	previousWorld = world;
+
+	initSnapshotRing(history, historyTicks, fixedMode ? sizeof(FixedWorld) : sizeof(World));
 
-		// SPRAWDZANIE KOLIZJI PIECZKI Z LEW CIAN
-		if (offsetsForBall.x - ballRadius <= 0) {
-			scoreForRight++;
-			reset = 1;
+	displayScore();
+
+	if (timingPath)
+	{
+		if (frameBudget <= 0.0)
+		{
+			const GLFWvidmode* mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+			frameBudget = 1.5 / (mode && mode->refreshRate > 0 ? mode->refreshRate : 60);
 		}
 
-		// SPRAWDZANIE KOLIZJI PIECZKI Z PRAW
-		else if (offsetsForBall.x + ballRadius >= WIN_WIDTH) {
-			scoreForLeft++;
-			reset = 2;
+		initFrameTiming(frameTiming, timingWindow, timingFrames, frameBudget);
+		if (!initGpuTiming(gpuTiming))
+		{
+			std::cout << "Brak zapytan czasowych GPU - mierzony tylko czas CPU" << std::endl;
 		}
+	}
 
-		// RESET POZYCJI I KIERUNKU RUCHU PIECZKI PO ZDOBYCIU PUNKTU
-		if (reset) {
-			offsetsForBall.x = WIN_WIDTH / 2.0f;
-			offsetsForBall.y = WIN_HEIGHT / 2.0f;
+	// glowna petla programu
+	while( !glfwWindowShouldClose( window ) )
+	{
+		TRACE_ZONE("frame");
+		beginFrame(frameTiming);
+		beginGpuFrame(gpuTiming, frameTiming);
 
-			ballDirection(reset, 200.0f, -200.0f, 200.0f);
+		frameTime = glfwGetTime() - lastFrame;
+		lastFrame += frameTime;
+		accumulator += frameTime;
 
-			displayScore();
-		}
+		// Sterowanie
+		Inputs inputs = processInput(window);
+		bool rewinding = !recordPath && !peerAddress && !serverAddress && glfwGetKey(window, GLFW_KEY_BACKSPACE) == GLFW_PRESS; // nagrywany mecz nie moe si cofa
+		markPhase(frameTiming, PHASE_INPUT);
 
-		/*-----------------------------------------
-		SPRAWDZANIE KOLIZJI PIECZKI Z RAKIETKAMI
-		------------------------------------------*/
-		if (framesWhenLastCollision >= framesToWaitForNextColision || framesWhenLastCollision == -1) 
+		// KROKI SYMULACJI O STAEJ DUGOCI - KOLIZJE, PUNKTY I RUCH OBIEKTW
+		int steps = 0;
+		while (accumulator >= tickDt && steps < maxStepsPerFrame)
 		{
-			// SPRAWDZENIE CZY PIECZKA JEST PO LEWEJ CZY PRAWEJ STRONIE EKRANU
-			int i = 0;
-			if (offsetsForBall.x > WIN_HEIGHT / 2.0f)
+			TRACE_ZONE("tick");
+			StepTimer stepTimer(frameTiming);
+
+			// GRA SIECIOWA - klawisze drugiego gracza przewidywane, poprawiane cofniciem
+			if (peerAddress)
 			{
-				i++;
-			}
+				if (shimRtt > 0.0 || shimLoss > 0.0)
+				{
+					pumpShim(shim, glfwGetTime());
+				}
+
+				bool up = (inputs.keys & (INPUT_LEFT_UP | INPUT_RIGHT_UP)) != 0;
+				bool down = (inputs.keys & (INPUT_LEFT_DOWN | INPUT_RIGHT_DOWN)) != 0;
 
-			// DYSTANS MIDZY PIECZK A RAKIETK
-			vec2 distance = { std::abs(offsetsForBall.x - offsetsForRackets[i].x), std::abs(offsetsForBall.y - offsetsForRackets[i].y) };
+				previousWorld = world;
+				advanceRollbackSession(session, sideKeys(localSide, up, down));
+				fixedToWorld(session.world, world);
 
-			// SPRAWDZENIE CZY KOLIZJA WYSTPUJE
-			if (distance.x <= halfRacketsWidth + ballRadius && distance.y <= halfRacketsHeight + ballRadius)
+				if (world.scoreForLeft != previousWorld.scoreForLeft || world.scoreForRight != previousWorld.scoreForRight)
+				{
+					displayScore();
+				}
+
+				accumulator -= tickDt;
+				steps++;
+				continue;
+			}
+
+			// GRA NA SERWERZE - wasna rakietka od razu, stan serwera poprawia przewidywanie
+			if (serverAddress)
 			{
-				bool collision = false;
-				// SPRAWDZENIE CZY KOLIZJA WYSTPUJE Z WYSOKOCI RAKIETKI
-				if (distance.x <= halfRacketsWidth && distance.x >= (halfRacketsWidth - ballRadius))
+				if (shimRtt > 0.0 || shimLoss > 0.0)
 				{
-					collision = true;
-					velocityForBall.x *= -1;
+					pumpShim(shim, glfwGetTime());
 				}
-				// SPRAWDZENIE CZY KOLIZJA WYSTPUJE Z SZEROKOCI RAKIETKI
-				else if (distance.y <= halfRacketsHeight && distance.y >= (halfRacketsHeight - ballRadius))
+
+				pollServerConnection(connection, glfwGetTime());
+				if (connection.phase == CONNECTION_PLAYING)
 				{
-					collision = true;
-					velocityForBall.y *= -1;
+					tickDt = connection.prediction.dt; // rytm krokw serwera
 				}
 
-				if (collision)
+				bool up = (inputs.keys & (INPUT_LEFT_UP | INPUT_RIGHT_UP)) != 0;
+				bool down = (inputs.keys & (INPUT_LEFT_DOWN | INPUT_RIGHT_DOWN)) != 0;
+
+				previousWorld = world;
+				advanceServerConnection(connection, up, down);
+				if (connection.prediction.synced)
 				{
-					velocityForBall.x *= 1.01f;
-					// ZRESESTOWANIE OSTATNIEJ KLATKI Z KOLIZJ
-					framesWhenLastCollision = 0;
+					world = connection.prediction.world;
 				}
+
+				if (world.scoreForLeft != previousWorld.scoreForLeft || world.scoreForRight != previousWorld.scoreForRight)
+				{
+					displayScore();
+				}
+
+				accumulator -= tickDt;
+				steps++;
+				continue;
+			}
+
+			// COFANIE - poprzedni krok z historii
+			if (rewinding)
+			{
+				previousWorld = world;
+
+				bool restored = world.tick > 0 && (fixedMode ? restoreSnapshot(history, world.tick - 1, fixedWorld) : restoreSnapshot(history, world.tick - 1, world));
+				if (!restored)
+				{
+					accumulator = 0.0;
+					break;
+				}
+				if (fixedMode)
+				{
+					fixedToWorld(fixedWorld, world);
+				}
+				if (world.scoreForLeft != previousWorld.scoreForLeft || world.scoreForRight != previousWorld.scoreForRight)
+				{
+					displayScore();
+				}
+
+				accumulator -= tickDt;
+				steps++;
+				continue;
+			}
+
+			// koniec powtrki - obraz zatrzymuje si na ostatnim stanie
+			if (playPath && world.tick >= replayTickCount(player))
+			{
+				previousWorld = world;
+				accumulator = 0.0;
+				break;
+			}
+
+			if (playPath)
+			{
+				inputs.keys = replayKeys(player, world.tick);
+			}
+			else if (recordPath)
+			{
+				if (fixedMode)
+					recordTick(recorder, fixedWorld, inputs.keys);
+				else
+					recordTick(recorder, world, inputs.keys);
 			}
+
+			if (fixedMode)
+				saveSnapshot(history, fixedWorld);
+			else
+				saveSnapshot(history, world);
+
+			previousWorld = world;
+
+			unsigned int scored;
+			if (fixedMode)
+			{
+				scored = stepFixed(fixedWorld, inputs, fixedTickDt);
+				fixedToWorld(fixedWorld, world);
+			}
+			else
+			{
+				scored = step(world, inputs, (float)tickDt);
+			}
+
+			if (scored)
+			{
+				displayScore();
+			}
+
+			accumulator -= tickDt;
+			steps++;
 		}
-		// AKTUALIZOWANIE POZYCJI RAKIETEK
-		offsetsForRackets[0].y += velocityForRackets[0] * dt;
-		offsetsForRackets[1].y += velocityForRackets[1] * dt;
 
-		// AKTUALIZOWANIE POZYCJI PIKI 
-		offsetsForBall.x += velocityForBall.x * dt;
-		offsetsForBall.y += velocityForBall.y * dt;
+		// po przyciciu (np. przeciganie okna) gra zwalnia zamiast nadrabia kolejnymi krokami
+		if (accumulator >= tickDt)
+		{
+			accumulator = 0.0;
+		}
+
+		// POZYCJE MIDZY DWOMA OSTATNIMI KROKAMI
+		interpolatePositions(previousWorld, world, (float)(accumulator / tickDt), renderBall, renderRackets);
+		markPhase(frameTiming, PHASE_PHYSICS);
 
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT); // czyszczenie bufora koloru
+		markPhase(frameTiming, PHASE_RENDER);
+
+		{
+			TRACE_ZONE("upload");
+			gpuMark(gpuTiming, GPU_UPLOAD);
 
-		// AKTUALIZOWANIE POZYCJI PIKI W GPU
-		glBindBuffer(GL_ARRAY_BUFFER, buffers[1]);
-		glBufferSubData(GL_ARRAY_BUFFER, 0, 1 * sizeof(vec2), &offsetsForBall);
+			// AKTUALIZOWANIE POZYCJI PIKI W GPU
+			glBindBuffer(GL_ARRAY_BUFFER, buffers[1]);
+			glBufferSubData(GL_ARRAY_BUFFER, 0, 1 * sizeof(vec2), &renderBall);
 
-		// AKTUALIZOWANIE POZYCJI RAKIETEK W GPU
-		glBindBuffer(GL_ARRAY_BUFFER, buffers[4]);
-		glBufferSubData(GL_ARRAY_BUFFER, 0, 2 * sizeof(vec2), offsetsForRackets);
+			// AKTUALIZOWANIE POZYCJI RAKIETEK W GPU
+			glBindBuffer(GL_ARRAY_BUFFER, buffers[4]);
+			glBufferSubData(GL_ARRAY_BUFFER, 0, 2 * sizeof(vec2), renderRackets);
+		}
+		markPhase(frameTiming, PHASE_UPLOAD);
 
 		renderScene();
+		markPhase(frameTiming, PHASE_RENDER);
+
+		{
+			TRACE_ZONE("glfwSwapBuffers");
+			glfwSwapBuffers( window ); // zamieniamy bufory
+		}
+		markPhase(frameTiming, PHASE_SWAP);
+		{
+			TRACE_ZONE("glfwPollEvents");
+			glfwPollEvents(); // przetwarzanie zdarzen
+		}
+		markPhase(frameTiming, PHASE_EVENTS);
 
-		glfwSwapBuffers( window ); // zamieniamy bufory
-		glfwPollEvents(); // przetwarzanie zdarzen
+		// KLATKA PONAD LIMITEM - rozkad faz, eby byo wida, co j wyduyo
+		if (endFrame(frameTiming, steps))
+		{
+			printFrameRecord(frameTiming.current);
+		}
+		if (frameTiming.enabled && frameTiming.frames % frameTiming.windowSize == 0)
+		{
+			printFrameTiming(frameTiming);
+
+			// percentyle na bieco w tytule okna
+			char title[256] = "Pong - ";
+			formatPercentiles(frameTiming, title + 7, sizeof(title) - 7);
+			glfwSetWindowTitle(window, title);
+		}
+	}
+
+	if (timingPath)
+	{
+		collectGpuTiming(gpuTiming, frameTiming); // wyniki, ktore zdazyly dotrzec - bez czekania na GPU
+		if (!writeFrameTiming(frameTiming, timingPath))
+		{
+			std::cerr << "Blad zapisu czasow klatek: " << timingPath << std::endl;
+		}
+		std::cout << "Narzut pomiaru czasow: " << timingOverhead(frameTiming) * 100.0 << "% czasu klatek" << std::endl;
+
+		char percentiles[256];
+		formatPercentiles(frameTiming, percentiles, sizeof(percentiles));
+		std::cout << percentiles << std::endl;
+		if (gpuTiming.enabled)
+		{
+			std::cout << "Klatki z czasem GPU: " << gpuTiming.read << ", utracone: " << gpuTiming.lost << std::endl;
+			freeGpuTiming(gpuTiming);
+		}
+		freeFrameTiming(frameTiming);
+	}
+
+	if (tracePath)
+	{
+		if (!writeTrace(tracePath))
+		{
+			std::cerr << "Blad zapisu sladu: " << tracePath << std::endl;
+		}
+		stopTrace();
 	}
 
 	cleanup();
 
+	freeSnapshotRing(history);
+
+	if (peerAddress)
+	{
+		freeRollbackSession(session);
+		closeUdpLink(udp);
+	}
+	else if (serverAddress)
+	{
+		leaveServer(connection);
+		closeUdpLink(udp);
+	}
+
+	if (playPath)
+	{
+		closeReplay(player);
+	}
+	else if (recordPath && !closeReplayWriter(recorder))
+	{
+		std::cerr << "Blad zapisu powtorki: " << recordPath << std::endl;
+	}
+
 	glfwDestroyWindow( window ); // niszczy okno i jego kontekst
 	glfwTerminate();
 
@@ -277,73 +579,152 @@ void errorCallback( int error, const char* description )
 }
 
 /*------------------------------------------------------------------------------------------
-** funkcja zwrotna do obslugi klawiatury
-** window - okno, ktre otrzymalo zdarzenie
-** key - klawisz jaki zostal nacisniety lub zwolniony
-** scancode - scancode klawisza specyficzny dla systemu
-** action - zachowanie klawisza (GLFW_PRESS, GLFW_RELEASE or GLFW_REPEAT)
-** mods - pole bitowe zawierajace informacje o nacisnietych modyfikatorach (GLFW_MOD_SHIFT, GLFW_MOD_CONTROL, GLFW_MOD_ALT, GLFW_MOD_SUPER)
+** funkcja wczytujaca opcje z linii polecen
+** --tick-rate N - liczba krokow fizyki na sekunde (np. 120, 240, 1000)
+** --fixed - fizyka w liczbach staloprzecinkowych (deterministyczna)
+** --record PLIK - zapis meczu do pliku powtorki
+** --play PLIK - odtwarzanie powtorki zamiast gry
+** --seek N - krok, od ktorego zaczyna sie odtwarzanie
+** --peer HOST:PORT - gra sieciowa z drugim graczem (kazdy steruje swoja rakietka W/S lub strzalkami)
+** --port N - lokalny port UDP gry sieciowej
+** --side left|right - rakietka sterowana lokalnie
+** --seed N - ziarno meczu sieciowego (u obu graczy takie samo)
+** --input-delay N - opoznienie wlasnych klawiszy w krokach
+** --server HOST:PORT - gra na serwerze meczow (pong_server serve) z przewidywaniem wlasnej rakietki
+** --shim-rtt MS, --shim-loss P - sztuczne opoznienie i procent strat pakietow (testy)
+** --timing PLIK - pomiar czasow faz klatki (CPU i GPU), zapis przy wyjsciu (.json - JSON, inaczej CSV)
+** --timing-window N - liczba klatek ruchomego okna srednich czasow faz
+** --timing-frames N - liczba ostatnich klatek zapisywanych do pliku
+** --frame-budget MS - limit czasu klatki; dluzsze klatki sa wypisywane z rozkladem faz
+** --trace PLIK - zapis stref (klatki, kroki, shadery, bufory) w formacie Chrome trace-event
+** --trace-events N - pojemnosc bufora stref na watek (po zapelnieniu kolejne sa pomijane)
 **------------------------------------------------------------------------------------------*/
-void processInput(GLFWwindow* window, double dt) 
+void parseArguments(int argc, char* argv[])
 {
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::string(argv[i]) == "--fixed")
+		{
+			fixedMode = true;
+		}
+		else if (std::string(argv[i]) == "--record" && i + 1 < argc)
+		{
+			recordPath = argv[++i];
+		}
+		else if (std::string(argv[i]) == "--play" && i + 1 < argc)
+		{
+			playPath = argv[++i];
+		}
+		else if (std::string(argv[i]) == "--seek" && i + 1 < argc)
+		{
+			playFromTick = strtoull(argv[++i], nullptr, 10);
+		}
+		else if (std::string(argv[i]) == "--peer" && i + 1 < argc)
+		{
+			peerAddress = argv[++i];
+		}
+		else if (std::string(argv[i]) == "--server" && i + 1 < argc)
+		{
+			serverAddress = argv[++i];
+		}
+		else if (std::string(argv[i]) == "--port" && i + 1 < argc)
+		{
+			localPort = (unsigned short)atoi(argv[++i]);
+		}
+		else if (std::string(argv[i]) == "--side" && i + 1 < argc)
+		{
+			localSide = std::string(argv[++i]) == "right" ? 1 : 0;
+		}
+		else if (std::string(argv[i]) == "--seed" && i + 1 < argc)
+		{
+			netSeed = (unsigned int)strtoul(argv[++i], nullptr, 10);
+		}
+		else if (std::string(argv[i]) == "--input-delay" && i + 1 < argc)
+		{
+			inputDelay = (unsigned int)atoi(argv[++i]);
+		}
+		else if (std::string(argv[i]) == "--shim-rtt" && i + 1 < argc)
+		{
+			shimRtt = atof(argv[++i]) / 1000.0;
+		}
+		else if (std::string(argv[i]) == "--shim-loss" && i + 1 < argc)
+		{
+			shimLoss = atof(argv[++i]) / 100.0;
+		}
+		else if (std::string(argv[i]) == "--timing" && i + 1 < argc)
+		{
+			timingPath = argv[++i];
+		}
+		else if (std::string(argv[i]) == "--timing-window" && i + 1 < argc)
+		{
+			timingWindow = (unsigned int)atoi(argv[++i]);
+		}
+		else if (std::string(argv[i]) == "--timing-frames" && i + 1 < argc)
+		{
+			timingFrames = (unsigned int)atoi(argv[++i]);
+		}
+		else if (std::string(argv[i]) == "--frame-budget" && i + 1 < argc)
+		{
+			frameBudget = atof(argv[++i]) / 1000.0;
+		}
+		else if (std::string(argv[i]) == "--trace" && i + 1 < argc)
+		{
+			tracePath = argv[++i];
+		}
+		else if (std::string(argv[i]) == "--trace-events" && i + 1 < argc)
+		{
+			traceEvents = (unsigned int)atoi(argv[++i]);
+		}
+		else if (std::string(argv[i]) == "--tick-rate" && i + 1 < argc)
+		{
+			double rate = atof(argv[++i]);
+			if (rate > 0.0)
+			{
+				tickRate = rate;
+			}
+		}
+	}
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja odczytujaca stan klawiatury
+** window - okno, z ktorego odczytywane sa klawisze
+** funkcja zwraca maske wcisnietych klawiszy sterujacych rakietkami
+**------------------------------------------------------------------------------------------*/
+Inputs processInput(GLFWwindow* window) 
+{
+	TRACE_ZONE("processInput");
+
+	Inputs inputs = { 0 };
+
 	// WYJCIE Z PROGRAMU
 	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
 	{
 		glfwSetWindowShouldClose(window, true);
 	}
 
-	//RESETOWANIE SZYBKOCI RAKIETEK 
-	velocityForRackets[0] = 0.0f;
-	velocityForRackets[1] = 0.0f;
-
-	// STEROWANIE RAKIETKAMI, NADAWNIE IM PRDKOCI
+	// STEROWANIE RAKIETKAMI
 	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
 	{
-		if (offsetsForRackets[0].y < WIN_HEIGHT - racketLimit)
-		{
-			velocityForRackets[0] = racketsSpeed;
-		}
-		else 
-		{
-			offsetsForRackets[0].y = WIN_HEIGHT - racketLimit;
-		}
+		inputs.keys |= INPUT_LEFT_UP;
 	}
 
 	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
 	{
-		if (offsetsForRackets[0].y > racketLimit)
-		{
-			velocityForRackets[0] = -racketsSpeed;
-		}
-		else
-		{
-			offsetsForRackets[0].y = halfRacketsHeight;
-		}
+		inputs.keys |= INPUT_LEFT_DOWN;
 	}
 
 	if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS)
 	{
-		if (offsetsForRackets[1].y < WIN_HEIGHT - racketLimit)
-		{
-			velocityForRackets[1] = racketsSpeed;
-		}
-		else
-		{
-			offsetsForRackets[1].y = WIN_HEIGHT - racketLimit;
-		}
+		inputs.keys |= INPUT_RIGHT_UP;
 	}
 
 	if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) 
 	{
-		if (offsetsForRackets[1].y > racketLimit)
-		{
-			velocityForRackets[1] = -racketsSpeed;
-		}
-		else
-		{
-			offsetsForRackets[1].y = halfRacketsHeight;
-		}
+		inputs.keys |= INPUT_RIGHT_DOWN;
 	}
+
+	return inputs;
 }
 
 /*------------------------------------------------------------------------------------------
@@ -362,6 +743,8 @@ void cleanup()
 **------------------------------------------------------------------------------------------*/
 void initGL()
 {
+	TRACE_ZONE("initGL");
+
 	std::cout << "GLEW = " << glewGetString( GLEW_VERSION ) << std::endl;
 	std::cout << "GL_VENDOR = " << glGetString( GL_VENDOR ) << std::endl;
 	std::cout << "GL_RENDERER = " << glGetString( GL_RENDERER ) << std::endl;
@@ -380,6 +763,8 @@ void initGL()
 **------------------------------------------------------------------------------------------*/
 void setupShaders()
 {
+	TRACE_ZONE("setupShaders");
+
 	if( !setupShaders( "shaders/vertex.vert", "shaders/fragment.frag", shaderProgram ) )
 		exit( 3 );
 
@@ -392,6 +777,8 @@ void setupShaders()
 **------------------------------------------------------------------------------------------*/
 void setupBuffers()
 {
+	TRACE_ZONE("setupBuffers");
+
 	// Stworzenie tablicy wierzechokw i indeksw dla piki
 	generateCircleArray(verticesForBall, indicesForBall, numOfTraingles, 1.0f);
 
@@ -414,7 +801,7 @@ void setupBuffers()
 
 	// VBO dla pozycji na ekranie dla piki
 	glBindBuffer(GL_ARRAY_BUFFER, buffers[1]);
-	glBufferData(GL_ARRAY_BUFFER, 1 * sizeof(vec2), &offsetsForBall, GL_DYNAMIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, 1 * sizeof(vec2), &world.ball, GL_DYNAMIC_DRAW);
 	glBindBuffer(GL_ARRAY_BUFFER, buffers[1]);
 	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)(0 * sizeof(float))); 
 	glEnableVertexAttribArray(1); // wlaczenie tablicy atrybutu wierzcholka - wspolrzedne
@@ -450,7 +837,7 @@ void setupBuffers()
 
 	// VBO dla pozycji na ekranie dla rakietek
 	glBindBuffer(GL_ARRAY_BUFFER, buffers[4]);
-	glBufferData(GL_ARRAY_BUFFER, 2 * sizeof(vec2), offsetsForRackets, GL_DYNAMIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, 2 * sizeof(vec2), world.rackets, GL_DYNAMIC_DRAW);
 	glBindBuffer(GL_ARRAY_BUFFER, buffers[4]);
 	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)(0 * sizeof(float))); 
 	glEnableVertexAttribArray(1); 
@@ -478,13 +865,18 @@ void setupBuffers()
 **------------------------------------------------------------------------------------------*/
 void renderScene()
 {
+	TRACE_ZONE("renderScene");
+
 	// wyrysowanie pieczki 
+	gpuMark(gpuTiming, GPU_BALL);
 	glBindVertexArray(vao[0]);
 	glDrawElementsInstanced(GL_TRIANGLES, 3 * numOfTraingles, GL_UNSIGNED_INT, (void*)0, 1);
 
 	// wyrysowanie rakietek 
+	gpuMark(gpuTiming, GPU_RACKETS);
 	glBindVertexArray(vao[1]);
 	glDrawElementsInstanced(GL_TRIANGLES, 3 * 2, GL_UNSIGNED_INT, (void*)0, 2);
+	gpuMark(gpuTiming, GPU_RANGE_COUNT);
 }
 
 /*------------------------------------------------------------------------------------------
@@ -553,33 +945,5 @@ void generateCircleArray(float*& vertices, unsigned int*& indices, unsigned int
 ** funkcja wywietlajca punkty
 **------------------------------------------------------------------------------------------*/
 void displayScore() {
-	std::cout << scoreForLeft << " - " << scoreForRight << std::endl;
-}
-
-/*------------------------------------------------------------------------------------------
-** funkcja ustalajca kierunek pieczki
-**------------------------------------------------------------------------------------------*/
-void ballDirection(unsigned int direction, float x, float yMin, float yMax) {
-	
-	if (direction == 1) {
-		velocityForBall.x = x;
-	}
-	else if(direction == 2)
-	{
-		velocityForBall.x = -x;
-	}
-	else 
-	{
-		int randomDir = rand() % 2 + 1;
-		if (randomDir == 1) 
-		{
-			velocityForBall.x = x;
-		}
-		else 
-		{
-			velocityForBall.x = -x;
-		}
-	}
-
-	velocityForBall.y = ((yMax - yMin) * ((((float)rand()) / (float)RAND_MAX))) + yMin;
+	std::cout << world.scoreForLeft << " - " << world.scoreForRight << std::endl;
 }
\ No newline at end of file
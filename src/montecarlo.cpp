@@ -0,0 +1,391 @@
+#include <atomic>
+#include <thread>
+#include <cmath>
+
+#include "montecarlo.h"
+#include "trace.h"
+
+const double confidenceZ = 1.959963984540054; // kwantyl rozkladu normalnego dla przedzialu 95%
+
+static void addWide(WideSum& sum, unsigned long long value)
+{
+	unsigned long long low = sum.low + value;
+	sum.high += low < sum.low ? 1 : 0;
+	sum.low = low;
+}
+
+static void mergeWide(WideSum& total, const WideSum& part)
+{
+	addWide(total, part.low);
+	total.high += part.high;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zamieniajaca sume 128-bitowa na liczbe zmiennoprzecinkowa (do raportu)
+**------------------------------------------------------------------------------------------*/
+double wideSumValue(const WideSum& sum)
+{
+	return (double)sum.high * 18446744073709551616.0 + (double)sum.low;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja dodajaca statystyki czesciowe do sumy
+**------------------------------------------------------------------------------------------*/
+void mergeMonteCarlo(MonteCarloStats& total, const MonteCarloStats& part)
+{
+	total.matches += part.matches;
+	total.winsForLeft += part.winsForLeft;
+	total.winsForRight += part.winsForRight;
+	total.unfinished += part.unfinished;
+	total.matchTicks += part.matchTicks;
+	mergeWide(total.matchTicksSquared, part.matchTicksSquared);
+
+	total.points += part.points;
+	total.pointsForLeft += part.pointsForLeft;
+	total.pointTicks += part.pointTicks;
+	mergeWide(total.pointTicksSquared, part.pointTicksSquared);
+	if (part.longestPoint > total.longestPoint)
+		total.longestPoint = part.longestPoint;
+
+	total.rallyHits += part.rallyHits;
+	total.rallyHitsSquared += part.rallyHitsSquared;
+	for (unsigned int b = 0; b < rallyHitBuckets; b++)
+	{
+		total.rallyHistogram[b] += part.rallyHistogram[b];
+	}
+
+	for (unsigned int b = 0; b < serveAngleBuckets; b++)
+	{
+		total.serve[b].serves += part.serve[b].serves;
+		total.serve[b].receiverWins += part.serve[b].receiverWins;
+		total.serve[b].hits += part.serve[b].hits;
+		total.serve[b].ticks += part.serve[b].ticks;
+	}
+}
+
+// przedzial kata serwu dla pionowej predkosci pileczki
+static unsigned int serveBucket(float vy)
+{
+	int bucket = (int)((vy + ballServeMaxY) / (2.0f * ballServeMaxY) * serveAngleBuckets);
+	if (bucket < 0)
+		return 0;
+	if (bucket >= (int)serveAngleBuckets)
+		return serveAngleBuckets - 1;
+
+	return (unsigned int)bucket;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwracajaca kubelek histogramu odbic: do rallyExactHits po jednym na liczbe odbic,
+** dalej rallySubBuckets rownych kubelkow na kazda potege dwojki (staly blad wzgledny)
+**------------------------------------------------------------------------------------------*/
+unsigned int rallyBucket(unsigned int hits)
+{
+	if (hits < rallyExactHits)
+		return hits;
+
+	unsigned int octave = 0;
+	while ((hits >> octave) >= 2 * rallyExactHits)
+	{
+		octave++;
+	}
+
+	unsigned int bucket = rallyExactHits + octave * rallySubBuckets + ((hits >> octave) - rallyExactHits) * rallySubBuckets / rallyExactHits;
+
+	return bucket < rallyHitBuckets ? bucket : rallyHitBuckets - 1;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwracajaca najmniejsza liczbe odbic w kubelku
+**------------------------------------------------------------------------------------------*/
+unsigned int rallyBucketLow(unsigned int bucket)
+{
+	if (bucket < rallyExactHits)
+		return bucket;
+
+	unsigned int octave = (bucket - rallyExactHits) / rallySubBuckets;
+	unsigned int sub = (bucket - rallyExactHits) % rallySubBuckets;
+
+	return (rallyExactHits + sub * rallyExactHits / rallySubBuckets) << octave;
+}
+
+// STAN MIEJSCA W PACZCE WATKU
+struct MonteCarloLane {
+	bool active;
+	unsigned long long startTick; // krok paczki na poczatku meczu
+	unsigned long long rallyStart; // krok paczki na poczatku punktu
+	unsigned int points; // suma punktow po ostatnim kroku
+	unsigned int scoreForLeft;
+	unsigned int rallyHitsStart; // batch.hits na poczatku punktu
+	unsigned int serve; // przedzial kata serwu punktu
+	int receiver; // strona, w ktora polecial serw (0 - lewa, 1 - prawa)
+};
+
+// poczatek punktu: kat serwu i odbierajacy z predkosci pileczki po serwie
+static void startPoint(const MatchBatch& batch, unsigned int i, MonteCarloLane& lane)
+{
+	lane.rallyStart = batch.tick;
+	lane.rallyHitsStart = batch.hits[i];
+	lane.serve = serveBucket(batch.ballVY[i]);
+	lane.receiver = batch.ballVX[i] < 0.0f ? 0 : 1;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja watku - paczka meczow krokowana kernelem SIMD, kolejne numery meczow pobierane
+** ze wspolnego licznika; kazdy mecz zalezy tylko od swojego ziarna, wiec zbior rozegranych
+** meczow jest ten sam przy kazdej liczbie watkow
+**------------------------------------------------------------------------------------------*/
+static void monteCarloWorker(const MonteCarloOptions& options, std::atomic<unsigned int>* nextMatch, MonteCarloStats& stats)
+{
+	TRACE_THREAD("monteCarloWorker");
+	TRACE_ZONE("monteCarloWorker");
+
+	stats = MonteCarloStats();
+
+	MatchBatch batch;
+	initBatch(batch, options.batchSize, options.firstSeed);
+
+	unsigned int* keys = new unsigned int[batch.capacity];
+	unsigned int* rightKeys = options.bots[1] != options.bots[0] ? new unsigned int[batch.capacity] : nullptr;
+	MonteCarloLane* lanes = new MonteCarloLane[batch.count];
+
+	auto startMatch = [&](unsigned int i) {
+		unsigned int index = nextMatch->fetch_add(1, std::memory_order_relaxed);
+		lanes[i].active = index < options.matches;
+		if (!lanes[i].active)
+			return false;
+
+		resetMatch(batch, i, options.firstSeed + index);
+		lanes[i].startTick = batch.tick;
+		lanes[i].points = 0;
+		lanes[i].scoreForLeft = 0;
+		startPoint(batch, i, lanes[i]);
+		return true;
+	};
+
+	unsigned int active = 0;
+	for (unsigned int i = 0; i < batch.count; i++)
+	{
+		if (startMatch(i))
+			active++;
+	}
+
+	while (active > 0)
+	{
+		options.bots[0](batch, keys);
+		if (rightKeys)
+		{
+			options.bots[1](batch, rightKeys);
+			for (unsigned int i = 0; i < batch.count; i++)
+			{
+				keys[i] = (keys[i] & (INPUT_LEFT_UP | INPUT_LEFT_DOWN)) | (rightKeys[i] & (INPUT_RIGHT_UP | INPUT_RIGHT_DOWN));
+			}
+		}
+		stepBatch(batch, keys, options.dt);
+
+		for (unsigned int i = 0; i < batch.count; i++)
+		{
+			MonteCarloLane& lane = lanes[i];
+			if (!lane.active)
+				continue;
+
+			// KONIEC PUNKTU
+			unsigned int points = batch.scoreForLeft[i] + batch.scoreForRight[i];
+			if (points != lane.points)
+			{
+				unsigned long long ticks = batch.tick - lane.rallyStart;
+				unsigned int hits = batch.hits[i] - lane.rallyHitsStart;
+				int winner = batch.scoreForLeft[i] != lane.scoreForLeft ? 0 : 1;
+
+				stats.points++;
+				stats.pointsForLeft += winner == 0;
+				stats.pointTicks += ticks;
+				addWide(stats.pointTicksSquared, ticks * ticks);
+				if (ticks > stats.longestPoint)
+					stats.longestPoint = ticks;
+
+				stats.rallyHits += hits;
+				stats.rallyHitsSquared += (unsigned long long)hits * hits;
+				stats.rallyHistogram[rallyBucket(hits)]++;
+
+				ServeBucket& serve = stats.serve[lane.serve];
+				serve.serves++;
+				serve.receiverWins += winner == lane.receiver;
+				serve.hits += hits;
+				serve.ticks += ticks;
+
+				lane.points = points;
+				lane.scoreForLeft = batch.scoreForLeft[i];
+				startPoint(batch, i, lane);
+			}
+
+			// KONIEC MECZU
+			bool won = batch.scoreForLeft[i] >= options.points || batch.scoreForRight[i] >= options.points;
+			unsigned long long ticks = batch.tick - lane.startTick;
+			if (!won && ticks < options.maxTicks)
+				continue;
+
+			stats.matches++;
+			if (!won)
+			{
+				stats.unfinished++;
+			}
+			else
+			{
+				if (batch.scoreForLeft[i] > batch.scoreForRight[i])
+					stats.winsForLeft++;
+				else
+					stats.winsForRight++;
+				stats.matchTicks += ticks;
+				addWide(stats.matchTicksSquared, ticks * ticks);
+			}
+
+			if (!startMatch(i))
+				active--;
+		}
+	}
+
+	delete[] lanes;
+	delete[] rightKeys;
+	delete[] keys;
+	freeBatch(batch);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja rozgrywajaca mecze na wielu watkach; kazdy watek zbiera wlasne statystyki, ktore
+** na koniec sa laczone w kolejnosci watkow (same sumy liczb calkowitych i maksimum - wynik
+** jest ten sam przy kazdej liczbie watkow)
+** options - parametry rozgrywek
+** total - polaczone statystyki
+** parts - statystyki poszczegolnych watkow
+**------------------------------------------------------------------------------------------*/
+void runMonteCarlo(const MonteCarloOptions& options, MonteCarloStats& total, std::vector<MonteCarloStats>& parts)
+{
+	TRACE_ZONE("runMonteCarlo");
+
+	unsigned int threads = options.threads ? options.threads : std::thread::hardware_concurrency();
+	if (threads == 0)
+		threads = 1;
+
+	std::atomic<unsigned int> nextMatch(0);
+	parts.assign(threads, MonteCarloStats());
+
+	std::vector<std::thread> workers;
+	for (unsigned int t = 0; t < threads; t++)
+	{
+		workers.emplace_back(monteCarloWorker, std::cref(options), &nextMatch, std::ref(parts[t]));
+	}
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+
+	total = MonteCarloStats();
+	for (const MonteCarloStats& part : parts)
+	{
+		mergeMonteCarlo(total, part);
+	}
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja liczaca skrot statystyk (FNV-1a po wszystkich licznikach) - rowny skrot przy
+** roznej liczbie watkow potwierdza deterministyczne laczenie
+**------------------------------------------------------------------------------------------*/
+unsigned long long monteCarloDigest(const MonteCarloStats& stats)
+{
+	unsigned long long hash = 1469598103934665603ull;
+	auto mix = [&hash](unsigned long long value) {
+		for (int b = 0; b < 8; b++)
+		{
+			hash ^= (value >> (8 * b)) & 0xFF;
+			hash *= 1099511628211ull;
+		}
+	};
+
+	mix(stats.matches);
+	mix(stats.winsForLeft);
+	mix(stats.winsForRight);
+	mix(stats.unfinished);
+	mix(stats.matchTicks);
+	mix(stats.matchTicksSquared.low);
+	mix(stats.matchTicksSquared.high);
+	mix(stats.points);
+	mix(stats.pointsForLeft);
+	mix(stats.pointTicks);
+	mix(stats.pointTicksSquared.low);
+	mix(stats.pointTicksSquared.high);
+	mix(stats.longestPoint);
+	mix(stats.rallyHits);
+	mix(stats.rallyHitsSquared);
+	for (unsigned int b = 0; b < rallyHitBuckets; b++)
+	{
+		mix(stats.rallyHistogram[b]);
+	}
+	for (unsigned int b = 0; b < serveAngleBuckets; b++)
+	{
+		mix(stats.serve[b].serves);
+		mix(stats.serve[b].receiverWins);
+		mix(stats.serve[b].hits);
+		mix(stats.serve[b].ticks);
+	}
+
+	return hash;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja liczaca 95% przedzial ufnosci prawdopodobienstwa metoda Wilsona (poprawna takze
+** przy malej liczbie prob i czestosci bliskiej 0 lub 1)
+**------------------------------------------------------------------------------------------*/
+Interval proportionInterval(unsigned long long successes, unsigned long long trials)
+{
+	if (trials == 0)
+		return { 0.0, 0.0, 1.0 };
+
+	double n = (double)trials;
+	double p = successes / n;
+	double z2 = confidenceZ * confidenceZ;
+	double center = (p + z2 / (2.0 * n)) / (1.0 + z2 / n);
+	double spread = confidenceZ * sqrt(p * (1.0 - p) / n + z2 / (4.0 * n * n)) / (1.0 + z2 / n);
+
+	return { p, center - spread, center + spread };
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja liczaca 95% przedzial ufnosci sredniej (przyblizenie normalne) z liczby probek,
+** sumy i sumy kwadratow
+**------------------------------------------------------------------------------------------*/
+Interval meanInterval(unsigned long long count, double sum, double sumSquared)
+{
+	if (count == 0)
+		return { 0.0, 0.0, 0.0 };
+
+	double n = (double)count;
+	double mean = sum / n;
+	double variance = count > 1 ? (sumSquared - sum * mean) / (n - 1.0) : 0.0;
+	double spread = confidenceZ * sqrt(variance > 0.0 ? variance / n : 0.0);
+
+	return { mean, mean - spread, mean + spread };
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwracajaca poczatek kubelka histogramu, do ktorego wlacznie miesci sie podany
+** ulamek wymian
+**------------------------------------------------------------------------------------------*/
+unsigned int rallyPercentile(const MonteCarloStats& stats, double fraction)
+{
+	unsigned long long total = 0;
+	for (unsigned int b = 0; b < rallyHitBuckets; b++)
+	{
+		total += stats.rallyHistogram[b];
+	}
+
+	unsigned long long seen = 0;
+	for (unsigned int b = 0; b < rallyHitBuckets; b++)
+	{
+		seen += stats.rallyHistogram[b];
+		if (total > 0 && seen >= fraction * total)
+			return rallyBucketLow(b);
+	}
+
+	return rallyBucketLow(rallyHitBuckets - 1);
+}
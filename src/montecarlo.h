@@ -0,0 +1,79 @@
+#ifndef __MONTECARLO_H__
+#define __MONTECARLO_H__
+
+#include <vector>
+
+#include "batch.h"
+
+constexpr unsigned int rallyExactHits = 16; // krotsze wymiany maja w histogramie kubelek na kazda liczbe odbic
+constexpr unsigned int rallySubBuckets = 8; // dluzsze - tyle kubelkow na kazda potege dwojki
+constexpr unsigned int rallyHitBuckets = 96; // kubelki histogramu odbic (do 16 * 2^10 odbic, ostatni - wszystkie dluzsze)
+constexpr unsigned int serveAngleBuckets = 16; // przedzialy pionowej predkosci serwu w [-ballServeMaxY, ballServeMaxY]
+
+// SUMA 128-BITOWA - sumy kwadratow dlugosci punktow i meczow nie mieszcza sie w 64 bitach
+struct WideSum {
+	unsigned long long low;
+	unsigned long long high;
+};
+
+// WYNIKI SERWOW Z JEDNEGO PRZEDZIALU KATA
+struct ServeBucket {
+	unsigned long long serves; // punkty zaczete serwem z tego przedzialu
+	unsigned long long receiverWins; // punkty zdobyte przez odbierajacego serw
+	unsigned long long hits; // suma odbic w tych wymianach
+	unsigned long long ticks; // suma dlugosci tych punktow w krokach
+};
+
+// STATYSTYKI MECZOW - same liczby calkowite, wiec suma czesci nie zalezy od kolejnosci
+// laczenia ani od podzialu meczow miedzy watki
+struct MonteCarloStats {
+	unsigned long long matches;
+	unsigned long long winsForLeft;
+	unsigned long long winsForRight;
+	unsigned long long unfinished; // mecze przerwane po maxTicks
+	unsigned long long matchTicks; // suma dlugosci zakonczonych meczow
+	WideSum matchTicksSquared;
+
+	unsigned long long points;
+	unsigned long long pointsForLeft;
+	unsigned long long pointTicks; // suma dlugosci punktow (od serwu do bramki)
+	WideSum pointTicksSquared;
+	unsigned long long longestPoint; // w krokach
+
+	unsigned long long rallyHits; // suma odbic w wymianach
+	unsigned long long rallyHitsSquared;
+	unsigned long long rallyHistogram[rallyHitBuckets];
+
+	ServeBucket serve[serveAngleBuckets];
+};
+
+// PARAMETRY ROZGRYWEK MONTE CARLO
+struct MonteCarloOptions {
+	unsigned int threads; // liczba watkow (0 - tyle ile rdzeni)
+	unsigned int matches;
+	unsigned int firstSeed; // ziarno pierwszego meczu (kolejne mecze: firstSeed + i)
+	unsigned int points; // do ilu punktow gra sie mecz
+	unsigned int batchSize; // mecze krokowane naraz przez watek
+	unsigned long long maxTicks; // limit krokow na mecz
+	float dt;
+	void (*bots[2])(const MatchBatch& batch, unsigned int* keys); // sterowniki lewej i prawej rakietki
+};
+
+// PRZEDZIAL UFNOSCI
+struct Interval {
+	double estimate;
+	double low;
+	double high;
+};
+
+void mergeMonteCarlo(MonteCarloStats& total, const MonteCarloStats& part);
+void runMonteCarlo(const MonteCarloOptions& options, MonteCarloStats& total, std::vector<MonteCarloStats>& parts);
+unsigned long long monteCarloDigest(const MonteCarloStats& stats);
+Interval proportionInterval(unsigned long long successes, unsigned long long trials);
+Interval meanInterval(unsigned long long count, double sum, double sumSquared);
+double wideSumValue(const WideSum& sum);
+unsigned int rallyBucket(unsigned int hits);
+unsigned int rallyBucketLow(unsigned int bucket);
+unsigned int rallyPercentile(const MonteCarloStats& stats, double fraction);
+
+#endif /* __MONTECARLO_H__ */
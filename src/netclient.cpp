@@ -0,0 +1,152 @@
+#include "netclient.h"
+#include "rollback.h"
+#include "wire.h"
+
+/*------------------------------------------------------------------------------------------
+** funkcja przygotowujaca polaczenie z serwerem meczow (pierwszy PACKET_JOIN wysyla
+** pollServerConnection())
+** link - lacze do serwera
+** nonce - identyfikator klienta (powtorzony JOIN z tym samym identyfikatorem dostaje to samo miejsce)
+**------------------------------------------------------------------------------------------*/
+void initServerConnection(ServerConnection& connection, const NetLink& link, unsigned int nonce)
+{
+	connection.link = link;
+	connection.nonce = nonce;
+	connection.phase = CONNECTION_JOINING;
+	connection.lastJoinSent = -1.0;
+
+	connection.match = noMatch;
+	connection.side = 0;
+	connection.seed = 0;
+	connection.tickRate = 0;
+	connection.finalScore[0] = 0;
+	connection.finalScore[1] = 0;
+
+	clearNetStateHistory(connection.history);
+	connection.lastStateTick = 0;
+	initPrediction(connection.prediction, 0, 0, 1.0f / 60.0f);
+
+	connection.stats = ConnectionStats();
+}
+
+static void sendPacket(ServerConnection& connection, const unsigned char* packet, unsigned int size)
+{
+	if (connection.link.send(connection.link.context, packet, size))
+		connection.stats.packetsSent++;
+}
+
+static void handleJoined(ServerConnection& connection, const unsigned char* packet)
+{
+	if (connection.phase != CONNECTION_JOINING || getU32(packet + 1) != connection.nonce)
+		return;
+
+	connection.match = getU32(packet + 5);
+	connection.side = packet[9];
+	connection.seed = getU32(packet + 10);
+	connection.tickRate = getU16(packet + 14);
+	if (connection.tickRate == 0)
+		connection.tickRate = 60;
+
+	initPrediction(connection.prediction, connection.side, connection.seed, 1.0f / connection.tickRate);
+	connection.phase = CONNECTION_PLAYING;
+}
+
+static void handleState(ServerConnection& connection, const unsigned char* packet, unsigned int size)
+{
+	NetState state;
+	if (!decodeState(packet + stateHeaderSize, size - stateHeaderSize, connection.history, connection.tickRate, state))
+	{
+		connection.stats.undecodable++;
+		return;
+	}
+	storeNetState(connection.history, state);
+	connection.stats.statesReceived++;
+
+	if (state.tick > connection.lastStateTick)
+		connection.lastStateTick = state.tick;
+
+	unsigned int confirmedInput = getU32(packet + 6);
+	connection.stats.inputLagTicks += connection.prediction.inputTick - confirmedInput;
+	reconcilePrediction(connection.prediction, state, confirmedInput);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja odbierajaca pakiety serwera (i ponawiajaca zgloszenie co sekunde)
+** now - biezacy czas w sekundach
+**------------------------------------------------------------------------------------------*/
+void pollServerConnection(ServerConnection& connection, double now)
+{
+	if (connection.phase == CONNECTION_JOINING && (connection.lastJoinSent < 0.0 || now - connection.lastJoinSent >= 1.0))
+	{
+		unsigned char join[joinPacketSize];
+		join[0] = PACKET_JOIN;
+		putU32(join + 1, connection.nonce);
+		sendPacket(connection, join, sizeof(join));
+		connection.lastJoinSent = now;
+	}
+
+	unsigned char packet[maxDatagramSize];
+	int size;
+	while ((size = connection.link.receive(connection.link.context, packet, sizeof(packet))) > 0)
+	{
+		if (packet[0] == PACKET_JOINED && size >= (int)joinedPacketSize)
+		{
+			handleJoined(connection, packet);
+			continue;
+		}
+
+		// pozostale pakiety tylko z naszego meczu
+		if (connection.phase != CONNECTION_PLAYING || size < 6 || getU32(packet + 1) != connection.match || packet[5] != connection.side)
+			continue;
+
+		if (packet[0] == PACKET_STATE && size > (int)stateHeaderSize)
+		{
+			handleState(connection, packet, (unsigned int)size);
+		}
+		else if (packet[0] == PACKET_END && size >= (int)endPacketSize)
+		{
+			connection.finalScore[0] = getU16(packet + 6);
+			connection.finalScore[1] = getU16(packet + 8);
+			connection.phase = CONNECTION_ENDED;
+		}
+	}
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja wykonujaca krok klienta: wlasne klawisze od razu na przewidywanej kopii meczu
+** i w PACKET_INPUT do serwera (razem z potwierdzeniem ostatniego stanu)
+** up, down - wcisniete klawisze wlasnej rakietki
+**------------------------------------------------------------------------------------------*/
+void advanceServerConnection(ServerConnection& connection, bool up, bool down)
+{
+	if (connection.phase != CONNECTION_PLAYING)
+		return;
+
+	unsigned int keys = sideKeys(connection.side, up, down);
+	unsigned int inputTick = predictInput(connection.prediction, keys);
+
+	unsigned char packet[inputPacketSize];
+	packet[0] = PACKET_INPUT;
+	putU32(packet + 1, connection.match);
+	packet[5] = (unsigned char)connection.side;
+	putU32(packet + 6, connection.lastStateTick);
+	packet[10] = (unsigned char)keys;
+	putU32(packet + 11, inputTick);
+	sendPacket(connection, packet, sizeof(packet));
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja wysylajaca pozegnanie (serwer nie czeka na przekroczenie czasu ciszy)
+**------------------------------------------------------------------------------------------*/
+void leaveServer(ServerConnection& connection)
+{
+	if (connection.phase != CONNECTION_PLAYING)
+		return;
+
+	unsigned char packet[leavePacketSize];
+	packet[0] = PACKET_LEAVE;
+	putU32(packet + 1, connection.match);
+	packet[5] = (unsigned char)connection.side;
+	sendPacket(connection, packet, sizeof(packet));
+	connection.phase = CONNECTION_ENDED;
+}
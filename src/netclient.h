@@ -0,0 +1,48 @@
+#ifndef __NETCLIENT_H__
+#define __NETCLIENT_H__
+
+#include "netlink.h"
+#include "predict.h"
+#include "protocol.h"
+
+// ETAPY POLACZENIA Z SERWEREM MECZOW
+enum ConnectionPhase {
+	CONNECTION_JOINING = 0, // PACKET_JOIN powtarzany co sekunde do odpowiedzi
+	CONNECTION_PLAYING = 1, // mecz trwa - klawisze co krok, stany od serwera
+	CONNECTION_ENDED = 2 // serwer przyslal PACKET_END
+};
+
+// STATYSTYKI POLACZENIA
+struct ConnectionStats {
+	unsigned long long packetsSent;
+	unsigned long long statesReceived;
+	unsigned long long undecodable; // stany bez znanej bazy roznicy
+	unsigned long long inputLagTicks; // suma krokow miedzy wyslaniem klawiszy a ich uzyciem w stanie serwera
+};
+
+// GRACZ MECZU NA SERWERZE AUTORYTATYWNYM (server.h) - wlasna rakietka przewidywana lokalnie
+struct ServerConnection {
+	NetLink link;
+	unsigned int nonce; // identyfikator klienta w PACKET_JOIN
+	ConnectionPhase phase;
+	double lastJoinSent;
+
+	unsigned int match;
+	int side;
+	unsigned int seed;
+	unsigned int tickRate; // kroki serwera na sekunde (z PACKET_JOINED)
+	unsigned int finalScore[2]; // wynik z PACKET_END
+
+	NetStateHistory history; // odebrane stany - bazy roznic
+	unsigned int lastStateTick; // ostatni odebrany stan - potwierdzany w PACKET_INPUT
+	Prediction prediction;
+
+	ConnectionStats stats;
+};
+
+void initServerConnection(ServerConnection& connection, const NetLink& link, unsigned int nonce);
+void pollServerConnection(ServerConnection& connection, double now);
+void advanceServerConnection(ServerConnection& connection, bool up, bool down);
+void leaveServer(ServerConnection& connection);
+
+#endif /* __NETCLIENT_H__ */
@@ -0,0 +1,278 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "netlink.h"
+
+/*------------------------------------------------------------------------------------------
+** funkcja otwierajaca nieblokujace gniazdo UDP i zapamietujaca adres drugiego gracza
+** udp - otwierane lacze
+** localPort - port, na ktorym odbierane sa pakiety
+** peerHost - nazwa lub adres IPv4 drugiego gracza
+** peerPort - port drugiego gracza
+** funkcja zwraca false jesli nie mozna otworzyc gniazda lub znalezc adresu
+**------------------------------------------------------------------------------------------*/
+bool openUdpLink(UdpLink& udp, unsigned short localPort, const char* peerHost, unsigned short peerPort)
+{
+#ifdef _WIN32
+	static bool started = false;
+	if (!started)
+	{
+		WSADATA data;
+		if (WSAStartup(MAKEWORD(2, 2), &data) != 0)
+			return false;
+		started = true;
+	}
+#endif
+
+	addrinfo hints = {};
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+
+	addrinfo* peer = nullptr;
+	if (getaddrinfo(peerHost, nullptr, &hints, &peer) != 0 || !peer)
+	{
+		std::cerr << "Nie mozna znalezc adresu: " << peerHost << std::endl;
+		return false;
+	}
+	udp.peerAddress = ((sockaddr_in*)peer->ai_addr)->sin_addr.s_addr;
+	udp.peerPort = htons(peerPort);
+	freeaddrinfo(peer);
+
+	udp.socket = (long long)::socket(AF_INET, SOCK_DGRAM, 0);
+
+	sockaddr_in local = {};
+	local.sin_family = AF_INET;
+	local.sin_addr.s_addr = htonl(INADDR_ANY);
+	local.sin_port = htons(localPort);
+
+#ifdef _WIN32
+	u_long nonBlocking = 1;
+	bool ok = (SOCKET)udp.socket != INVALID_SOCKET
+		&& bind((SOCKET)udp.socket, (sockaddr*)&local, sizeof(local)) == 0
+		&& ioctlsocket((SOCKET)udp.socket, FIONBIO, &nonBlocking) == 0;
+#else
+	bool ok = udp.socket >= 0
+		&& bind((int)udp.socket, (sockaddr*)&local, sizeof(local)) == 0
+		&& fcntl((int)udp.socket, F_SETFL, fcntl((int)udp.socket, F_GETFL) | O_NONBLOCK) == 0;
+#endif
+
+	if (!ok)
+	{
+		std::cerr << "Nie mozna otworzyc gniazda UDP na porcie " << localPort << std::endl;
+		closeUdpLink(udp);
+		return false;
+	}
+
+	return true;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zamykajaca gniazdo UDP
+**------------------------------------------------------------------------------------------*/
+void closeUdpLink(UdpLink& udp)
+{
+#ifdef _WIN32
+	if ((SOCKET)udp.socket != INVALID_SOCKET)
+		closesocket((SOCKET)udp.socket);
+	udp.socket = (long long)INVALID_SOCKET;
+#else
+	if (udp.socket >= 0)
+		close((int)udp.socket);
+	udp.socket = -1;
+#endif
+}
+
+static bool udpSend(void* context, const void* data, unsigned int size)
+{
+	UdpLink& udp = *(UdpLink*)context;
+
+	sockaddr_in peer = {};
+	peer.sin_family = AF_INET;
+	peer.sin_addr.s_addr = udp.peerAddress;
+	peer.sin_port = udp.peerPort;
+
+#ifdef _WIN32
+	return sendto((SOCKET)udp.socket, (const char*)data, (int)size, 0, (sockaddr*)&peer, sizeof(peer)) == (int)size;
+#else
+	return sendto((int)udp.socket, data, size, 0, (sockaddr*)&peer, sizeof(peer)) == (ssize_t)size;
+#endif
+}
+
+static int udpReceive(void* context, void* data, unsigned int capacity)
+{
+	UdpLink& udp = *(UdpLink*)context;
+
+	// pakiety z innych adresow sa pomijane
+	for (;;)
+	{
+		sockaddr_in from = {};
+		socklen_t fromSize = sizeof(from);
+
+#ifdef _WIN32
+		int size = recvfrom((SOCKET)udp.socket, (char*)data, (int)capacity, 0, (sockaddr*)&from, &fromSize);
+#else
+		int size = (int)recvfrom((int)udp.socket, data, capacity, 0, (sockaddr*)&from, &fromSize);
+#endif
+		if (size <= 0)
+			return 0;
+		if (from.sin_addr.s_addr == udp.peerAddress && from.sin_port == udp.peerPort)
+			return size;
+	}
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja tworzaca lacze NetLink z gniazda UDP
+**------------------------------------------------------------------------------------------*/
+NetLink udpNetLink(UdpLink& udp)
+{
+	NetLink link = { &udp, udpSend, udpReceive };
+	return link;
+}
+
+static bool loopbackSend(void* context, const void* data, unsigned int size)
+{
+	LoopbackEndpoint& endpoint = *(LoopbackEndpoint*)context;
+	const unsigned char* bytes = (const unsigned char*)data;
+
+	endpoint.channel->queues[1 - endpoint.side].emplace_back(bytes, bytes + size);
+
+	return true;
+}
+
+static int loopbackReceive(void* context, void* data, unsigned int capacity)
+{
+	LoopbackEndpoint& endpoint = *(LoopbackEndpoint*)context;
+	std::deque<std::vector<unsigned char>>& queue = endpoint.channel->queues[endpoint.side];
+
+	if (queue.empty())
+		return 0;
+
+	unsigned int size = std::min((unsigned int)queue.front().size(), capacity);
+	memcpy(data, queue.front().data(), size);
+	queue.pop_front();
+
+	return (int)size;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja tworzaca dwa polaczone ze soba lacza w pamieci (pakiety bez opoznien i strat)
+** channel - kolejki pakietow; musi istniec dluzej niz lacza
+**------------------------------------------------------------------------------------------*/
+void loopbackNetLinks(LoopbackChannel& channel, NetLink& first, NetLink& second)
+{
+	for (int side = 0; side < 2; side++)
+	{
+		channel.queues[side].clear();
+		channel.endpoints[side].channel = &channel;
+		channel.endpoints[side].side = side;
+	}
+
+	first = { &channel.endpoints[0], loopbackSend, loopbackReceive };
+	second = { &channel.endpoints[1], loopbackSend, loopbackReceive };
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja losujaca liczbe z przedzialu [0, 1) dla symulatora opoznien
+**------------------------------------------------------------------------------------------*/
+static double shimRandom(NetShim& shim)
+{
+	unsigned int x = shim.rngState;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	shim.rngState = x;
+
+	return (x >> 8) / (double)(1u << 24);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja przygotowujaca symulator opoznien i strat
+** inner - lacze, ktorym pakiety sa naprawde wysylane
+** delay - opoznienie w jedna strone (s), np. 0.05 dla RTT 100 ms
+** jitter - losowy dodatek do opoznienia (s)
+** loss - prawdopodobienstwo zgubienia pakietu (0..1)
+** seed - ziarno generatora (ten sam seed - te same straty)
+**------------------------------------------------------------------------------------------*/
+void initShim(NetShim& shim, const NetLink& inner, double delay, double jitter, double loss, unsigned int seed)
+{
+	shim.inner = inner;
+	shim.delay = delay;
+	shim.jitter = jitter;
+	shim.loss = loss;
+	shim.rngState = seed ? seed : 0x9E3779B9u;
+	shim.now = 0.0;
+	shim.pending.clear();
+	shim.dropped = 0;
+}
+
+static bool shimSend(void* context, const void* data, unsigned int size)
+{
+	NetShim& shim = *(NetShim*)context;
+
+	if (shimRandom(shim) < shim.loss)
+	{
+		shim.dropped++;
+		return true; // zgubiony po drodze - wysylajacy o tym nie wie
+	}
+
+	const unsigned char* bytes = (const unsigned char*)data;
+	DelayedPacket packet;
+	packet.deliverAt = shim.now + shim.delay + shim.jitter * shimRandom(shim);
+	packet.data.assign(bytes, bytes + size);
+	shim.pending.push_back(std::move(packet));
+
+	return true;
+}
+
+static int shimReceive(void* context, void* data, unsigned int capacity)
+{
+	NetShim& shim = *(NetShim*)context;
+	return shim.inner.receive(shim.inner.context, data, capacity);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja tworzaca lacze NetLink przechodzace przez symulator opoznien
+**------------------------------------------------------------------------------------------*/
+NetLink shimNetLink(NetShim& shim)
+{
+	NetLink link = { &shim, shimSend, shimReceive };
+	return link;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja ustawiajaca biezacy czas i wysylajaca pakiety, ktorych opoznienie minelo
+** (w kolejnosci czasow dostarczenia - przy rozrzucie opoznien kolejnosc moze sie zmienic)
+** now - biezacy czas w sekundach (zegar gry albo czas wirtualny w testach)
+**------------------------------------------------------------------------------------------*/
+void pumpShim(NetShim& shim, double now)
+{
+	shim.now = now;
+
+	std::stable_sort(shim.pending.begin(), shim.pending.end(), [](const DelayedPacket& a, const DelayedPacket& b) {
+		return a.deliverAt < b.deliverAt;
+	});
+
+	size_t due = 0;
+	while (due < shim.pending.size() && shim.pending[due].deliverAt <= now)
+	{
+		const std::vector<unsigned char>& packet = shim.pending[due].data;
+		shim.inner.send(shim.inner.context, packet.data(), (unsigned int)packet.size());
+		due++;
+	}
+
+	shim.pending.erase(shim.pending.begin(), shim.pending.begin() + due);
+}
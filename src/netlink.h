@@ -0,0 +1,64 @@
+#ifndef __NETLINK_H__
+#define __NETLINK_H__
+
+#include <deque>
+#include <vector>
+
+constexpr unsigned int maxDatagramSize = 1400; // najwiekszy pakiet, ktory nie zostanie podzielony po drodze
+
+// LACZE DO DRUGIEGO GRACZA - datagramy bez gwarancji dostarczenia i kolejnosci
+struct NetLink {
+	void* context;
+	bool (*send)(void* context, const void* data, unsigned int size); // false - pakiet nie zostal wyslany
+	int (*receive)(void* context, void* data, unsigned int capacity); // rozmiar odebranego pakietu, 0 - brak pakietow
+};
+
+// GNIAZDO UDP POLACZONE Z JEDNYM ADRESEM
+struct UdpLink {
+	long long socket; // uchwyt gniazda (int na Linuksie, SOCKET na Windows)
+	unsigned int peerAddress; // IPv4 drugiego gracza (kolejnosc bajtow sieci)
+	unsigned short peerPort; // port drugiego gracza (kolejnosc bajtow sieci)
+};
+
+// LACZE W PAMIECI MIEDZY DWOMA SESJAMI W JEDNYM PROCESIE
+struct LoopbackChannel;
+
+struct LoopbackEndpoint {
+	LoopbackChannel* channel;
+	int side; // 0 lub 1
+};
+
+struct LoopbackChannel {
+	std::deque<std::vector<unsigned char>> queues[2]; // pakiety czekajace na strone 0 i 1
+	LoopbackEndpoint endpoints[2];
+};
+
+// PAKIET ZATRZYMANY PRZEZ SYMULATOR OPOZNIEN
+struct DelayedPacket {
+	double deliverAt; // czas, od ktorego pakiet moze byc dostarczony
+	std::vector<unsigned char> data;
+};
+
+// SYMULATOR OPOZNIEN I STRAT NAKLADANY NA INNE LACZE (po stronie wysylajacego)
+struct NetShim {
+	NetLink inner; // lacze, do ktorego trafiaja przepuszczone pakiety
+	double delay; // opoznienie w jedna strone w sekundach
+	double jitter; // losowy dodatek do opoznienia (0..jitter s) - moze zmieniac kolejnosc pakietow
+	double loss; // prawdopodobienstwo zgubienia pakietu (0..1)
+	unsigned int rngState; // generator strat i rozrzutu (xorshift32, rozny od zera)
+	double now; // biezacy czas ustawiany przez pumpShim()
+	std::vector<DelayedPacket> pending;
+	unsigned long long dropped; // liczba zgubionych pakietow
+};
+
+bool openUdpLink(UdpLink& udp, unsigned short localPort, const char* peerHost, unsigned short peerPort);
+void closeUdpLink(UdpLink& udp);
+NetLink udpNetLink(UdpLink& udp);
+
+void loopbackNetLinks(LoopbackChannel& channel, NetLink& first, NetLink& second);
+
+void initShim(NetShim& shim, const NetLink& inner, double delay, double jitter, double loss, unsigned int seed);
+NetLink shimNetLink(NetShim& shim);
+void pumpShim(NetShim& shim, double now);
+
+#endif /* __NETLINK_H__ */
@@ -0,0 +1,693 @@
+#include <iostream>
+#include <cstring>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "packetio.h"
+
+constexpr unsigned int maxGsoSegments = 64; // najstarsze jadra z UDP GSO przyjmuja do 64 segmentow
+constexpr unsigned int maxGsoBytes = 65000;
+constexpr unsigned int uringEntries = 2 * packetBatchSize; // odbiory + jedna paczka wysylania
+constexpr unsigned long long uringReceive = 1ull << 32; // rodzaj zgloszenia w user_data
+constexpr unsigned long long uringSend = 2ull << 32;
+constexpr unsigned int uringBufferSize = sizeof(io_uring_recvmsg_out) + sizeof(sockaddr_in) + packetSlotSize;
+constexpr unsigned short uringBufferGroup = 0;
+
+// PIERSCIENIE IO_URING (bez liburing - mmap i wywolania systemowe wprost)
+struct UringRing {
+	int fd;
+	unsigned int* sqHead;
+	unsigned int* sqTail;
+	unsigned int sqMask;
+	unsigned int* sqArray;
+	io_uring_sqe* sqes;
+	unsigned int sqLocalTail; // zgloszenia przygotowane, ale jeszcze nie oddane jadru
+	unsigned int toSubmit;
+
+	unsigned int* cqHead;
+	unsigned int* cqTail;
+	unsigned int cqMask;
+	io_uring_cqe* cqes;
+
+	void* sqRing;
+	size_t sqRingSize;
+	void* cqRing;
+	size_t cqRingSize;
+	size_t sqesSize;
+};
+
+struct PacketIoState {
+	// WYSYLANIE
+	mmsghdr sendMessages[packetBatchSize];
+	iovec sendVectors[packetBatchSize];
+	sockaddr_in sendAddresses[packetBatchSize];
+	unsigned int sendCount;
+	unsigned char arena[packetArenaSize];
+	unsigned int arenaUsed;
+
+	// GSO: pakiety sklejone w wiadomosci z segmentami tej samej dlugosci
+	mmsghdr gsoMessages[packetBatchSize];
+	unsigned int gsoSegments[packetBatchSize]; // liczba pakietow w wiadomosci
+	char gsoControl[packetBatchSize][CMSG_SPACE(sizeof(unsigned short))];
+
+	// ODBIOR
+	mmsghdr receiveMessages[packetBatchSize];
+	iovec receiveVectors[packetBatchSize];
+	sockaddr_in receiveAddresses[packetBatchSize];
+	unsigned char receiveBuffers[packetBatchSize][packetSlotSize];
+	ReceivedPacket received[packetBatchSize];
+
+	// IO_URING: jeden odbior wielokrotny (multishot) z pierscieniem buforow dostarczanych przez nas;
+	// bufory oddane w receiveBatch() wracaja do pierscienia przy nastepnym wywolaniu
+	UringRing ring;
+	io_uring_buf* bufferRing; // io_uring_buf_ring jako zwykla tablica (w C++ pusta struktura z makra przesuwa bufs)
+	unsigned short bufferTail;
+	unsigned char uringBuffers[packetBatchSize][uringBufferSize];
+	msghdr uringMessage; // tylko dlugosci adresu i danych sterujacych dla odbioru wielokrotnego
+	bool receiveArmed;
+	unsigned short readyBuffers[packetBatchSize];
+	int readyResults[packetBatchSize];
+	unsigned int readyCount;
+	unsigned short lentBuffers[packetBatchSize];
+	unsigned int lentCount;
+};
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwracajaca nazwe sposobu wysylania pakietow
+**------------------------------------------------------------------------------------------*/
+const char* packetBackendName(PacketBackend backend)
+{
+	switch (backend)
+	{
+	case PACKET_IO_BASIC:
+		return "basic";
+	case PACKET_IO_MMSG:
+		return "mmsg";
+	case PACKET_IO_GSO:
+		return "gso";
+	case PACKET_IO_URING:
+		return "uring";
+	}
+
+	return "?";
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja odczytujaca sposob wysylania pakietow z nazwy (basic, mmsg, gso, uring)
+**------------------------------------------------------------------------------------------*/
+bool parsePacketBackend(const char* name, PacketBackend& backend)
+{
+	for (int b = PACKET_IO_BASIC; b <= PACKET_IO_URING; b++)
+	{
+		if (!strcmp(name, packetBackendName((PacketBackend)b)))
+		{
+			backend = (PacketBackend)b;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// ---------------------------------------------------------------------------------------
+// IO_URING
+// ---------------------------------------------------------------------------------------
+
+static bool openRing(UringRing& ring, unsigned int entries)
+{
+	io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	params.cq_entries = 2 * entries;
+	params.flags = IORING_SETUP_CQSIZE;
+
+	ring.fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+	if (ring.fd < 0)
+		return false;
+
+	ring.sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+	ring.cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+	{
+		if (ring.cqRingSize > ring.sqRingSize)
+			ring.sqRingSize = ring.cqRingSize;
+		ring.cqRingSize = ring.sqRingSize;
+	}
+
+	ring.sqRing = mmap(nullptr, ring.sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQ_RING);
+	ring.cqRing = (params.features & IORING_FEAT_SINGLE_MMAP) ? ring.sqRing
+		: mmap(nullptr, ring.cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_CQ_RING);
+	ring.sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+	ring.sqes = (io_uring_sqe*)mmap(nullptr, ring.sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQES);
+
+	if (ring.sqRing == MAP_FAILED || ring.cqRing == MAP_FAILED || ring.sqes == MAP_FAILED)
+	{
+		close(ring.fd);
+		ring.fd = -1;
+		return false;
+	}
+
+	unsigned char* sq = (unsigned char*)ring.sqRing;
+	ring.sqHead = (unsigned int*)(sq + params.sq_off.head);
+	ring.sqTail = (unsigned int*)(sq + params.sq_off.tail);
+	ring.sqMask = *(unsigned int*)(sq + params.sq_off.ring_mask);
+	ring.sqArray = (unsigned int*)(sq + params.sq_off.array);
+	ring.sqLocalTail = *ring.sqTail;
+	ring.toSubmit = 0;
+
+	unsigned char* cq = (unsigned char*)ring.cqRing;
+	ring.cqHead = (unsigned int*)(cq + params.cq_off.head);
+	ring.cqTail = (unsigned int*)(cq + params.cq_off.tail);
+	ring.cqMask = *(unsigned int*)(cq + params.cq_off.ring_mask);
+	ring.cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+
+	return true;
+}
+
+static void closeRing(UringRing& ring)
+{
+	if (ring.fd < 0)
+		return;
+
+	munmap(ring.sqes, ring.sqesSize);
+	if (ring.cqRing != ring.sqRing)
+		munmap(ring.cqRing, ring.cqRingSize);
+	munmap(ring.sqRing, ring.sqRingSize);
+	close(ring.fd);
+	ring.fd = -1;
+}
+
+// nowe zgloszenie (jadro widzi je po enterRing())
+static io_uring_sqe* nextSqe(UringRing& ring)
+{
+	unsigned int index = ring.sqLocalTail & ring.sqMask;
+	ring.sqArray[index] = index;
+	ring.sqLocalTail++;
+	ring.toSubmit++;
+
+	io_uring_sqe* sqe = &ring.sqes[index];
+	memset(sqe, 0, sizeof(*sqe));
+	return sqe;
+}
+
+static int enterRing(PacketIo& io, unsigned int minComplete)
+{
+	UringRing& ring = io.state->ring;
+
+	__atomic_store_n(ring.sqTail, ring.sqLocalTail, __ATOMIC_RELEASE);
+	unsigned int flags = minComplete > 0 ? IORING_ENTER_GETEVENTS : 0;
+	int result = (int)syscall(__NR_io_uring_enter, ring.fd, ring.toSubmit, minComplete, flags, nullptr, 0);
+	io.stats.syscalls++;
+
+	if (result > 0)
+		ring.toSubmit -= (unsigned int)result < ring.toSubmit ? (unsigned int)result : ring.toSubmit;
+	return result;
+}
+
+// zwraca bufor do pierscienia, z ktorego jadro bierze miejsce na kolejne pakiety
+static void provideBuffer(PacketIoState& state, unsigned short buffer)
+{
+	io_uring_buf& entry = state.bufferRing[state.bufferTail & (packetBatchSize - 1)];
+	entry.addr = (unsigned long long)state.uringBuffers[buffer];
+	entry.len = uringBufferSize;
+	entry.bid = buffer;
+	state.bufferTail++;
+}
+
+static void publishBuffers(PacketIoState& state)
+{
+	// ogon pierscienia lezy w polu resv pierwszego wpisu
+	__atomic_store_n(&state.bufferRing[0].resv, state.bufferTail, __ATOMIC_RELEASE);
+}
+
+// odbior wielokrotny: jedno zgloszenie daje zakonczenie na kazdy pakiet, dopoki sa bufory
+static void armReceive(PacketIoState& state, int socket)
+{
+	state.uringMessage.msg_namelen = sizeof(sockaddr_in);
+	state.uringMessage.msg_controllen = 0;
+
+	io_uring_sqe* sqe = nextSqe(state.ring);
+	sqe->opcode = IORING_OP_RECVMSG;
+	sqe->fd = socket;
+	sqe->addr = (unsigned long long)&state.uringMessage;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->buf_group = uringBufferGroup;
+	sqe->ioprio = IORING_RECV_MULTISHOT;
+	sqe->user_data = uringReceive;
+	state.receiveArmed = true;
+}
+
+// zbiera zakonczone zgloszenia; odbiory trafiaja do readyBuffers, zwraca liczbe zakonczonych wysylek
+static unsigned int reapRing(PacketIo& io)
+{
+	PacketIoState& state = *io.state;
+	UringRing& ring = state.ring;
+	unsigned int sends = 0;
+
+	unsigned int head = *ring.cqHead;
+	unsigned int tail = __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE);
+	while (head != tail)
+	{
+		const io_uring_cqe& cqe = ring.cqes[head & ring.cqMask];
+		if ((cqe.user_data & ~0xFFFFFFFFull) == uringSend)
+		{
+			sends++;
+			if (cqe.res < 0)
+				io.stats.sendFailures++;
+			else
+				io.stats.packetsOut++;
+		}
+		else
+		{
+			if (!(cqe.flags & IORING_CQE_F_MORE))
+				state.receiveArmed = false; // np. zabraklo buforow - trzeba zglosic odbior ponownie
+			if (cqe.flags & IORING_CQE_F_BUFFER)
+			{
+				state.readyBuffers[state.readyCount] = (unsigned short)(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+				state.readyResults[state.readyCount] = cqe.res;
+				state.readyCount++;
+			}
+		}
+		head++;
+	}
+	__atomic_store_n(ring.cqHead, head, __ATOMIC_RELEASE);
+
+	return sends;
+}
+
+// ---------------------------------------------------------------------------------------
+
+/*------------------------------------------------------------------------------------------
+** funkcja przygotowujaca warstwe pakietow na gniezdzie UDP
+** socket - gniazdo (nieblokujace; przy io_uring przelaczane na blokujace - jadro samo czeka na pakiety)
+** backend - sposob wysylania i odbioru
+** funkcja zwraca false, jesli wybrany sposob nie jest dostepny w tym jadrze
+**------------------------------------------------------------------------------------------*/
+bool openPacketIo(PacketIo& io, int socket, PacketBackend backend)
+{
+	io.backend = backend;
+	io.socket = socket;
+	io.readyFd = socket;
+	io.state = new PacketIoState();
+	io.stats = PacketIoStats();
+
+	PacketIoState& state = *io.state;
+	state.ring.fd = -1;
+
+	for (unsigned int i = 0; i < packetBatchSize; i++)
+	{
+		msghdr& message = state.receiveMessages[i].msg_hdr;
+		state.receiveVectors[i].iov_base = state.receiveBuffers[i];
+		state.receiveVectors[i].iov_len = packetSlotSize;
+		message.msg_name = &state.receiveAddresses[i];
+		message.msg_namelen = sizeof(sockaddr_in);
+		message.msg_iov = &state.receiveVectors[i];
+		message.msg_iovlen = 1;
+
+		msghdr& sent = state.sendMessages[i].msg_hdr;
+		sent.msg_name = &state.sendAddresses[i];
+		sent.msg_namelen = sizeof(sockaddr_in);
+		sent.msg_iov = &state.sendVectors[i];
+		sent.msg_iovlen = 1;
+	}
+
+	if (backend == PACKET_IO_GSO)
+	{
+		int segment = 0;
+		if (setsockopt(socket, SOL_UDP, UDP_SEGMENT, &segment, sizeof(segment)) != 0)
+		{
+			std::cerr << "UDP GSO niedostepne w tym jadrze" << std::endl;
+			closePacketIo(io);
+			return false;
+		}
+	}
+
+	if (backend == PACKET_IO_URING)
+	{
+		if (!openRing(state.ring, uringEntries))
+		{
+			std::cerr << "io_uring niedostepne (" << strerror(errno) << ")" << std::endl;
+			closePacketIo(io);
+			return false;
+		}
+
+		// pierscien buforow odbioru (mmap - wyrownany do strony)
+		state.bufferRing = (io_uring_buf*)mmap(nullptr, packetBatchSize * sizeof(io_uring_buf), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (state.bufferRing == MAP_FAILED)
+			state.bufferRing = nullptr;
+
+		io_uring_buf_reg registration;
+		memset(&registration, 0, sizeof(registration));
+		registration.ring_addr = (unsigned long long)state.bufferRing;
+		registration.ring_entries = packetBatchSize;
+		registration.bgid = uringBufferGroup;
+		if (!state.bufferRing || syscall(__NR_io_uring_register, state.ring.fd, IORING_REGISTER_PBUF_RING, &registration, 1) != 0)
+		{
+			std::cerr << "io_uring bez pierscienia buforow odbioru (potrzebne jadro 6.0+)" << std::endl;
+			closePacketIo(io);
+			return false;
+		}
+		state.bufferTail = 0;
+		for (unsigned int i = 0; i < packetBatchSize; i++)
+		{
+			provideBuffer(state, (unsigned short)i);
+		}
+		publishBuffers(state);
+
+		// powiadomienia o zakonczonych zgloszeniach przez eventfd - do tej samej petli epoll
+		io.readyFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (io.readyFd < 0 || syscall(__NR_io_uring_register, state.ring.fd, IORING_REGISTER_EVENTFD, &io.readyFd, 1) != 0)
+		{
+			std::cerr << "io_uring bez powiadomien eventfd (" << strerror(errno) << ")" << std::endl;
+			closePacketIo(io);
+			return false;
+		}
+
+		fcntl(socket, F_SETFL, fcntl(socket, F_GETFL) & ~O_NONBLOCK);
+
+		armReceive(state, socket);
+		enterRing(io, 0);
+	}
+
+	return true;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwalniajaca bufory warstwy pakietow (gniazdo nalezy do wywolujacego)
+**------------------------------------------------------------------------------------------*/
+void closePacketIo(PacketIo& io)
+{
+	if (!io.state)
+		return;
+
+	if (io.backend == PACKET_IO_URING && io.state->ring.fd >= 0)
+	{
+		closeRing(io.state->ring);
+		if (io.state->bufferRing)
+			munmap(io.state->bufferRing, packetBatchSize * sizeof(io_uring_buf));
+		// przed utworzeniem eventfd readyFd to gniazdo wywolujacego, ktorego nie wolno zamknac
+		if (io.readyFd >= 0 && io.readyFd != io.socket)
+			close(io.readyFd);
+		io.readyFd = io.socket;
+		fcntl(io.socket, F_SETFL, fcntl(io.socket, F_GETFL) | O_NONBLOCK);
+	}
+
+	delete io.state;
+	io.state = nullptr;
+}
+
+static void addReceived(PacketIo& io, unsigned int count, unsigned int slot, unsigned int size)
+{
+	PacketIoState& state = *io.state;
+	ReceivedPacket& packet = state.received[count];
+	packet.data = state.receiveBuffers[slot];
+	packet.size = size;
+	packet.address = state.receiveAddresses[slot].sin_addr.s_addr;
+	packet.port = state.receiveAddresses[slot].sin_port;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja odbierajaca pakiety czekajace w gniezdzie (bez czekania)
+** packets - wynik: tablica odebranych pakietow, wazna do nastepnego wywolania
+** funkcja zwraca liczbe pakietow (najwyzej packetBatchSize; 0 - nic nie czeka)
+**------------------------------------------------------------------------------------------*/
+unsigned int receiveBatch(PacketIo& io, const ReceivedPacket*& packets)
+{
+	PacketIoState& state = *io.state;
+	unsigned int count = 0;
+	packets = state.received;
+
+	if (io.backend == PACKET_IO_BASIC)
+	{
+		while (count < packetBatchSize)
+		{
+			socklen_t fromSize = sizeof(sockaddr_in);
+			ssize_t size = recvfrom(io.socket, state.receiveBuffers[count], packetSlotSize, MSG_TRUNC,
+				(sockaddr*)&state.receiveAddresses[count], &fromSize);
+			io.stats.syscalls++;
+			if (size < 0)
+				break;
+			if (size > (ssize_t)packetSlotSize)
+				continue;
+
+			addReceived(io, count, count, (unsigned int)size);
+			count++;
+		}
+	}
+	else if (io.backend == PACKET_IO_MMSG || io.backend == PACKET_IO_GSO)
+	{
+		for (unsigned int i = 0; i < packetBatchSize; i++)
+		{
+			state.receiveMessages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+		}
+
+		int received = recvmmsg(io.socket, state.receiveMessages, packetBatchSize, MSG_DONTWAIT, nullptr);
+		io.stats.syscalls++;
+
+		for (int i = 0; i < received; i++)
+		{
+			if (state.receiveMessages[i].msg_hdr.msg_flags & MSG_TRUNC)
+				continue;
+			addReceived(io, count, i, state.receiveMessages[i].msg_len);
+			count++;
+		}
+	}
+	else
+	{
+		// bufory oddane w poprzednim wywolaniu wracaja do pierscienia
+		for (unsigned int i = 0; i < state.lentCount; i++)
+		{
+			provideBuffer(state, state.lentBuffers[i]);
+		}
+		if (state.lentCount > 0)
+			publishBuffers(state);
+		state.lentCount = 0;
+
+		unsigned long long events;
+		if (read(io.readyFd, &events, sizeof(events)) > 0)
+			io.stats.syscalls++;
+
+		reapRing(io);
+		if (!state.receiveArmed)
+		{
+			armReceive(state, io.socket);
+			enterRing(io, 0);
+		}
+
+		for (unsigned int i = 0; i < state.readyCount; i++)
+		{
+			unsigned short buffer = state.readyBuffers[i];
+			state.lentBuffers[state.lentCount++] = buffer;
+			if (state.readyResults[i] < 0)
+				continue;
+
+			// bufor: naglowek io_uring_recvmsg_out, adres nadawcy, dane
+			const unsigned char* data = state.uringBuffers[buffer];
+			io_uring_recvmsg_out header;
+			memcpy(&header, data, sizeof(header));
+			if (header.flags & MSG_TRUNC)
+				continue;
+
+			sockaddr_in from;
+			memcpy(&from, data + sizeof(header), sizeof(from));
+
+			ReceivedPacket& packet = state.received[count++];
+			packet.data = data + sizeof(header) + sizeof(sockaddr_in);
+			packet.size = header.payloadlen;
+			packet.address = from.sin_addr.s_addr;
+			packet.port = from.sin_port;
+		}
+		state.readyCount = 0;
+	}
+
+	io.stats.packetsIn += count;
+	return count;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwracajaca miejsce na budowany pakiet (wazne do wyslania); po wypelnieniu trzeba
+** go od razu podac do queuePacket(); gdy paczka jest pelna, jest najpierw wysylana
+**------------------------------------------------------------------------------------------*/
+unsigned char* allocPacket(PacketIo& io, unsigned int size)
+{
+	PacketIoState& state = *io.state;
+	unsigned int aligned = (size + 7) & ~7u;
+
+	if (state.sendCount == packetBatchSize || state.arenaUsed + aligned > packetArenaSize)
+		flushPackets(io);
+
+	unsigned char* data = state.arena + state.arenaUsed;
+	state.arenaUsed += aligned;
+	return data;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja dopisujaca pakiet do paczki wysylania (bez kopiowania - dane musza istniec do
+** flushPackets(); pelna paczka jest wysylana od razu)
+** address, port - adresat (kolejnosc bajtow sieci)
+**------------------------------------------------------------------------------------------*/
+void queuePacket(PacketIo& io, unsigned int address, unsigned short port, const unsigned char* data, unsigned int size)
+{
+	PacketIoState& state = *io.state;
+	if (state.sendCount == packetBatchSize)
+		flushPackets(io);
+
+	unsigned int i = state.sendCount++;
+	state.sendAddresses[i].sin_family = AF_INET;
+	state.sendAddresses[i].sin_addr.s_addr = address;
+	state.sendAddresses[i].sin_port = port;
+	state.sendVectors[i].iov_base = (void*)data;
+	state.sendVectors[i].iov_len = size;
+}
+
+// wysyla wiadomosci przez sendmmsg; segments - liczba pakietow w kazdej wiadomosci (nullptr - po jednym)
+static void sendMessages(PacketIo& io, mmsghdr* messages, unsigned int count, const unsigned int* segments)
+{
+	unsigned int first = 0;
+	while (first < count)
+	{
+		int sent = sendmmsg(io.socket, messages + first, count - first, 0);
+		io.stats.syscalls++;
+
+		if (sent < 0)
+		{
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+			{
+				// pelny bufor gniazda - reszta paczki przepada jak zgubione pakiety UDP
+				for (unsigned int i = first; i < count; i++)
+					io.stats.sendFailures += segments ? segments[i] : 1;
+				return;
+			}
+			io.stats.sendFailures += segments ? segments[first] : 1;
+			first++;
+			continue;
+		}
+
+		for (int i = 0; i < sent; i++)
+			io.stats.packetsOut += segments ? segments[first + i] : 1;
+		first += sent;
+	}
+}
+
+// skleja kolejne pakiety do tego samego adresu o tej samej dlugosci (ostatni moze byc krotszy)
+static void sendGso(PacketIo& io)
+{
+	PacketIoState& state = *io.state;
+	unsigned int messages = 0;
+
+	for (unsigned int i = 0; i < state.sendCount;)
+	{
+		const sockaddr_in& to = state.sendAddresses[i];
+		unsigned int segmentSize = (unsigned int)state.sendVectors[i].iov_len;
+		unsigned int segments = 1;
+		unsigned int bytes = segmentSize;
+
+		while (i + segments < state.sendCount && segments < maxGsoSegments)
+		{
+			const sockaddr_in& next = state.sendAddresses[i + segments];
+			unsigned int size = (unsigned int)state.sendVectors[i + segments].iov_len;
+			if (next.sin_addr.s_addr != to.sin_addr.s_addr || next.sin_port != to.sin_port || size > segmentSize || bytes + size > maxGsoBytes)
+				break;
+
+			segments++;
+			bytes += size;
+			if (size < segmentSize)
+				break; // krotszy moze byc tylko ostatni segment
+		}
+
+		msghdr& message = state.gsoMessages[messages].msg_hdr;
+		memset(&message, 0, sizeof(message));
+		message.msg_name = &state.sendAddresses[i];
+		message.msg_namelen = sizeof(sockaddr_in);
+		message.msg_iov = &state.sendVectors[i]; // wektory pakietow leza obok siebie - jadro je sklei
+		message.msg_iovlen = segments;
+
+		if (segments > 1)
+		{
+			message.msg_control = state.gsoControl[messages];
+			message.msg_controllen = CMSG_SPACE(sizeof(unsigned short));
+			cmsghdr* control = CMSG_FIRSTHDR(&message);
+			control->cmsg_level = SOL_UDP;
+			control->cmsg_type = UDP_SEGMENT;
+			control->cmsg_len = CMSG_LEN(sizeof(unsigned short));
+			unsigned short gsoSize = (unsigned short)segmentSize;
+			memcpy(CMSG_DATA(control), &gsoSize, sizeof(gsoSize));
+		}
+
+		state.gsoSegments[messages] = segments;
+		messages++;
+		i += segments;
+	}
+
+	sendMessages(io, state.gsoMessages, messages, state.gsoSegments);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja wysylajaca paczke zakolejkowanych pakietow
+** funkcja zwraca liczbe pakietow, ktorych nie udalo sie wyslac
+**------------------------------------------------------------------------------------------*/
+unsigned int flushPackets(PacketIo& io)
+{
+	PacketIoState& state = *io.state;
+	unsigned long long failuresBefore = io.stats.sendFailures;
+
+	if (state.sendCount == 0)
+		return 0;
+
+	if (io.backend == PACKET_IO_BASIC)
+	{
+		for (unsigned int i = 0; i < state.sendCount; i++)
+		{
+			ssize_t sent = sendto(io.socket, state.sendVectors[i].iov_base, state.sendVectors[i].iov_len, 0,
+				(sockaddr*)&state.sendAddresses[i], sizeof(sockaddr_in));
+			io.stats.syscalls++;
+			if (sent == (ssize_t)state.sendVectors[i].iov_len)
+				io.stats.packetsOut++;
+			else
+				io.stats.sendFailures++;
+		}
+	}
+	else if (io.backend == PACKET_IO_MMSG)
+	{
+		sendMessages(io, state.sendMessages, state.sendCount, nullptr);
+	}
+	else if (io.backend == PACKET_IO_GSO)
+	{
+		sendGso(io);
+	}
+	else
+	{
+		for (unsigned int i = 0; i < state.sendCount; i++)
+		{
+			io_uring_sqe* sqe = nextSqe(state.ring);
+			sqe->opcode = IORING_OP_SENDMSG;
+			sqe->fd = io.socket;
+			sqe->addr = (unsigned long long)&state.sendMessages[i].msg_hdr;
+			sqe->len = 1;
+			sqe->user_data = uringSend | i;
+		}
+
+		// bufory paczki sa uzywane ponownie, wiec czekamy na zakonczenie wszystkich wysylek
+		unsigned int pending = state.sendCount;
+		enterRing(io, pending);
+		pending -= reapRing(io);
+		while (pending > 0)
+		{
+			enterRing(io, 1);
+			pending -= reapRing(io);
+		}
+	}
+
+	state.sendCount = 0;
+	state.arenaUsed = 0;
+
+	return (unsigned int)(io.stats.sendFailures - failuresBefore);
+}
@@ -0,0 +1,53 @@
+#ifndef __PACKETIO_H__
+#define __PACKETIO_H__
+
+// SPOSOBY WYSYLANIA I ODBIERANIA PAKIETOW UDP (Linux)
+enum PacketBackend {
+	PACKET_IO_BASIC = 0, // sendto/recvfrom - wywolanie systemowe na kazdy pakiet
+	PACKET_IO_MMSG = 1, // sendmmsg/recvmmsg - jedno wywolanie na paczke pakietow
+	PACKET_IO_GSO = 2, // jak MMSG, a kolejne pakiety do tego samego adresu sklejane przez UDP GSO
+	PACKET_IO_URING = 3 // io_uring: kolejka zgloszen wysylania i stale oczekujace odbiory
+};
+
+constexpr unsigned int packetBatchSize = 256; // najwiecej pakietow na wywolanie systemowe
+constexpr unsigned int packetSlotSize = 256; // bufor jednego odbieranego pakietu (dluzsze sa odrzucane)
+constexpr unsigned int packetArenaSize = packetBatchSize * 64; // miejsce na pakiety budowane przez allocPacket()
+
+// ODEBRANY PAKIET - dane w buforach PacketIo, wazne do nastepnego receiveBatch()
+struct ReceivedPacket {
+	const unsigned char* data;
+	unsigned int size;
+	unsigned int address; // IPv4 nadawcy (kolejnosc bajtow sieci)
+	unsigned short port; // port nadawcy (kolejnosc bajtow sieci)
+};
+
+// STATYSTYKI OD OSTATNIEGO ZEROWANIA
+struct PacketIoStats {
+	unsigned long long packetsIn;
+	unsigned long long packetsOut;
+	unsigned long long sendFailures;
+	unsigned long long syscalls; // wywolania systemowe wysylania i odbioru
+};
+
+struct PacketIoState; // bufory i kolejki zalezne od sposobu (packetio.cpp)
+
+// WARSTWA PAKIETOW NA JEDNYM GNIEZDZIE UDP - pakiety do wyslania sa kolejkowane (bez kopiowania)
+// i wysylane paczka w flushPackets(), odbior zwraca od razu wszystko, co czeka
+struct PacketIo {
+	PacketBackend backend;
+	int socket;
+	int readyFd; // deskryptor do epoll - czytelny, gdy moga czekac pakiety (gniazdo albo eventfd io_uring)
+	PacketIoState* state;
+	PacketIoStats stats;
+};
+
+bool openPacketIo(PacketIo& io, int socket, PacketBackend backend);
+void closePacketIo(PacketIo& io);
+unsigned int receiveBatch(PacketIo& io, const ReceivedPacket*& packets);
+unsigned char* allocPacket(PacketIo& io, unsigned int size);
+void queuePacket(PacketIo& io, unsigned int address, unsigned short port, const unsigned char* data, unsigned int size);
+unsigned int flushPackets(PacketIo& io);
+const char* packetBackendName(PacketBackend backend);
+bool parsePacketBackend(const char* name, PacketBackend& backend);
+
+#endif /* __PACKETIO_H__ */
@@ -0,0 +1,432 @@
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+#include "sim.h"
+#include "batch.h"
+#include "bots.h"
+
+// PARAMETRY POMIAROW
+struct BenchOptions {
+	unsigned int repetitions = 10; // mierzone powtorzenia kazdego pomiaru (rozgrzewa kalibracja liczby operacji)
+	double minTime = 0.1; // najkrotszy czas jednego powtorzenia w sekundach
+	unsigned int points = 3; // do ilu punktow gra sie mecz (match)
+	float dt = 1.0f / 60.0f;
+	std::string filter; // tylko pomiary z tym fragmentem nazwy
+	std::string json; // plik wynikow JSON ("-" - standardowe wyjscie zamiast tabeli)
+};
+
+// POMIAR - ops operacji, zwraca liczbe krokow symulacji, ktore w nich wykonano (0 - nie dotyczy)
+struct Benchmark {
+	const char* name;
+	const char* description;
+	unsigned long long (*run)(unsigned long long ops, const BenchOptions& options);
+};
+
+// WYNIK POMIARU
+struct BenchResult {
+	const Benchmark* benchmark;
+	unsigned long long ops; // operacje w jednym powtorzeniu
+	double ticksPerOp;
+	std::vector<double> nsPerOp; // kolejne powtorzenia
+	double mean, median, stddev, min, max;
+};
+
+static volatile unsigned int sink; // wyniki, ktorych kompilator nie moze usunac
+
+void printUsage();
+bool parseBenchOptions(int argc, char* argv[], int first, BenchOptions& options);
+
+/*------------------------------------------------------------------------------------------
+** pomiar step(): jeden krok meczu z ustalona sekwencja 64 masek klawiszy (mecz toczy sie dalej
+** po punktach, wiec sa tu wymiany, odbicia i serwy)
+**------------------------------------------------------------------------------------------*/
+static unsigned long long benchStep(unsigned long long ops, const BenchOptions& options)
+{
+	World world;
+	initWorld(world, 1);
+
+	unsigned int keys[64];
+	for (int i = 0; i < 64; i++)
+	{
+		keys[i] = (unsigned int)(i * 7 + (i >> 3)) & (INPUT_LEFT_UP | INPUT_LEFT_DOWN | INPUT_RIGHT_UP | INPUT_RIGHT_DOWN);
+	}
+
+	unsigned int scored = 0;
+	for (unsigned long long n = 0; n < ops; n++)
+	{
+		Inputs inputs = { keys[n & 63] };
+		scored += step(world, inputs, options.dt);
+	}
+	sink = scored + (unsigned int)world.ball.y;
+
+	return ops;
+}
+
+/*------------------------------------------------------------------------------------------
+** pomiar kroku petli gry: decyzje trackingBot obu rakietek i step()
+**------------------------------------------------------------------------------------------*/
+static unsigned long long benchStepWithBots(unsigned long long ops, const BenchOptions& options)
+{
+	World world;
+	initWorld(world, 1);
+
+	for (unsigned long long n = 0; n < ops; n++)
+	{
+		Inputs inputs = { trackingBot(world, 0) | trackingBot(world, 1) };
+		step(world, inputs, options.dt);
+	}
+	sink = (unsigned int)world.ball.y;
+
+	return ops;
+}
+
+/*------------------------------------------------------------------------------------------
+** pomiar timeToRacket(): test zderzenia pileczki z rakietka dla 1024 roznych polozen
+** i predkosci (trafienia w bok, w krawedz i chybienia)
+**------------------------------------------------------------------------------------------*/
+static unsigned long long benchRacketCollision(unsigned long long ops, const BenchOptions&)
+{
+	const unsigned int cases = 1024;
+	static float dx[cases], dy[cases], vx[cases], vy[cases];
+
+	unsigned int state = 12345;
+	auto next = [&state]() {
+		state = state * 1664525u + 1013904223u;
+		return (float)(state >> 8) / (float)(1u << 24);
+	};
+	for (unsigned int i = 0; i < cases; i++)
+	{
+		dx[i] = (next() - 0.5f) * 200.0f;
+		dy[i] = (next() - 0.5f) * 200.0f;
+		vx[i] = (next() - 0.5f) * 800.0f;
+		vy[i] = (next() - 0.5f) * 800.0f;
+	}
+
+	float sum = 0.0f;
+	unsigned int edges = 0;
+	for (unsigned long long n = 0; n < ops; n++)
+	{
+		unsigned int i = (unsigned int)n & (cases - 1);
+		bool edge;
+		float t = timeToRacket(dx[i], dy[i], vx[i], vy[i], edge);
+		sum += t < 1e29f ? t : 0.0f;
+		edges += edge;
+	}
+	sink = edges + (unsigned int)sum;
+
+	return 0;
+}
+
+/*------------------------------------------------------------------------------------------
+** pomiar ballDirection(): serw z losowaniem Philox (kolejne numery serwow)
+**------------------------------------------------------------------------------------------*/
+static unsigned long long benchBallDirection(unsigned long long ops, const BenchOptions&)
+{
+	World world;
+	initWorld(world, 7);
+
+	float sum = 0.0f;
+	for (unsigned long long n = 0; n < ops; n++)
+	{
+		world.scoreForLeft = (unsigned int)n;
+		ballDirection(world, (unsigned int)(n % 3), ballServeSpeed, -ballServeMaxY, ballServeMaxY);
+		sum += world.ballVelocity.y;
+	}
+	sink = (unsigned int)sum;
+
+	return 0;
+}
+
+/*------------------------------------------------------------------------------------------
+** pomiar calego punktu trackingBot kontra trackingBot: od serwu do bramki
+**------------------------------------------------------------------------------------------*/
+static unsigned long long benchPoint(unsigned long long ops, const BenchOptions& options)
+{
+	unsigned long long ticks = 0;
+
+	for (unsigned long long n = 0; n < ops; n++)
+	{
+		World world;
+		initWorld(world, (unsigned int)n + 1);
+
+		unsigned int scored = 0;
+		while (!scored)
+		{
+			Inputs inputs = { trackingBot(world, 0) | trackingBot(world, 1) };
+			scored = step(world, inputs, options.dt);
+		}
+		ticks += world.tick;
+	}
+
+	return ticks;
+}
+
+/*------------------------------------------------------------------------------------------
+** pomiar calego meczu do --points punktow trackingBot kontra trackingBot
+**------------------------------------------------------------------------------------------*/
+static unsigned long long benchMatch(unsigned long long ops, const BenchOptions& options)
+{
+	unsigned long long ticks = 0;
+
+	for (unsigned long long n = 0; n < ops; n++)
+	{
+		World world;
+		initWorld(world, (unsigned int)n + 1);
+
+		while (world.scoreForLeft < options.points && world.scoreForRight < options.points)
+		{
+			Inputs inputs = { trackingBot(world, 0) | trackingBot(world, 1) };
+			step(world, inputs, options.dt);
+		}
+		ticks += world.tick;
+	}
+
+	return ticks;
+}
+
+/*------------------------------------------------------------------------------------------
+** pomiar stepBatch(): krok paczki 256 meczow najszybszym kernelem z decyzjami botow
+**------------------------------------------------------------------------------------------*/
+static unsigned long long benchBatchStep(unsigned long long ops, const BenchOptions& options)
+{
+	const unsigned int count = 256;
+
+	MatchBatch batch;
+	initBatch(batch, count, 1);
+	unsigned int* keys = new unsigned int[batch.capacity];
+
+	for (unsigned long long n = 0; n < ops; n++)
+	{
+		trackingBotBatch(batch, keys);
+		stepBatch(batch, keys, options.dt);
+	}
+	sink = (unsigned int)batch.ballY[0];
+
+	delete[] keys;
+	freeBatch(batch);
+
+	return ops * count;
+}
+
+static const Benchmark benchmarks[] = {
+	{ "step", "jeden krok step() w trakcie wymiany", benchStep },
+	{ "step_bots", "decyzje trackingBot obu rakietek i step()", benchStepWithBots },
+	{ "racket_collision", "timeToRacket() - test zderzenia z rakietka", benchRacketCollision },
+	{ "ball_direction", "ballDirection() - kierunek serwu", benchBallDirection },
+	{ "point", "punkt od serwu do bramki (trackingBot)", benchPoint },
+	{ "match", "mecz do --points punktow (trackingBot)", benchMatch },
+	{ "batch_step", "stepBatch() paczki 256 meczow z trackingBotBatch", benchBatchStep },
+};
+
+// czas ops operacji w sekundach
+static double timeOps(const Benchmark& benchmark, unsigned long long ops, const BenchOptions& options, unsigned long long& ticks)
+{
+	auto start = std::chrono::steady_clock::now();
+	ticks = benchmark.run(ops, options);
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja mierzaca jeden pomiar: liczba operacji dobierana tak, zeby powtorzenie trwalo
+** co najmniej --min-time (kalibracja rozgrzewa tez pamiec podreczna i zegar procesora),
+** potem --repetitions mierzonych powtorzen
+**------------------------------------------------------------------------------------------*/
+static BenchResult measure(const Benchmark& benchmark, const BenchOptions& options)
+{
+	BenchResult result;
+	result.benchmark = &benchmark;
+
+	unsigned long long ops = 1, ticks = 0;
+	double seconds = timeOps(benchmark, ops, options, ticks);
+	while (seconds < options.minTime && ops < (1ull << 40))
+	{
+		double scale = seconds > 0.0 ? options.minTime / seconds * 1.2 : 100.0;
+		ops = (unsigned long long)(ops * std::min(std::max(scale, 2.0), 100.0));
+		seconds = timeOps(benchmark, ops, options, ticks);
+	}
+	result.ops = ops;
+
+	double totalTicks = 0.0;
+	for (unsigned int r = 0; r < options.repetitions; r++)
+	{
+		seconds = timeOps(benchmark, ops, options, ticks);
+		result.nsPerOp.push_back(seconds / ops * 1e9);
+		totalTicks += (double)ticks;
+	}
+	result.ticksPerOp = totalTicks / ((double)ops * options.repetitions);
+
+	std::vector<double> sorted = result.nsPerOp;
+	std::sort(sorted.begin(), sorted.end());
+	size_t n = sorted.size();
+	result.median = n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2.0;
+	result.min = sorted.front();
+	result.max = sorted.back();
+
+	double sum = 0.0;
+	for (double value : sorted)
+	{
+		sum += value;
+	}
+	result.mean = sum / n;
+
+	double squares = 0.0;
+	for (double value : sorted)
+	{
+		squares += (value - result.mean) * (value - result.mean);
+	}
+	result.stddev = n > 1 ? sqrt(squares / (n - 1)) : 0.0;
+
+	return result;
+}
+
+// kroki symulacji na sekunde przy medianie czasu operacji (0 - pomiar bez krokow)
+static double ticksPerSecond(const BenchResult& result)
+{
+	return result.ticksPerOp > 0.0 && result.median > 0.0 ? result.ticksPerOp / result.median * 1e9 : 0.0;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zapisujaca wyniki jako JSON (jeden obiekt, pomiary w tablicy "benchmarks")
+**------------------------------------------------------------------------------------------*/
+static void writeJson(FILE* file, const std::vector<BenchResult>& results, const BenchOptions& options)
+{
+	fprintf(file, "{\n  \"context\": {\"kernel\": \"%s\", \"repetitions\": %u, \"min_time_s\": %g, \"dt\": %g, \"points\": %u},\n",
+		batchKernelName(BATCH_KERNEL_BEST), options.repetitions, options.minTime, options.dt, options.points);
+	fprintf(file, "  \"benchmarks\": [\n");
+
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const BenchResult& result = results[i];
+		fprintf(file, "    {\"name\": \"%s\", \"ops_per_repetition\": %llu, \"ns_per_op\": {\"median\": %.3f, \"mean\": %.3f, "
+			"\"stddev\": %.3f, \"min\": %.3f, \"max\": %.3f}, \"ticks_per_op\": %.3f, \"ticks_per_s\": %.1f, \"samples\": [",
+			result.benchmark->name, result.ops, result.median, result.mean, result.stddev, result.min, result.max,
+			result.ticksPerOp, ticksPerSecond(result));
+		for (size_t r = 0; r < result.nsPerOp.size(); r++)
+		{
+			fprintf(file, "%s%.3f", r ? ", " : "", result.nsPerOp[r]);
+		}
+		fprintf(file, "]}%s\n", i + 1 < results.size() ? "," : "");
+	}
+
+	fprintf(file, "  ]\n}\n");
+}
+
+int main(int argc, char* argv[])
+{
+	BenchOptions options;
+	if (!parseBenchOptions(argc, argv, 1, options))
+	{
+		printUsage();
+		return 1;
+	}
+
+	bool table = options.json != "-";
+	if (table)
+	{
+		printf("%-18s %14s %12s %8s %12s %16s\n", "pomiar", "ns/op (med.)", "min", "odch. %", "ops", "kroki/s");
+	}
+
+	std::vector<BenchResult> results;
+	for (const Benchmark& benchmark : benchmarks)
+	{
+		if (!options.filter.empty() && !strstr(benchmark.name, options.filter.c_str()))
+			continue;
+
+		BenchResult result = measure(benchmark, options);
+		results.push_back(result);
+
+		if (table)
+		{
+			printf("%-18s %14.2f %12.2f %8.2f %12llu %16.0f\n", benchmark.name, result.median, result.min,
+				result.mean > 0.0 ? result.stddev / result.mean * 100.0 : 0.0, result.ops, ticksPerSecond(result));
+			fflush(stdout);
+		}
+	}
+
+	if (options.json == "-")
+	{
+		writeJson(stdout, results, options);
+	}
+	else if (!options.json.empty())
+	{
+		FILE* file = fopen(options.json.c_str(), "w");
+		if (!file)
+		{
+			std::cerr << "Nie mozna zapisac " << options.json << std::endl;
+			return 1;
+		}
+		writeJson(file, results, options);
+		fclose(file);
+	}
+
+	return 0;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja wyswietlajaca sposob uzycia programu
+**------------------------------------------------------------------------------------------*/
+void printUsage()
+{
+	std::cerr << "Uzycie: pong_bench [opcje]\n"
+		<< "Pomiary:\n";
+	for (const Benchmark& benchmark : benchmarks)
+	{
+		std::cerr << "  " << benchmark.name << " - " << benchmark.description << "\n";
+	}
+	std::cerr << "Opcje:\n"
+		<< "  --repetitions N powtorzenia kazdego pomiaru\n"
+		<< "  --min-time S  najkrotszy czas powtorzenia w sekundach\n"
+		<< "  --points N    do ilu punktow gra sie mecz (match)\n"
+		<< "  --dt S        dlugosc kroku symulacji\n"
+		<< "  --filter F    tylko pomiary z F w nazwie\n"
+		<< "  --json PLIK   zapis wynikow JSON (\"-\" - na standardowe wyjscie zamiast tabeli)\n";
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja wczytujaca opcje z linii polecen
+** funkcja zwraca false jesli napotka nieznana lub niekompletna opcje
+**------------------------------------------------------------------------------------------*/
+bool parseBenchOptions(int argc, char* argv[], int first, BenchOptions& options)
+{
+	for (int i = first; i < argc; i++)
+	{
+		if (i + 1 >= argc)
+		{
+			std::cerr << "Brak wartosci dla opcji: " << argv[i] << std::endl;
+			return false;
+		}
+
+		const char* name = argv[i];
+		const char* value = argv[++i];
+
+		if (!strcmp(name, "--repetitions"))
+			options.repetitions = (unsigned int)strtoul(value, nullptr, 10);
+		else if (!strcmp(name, "--min-time"))
+			options.minTime = strtod(value, nullptr);
+		else if (!strcmp(name, "--points"))
+			options.points = (unsigned int)strtoul(value, nullptr, 10);
+		else if (!strcmp(name, "--dt"))
+			options.dt = strtof(value, nullptr);
+		else if (!strcmp(name, "--filter"))
+			options.filter = value;
+		else if (!strcmp(name, "--json"))
+			options.json = value;
+		else
+		{
+			std::cerr << "Nieznana opcja: " << name << std::endl;
+			return false;
+		}
+	}
+
+	if (options.repetitions == 0)
+		options.repetitions = 1;
+
+	return true;
+}
@@ -0,0 +1,457 @@
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <chrono>
+#include <vector>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "agentbridge.h"
+
+// PARAMETRY MOSTU I AGENTOW
+struct BridgeOptions {
+	std::string name = "/pong_bridge"; // nazwa pamieci wspoldzielonej
+	unsigned int channels = 4; // najwiecej procesow agentow
+	unsigned int envs = 256; // srodowiska na kanal
+	unsigned int agents = 2; // procesy agentow (bench)
+	unsigned int steps = 20000; // kroki na agenta (agent, bench)
+	unsigned int seed = 1; // ziarno pierwszego srodowiska agenta
+	PongEnvOptions env; // parametry srodowisk
+};
+
+static volatile int stopRequested = 0;
+
+void printUsage();
+bool parseBridgeOptions(int argc, char* argv[], int first, BridgeOptions& options);
+int runServe(const BridgeOptions& options);
+int runAgent(const BridgeOptions& options);
+int runBench(const BridgeOptions& options);
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		printUsage();
+		return 1;
+	}
+
+	signal(SIGINT, [](int) { stopRequested = 1; });
+	signal(SIGTERM, [](int) { stopRequested = 1; });
+
+	BridgeOptions options;
+	pongEnvDefaultOptions(&options.env);
+	if (!parseBridgeOptions(argc, argv, 2, options))
+	{
+		printUsage();
+		return 1;
+	}
+
+	std::string command = argv[1];
+
+	if (command == "serve")
+	{
+		return runServe(options);
+	}
+	if (command == "agent")
+	{
+		return runAgent(options);
+	}
+	if (command == "bench")
+	{
+		return runBench(options);
+	}
+
+	std::cerr << "Nieznane polecenie: " << command << std::endl;
+	printUsage();
+
+	return 1;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja wyswietlajaca sposob uzycia programu
+**------------------------------------------------------------------------------------------*/
+void printUsage()
+{
+	std::cerr << "Uzycie: pong_bridge <polecenie> [opcje]\n"
+		<< "Polecenia:\n"
+		<< "  serve    most w pamieci wspoldzielonej: srodowiska kanalow krokowane na zlecenie agentow (do Ctrl+C)\n"
+		<< "  agent    agent zastepczy: dolacza do mostu, wysyla pseudolosowe akcje i mierzy kroki na sekunde\n"
+		<< "  bench    most i --agents procesow agentow, potem to samo przez TCP na petli zwrotnej\n"
+		<< "Opcje:\n"
+		<< "  --name N      nazwa pamieci wspoldzielonej (/dev/shm)\n"
+		<< "  --channels N  najwiecej procesow agentow\n"
+		<< "  --envs N      srodowiska na kanal\n"
+		<< "  --agents N    procesy agentow (bench)\n"
+		<< "  --steps N     kroki na agenta\n"
+		<< "  --seed N      ziarno pierwszego srodowiska\n"
+		<< "  --opponent O  przeciwnik: tracking, intercept, agent\n"
+		<< "  --points N    do ilu punktow trwa epizod\n"
+		<< "  --frame-skip N kroki symulacji na akcje\n";
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja wczytujaca opcje z linii polecen
+** funkcja zwraca false jesli napotka nieznana lub niekompletna opcje
+**------------------------------------------------------------------------------------------*/
+bool parseBridgeOptions(int argc, char* argv[], int first, BridgeOptions& options)
+{
+	for (int i = first; i < argc; i++)
+	{
+		if (i + 1 >= argc)
+		{
+			std::cerr << "Brak wartosci dla opcji: " << argv[i] << std::endl;
+			return false;
+		}
+
+		const char* name = argv[i];
+		const char* value = argv[++i];
+
+		if (!strcmp(name, "--name"))
+			options.name = value[0] == '/' ? value : std::string("/") + value;
+		else if (!strcmp(name, "--channels"))
+			options.channels = (unsigned int)strtoul(value, nullptr, 10);
+		else if (!strcmp(name, "--envs"))
+			options.envs = (unsigned int)strtoul(value, nullptr, 10);
+		else if (!strcmp(name, "--agents"))
+			options.agents = (unsigned int)strtoul(value, nullptr, 10);
+		else if (!strcmp(name, "--steps"))
+			options.steps = (unsigned int)strtoul(value, nullptr, 10);
+		else if (!strcmp(name, "--seed"))
+			options.seed = (unsigned int)strtoul(value, nullptr, 10);
+		else if (!strcmp(name, "--points"))
+			options.env.points = (unsigned int)strtoul(value, nullptr, 10);
+		else if (!strcmp(name, "--frame-skip"))
+			options.env.frameSkip = (unsigned int)strtoul(value, nullptr, 10);
+		else if (!strcmp(name, "--opponent"))
+		{
+			if (!strcmp(value, "tracking"))
+				options.env.opponent = PONG_ENV_OPPONENT_TRACKING;
+			else if (!strcmp(value, "intercept"))
+				options.env.opponent = PONG_ENV_OPPONENT_INTERCEPT;
+			else if (!strcmp(value, "agent"))
+				options.env.opponent = PONG_ENV_OPPONENT_AGENT;
+			else
+			{
+				std::cerr << "Nieznany przeciwnik: " << value << std::endl;
+				return false;
+			}
+		}
+		else
+		{
+			std::cerr << "Nieznana opcja: " << name << std::endl;
+			return false;
+		}
+	}
+
+	if (options.agents > options.channels)
+		options.channels = options.agents;
+
+	return true;
+}
+
+// pseudolosowa akcja (PongEnvAction) agenta i w kroku t
+static unsigned char agentAction(unsigned int i, unsigned int t)
+{
+	unsigned int h = (i * 0x9E3779B9u) ^ (t * 0x85EBCA6Bu);
+	h ^= h >> 15;
+	h *= 0x2C1B3C6Du;
+	h ^= h >> 13;
+
+	return (unsigned char)(h % 3);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja obslugujaca most do stopRequested; co sekunde wypisuje kroki srodowisk
+**------------------------------------------------------------------------------------------*/
+static void serveUntilStopped(BridgeServer& server, volatile int* stop, bool report)
+{
+	auto last = std::chrono::steady_clock::now();
+	unsigned long long lastSteps = 0, lastSleeps = 0;
+
+	while (!*stop)
+	{
+		serveBridge(server);
+
+		auto now = std::chrono::steady_clock::now();
+		double seconds = std::chrono::duration<double>(now - last).count();
+		if (report && seconds >= 1.0)
+		{
+			printf("agenci %u, kroki srodowisk/s %.0f, zlecenia %llu, zasniecia/s %.0f\n", attachedAgents(server),
+				(server.stats.envSteps - lastSteps) / seconds, server.stats.requests, (server.stats.sleeps - lastSleeps) / seconds);
+			fflush(stdout);
+			last = now;
+			lastSteps = server.stats.envSteps;
+			lastSleeps = server.stats.sleeps;
+		}
+	}
+}
+
+/*------------------------------------------------------------------------------------------
+** polecenie serve - most do Ctrl+C
+**------------------------------------------------------------------------------------------*/
+int runServe(const BridgeOptions& options)
+{
+	BridgeServer server;
+	if (!createBridge(server, options.name.c_str(), options.channels, options.envs, options.env))
+	{
+		std::cerr << "Nie mozna utworzyc mostu " << options.name << std::endl;
+		return 1;
+	}
+
+	printf("most %s: %u kanalow po %u srodowisk, %llu bajtow\n", options.name.c_str(), options.channels, options.envs,
+		(unsigned long long)server.size);
+	fflush(stdout);
+
+	serveUntilStopped(server, &stopRequested, true);
+	closeBridge(server);
+
+	return 0;
+}
+
+/*------------------------------------------------------------------------------------------
+** agent zastepczy: reset, potem --steps krokow z pseudolosowymi akcjami; suma kontrolna
+** obserwacji pozwala porownac przebiegi
+**------------------------------------------------------------------------------------------*/
+static int runAgentLoop(const BridgeOptions& options, unsigned int index)
+{
+	BridgeAgent agent;
+	bool attached = false;
+	for (int attempt = 0; attempt < 100 && !attached; attempt++)
+	{
+		attached = attachBridge(agent, options.name.c_str());
+		if (!attached)
+			usleep(10000);
+	}
+	if (!attached)
+	{
+		std::cerr << "Nie mozna dolaczyc do mostu " << options.name << std::endl;
+		return 1;
+	}
+
+	unsigned int slots = agent.envs * agent.agents;
+	for (unsigned int i = 0; i < agent.envs; i++)
+	{
+		agent.seeds[i] = options.seed + index * agent.envs + i;
+	}
+	if (!bridgeReset(agent))
+	{
+		detachBridge(agent);
+		return 1;
+	}
+
+	double checksum = 0.0;
+	unsigned long long episodes = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned int t = 0; t < options.steps; t++)
+	{
+		for (unsigned int i = 0; i < slots; i++)
+		{
+			agent.actions[i] = agentAction(i, t);
+		}
+		if (!bridgeStep(agent))
+		{
+			std::cerr << "agent " << index << ": most zamkniety po " << t << " krokach" << std::endl;
+			detachBridge(agent);
+			return 1;
+		}
+
+		checksum += agent.observations[4] + agent.rewards[0];
+		for (unsigned int i = 0; i < agent.envs; i++)
+		{
+			episodes += agent.dones[i] != PONG_ENV_RUNNING;
+		}
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("agent %u: %.0f krokow srodowisk/s, %.2f us na zlecenie, %llu epizodow, %llu zasniec, suma %.6f\n", index,
+		(double)options.steps * agent.envs / seconds, seconds / options.steps * 1e6, episodes, agent.sleeps, checksum);
+	fflush(stdout);
+
+	detachBridge(agent);
+
+	return 0;
+}
+
+/*------------------------------------------------------------------------------------------
+** polecenie agent - jeden agent zastepczy dolaczony do dzialajacego mostu
+**------------------------------------------------------------------------------------------*/
+int runAgent(const BridgeOptions& options)
+{
+	return runAgentLoop(options, (unsigned int)getpid() % 1000);
+}
+
+// pelne odczytanie/zapisanie bufora z gniazda
+static bool readAll(int socket, void* data, size_t size)
+{
+	unsigned char* bytes = (unsigned char*)data;
+	while (size > 0)
+	{
+		ssize_t done = read(socket, bytes, size);
+		if (done <= 0)
+			return false;
+		bytes += done;
+		size -= (size_t)done;
+	}
+
+	return true;
+}
+
+static bool writeAll(int socket, const void* data, size_t size)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	while (size > 0)
+	{
+		ssize_t done = write(socket, bytes, size);
+		if (done <= 0)
+			return false;
+		bytes += done;
+		size -= (size_t)done;
+	}
+
+	return true;
+}
+
+/*------------------------------------------------------------------------------------------
+** punkt odniesienia: jeden agent przez TCP na petli zwrotnej - akcje do serwera, obserwacje,
+** nagrody i konce epizodow z powrotem w kazdym kroku
+** funkcja zwraca kroki srodowisk na sekunde (0 przy bledzie)
+**------------------------------------------------------------------------------------------*/
+static double benchTcp(const BridgeOptions& options)
+{
+	int listener = socket(AF_INET, SOCK_STREAM, 0);
+	sockaddr_in address = {};
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	socklen_t length = sizeof(address);
+	if (listener < 0 || bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 1) != 0
+		|| getsockname(listener, (sockaddr*)&address, &length) != 0)
+	{
+		if (listener >= 0)
+			close(listener);
+		return 0.0;
+	}
+
+	PongEnv* env = pongEnvCreate(&options.env);
+	const unsigned int agents = pongEnvAgents(env);
+	const unsigned int slots = options.envs * agents;
+	std::vector<unsigned char> actions(slots), dones(options.envs);
+	std::vector<float> observations(slots * PONG_ENV_OBSERVATION_SIZE), rewards(slots);
+	std::vector<unsigned int> seeds(options.envs);
+
+	pid_t child = fork();
+	if (child == 0)
+	{
+		close(listener);
+		int connection = socket(AF_INET, SOCK_STREAM, 0);
+		int on = 1;
+		setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+		if (connect(connection, (sockaddr*)&address, sizeof(address)) != 0)
+			_exit(1);
+
+		for (unsigned int t = 0; t < options.steps; t++)
+		{
+			for (unsigned int i = 0; i < slots; i++)
+			{
+				actions[i] = agentAction(i, t);
+			}
+			if (!writeAll(connection, actions.data(), slots)
+				|| !readAll(connection, observations.data(), observations.size() * sizeof(float))
+				|| !readAll(connection, rewards.data(), rewards.size() * sizeof(float))
+				|| !readAll(connection, dones.data(), dones.size()))
+				_exit(1);
+		}
+		close(connection);
+		_exit(0);
+	}
+
+	int connection = accept(listener, nullptr, nullptr);
+	close(listener);
+	int on = 1;
+	setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+	for (unsigned int i = 0; i < options.envs; i++)
+	{
+		seeds[i] = options.seed + i;
+	}
+	pongEnvReset(env, options.envs, seeds.data(), observations.data());
+
+	auto start = std::chrono::steady_clock::now();
+	unsigned int t = 0;
+	for (; t < options.steps; t++)
+	{
+		if (!readAll(connection, actions.data(), slots))
+			break;
+		pongEnvStep(env, actions.data(), observations.data(), rewards.data(), dones.data(), nullptr);
+		if (!writeAll(connection, observations.data(), observations.size() * sizeof(float))
+			|| !writeAll(connection, rewards.data(), rewards.size() * sizeof(float))
+			|| !writeAll(connection, dones.data(), dones.size()))
+			break;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	close(connection);
+	waitpid(child, nullptr, 0);
+	pongEnvDestroy(env);
+
+	return t == options.steps && seconds > 0.0 ? (double)options.steps * options.envs / seconds : 0.0;
+}
+
+/*------------------------------------------------------------------------------------------
+** polecenie bench - most w tym procesie i --agents procesow agentow (fork); most dziala,
+** dopoki wszyscy agenci sie nie zakoncza; na koniec jeden agent przez TCP dla porownania
+**------------------------------------------------------------------------------------------*/
+int runBench(const BridgeOptions& options)
+{
+	BridgeServer server;
+	if (!createBridge(server, options.name.c_str(), options.channels, options.envs, options.env))
+	{
+		std::cerr << "Nie mozna utworzyc mostu " << options.name << std::endl;
+		return 1;
+	}
+
+	printf("most %s: %u agentow, %u srodowisk na agenta, %u krokow\n", options.name.c_str(), options.agents, options.envs, options.steps);
+	fflush(stdout);
+
+	std::vector<pid_t> children;
+	for (unsigned int a = 0; a < options.agents; a++)
+	{
+		pid_t child = fork();
+		if (child == 0)
+			_exit(runAgentLoop(options, a));
+		children.push_back(child);
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	unsigned int running = (unsigned int)children.size();
+	int failures = 0;
+	while (running > 0 && !stopRequested)
+	{
+		serveBridge(server);
+
+		int status;
+		pid_t done;
+		while ((done = waitpid(-1, &status, WNOHANG)) > 0)
+		{
+			running--;
+			if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+				failures++;
+		}
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("most: %.0f krokow srodowisk/s lacznie, %llu zlecen, %llu zasniec serwera, %llu budzen agentow\n",
+		server.stats.envSteps / seconds, server.stats.requests, server.stats.sleeps, server.stats.wakes);
+	closeBridge(server);
+
+	double tcp = benchTcp(options);
+	printf("tcp (1 agent): %.0f krokow srodowisk/s, %.2f us na krok\n", tcp, tcp > 0.0 ? options.envs / tcp * 1e6 : 0.0);
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,309 @@
+#include "pong_env.h"
+#include "batch.h"
+#include "bots.h"
+
+// STAN SRODOWISKA - paczka meczow i bufory na jeden krok (przydzielane w pongEnvReset)
+struct PongEnv {
+	PongEnvOptions options;
+	unsigned int agents; // agenci na srodowisko (1 - lewa rakietka, 2 - obie)
+	void (*opponentBatch)(const MatchBatch& batch, unsigned int* keys); // bot prawej rakietki albo nullptr
+
+	MatchBatch batch;
+	bool ready; // paczka utworzona przez pongEnvReset
+	unsigned int* agentKeys; // klawisze z akcji agentow
+	unsigned int* keys; // klawisze kroku symulacji (agenci + bot)
+	unsigned int* seeds; // ziarno nastepnego epizodu
+	unsigned int* ticks; // kroki symulacji biezacego epizodu
+	unsigned int* scoreForLeft; // wynik przed krokiem symulacji
+	unsigned int* scoreForRight;
+	unsigned char* finished; // epizod zakonczony w trwajacym kroku (PongEnvDone)
+};
+
+/*------------------------------------------------------------------------------------------
+** funkcja wypelniajaca domyslne parametry: krok 1/60 s jak w grze, mecz do 11 punktow,
+** bez limitu krokow, przeciwnikiem trackingBot
+**------------------------------------------------------------------------------------------*/
+void pongEnvDefaultOptions(PongEnvOptions* options)
+{
+	options->dt = 1.0f / 60.0f;
+	options->frameSkip = 1;
+	options->points = 11;
+	options->maxTicks = 0;
+	options->opponent = PONG_ENV_OPPONENT_TRACKING;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja tworzaca srodowisko (mecze powstaja dopiero w pongEnvReset)
+** options - parametry albo NULL dla domyslnych
+** funkcja zwraca NULL przy blednych parametrach
+**------------------------------------------------------------------------------------------*/
+PongEnv* pongEnvCreate(const PongEnvOptions* options)
+{
+	PongEnvOptions chosen;
+	pongEnvDefaultOptions(&chosen);
+	if (options)
+		chosen = *options;
+
+	if (!(chosen.dt > 0.0f) || chosen.frameSkip == 0 || chosen.points == 0)
+		return nullptr;
+
+	PongEnv* env = new PongEnv();
+	env->options = chosen;
+	switch (chosen.opponent)
+	{
+	case PONG_ENV_OPPONENT_TRACKING:
+		env->agents = 1;
+		env->opponentBatch = trackingBotBatch;
+		break;
+	case PONG_ENV_OPPONENT_INTERCEPT:
+		env->agents = 1;
+		env->opponentBatch = interceptBotBatch;
+		break;
+	case PONG_ENV_OPPONENT_AGENT:
+		env->agents = 2;
+		env->opponentBatch = nullptr;
+		break;
+	default:
+		delete env;
+		return nullptr;
+	}
+
+	env->ready = false;
+	env->agentKeys = nullptr;
+	env->keys = nullptr;
+	env->seeds = nullptr;
+	env->ticks = nullptr;
+	env->scoreForLeft = nullptr;
+	env->scoreForRight = nullptr;
+	env->finished = nullptr;
+
+	return env;
+}
+
+static void freeEnvBuffers(PongEnv* env)
+{
+	if (env->ready)
+		freeBatch(env->batch);
+	env->ready = false;
+
+	delete[] env->agentKeys;
+	delete[] env->keys;
+	delete[] env->seeds;
+	delete[] env->ticks;
+	delete[] env->scoreForLeft;
+	delete[] env->scoreForRight;
+	delete[] env->finished;
+	env->agentKeys = nullptr;
+	env->keys = nullptr;
+	env->seeds = nullptr;
+	env->ticks = nullptr;
+	env->scoreForLeft = nullptr;
+	env->scoreForRight = nullptr;
+	env->finished = nullptr;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja niszczaca srodowisko
+**------------------------------------------------------------------------------------------*/
+void pongEnvDestroy(PongEnv* env)
+{
+	if (!env)
+		return;
+
+	freeEnvBuffers(env);
+	delete env;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwracajaca liczbe agentow na srodowisko (akcje, nagrody i obserwacje sa w tablicach
+** [srodowisko][agent])
+**------------------------------------------------------------------------------------------*/
+unsigned int pongEnvAgents(const PongEnv* env)
+{
+	return env ? env->agents : 0;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwracajaca liczbe srodowisk z ostatniego pongEnvReset
+**------------------------------------------------------------------------------------------*/
+unsigned int pongEnvCount(const PongEnv* env)
+{
+	return env && env->ready ? env->batch.count : 0;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zapisujaca obserwacje agentow meczu index; prawy agent widzi boisko odbite
+** w poziomie, wiec obaj dostaja [wlasna rakietka y, vy, rakietka przeciwnika y, vy,
+** pileczka x od wlasnej strony, y, vx od siebie, vy] - pozycje w [0, 1], predkosci
+** wzgledem predkosci rakietki i serwu
+**------------------------------------------------------------------------------------------*/
+static void writeObservation(const PongEnv* env, unsigned int index, float* observations)
+{
+	const MatchBatch& batch = env->batch;
+	float* out = observations + (unsigned long long)index * env->agents * PONG_ENV_OBSERVATION_SIZE;
+
+	for (unsigned int agent = 0; agent < env->agents; agent++)
+	{
+		int own = agent;
+		float ballX = batch.ballX[index] / WIN_WIDTH;
+		float ballVX = batch.ballVX[index] / ballServeSpeed;
+
+		out[0] = batch.racketY[own][index] / WIN_HEIGHT;
+		out[1] = batch.racketVY[own][index] / racketsSpeed;
+		out[2] = batch.racketY[1 - own][index] / WIN_HEIGHT;
+		out[3] = batch.racketVY[1 - own][index] / racketsSpeed;
+		out[4] = own == 0 ? ballX : 1.0f - ballX;
+		out[5] = batch.ballY[index] / WIN_HEIGHT;
+		out[6] = own == 0 ? ballVX : -ballVX;
+		out[7] = batch.ballVY[index] / ballServeSpeed;
+		out += PONG_ENV_OBSERVATION_SIZE;
+	}
+}
+
+// poczatek epizodu meczu index z ziarnem seed
+static void startEpisode(PongEnv* env, unsigned int index, unsigned int seed)
+{
+	resetMatch(env->batch, index, seed);
+	env->ticks[index] = 0;
+	env->scoreForLeft[index] = 0;
+	env->scoreForRight[index] = 0;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja rozpoczynajaca wszystkie epizody od nowa (przy innej liczbie srodowisk
+** przydziela pamiec od nowa - jedyne miejsce, w ktorym to sie dzieje)
+** count - liczba srodowisk
+** seeds - ziarna pierwszych epizodow, count elementow; kolejne epizody srodowiska i
+**         dostaja seeds[i] + k * count, wiec nie powtarzaja ziaren sasiadow
+** observations - wypelniana tablica [count][agenci][PONG_ENV_OBSERVATION_SIZE]
+** funkcja zwraca 0, albo -1 przy blednych argumentach
+**------------------------------------------------------------------------------------------*/
+int pongEnvReset(PongEnv* env, unsigned int count, const unsigned int* seeds, float* observations)
+{
+	if (!env || count == 0 || !seeds || !observations)
+		return -1;
+
+	if (!env->ready || env->batch.count != count)
+	{
+		freeEnvBuffers(env);
+		initBatch(env->batch, count, seeds[0]);
+		env->ready = true;
+
+		env->agentKeys = new unsigned int[count];
+		env->keys = new unsigned int[count];
+		env->seeds = new unsigned int[count];
+		env->ticks = new unsigned int[count];
+		env->scoreForLeft = new unsigned int[count];
+		env->scoreForRight = new unsigned int[count];
+		env->finished = new unsigned char[count];
+	}
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		startEpisode(env, i, seeds[i]);
+		env->seeds[i] = seeds[i] + count;
+		writeObservation(env, i, observations);
+	}
+
+	return 0;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja wykonujaca jedna akcje we wszystkich srodowiskach (options.frameSkip krokow
+** symulacji paczka meczow); epizody zakonczone w tym kroku od razu zaczynaja sie od nowa,
+** a observations opisuje juz nowy epizod
+** actions - akcje (PongEnvAction) [count][agenci]
+** observations - wypelniana tablica [count][agenci][PONG_ENV_OBSERVATION_SIZE]
+** rewards - wypelniana tablica [count][agenci]: +1 za zdobyty punkt, -1 za stracony
+** dones - wypelniana tablica [count] (PongEnvDone)
+** finalObservations - NULL albo tablica jak observations, w ktorej zakonczone epizody
+**                     dostaja obserwacje ostatniego stanu (pozostale elementy bez zmian)
+** funkcja zwraca 0, albo -1 przy blednych argumentach lub przed pongEnvReset
+**------------------------------------------------------------------------------------------*/
+int pongEnvStep(PongEnv* env, const unsigned char* actions, float* observations, float* rewards,
+	unsigned char* dones, float* finalObservations)
+{
+	if (!env || !env->ready || !actions || !observations || !rewards || !dones)
+		return -1;
+
+	MatchBatch& batch = env->batch;
+	const unsigned int count = batch.count;
+	const unsigned int agents = env->agents;
+	const unsigned int upKeys[2] = { INPUT_LEFT_UP, INPUT_RIGHT_UP };
+	const unsigned int downKeys[2] = { INPUT_LEFT_DOWN, INPUT_RIGHT_DOWN };
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		unsigned int keys = 0;
+		for (unsigned int agent = 0; agent < agents; agent++)
+		{
+			unsigned char action = actions[i * agents + agent];
+			if (action == PONG_ENV_UP)
+				keys |= upKeys[agent];
+			else if (action == PONG_ENV_DOWN)
+				keys |= downKeys[agent];
+		}
+		env->agentKeys[i] = keys;
+		env->finished[i] = PONG_ENV_RUNNING;
+
+		for (unsigned int agent = 0; agent < agents; agent++)
+		{
+			rewards[i * agents + agent] = 0.0f;
+		}
+	}
+
+	for (unsigned int frame = 0; frame < env->options.frameSkip; frame++)
+	{
+		const unsigned int* keys = env->agentKeys;
+		if (env->opponentBatch)
+		{
+			env->opponentBatch(batch, env->keys);
+			for (unsigned int i = 0; i < count; i++)
+			{
+				env->keys[i] = (env->keys[i] & (INPUT_RIGHT_UP | INPUT_RIGHT_DOWN)) | env->agentKeys[i];
+			}
+			keys = env->keys;
+		}
+
+		stepBatch(batch, keys, env->options.dt);
+
+		// punkty i konce epizodow; zakonczone w poprzednich krokach tej akcji juz sie nie licza
+		for (unsigned int i = 0; i < count; i++)
+		{
+			if (env->finished[i] != PONG_ENV_RUNNING)
+				continue;
+
+			env->ticks[i]++;
+			float point = (float)(batch.scoreForLeft[i] - env->scoreForLeft[i]) - (float)(batch.scoreForRight[i] - env->scoreForRight[i]);
+			env->scoreForLeft[i] = batch.scoreForLeft[i];
+			env->scoreForRight[i] = batch.scoreForRight[i];
+			if (point != 0.0f)
+			{
+				rewards[i * agents] += point;
+				if (agents == 2)
+					rewards[i * agents + 1] -= point;
+			}
+
+			if (batch.scoreForLeft[i] >= env->options.points || batch.scoreForRight[i] >= env->options.points)
+				env->finished[i] = PONG_ENV_TERMINATED;
+			else if (env->options.maxTicks != 0 && env->ticks[i] >= env->options.maxTicks)
+				env->finished[i] = PONG_ENV_TRUNCATED;
+
+			if (env->finished[i] != PONG_ENV_RUNNING && finalObservations)
+				writeObservation(env, i, finalObservations);
+		}
+	}
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		dones[i] = env->finished[i];
+		if (env->finished[i] != PONG_ENV_RUNNING)
+		{
+			startEpisode(env, i, env->seeds[i]);
+			env->seeds[i] += count;
+		}
+		writeObservation(env, i, observations);
+	}
+
+	return 0;
+}
@@ -0,0 +1,65 @@
+#ifndef __PONG_ENV_H__
+#define __PONG_ENV_H__
+
+/* SRODOWISKO DO UCZENIA ZE WZMOCNIENIEM (libpong_env.so) - interfejs w C, wiele meczow naraz.
+** Wszystkie tablice podaje wywolujacy; krok nie przydziela pamieci i niczego nie kopiuje poza
+** zapisem wynikow. Zakonczone epizody zaczynaja sie od nowa w tym samym kroku. */
+
+#if defined(_WIN32)
+#	define PONG_ENV_API __declspec(dllexport)
+#else
+#	define PONG_ENV_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PONG_ENV_OBSERVATION_SIZE 8 /* liczby float w obserwacji jednego agenta */
+
+/* PRZECIWNIK AGENTA LEWEJ RAKIETKI */
+enum PongEnvOpponent {
+	PONG_ENV_OPPONENT_TRACKING = 0, /* prawa rakietka sterowana przez trackingBot */
+	PONG_ENV_OPPONENT_INTERCEPT = 1, /* prawa rakietka sterowana przez interceptBot */
+	PONG_ENV_OPPONENT_AGENT = 2 /* dwoch agentow na srodowisko - akcje dla obu rakietek */
+};
+
+/* AKCJE AGENTA (jeden bajt na agenta) */
+enum PongEnvAction {
+	PONG_ENV_STAY = 0,
+	PONG_ENV_UP = 1,
+	PONG_ENV_DOWN = 2
+};
+
+/* ZAKONCZENIE EPIZODU (jeden bajt na srodowisko) */
+enum PongEnvDone {
+	PONG_ENV_RUNNING = 0,
+	PONG_ENV_TERMINATED = 1, /* ktos zdobyl options.points punktow */
+	PONG_ENV_TRUNCATED = 2 /* epizod przerwany po options.maxTicks krokach */
+};
+
+/* PARAMETRY SRODOWISKA */
+typedef struct PongEnvOptions {
+	float dt; /* dlugosc kroku symulacji w sekundach */
+	unsigned int frameSkip; /* kroki symulacji na jedna akcje */
+	unsigned int points; /* do ilu punktow trwa epizod */
+	unsigned int maxTicks; /* limit krokow symulacji epizodu (0 - bez limitu) */
+	int opponent; /* PongEnvOpponent */
+} PongEnvOptions;
+
+typedef struct PongEnv PongEnv;
+
+PONG_ENV_API void pongEnvDefaultOptions(PongEnvOptions* options);
+PONG_ENV_API PongEnv* pongEnvCreate(const PongEnvOptions* options);
+PONG_ENV_API void pongEnvDestroy(PongEnv* env);
+PONG_ENV_API unsigned int pongEnvAgents(const PongEnv* env);
+PONG_ENV_API unsigned int pongEnvCount(const PongEnv* env);
+PONG_ENV_API int pongEnvReset(PongEnv* env, unsigned int count, const unsigned int* seeds, float* observations);
+PONG_ENV_API int pongEnvStep(PongEnv* env, const unsigned char* actions, float* observations, float* rewards,
+	unsigned char* dones, float* finalObservations);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PONG_ENV_H__ */
@@ -0,0 +1,982 @@
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <ctime>
+#include <vector>
+#include <unordered_map>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "server.h"
+#include "rollback.h"
+#include "wire.h"
+#include "statecodec.h"
+#include "spectator.h"
+#include "sim.h"
+#include "bots.h"
+
+// PARAMETRY KLIENTA ZASTEPCZEGO (OBCIAZENIE SERWERA)
+struct ClientOptions {
+	std::string host = "127.0.0.1"; // adres serwera
+	unsigned short port = 7000; // port serwera
+	unsigned int clients = 1000; // liczba graczy (kazdy gra osobny mecz z botem serwera)
+	unsigned int sockets = 16; // liczba gniazd, na ktore rozkladani sa gracze
+	double tickRate = 60.0; // czestotliwosc wysylania klawiszy
+	unsigned int stateInterval = 1; // co ile krokow serwer wysyla stan (do liczenia pominietych stanow)
+	unsigned int joinsPerTick = 500; // tylu graczy (widzow) zglasza sie w jednym kroku (bez zalewu na starcie)
+	double seconds = 10.0; // czas pracy
+};
+
+// GRACZ ZASTEPCZY - podaza rakietka za pileczka z ostatniego stanu od serwera
+struct StandInClient {
+	unsigned int nonce;
+	int socket; // indeks gniazda
+	bool joined;
+	unsigned int match;
+	int side;
+	float ballY;
+	float racketY;
+	unsigned int lastStateTick; // ostatni odebrany stan - potwierdzany w kazdym PACKET_INPUT
+	unsigned int inputTick; // numer ostatnich wyslanych klawiszy
+	NetStateHistory history; // odebrane stany (bazy roznic od serwera)
+	double joinSent; // czas ostatniego zgloszenia (0 - jeszcze nie wyslano)
+};
+
+// WIDZ ZASTEPCZY - osobne gniazdo, dekoduje klatki meczu
+struct StandInViewer {
+	int socket;
+	bool subscribed;
+	bool synced; // zdekodowal pierwsza klatke
+	double subscribeTime;
+	unsigned int lastTick;
+	NetStateHistory history;
+};
+
+// PARAMETRY POMIARU PRZEPUSTOWOSCI PAKIETOW
+struct IoBenchOptions {
+	unsigned int packets = 2000000; // pakiety na sposob
+	unsigned int size = 32; // bajty pakietu
+	int backend = -1; // sposob (-1 - wszystkie po kolei)
+};
+
+static volatile int stopRequested = 0;
+
+void printUsage();
+bool parseServerOptions(int argc, char* argv[], int first, ServerOptions& options);
+bool parseClientOptions(int argc, char* argv[], int first, ClientOptions& options);
+int runServe(const ServerOptions& options);
+int runClients(const ClientOptions& options);
+int runHost(const ServerOptions& options);
+int runViewers(const ClientOptions& options);
+bool parseIoBenchOptions(int argc, char* argv[], int first, IoBenchOptions& options);
+int runIoBench(const IoBenchOptions& options);
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		printUsage();
+		return 1;
+	}
+
+	signal(SIGINT, [](int) { stopRequested = 1; });
+	signal(SIGTERM, [](int) { stopRequested = 1; });
+
+	std::string command = argv[1];
+
+	if (command == "serve")
+	{
+		ServerOptions options;
+		if (!parseServerOptions(argc, argv, 2, options))
+		{
+			printUsage();
+			return 1;
+		}
+		return runServe(options);
+	}
+	if (command == "clients")
+	{
+		ClientOptions options;
+		if (!parseClientOptions(argc, argv, 2, options))
+		{
+			printUsage();
+			return 1;
+		}
+		return runClients(options);
+	}
+	if (command == "host")
+	{
+		ServerOptions options;
+		options.port = 7100;
+		if (!parseServerOptions(argc, argv, 2, options))
+		{
+			printUsage();
+			return 1;
+		}
+		return runHost(options);
+	}
+	if (command == "viewers")
+	{
+		ClientOptions options;
+		options.port = 7100;
+		options.joinsPerTick = 20;
+		if (!parseClientOptions(argc, argv, 2, options))
+		{
+			printUsage();
+			return 1;
+		}
+		return runViewers(options);
+	}
+	if (command == "iobench")
+	{
+		IoBenchOptions options;
+		if (!parseIoBenchOptions(argc, argv, 2, options))
+		{
+			printUsage();
+			return 1;
+		}
+		return runIoBench(options);
+	}
+
+	std::cerr << "Nieznane polecenie: " << command << std::endl;
+	printUsage();
+
+	return 1;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja wyswietlajaca sposob uzycia programu
+**------------------------------------------------------------------------------------------*/
+void printUsage()
+{
+	std::cerr << "Uzycie: pong_server <polecenie> [opcje]\n"
+		<< "Polecenia:\n"
+		<< "  serve    serwer meczow: wszystkie mecze krokowane jedna paczka w stalym rytmie, stan rozsylany przez UDP\n"
+		<< "  clients  klient zastepczy: wielu graczy na kilku gniazdach, obciaza serwer i mierzy odbior stanow\n"
+		<< "  host     jeden mecz botow rozsylany widzom: kazdy krok kodowany raz, ta sama klatka do wszystkich (port 7100)\n"
+		<< "  viewers  widzowie zastepczy: --clients gniazd dolaczajacych stopniowo, dekoduja klatki i mierza dolaczenie\n"
+		<< "  iobench  przepustowosc pakietow przez petle zwrotna dla kazdego sposobu wysylania (basic, mmsg, gso, uring)\n"
+		<< "Opcje serve i host:\n"
+		<< "  --port N      port UDP\n"
+		<< "  --matches N   liczba miejsc na mecze\n"
+		<< "  --tick-rate N kroki na sekunde\n"
+		<< "  --points N    do ilu punktow gra sie mecz\n"
+		<< "  --pairs 1     klienci graja ze soba w parach zamiast z botem serwera\n"
+		<< "  --state-interval N co ile krokow wysylac stan meczu\n"
+		<< "  --report S    co ile sekund wypisywac statystyki\n"
+		<< "  --seconds S   czas pracy serwera (0 - do Ctrl+C)\n"
+		<< "  --io B        wysylanie i odbior pakietow: basic, mmsg, gso, uring\n"
+		<< "Opcje clients i viewers:\n"
+		<< "  --server HOST:PORT adres serwera\n"
+		<< "  --clients N   liczba graczy (widzow)\n"
+		<< "  --joins-per-tick N tylu graczy (widzow) dolacza w jednym kroku\n"
+		<< "  --sockets N   liczba gniazd\n"
+		<< "  --tick-rate N czestotliwosc wysylania klawiszy (taka jak krokow serwera - dekodowanie stanow)\n"
+		<< "  --state-interval N co ile krokow serwer wysyla stan\n"
+		<< "  --seconds S   czas pracy\n"
+		<< "Opcje iobench:\n"
+		<< "  --packets N   liczba pakietow na sposob\n"
+		<< "  --size N      bajty pakietu\n"
+		<< "  --io B        tylko jeden sposob\n";
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja wczytujaca opcje serwera z linii polecen
+** funkcja zwraca false jesli napotka nieznana lub niekompletna opcje
+**------------------------------------------------------------------------------------------*/
+bool parseServerOptions(int argc, char* argv[], int first, ServerOptions& options)
+{
+	for (int i = first; i < argc; i++)
+	{
+		if (i + 1 >= argc)
+		{
+			std::cerr << "Brak wartosci dla opcji: " << argv[i] << std::endl;
+			return false;
+		}
+
+		const char* name = argv[i];
+		const char* value = argv[++i];
+
+		if (!strcmp(name, "--port"))
+			options.port = (unsigned short)strtoul(value, nullptr, 10);
+		else if (!strcmp(name, "--matches"))
+			options.maxMatches = (unsigned int)strtoul(value, nullptr, 10);
+		else if (!strcmp(name, "--tick-rate"))
+			options.tickRate = strtod(value, nullptr);
+		else if (!strcmp(name, "--points"))
+			options.points = (unsigned int)strtoul(value, nullptr, 10);
+		else if (!strcmp(name, "--pairs"))
+			options.botOpponents = strtoul(value, nullptr, 10) == 0;
+		else if (!strcmp(name, "--state-interval"))
+			options.stateInterval = (unsigned int)strtoul(value, nullptr, 10);
+		else if (!strcmp(name, "--report"))
+			options.reportInterval = strtod(value, nullptr);
+		else if (!strcmp(name, "--seconds"))
+			options.seconds = strtod(value, nullptr);
+		else if (!strcmp(name, "--io"))
+		{
+			if (!parsePacketBackend(value, options.backend))
+			{
+				std::cerr << "Nieznany sposob wysylania pakietow: " << value << std::endl;
+				return false;
+			}
+		}
+		else
+		{
+			std::cerr << "Nieznana opcja: " << name << std::endl;
+			return false;
+		}
+	}
+
+	if (options.maxMatches == 0 || options.tickRate <= 0.0)
+	{
+		std::cerr << "Liczba meczow i czestotliwosc krokow musza byc dodatnie" << std::endl;
+		return false;
+	}
+	if (options.stateInterval == 0)
+		options.stateInterval = 1;
+
+	return true;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja wczytujaca opcje klienta zastepczego z linii polecen
+** funkcja zwraca false jesli napotka nieznana lub niekompletna opcje
+**------------------------------------------------------------------------------------------*/
+bool parseClientOptions(int argc, char* argv[], int first, ClientOptions& options)
+{
+	for (int i = first; i < argc; i++)
+	{
+		if (i + 1 >= argc)
+		{
+			std::cerr << "Brak wartosci dla opcji: " << argv[i] << std::endl;
+			return false;
+		}
+
+		const char* name = argv[i];
+		const char* value = argv[++i];
+
+		if (!strcmp(name, "--server"))
+		{
+			std::string address = value;
+			size_t colon = address.rfind(':');
+			if (colon == std::string::npos)
+			{
+				std::cerr << "Oczekiwano HOST:PORT: " << value << std::endl;
+				return false;
+			}
+			options.host = address.substr(0, colon);
+			options.port = (unsigned short)strtoul(address.c_str() + colon + 1, nullptr, 10);
+		}
+		else if (!strcmp(name, "--clients"))
+			options.clients = (unsigned int)strtoul(value, nullptr, 10);
+		else if (!strcmp(name, "--joins-per-tick"))
+			options.joinsPerTick = (unsigned int)strtoul(value, nullptr, 10);
+		else if (!strcmp(name, "--sockets"))
+			options.sockets = (unsigned int)strtoul(value, nullptr, 10);
+		else if (!strcmp(name, "--tick-rate"))
+			options.tickRate = strtod(value, nullptr);
+		else if (!strcmp(name, "--state-interval"))
+			options.stateInterval = (unsigned int)strtoul(value, nullptr, 10);
+		else if (!strcmp(name, "--seconds"))
+			options.seconds = strtod(value, nullptr);
+		else
+		{
+			std::cerr << "Nieznana opcja: " << name << std::endl;
+			return false;
+		}
+	}
+
+	if (options.stateInterval == 0)
+		options.stateInterval = 1;
+	if (options.sockets == 0)
+		options.sockets = 1;
+	if (options.tickRate <= 0.0)
+		options.tickRate = 60.0;
+
+	return true;
+}
+
+/*------------------------------------------------------------------------------------------
+** polecenie serve - serwer meczow do Ctrl+C albo przez --seconds
+**------------------------------------------------------------------------------------------*/
+int runServe(const ServerOptions& options)
+{
+	MatchServer server;
+	if (!initServer(server, options))
+		return 1;
+
+	printf("serwer: port %u, %u miejsc na mecze, %.0f krokow/s, %s\n",
+		options.port, server.batch.count, options.tickRate,
+		options.botOpponents ? "gracz kontra bot" : "gracze w parach");
+	fflush(stdout);
+
+	runServer(server, &stopRequested);
+	freeServer(server);
+
+	return 0;
+}
+
+/*------------------------------------------------------------------------------------------
+** polecenie clients - klient zastepczy: --clients graczy rozlozonych na --sockets gniazd,
+** kazdy co krok wysyla klawisze podazajace za pileczka; pakiety od serwera sa rozdzielane
+** do graczy po (mecz, strona)
+**------------------------------------------------------------------------------------------*/
+int runClients(const ClientOptions& options)
+{
+	addrinfo hints = {};
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+	addrinfo* resolved = nullptr;
+	if (getaddrinfo(options.host.c_str(), nullptr, &hints, &resolved) != 0 || !resolved)
+	{
+		std::cerr << "Nieznany adres serwera: " << options.host << std::endl;
+		return 1;
+	}
+	sockaddr_in serverAddress = *(sockaddr_in*)resolved->ai_addr;
+	serverAddress.sin_port = htons(options.port);
+	freeaddrinfo(resolved);
+
+	int epoll = epoll_create1(0);
+	std::vector<int> sockets(options.sockets);
+	for (unsigned int s = 0; s < options.sockets; s++)
+	{
+		sockets[s] = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+		int size = 4 << 20;
+		if (setsockopt(sockets[s], SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)) != 0)
+			setsockopt(sockets[s], SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+		if (sockets[s] < 0 || connect(sockets[s], (sockaddr*)&serverAddress, sizeof(serverAddress)) != 0)
+		{
+			std::cerr << "Nie mozna utworzyc gniazda klienta" << std::endl;
+			return 1;
+		}
+
+		epoll_event event = {};
+		event.events = EPOLLIN;
+		event.data.u32 = s;
+		epoll_ctl(epoll, EPOLL_CTL_ADD, sockets[s], &event);
+	}
+
+	int timer = openTickTimer(options.tickRate);
+
+	epoll_event timerEvent = {};
+	timerEvent.events = EPOLLIN;
+	timerEvent.data.u32 = options.sockets;
+	epoll_ctl(epoll, EPOLL_CTL_ADD, timer, &timerEvent);
+
+	std::vector<StandInClient> clients(options.clients);
+	std::unordered_map<unsigned long long, unsigned int> byMatch; // mecz * 2 + strona -> gracz
+	for (unsigned int c = 0; c < options.clients; c++)
+	{
+		clients[c] = StandInClient();
+		clients[c].nonce = c;
+		clients[c].socket = c % options.sockets;
+	}
+
+	unsigned long long sent = 0, received = 0, states = 0, stateBytes = 0, finished = 0, lateStates = 0, skippedStates = 0, undecodable = 0;
+	unsigned long long echoTicks = 0; // suma opoznien wlasnych klawiszy w stanach (kroki miedzy wyslaniem a uzyciem przez serwer)
+	const unsigned int tickRate = (unsigned int)lround(options.tickRate);
+	unsigned int joinedCount = 0, nextJoin = 0;
+	unsigned char packet[64];
+
+	double start = monotonicSeconds();
+	double lastReport = start;
+	double now = start;
+
+	while (!stopRequested && now - start < options.seconds)
+	{
+		epoll_event events[32];
+		int count = epoll_wait(epoll, events, 32, 100);
+		now = monotonicSeconds();
+
+		for (int e = 0; e < count; e++)
+		{
+			unsigned int s = events[e].data.u32;
+
+			if (s == options.sockets)
+			{
+				unsigned long long expirations;
+				if (read(timer, &expirations, sizeof(expirations)) != sizeof(expirations))
+					continue;
+
+				// zgloszenia: nowi gracze porcjami, a bez odpowiedzi po sekundzie - ponownie
+				unsigned int joins = 0;
+				for (unsigned int n = 0; n < options.clients && joins < options.joinsPerTick; n++)
+				{
+					StandInClient& client = clients[nextJoin];
+					nextJoin = (nextJoin + 1) % options.clients;
+
+					if (client.joined || (client.joinSent > 0.0 && now - client.joinSent < 1.0))
+						continue;
+
+					packet[0] = PACKET_JOIN;
+					putU32(packet + 1, client.nonce);
+					if (send(sockets[client.socket], packet, joinPacketSize, 0) == (ssize_t)joinPacketSize)
+						sent++;
+					client.joinSent = now;
+					joins++;
+				}
+
+				// klawisze wszystkich graczy w meczach
+				packet[0] = PACKET_INPUT;
+				for (StandInClient& client : clients)
+				{
+					if (!client.joined)
+						continue;
+
+					const float deadZone = halfRacketsHeight / 4.0f;
+					putU32(packet + 1, client.match);
+					packet[5] = (unsigned char)client.side;
+					putU32(packet + 6, client.lastStateTick);
+					packet[10] = (unsigned char)sideKeys(client.side, client.ballY > client.racketY + deadZone, client.ballY < client.racketY - deadZone);
+					putU32(packet + 11, ++client.inputTick);
+					if (send(sockets[client.socket], packet, inputPacketSize, 0) == (ssize_t)inputPacketSize)
+						sent++;
+				}
+				continue;
+			}
+
+			ssize_t size;
+			while ((size = recv(sockets[s], packet, sizeof(packet), 0)) > 0)
+			{
+				received++;
+
+				if (packet[0] == PACKET_JOINED && size >= (ssize_t)joinedPacketSize)
+				{
+					unsigned int nonce = getU32(packet + 1);
+					// identyfikatory graczy: c, potem c + clients, c + 2 * clients... po kazdym ponownym dolaczeniu
+					StandInClient& client = clients[nonce % options.clients];
+					if (client.nonce != nonce || client.joined)
+						continue;
+
+					client.joined = true;
+					client.match = getU32(packet + 5);
+					client.side = packet[9];
+					client.lastStateTick = 0;
+					client.inputTick = 0;
+					clearNetStateHistory(client.history);
+					byMatch[client.match * 2ull + client.side] = nonce % options.clients;
+					joinedCount++;
+				}
+				else if ((packet[0] == PACKET_STATE && size > (ssize_t)stateHeaderSize) || (packet[0] == PACKET_END && size >= (ssize_t)endPacketSize))
+				{
+					auto found = byMatch.find(getU32(packet + 1) * 2ull + packet[5]);
+					if (found == byMatch.end())
+						continue;
+					StandInClient& client = clients[found->second];
+
+					if (packet[0] == PACKET_END)
+					{
+						// nowy mecz pod nowym identyfikatorem
+						byMatch.erase(found);
+						client.joined = false;
+						client.joinSent = 0.0;
+						client.nonce += options.clients;
+						finished++;
+						joinedCount--;
+						continue;
+					}
+
+					NetState state;
+					if (!decodeState(packet + stateHeaderSize, (unsigned int)size - stateHeaderSize, client.history, tickRate, state))
+					{
+						undecodable++;
+						continue;
+					}
+					storeNetState(client.history, state);
+
+					if (state.tick <= client.lastStateTick && client.lastStateTick != 0)
+						lateStates++;
+					else
+					{
+						if (client.lastStateTick != 0 && state.tick > client.lastStateTick + options.stateInterval)
+							skippedStates += (state.tick - client.lastStateTick) / options.stateInterval - 1;
+						client.lastStateTick = state.tick;
+						client.ballY = (float)state.ballY / positionScale - positionOffset;
+						client.racketY = (float)state.racketY[client.side] / positionScale - positionOffset;
+						echoTicks += client.inputTick - getU32(packet + 6);
+					}
+					states++;
+					stateBytes += size - stateHeaderSize;
+				}
+			}
+		}
+
+		if (now - lastReport >= 1.0)
+		{
+			double seconds = now - lastReport;
+			printf("gracze w meczach %u/%u | pakiety/s: wy %.0f, we %.0f | stany/s %.0f, sr %.2f B (pominiete %llu, spoznione %llu, nieczytelne %llu)"
+				" | klawisze w stanie po sr %.2f krokach | zakonczone mecze %llu\n",
+				joinedCount, options.clients, sent / seconds, received / seconds, states / seconds,
+				states ? (double)stateBytes / states : 0.0, skippedStates, lateStates, undecodable,
+				states ? (double)echoTicks / states : 0.0, finished);
+			fflush(stdout);
+
+			sent = received = states = stateBytes = echoTicks = 0;
+			lastReport = now;
+		}
+	}
+
+	// pozegnanie - serwer nie czeka na przekroczenie czasu ciszy
+	packet[0] = PACKET_LEAVE;
+	for (StandInClient& client : clients)
+	{
+		if (!client.joined)
+			continue;
+
+		putU32(packet + 1, client.match);
+		packet[5] = (unsigned char)client.side;
+		send(sockets[client.socket], packet, leavePacketSize, 0);
+	}
+
+	for (int s : sockets)
+	{
+		close(s);
+	}
+	close(timer);
+	close(epoll);
+
+	return 0;
+}
+
+/*------------------------------------------------------------------------------------------
+** polecenie host - jeden mecz botow (zasady gry z sim.cpp) w stalym rytmie zegara, rozsylany
+** do wszystkich widzow, ktorzy przyslali PACKET_SPECTATE dla meczu 0
+**------------------------------------------------------------------------------------------*/
+int runHost(const ServerOptions& options)
+{
+	int socket = openServerSocket(options.port);
+	int epoll = epoll_create1(0);
+	if (socket < 0 || epoll < 0)
+		return 1;
+
+	PacketIo io;
+	if (!openPacketIo(io, socket, options.backend))
+		return 1;
+
+	double start = monotonicSeconds();
+	int timer = openTickTimer(options.tickRate);
+
+	epoll_event event = {};
+	event.events = EPOLLIN;
+	event.data.fd = io.readyFd;
+	epoll_ctl(epoll, EPOLL_CTL_ADD, io.readyFd, &event);
+	event.data.fd = timer;
+	epoll_ctl(epoll, EPOLL_CTL_ADD, timer, &event);
+
+	const float dt = (float)(1.0 / options.tickRate);
+	unsigned int seed = (unsigned int)time(NULL);
+	World world;
+	initWorld(world, seed);
+	unsigned int tick = 0;
+
+	SpectatorHub hub;
+	initSpectatorHub(hub, &io, 0, (unsigned int)lround(options.tickRate));
+
+	printf("host: port %u, %.0f krokow/s, klatka kluczowa co %u krokow, pakiety: %s\n", options.port, options.tickRate, hub.keyframeInterval, packetBackendName(io.backend));
+	fflush(stdout);
+
+	unsigned long long ticks = 0, missedTicks = 0;
+	double publishSeconds = 0.0, flushSeconds = 0.0, maxFlushSeconds = 0.0;
+	double lastReport = start, lastTimeoutCheck = start;
+
+	while (!stopRequested)
+	{
+		epoll_event events[4];
+		int count = epoll_wait(epoll, events, 4, 100);
+		double now = monotonicSeconds();
+
+		for (int e = 0; e < count; e++)
+		{
+			if (events[e].data.fd == io.readyFd)
+			{
+				const ReceivedPacket* packets;
+				unsigned int received;
+				while ((received = receiveBatch(io, packets)) > 0)
+				{
+					for (unsigned int i = 0; i < received; i++)
+					{
+						const ReceivedPacket& packet = packets[i];
+						if (packet.size >= spectatePacketSize && getU32(packet.data + 1) == hub.match)
+						{
+							if (packet.data[0] == PACKET_SPECTATE)
+								addSpectator(hub, packet.address, packet.port, now);
+							else if (packet.data[0] == PACKET_UNSPECTATE)
+								removeSpectator(hub, packet.address, packet.port);
+						}
+					}
+				}
+				continue;
+			}
+
+			unsigned long long expirations = 0;
+			if (read(timer, &expirations, sizeof(expirations)) != sizeof(expirations) || expirations == 0)
+				continue;
+			missedTicks += expirations - 1;
+
+			// krok meczu i jedno kodowanie stanu na krok, niezaleznie od liczby widzow
+			double publishStart = monotonicSeconds();
+			for (unsigned long long t = 0; t < expirations && t < 4; t++)
+			{
+				Inputs inputs = { trackingBot(world, 0) | trackingBot(world, 1) };
+				step(world, inputs, dt);
+				if (world.scoreForLeft >= options.points || world.scoreForRight >= options.points)
+					initWorld(world, ++seed);
+
+				NetState state;
+				quantizeState(world, ++tick, state);
+				publishState(hub, state);
+				ticks++;
+			}
+			double flushStart = monotonicSeconds();
+			flushSpectators(hub);
+			double flushEnd = monotonicSeconds();
+
+			publishSeconds += flushStart - publishStart;
+			flushSeconds += flushEnd - flushStart;
+			if (flushEnd - flushStart > maxFlushSeconds)
+				maxFlushSeconds = flushEnd - flushStart;
+		}
+
+		if (now - lastTimeoutCheck >= 1.0)
+		{
+			dropSilentSpectators(hub, now, options.clientTimeout);
+			lastTimeoutCheck = now;
+		}
+
+		if (options.reportInterval > 0.0 && now - lastReport >= options.reportInterval)
+		{
+			const SpectatorStats& stats = hub.stats;
+			double seconds = now - lastReport;
+			double perTick = ticks ? (double)ticks : 1.0;
+
+			printf("widzowie %zu | kodowania/krok %.2f, klatki kluczowe %llu, kodowanie i kolejki sr %.1f us | wysylanie sr %.3f ms, max %.3f ms"
+				" | pakiety/s: we %.0f, wy %.0f, %.0f kB/s (bledy %llu), wywolania/s %.0f | dolaczenia %llu, resync %llu, klatki w uzyciu %u, nadrobione %llu\n",
+				hub.spectators.size(), stats.frames / perTick, stats.keyframes, publishSeconds / perTick * 1e6,
+				flushSeconds / perTick * 1e3, maxFlushSeconds * 1e3,
+				io.stats.packetsIn / seconds, stats.packetsOut / seconds, stats.bytesOut / seconds / 1000.0, stats.sendFailures, io.stats.syscalls / seconds,
+				stats.joins, stats.resyncs, hub.framesInUse, missedTicks);
+			fflush(stdout);
+
+			hub.stats = SpectatorStats();
+			io.stats = PacketIoStats();
+			ticks = missedTicks = 0;
+			publishSeconds = flushSeconds = maxFlushSeconds = 0.0;
+			lastReport = now;
+		}
+
+		if (options.seconds > 0.0 && now - start >= options.seconds)
+			break;
+	}
+
+	freeSpectatorHub(hub);
+	closePacketIo(io);
+	close(socket);
+	close(timer);
+	close(epoll);
+
+	return 0;
+}
+
+/*------------------------------------------------------------------------------------------
+** polecenie viewers - widzowie zastepczy: --clients gniazd, w kazdym kroku dolacza
+** --joins-per-tick nowych, wiec wiekszosc trafia w srodek lancucha roznic; kazdy widz dekoduje
+** klatki wlasna historia stanow i sprawdza ciaglosc krokow
+**------------------------------------------------------------------------------------------*/
+int runViewers(const ClientOptions& options)
+{
+	addrinfo hints = {};
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+	addrinfo* resolved = nullptr;
+	if (getaddrinfo(options.host.c_str(), nullptr, &hints, &resolved) != 0 || !resolved)
+	{
+		std::cerr << "Nieznany adres serwera: " << options.host << std::endl;
+		return 1;
+	}
+	sockaddr_in hostAddress = *(sockaddr_in*)resolved->ai_addr;
+	hostAddress.sin_port = htons(options.port);
+	freeaddrinfo(resolved);
+
+	int epoll = epoll_create1(0);
+	std::vector<StandInViewer> viewers(options.clients);
+	for (unsigned int v = 0; v < options.clients; v++)
+	{
+		StandInViewer& viewer = viewers[v];
+		viewer = StandInViewer();
+		viewer.socket = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+		if (viewer.socket < 0 || connect(viewer.socket, (sockaddr*)&hostAddress, sizeof(hostAddress)) != 0)
+		{
+			std::cerr << "Nie mozna utworzyc gniazda widza " << v << " (ulimit -n?)" << std::endl;
+			return 1;
+		}
+		clearNetStateHistory(viewer.history);
+
+		epoll_event event = {};
+		event.events = EPOLLIN;
+		event.data.u32 = v;
+		epoll_ctl(epoll, EPOLL_CTL_ADD, viewer.socket, &event);
+	}
+
+	int timer = openTickTimer(options.tickRate);
+	epoll_event timerEvent = {};
+	timerEvent.events = EPOLLIN;
+	timerEvent.data.u32 = options.clients;
+	epoll_ctl(epoll, EPOLL_CTL_ADD, timer, &timerEvent);
+
+	const unsigned int tickRate = (unsigned int)lround(options.tickRate);
+	const unsigned int keepAliveTicks = 2 * tickRate; // co ile krokow widz przypomina o sobie
+	unsigned long long frames = 0, frameBytes = 0, failures = 0, gaps = 0, bootstraps = 0;
+	double bootstrapSeconds = 0.0, maxBootstrapSeconds = 0.0;
+	unsigned int subscribed = 0, synced = 0, timerTicks = 0;
+	unsigned char packet[64];
+
+	double start = monotonicSeconds();
+	double lastReport = start;
+	double now = start;
+
+	while (!stopRequested && now - start < options.seconds)
+	{
+		epoll_event events[64];
+		int count = epoll_wait(epoll, events, 64, 100);
+		now = monotonicSeconds();
+
+		for (int e = 0; e < count; e++)
+		{
+			unsigned int v = events[e].data.u32;
+
+			if (v == options.clients)
+			{
+				unsigned long long expirations;
+				if (read(timer, &expirations, sizeof(expirations)) != sizeof(expirations))
+					continue;
+				timerTicks++;
+
+				packet[0] = PACKET_SPECTATE;
+				putU32(packet + 1, 0);
+
+				for (unsigned int n = 0; n < options.joinsPerTick && subscribed < options.clients; n++)
+				{
+					StandInViewer& viewer = viewers[subscribed++];
+					viewer.subscribed = true;
+					viewer.subscribeTime = now;
+					send(viewer.socket, packet, spectatePacketSize, 0);
+				}
+
+				for (unsigned int i = timerTicks % keepAliveTicks; i < subscribed; i += keepAliveTicks)
+				{
+					send(viewers[i].socket, packet, spectatePacketSize, 0);
+				}
+				continue;
+			}
+
+			StandInViewer& viewer = viewers[v];
+			ssize_t size;
+			while ((size = recv(viewer.socket, packet, sizeof(packet), 0)) > 0)
+			{
+				if (packet[0] != PACKET_FRAME || size <= (ssize_t)frameHeaderSize)
+					continue;
+
+				NetState state;
+				if (!decodeState(packet + frameHeaderSize, (unsigned int)size - frameHeaderSize, viewer.history, tickRate, state))
+				{
+					failures++;
+					continue;
+				}
+				storeNetState(viewer.history, state);
+				frames++;
+				frameBytes += size;
+
+				if (!viewer.synced)
+				{
+					viewer.synced = true;
+					synced++;
+					double seconds = now - viewer.subscribeTime;
+					bootstrapSeconds += seconds;
+					bootstraps++;
+					if (seconds > maxBootstrapSeconds)
+						maxBootstrapSeconds = seconds;
+				}
+				else if (state.tick != viewer.lastTick + 1)
+				{
+					gaps++;
+				}
+				viewer.lastTick = state.tick;
+			}
+		}
+
+		if (now - lastReport >= 1.0)
+		{
+			double seconds = now - lastReport;
+			printf("widzowie %u/%u, zsynchronizowani %u | klatki/s %.0f, sr %.2f B | dolaczenie sr %.1f ms, max %.1f ms | przerwy %llu, nieczytelne %llu\n",
+				subscribed, options.clients, synced, frames / seconds, frames ? (double)frameBytes / frames : 0.0,
+				bootstraps ? bootstrapSeconds / bootstraps * 1e3 : 0.0, maxBootstrapSeconds * 1e3, gaps, failures);
+			fflush(stdout);
+
+			frames = frameBytes = bootstraps = 0;
+			bootstrapSeconds = maxBootstrapSeconds = 0.0;
+			lastReport = now;
+		}
+	}
+
+	packet[0] = PACKET_UNSPECTATE;
+	putU32(packet + 1, 0);
+	for (StandInViewer& viewer : viewers)
+	{
+		if (viewer.subscribed)
+			send(viewer.socket, packet, spectatePacketSize, 0);
+		close(viewer.socket);
+	}
+	close(timer);
+	close(epoll);
+
+	return 0;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja wczytujaca opcje pomiaru przepustowosci pakietow z linii polecen
+** funkcja zwraca false jesli napotka nieznana lub niekompletna opcje
+**------------------------------------------------------------------------------------------*/
+bool parseIoBenchOptions(int argc, char* argv[], int first, IoBenchOptions& options)
+{
+	for (int i = first; i < argc; i++)
+	{
+		if (i + 1 >= argc)
+		{
+			std::cerr << "Brak wartosci dla opcji: " << argv[i] << std::endl;
+			return false;
+		}
+
+		const char* name = argv[i];
+		const char* value = argv[++i];
+
+		if (!strcmp(name, "--packets"))
+			options.packets = (unsigned int)strtoul(value, nullptr, 10);
+		else if (!strcmp(name, "--size"))
+			options.size = (unsigned int)strtoul(value, nullptr, 10);
+		else if (!strcmp(name, "--io"))
+		{
+			PacketBackend backend;
+			if (!parsePacketBackend(value, backend))
+			{
+				std::cerr << "Nieznany sposob wysylania pakietow: " << value << std::endl;
+				return false;
+			}
+			options.backend = backend;
+		}
+		else
+		{
+			std::cerr << "Nieznana opcja: " << name << std::endl;
+			return false;
+		}
+	}
+
+	if (options.size == 0 || options.size > packetSlotSize)
+	{
+		std::cerr << "Rozmiar pakietu musi byc z przedzialu 1.." << packetSlotSize << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+/*------------------------------------------------------------------------------------------
+** polecenie iobench - dwa gniazda na petli zwrotnej w jednym watku: nadawca wysyla paczki
+** pakietow, odbiorca odbiera je tym samym sposobem; w locie najwyzej kilka paczek, zeby
+** nie przepelnic bufora odbiorcy
+**------------------------------------------------------------------------------------------*/
+int runIoBench(const IoBenchOptions& options)
+{
+	const unsigned int window = 4 * packetBatchSize;
+	int result = 0;
+
+	printf("%u pakietow po %u B przez 127.0.0.1\n", options.packets, options.size);
+
+	for (int b = PACKET_IO_BASIC; b <= PACKET_IO_URING; b++)
+	{
+		if (options.backend >= 0 && b != options.backend)
+			continue;
+		PacketBackend backend = (PacketBackend)b;
+
+		int sender = openServerSocket(0);
+		int receiver = openServerSocket(0);
+		sockaddr_in local;
+		socklen_t localSize = sizeof(local);
+		getsockname(receiver, (sockaddr*)&local, &localSize);
+		unsigned int address = htonl(INADDR_LOOPBACK);
+
+		PacketIo out, in;
+		if (sender < 0 || receiver < 0 || !openPacketIo(out, sender, backend) || !openPacketIo(in, receiver, backend))
+		{
+			printf("%-6s niedostepny\n", packetBackendName(backend));
+			if (sender >= 0)
+				close(sender);
+			if (receiver >= 0)
+				close(receiver);
+			result = 1;
+			continue;
+		}
+
+		unsigned long long sent = 0, received = 0, corrupted = 0;
+		double start = monotonicSeconds();
+		double lastProgress = start;
+
+		while (received < options.packets)
+		{
+			// wysylanie do zapelnienia okna
+			while (sent < options.packets && sent - received - out.stats.sendFailures < window)
+			{
+				unsigned char* packet = allocPacket(out, options.size);
+				memset(packet, 0, options.size);
+				putU32(packet, (unsigned int)sent);
+				queuePacket(out, address, local.sin_port, packet, options.size);
+				sent++;
+				if (sent % packetBatchSize == 0)
+					flushPackets(out);
+			}
+			flushPackets(out);
+
+			const ReceivedPacket* packets;
+			unsigned int count = receiveBatch(in, packets);
+			for (unsigned int i = 0; i < count; i++)
+			{
+				if (packets[i].size != options.size)
+					corrupted++;
+			}
+			received += count;
+
+			double now = monotonicSeconds();
+			if (count > 0)
+				lastProgress = now;
+			else if (received + out.stats.sendFailures >= sent && sent >= options.packets)
+				break;
+			else if (now - lastProgress > 1.0)
+				break; // zgubione pakiety - reszta juz nie przyjdzie
+		}
+		double seconds = monotonicSeconds() - start;
+
+		printf("%-6s %10.0f pakietow/s | wywolania systemowe na pakiet: nadawca %.3f, odbiorca %.3f | zgubione %llu, bledy %llu\n",
+			packetBackendName(backend), received / seconds,
+			(double)out.stats.syscalls / sent, received ? (double)in.stats.syscalls / received : 0.0,
+			sent - received, out.stats.sendFailures + corrupted);
+		fflush(stdout);
+
+		closePacketIo(out);
+		closePacketIo(in);
+		close(sender);
+		close(receiver);
+	}
+
+	return result;
+}
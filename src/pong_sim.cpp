@@ -0,0 +1,1502 @@
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+#include "sim.h"
+#include "batch.h"
+#include "bots.h"
+#include "runner.h"
+#include "montecarlo.h"
+#include "fastforward.h"
+#include "fixed.h"
+#include "replay.h"
+#include "snapshot.h"
+#include "rollback.h"
+#include "statecodec.h"
+#include "netclient.h"
+#include "wire.h"
+#include "pong_env.h"
+#include "trace.h"
+
+// PARAMETRY URUCHOMIENIA SYMULACJI BEZ OKNA
+struct SimOptions {
+	unsigned int matches = 1000; // liczba rozgrywanych meczow
+	unsigned int points = 11; // do ilu punktow gra sie mecz
+	unsigned int seed = 1; // ziarno pierwszego meczu (kolejne mecze: seed + i)
+	float dt = 1.0f / 60.0f; // dlugosc kroku symulacji
+	unsigned long long maxTicks = 10000000ull; // limit krokow na mecz
+	unsigned int ticks = 10000; // liczba krokow paczki meczow
+	BatchKernel kernel = BATCH_KERNEL_BEST; // kernel kroku paczki
+	unsigned int threads = 0; // liczba watkow (0 - tyle ile rdzeni)
+	unsigned int batchSize = 256; // liczba meczow krokowanych naraz przez watek
+	std::string path = "."; // katalog plikow powtorek
+	double rtt = 0.1; // czas przesylu tam i z powrotem w grze sieciowej (s)
+	double jitter = 0.0; // losowy dodatek do opoznienia w jedna strone (s)
+	double loss = 0.0; // prawdopodobienstwo zgubienia pakietu
+	unsigned int inputDelay = 0; // opoznienie wlasnych klawiszy w krokach
+	unsigned int udpPort = 0; // pierwszy port UDP (0 - lacze w pamieci)
+	Bot bot = trackingBotController; // sterownik rakietek (match, events)
+	void (*botBatch)(const MatchBatch& batch, unsigned int* keys) = trackingBotBatch; // ten sam sterownik dla paczki (batch, run)
+	void (*rightBotBatch)(const MatchBatch& batch, unsigned int* keys) = nullptr; // inny sterownik prawej rakietki (stats)
+	std::string trace; // plik sladu Chrome trace-event (stats, tylko z PONG_TRACE)
+};
+
+void printUsage();
+bool parseOptions(int argc, char* argv[], int first, SimOptions& options);
+int runMatches(const SimOptions& options);
+int runBatch(const SimOptions& options);
+int runParallel(const SimOptions& options);
+int runEventDriven(const SimOptions& options);
+int runFixed(const SimOptions& options);
+int runReplay(const SimOptions& options);
+int runSnapshots(const SimOptions& options);
+int runNetplay(const SimOptions& options);
+int runCodec(const SimOptions& options);
+int runPredict(const SimOptions& options);
+int runIntercept(const SimOptions& options);
+int runEnv(const SimOptions& options);
+int runStats(const SimOptions& options);
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		printUsage();
+		return 1;
+	}
+
+	SimOptions options;
+	if (!parseOptions(argc, argv, 2, options))
+	{
+		printUsage();
+		return 1;
+	}
+
+	std::string command = argv[1];
+
+	if (command == "match")
+	{
+		return runMatches(options);
+	}
+	if (command == "batch")
+	{
+		return runBatch(options);
+	}
+	if (command == "run")
+	{
+		return runParallel(options);
+	}
+	if (command == "events")
+	{
+		return runEventDriven(options);
+	}
+	if (command == "fixed")
+	{
+		return runFixed(options);
+	}
+	if (command == "replay")
+	{
+		return runReplay(options);
+	}
+	if (command == "snapshot")
+	{
+		return runSnapshots(options);
+	}
+	if (command == "netplay")
+	{
+		return runNetplay(options);
+	}
+	if (command == "codec")
+	{
+		return runCodec(options);
+	}
+	if (command == "predict")
+	{
+		return runPredict(options);
+	}
+	if (command == "intercept")
+	{
+		return runIntercept(options);
+	}
+	if (command == "env")
+	{
+		return runEnv(options);
+	}
+	if (command == "stats")
+	{
+		return runStats(options);
+	}
+
+	std::cerr << "Nieznane polecenie: " << command << std::endl;
+	printUsage();
+
+	return 1;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja wyswietlajaca sposob uzycia programu
+**------------------------------------------------------------------------------------------*/
+void printUsage()
+{
+	std::cerr << "Uzycie: pong_sim <polecenie> [opcje]\n"
+		<< "Polecenia:\n"
+		<< "  match    rozgrywa mecze bot kontra bot i mierzy liczbe krokow na sekunde\n"
+		<< "  batch    krokuje paczke meczow (SoA, SIMD) i porownuje wynik z kernelem skalarnym\n"
+		<< "  run      rozgrywa mecze na wszystkich rdzeniach i raportuje wydajnosc watkow\n"
+		<< "  events   rozgrywa mecze skokami od zdarzenia do zdarzenia i porownuje z krokami --dt\n"
+		<< "  fixed    rozgrywa mecze w liczbach staloprzecinkowych i wypisuje skrot stanu (determinizm)\n"
+		<< "  replay   zapisuje powtorki meczow do --path, sprawdza przewijanie i mierzy rozmiar plikow\n"
+		<< "  snapshot cofa mecze o kilka krokow z pierscienia migawek, sprawdza zgodnosc i mierzy czas zapisu/odczytu\n"
+		<< "  netplay  gra dwoch botow przez lacze z opoznieniem i stratami (rollback), sprawdza zgodnosc stanow\n"
+		<< "  codec    koduje stany paczki meczow roznicowo (kwantyzacja, bity), mierzy bajty na krok i czas kodowania\n"
+		<< "  predict  gracz z przewidywaniem wlasnej rakietki przeciw serwerowi zastepczemu przez lacze z opoznieniem\n"
+		<< "  intercept porownuje analityczne miejsce przeciecia z symulacja do przodu (dokladnosc, czas decyzji) i gra nim z botem sledzacym\n"
+		<< "  env      sprawdza libpong_env (--batch-size srodowisk, --ticks akcji) z meczami step() i mierzy kroki srodowisk na sekunde\n"
+		<< "  stats    statystyki meczow (wygrane, wymiany, katy serwu, dlugosc punktow) z przedzialami ufnosci 95%\n"
+		<< "Opcje:\n"
+		<< "  --matches N   liczba meczow\n"
+		<< "  --points N    do ilu punktow gra sie mecz\n"
+		<< "  --seed N      ziarno pierwszego meczu\n"
+		<< "  --dt S        dlugosc kroku symulacji w sekundach\n"
+		<< "  --max-ticks N limit krokow na mecz\n"
+		<< "  --ticks N     liczba krokow paczki meczow\n"
+		<< "  --kernel K    kernel paczki: scalar, sse2, avx2, best\n"
+		<< "  --threads N   liczba watkow (0 - tyle ile rdzeni)\n"
+		<< "  --batch-size N liczba meczow krokowanych naraz przez watek\n"
+		<< "  --path DIR    katalog plikow powtorek\n"
+		<< "  --rtt MS      czas przesylu tam i z powrotem (codec: wiek potwierdzonej bazy)\n"
+		<< "  --jitter MS   losowy dodatek do opoznienia\n"
+		<< "  --loss P      procent gubionych pakietow\n"
+		<< "  --input-delay N opoznienie wlasnych klawiszy w krokach\n"
+		<< "  --udp PORT    gra przez gniazda UDP na PORT i PORT+1 zamiast lacza w pamieci\n"
+		<< "  --bot B       sterownik rakietek w match, events, batch, run i stats: tracking, intercept\n"
+		<< "  --right-bot B inny sterownik prawej rakietki w stats\n"
+		<< "  --trace FILE  slad watkow stats w formacie Chrome trace-event (build z PONG_TRACE)\n";
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja wczytujaca opcje z linii polecen
+** first - indeks pierwszego argumentu z opcjami
+** options - wypelniana struktura z parametrami
+** funkcja zwraca false jesli napotka nieznana lub niekompletna opcje
+**------------------------------------------------------------------------------------------*/
+bool parseOptions(int argc, char* argv[], int first, SimOptions& options)
+{
+	for (int i = first; i < argc; i++)
+	{
+		if (i + 1 >= argc)
+		{
+			std::cerr << "Brak wartosci dla opcji: " << argv[i] << std::endl;
+			return false;
+		}
+
+		const char* name = argv[i];
+		const char* value = argv[++i];
+
+		if (!strcmp(name, "--matches"))
+			options.matches = (unsigned int)strtoul(value, nullptr, 10);
+		else if (!strcmp(name, "--points"))
+			options.points = (unsigned int)strtoul(value, nullptr, 10);
+		else if (!strcmp(name, "--seed"))
+			options.seed = (unsigned int)strtoul(value, nullptr, 10);
+		else if (!strcmp(name, "--dt"))
+			options.dt = strtof(value, nullptr);
+		else if (!strcmp(name, "--max-ticks"))
+			options.maxTicks = strtoull(value, nullptr, 10);
+		else if (!strcmp(name, "--ticks"))
+			options.ticks = (unsigned int)strtoul(value, nullptr, 10);
+		else if (!strcmp(name, "--threads"))
+			options.threads = (unsigned int)strtoul(value, nullptr, 10);
+		else if (!strcmp(name, "--batch-size"))
+			options.batchSize = (unsigned int)strtoul(value, nullptr, 10);
+		else if (!strcmp(name, "--path"))
+			options.path = value;
+		else if (!strcmp(name, "--trace"))
+			options.trace = value;
+		else if (!strcmp(name, "--rtt"))
+			options.rtt = strtod(value, nullptr) / 1000.0;
+		else if (!strcmp(name, "--jitter"))
+			options.jitter = strtod(value, nullptr) / 1000.0;
+		else if (!strcmp(name, "--loss"))
+			options.loss = strtod(value, nullptr) / 100.0;
+		else if (!strcmp(name, "--input-delay"))
+			options.inputDelay = (unsigned int)strtoul(value, nullptr, 10);
+		else if (!strcmp(name, "--udp"))
+			options.udpPort = (unsigned int)strtoul(value, nullptr, 10);
+		else if (!strcmp(name, "--bot"))
+		{
+			if (!strcmp(value, "intercept"))
+			{
+				options.bot = interceptBotController;
+				options.botBatch = interceptBotBatch;
+			}
+			else if (!strcmp(value, "tracking"))
+			{
+				options.bot = trackingBotController;
+				options.botBatch = trackingBotBatch;
+			}
+			else
+			{
+				std::cerr << "Nieznany bot: " << value << std::endl;
+				return false;
+			}
+		}
+		else if (!strcmp(name, "--right-bot"))
+		{
+			if (!strcmp(value, "intercept"))
+				options.rightBotBatch = interceptBotBatch;
+			else if (!strcmp(value, "tracking"))
+				options.rightBotBatch = trackingBotBatch;
+			else
+			{
+				std::cerr << "Nieznany bot: " << value << std::endl;
+				return false;
+			}
+		}
+		else if (!strcmp(name, "--kernel"))
+		{
+			if (!strcmp(value, "scalar"))
+				options.kernel = BATCH_KERNEL_SCALAR;
+			else if (!strcmp(value, "sse2"))
+				options.kernel = BATCH_KERNEL_SSE2;
+			else if (!strcmp(value, "avx2"))
+				options.kernel = BATCH_KERNEL_AVX2;
+			else
+				options.kernel = BATCH_KERNEL_BEST;
+		}
+		else
+		{
+			std::cerr << "Nieznana opcja: " << name << std::endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja rozgrywajaca mecze bot kontra bot bez okna i kontekstu GL
+** options - parametry symulacji
+**------------------------------------------------------------------------------------------*/
+int runMatches(const SimOptions& options)
+{
+	unsigned long long totalTicks = 0;
+	unsigned int winsForLeft = 0;
+	unsigned int winsForRight = 0;
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (unsigned int m = 0; m < options.matches; m++)
+	{
+		World world;
+		initWorld(world, options.seed + m);
+
+		while (world.scoreForLeft < options.points && world.scoreForRight < options.points && world.tick < options.maxTicks)
+		{
+			Inputs inputs = { options.bot.decide(world, 0) | options.bot.decide(world, 1) };
+			step(world, inputs, options.dt);
+		}
+
+		totalTicks += world.tick;
+		if (world.scoreForLeft > world.scoreForRight)
+			winsForLeft++;
+		else if (world.scoreForRight > world.scoreForLeft)
+			winsForRight++;
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << "mecze: " << options.matches << "\n"
+		<< "wygrane lewego: " << winsForLeft << ", wygrane prawego: " << winsForRight << "\n"
+		<< "kroki: " << totalTicks << "\n"
+		<< "czas: " << seconds << " s\n"
+		<< "kroki/s: " << (seconds > 0.0 ? totalTicks / seconds : 0.0) << std::endl;
+
+	return 0;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja krokujaca cala paczke meczow zadanym kernelem
+** funkcja zwraca czas w sekundach
+**------------------------------------------------------------------------------------------*/
+static double simulateBatch(MatchBatch& batch, unsigned int* keys, const SimOptions& options, BatchKernel kernel)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	for (unsigned int t = 0; t < options.ticks; t++)
+	{
+		options.botBatch(batch, keys);
+		stepBatch(batch, keys, options.dt, kernel);
+	}
+
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja porownujaca stan dwoch paczek meczow
+** funkcja zwraca liczbe meczow, ktorych stan sie rozni
+**------------------------------------------------------------------------------------------*/
+static unsigned int compareBatches(const MatchBatch& a, const MatchBatch& b)
+{
+	unsigned int mismatches = 0;
+
+	for (unsigned int i = 0; i < a.count; i++)
+	{
+		World wa, wb;
+		loadWorld(a, i, wa);
+		loadWorld(b, i, wb);
+
+		if (memcmp(&wa, &wb, sizeof(World)) != 0)
+			mismatches++;
+	}
+
+	return mismatches;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja krokujaca paczke meczow kernelem SIMD i sprawdzajaca zgodnosc z kernelem skalarnym
+** options - parametry symulacji
+**------------------------------------------------------------------------------------------*/
+int runBatch(const SimOptions& options)
+{
+	MatchBatch batch, reference;
+	initBatch(batch, options.matches, options.seed);
+	initBatch(reference, options.matches, options.seed);
+
+	unsigned int* keys = new unsigned int[batch.capacity];
+
+	double seconds = simulateBatch(batch, keys, options, options.kernel);
+	double referenceSeconds = simulateBatch(reference, keys, options, BATCH_KERNEL_SCALAR);
+
+	unsigned int mismatches = compareBatches(batch, reference);
+	double matchTicks = (double)options.matches * options.ticks;
+
+	std::cout << "kernel: " << batchKernelName(options.kernel)
+		<< (batchKernelAvailable(options.kernel) ? "" : " (niedostepny w tej kompilacji lub na tym procesorze - liczony skalarnie)") << "\n"
+		<< "mecze: " << options.matches << ", kroki: " << options.ticks << "\n"
+		<< "kroki meczow/s: " << (seconds > 0.0 ? matchTicks / seconds : 0.0) << "\n"
+		<< "kroki meczow/s (scalar): " << (referenceSeconds > 0.0 ? matchTicks / referenceSeconds : 0.0) << "\n"
+		<< "mecze niezgodne ze scalar: " << mismatches << std::endl;
+
+	delete[] keys;
+	freeBatch(batch);
+	freeBatch(reference);
+
+	return mismatches == 0 ? 0 : 1;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja rozgrywajaca mecze na wielu rdzeniach z podkradaniem pracy
+** options - parametry symulacji
+**------------------------------------------------------------------------------------------*/
+int runParallel(const SimOptions& options)
+{
+	RunnerOptions runner;
+	runner.threads = options.threads;
+	runner.matches = options.matches;
+	runner.firstSeed = options.seed;
+	runner.points = options.points;
+	runner.batchSize = options.batchSize;
+	runner.maxTicks = options.maxTicks;
+	runner.dt = options.dt;
+	runner.bots = options.botBatch;
+
+	MatchResults total;
+	std::vector<WorkerReport> reports;
+
+	auto start = std::chrono::steady_clock::now();
+	runMatchesParallel(runner, total, reports);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	for (size_t t = 0; t < reports.size(); t++)
+	{
+		const WorkerReport& report = reports[t];
+		std::cout << "watek " << t << ": mecze " << report.results.matches
+			<< ", kradzieze " << report.steals
+			<< ", kroki/s " << (report.seconds > 0.0 ? report.results.ticks / report.seconds : 0.0) << "\n";
+	}
+
+	std::cout << "mecze: " << total.matches << " (nieskonczone: " << total.unfinished << ")\n"
+		<< "wygrane lewego: " << total.winsForLeft << ", wygrane prawego: " << total.winsForRight << "\n"
+		<< "punkty: " << total.points << ", odbicia: " << total.hits << "\n"
+		<< "srednia wymiana: " << (total.points ? (double)total.rallyTicks / total.points : 0.0) << " krokow"
+		<< ", najdluzsza: " << total.longestRally << "\n"
+		<< "kroki: " << total.ticks << "\n"
+		<< "czas: " << seconds << " s\n"
+		<< "kroki/s: " << (seconds > 0.0 ? total.ticks / seconds : 0.0) << std::endl;
+
+	return 0;
+}
+
+// dopisanie konca meczu do wynikow (do porownania rozkladow w runEventDriven)
+static void addMatchResult(MatchResults& results, const World& world, unsigned int points)
+{
+	results.matches++;
+	if (world.scoreForLeft >= points)
+		results.winsForLeft++;
+	else if (world.scoreForRight >= points)
+		results.winsForRight++;
+	else
+		results.unfinished++;
+	results.points += world.scoreForLeft + world.scoreForRight;
+	results.hits += world.hits;
+	results.ticks += world.tick;
+}
+
+// wzgledna roznica dwoch srednich
+static double relativeDifference(double a, double b)
+{
+	double scale = std::max(std::abs(a), std::abs(b));
+
+	return scale > 0.0 ? std::abs(a - b) / scale : 0.0;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja porownujaca rozgrywanie meczow krok po kroku i skokami od zdarzenia do zdarzenia;
+** skoki zaokraglaja sie inaczej niz kroki, wiec pojedyncze mecze moga sie rozejsc - porownywane
+** sa rozklady: udzial wygranych lewego (do 3 odchylen standardowych proby), srednia dlugosc
+** punktu i srednia liczba odbic na punkt (do eventTolerance)
+** options - parametry symulacji
+**------------------------------------------------------------------------------------------*/
+int runEventDriven(const SimOptions& options)
+{
+	const double eventTolerance = 0.02;
+	const Bot bots[2] = { options.bot, options.bot };
+
+	MatchResults stepped = MatchResults();
+	MatchResults jumped = MatchResults();
+	unsigned long long events = 0;
+	unsigned int diverged = 0;
+
+	double tickSeconds = 0.0, eventSeconds = 0.0;
+	for (unsigned int m = 0; m < options.matches; m++)
+	{
+		World a;
+		initWorld(a, options.seed + m);
+
+		auto start = std::chrono::steady_clock::now();
+		while (a.scoreForLeft < options.points && a.scoreForRight < options.points && a.tick < options.maxTicks)
+		{
+			Inputs inputs = { options.bot.decide(a, 0) | options.bot.decide(a, 1) };
+			step(a, inputs, options.dt);
+		}
+		tickSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		World b;
+		initWorld(b, options.seed + m);
+
+		start = std::chrono::steady_clock::now();
+		events += playPointsEventDriven(b, bots, options.points, options.dt, options.maxTicks);
+		eventSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		addMatchResult(stepped, a, options.points);
+		addMatchResult(jumped, b, options.points);
+		if (a.scoreForLeft != b.scoreForLeft || a.scoreForRight != b.scoreForRight || a.tick != b.tick || a.hits != b.hits)
+			diverged++;
+	}
+
+	double matches = options.matches ? (double)options.matches : 1.0;
+	double winShare[2] = { stepped.winsForLeft / matches, jumped.winsForLeft / matches };
+	double pointTicks[2] = { stepped.points ? (double)stepped.ticks / stepped.points : 0.0, jumped.points ? (double)jumped.ticks / jumped.points : 0.0 };
+	double pointHits[2] = { stepped.points ? (double)stepped.hits / stepped.points : 0.0, jumped.points ? (double)jumped.hits / jumped.points : 0.0 };
+
+	// trzy odchylenia standardowe roznicy udzialow w dwoch probach po options.matches meczow
+	double share = (winShare[0] + winShare[1]) / 2.0;
+	double shareError = 3.0 * std::sqrt(2.0 * share * (1.0 - share) / matches);
+
+	unsigned int failed = 0;
+	if (std::abs(winShare[0] - winShare[1]) > shareError)
+		failed++;
+	if (relativeDifference(pointTicks[0], pointTicks[1]) > eventTolerance)
+		failed++;
+	if (relativeDifference(pointHits[0], pointHits[1]) > eventTolerance)
+		failed++;
+	if (stepped.unfinished != jumped.unfinished)
+		failed++;
+
+	std::cout << "mecze: " << options.matches << " (rozne krok w krok: " << diverged << ")\n"
+		<< "krokami: " << stepped.ticks << " krokow, " << tickSeconds << " s\n"
+		<< "zdarzeniami: " << events << " skokow, " << eventSeconds << " s\n"
+		<< "przyspieszenie: " << (eventSeconds > 0.0 ? tickSeconds / eventSeconds : 0.0) << "x\n"
+		<< "wygrane lewego: " << winShare[0] * 100.0 << "% / " << winShare[1] * 100.0 << "%\n"
+		<< "krokow na punkt: " << pointTicks[0] << " / " << pointTicks[1] << "\n"
+		<< "odbic na punkt: " << pointHits[0] << " / " << pointHits[1] << "\n"
+		<< "nieskonczone: " << stepped.unfinished << " / " << jumped.unfinished << "\n"
+		<< "niezgodne rozklady: " << failed << std::endl;
+
+	return failed == 0 ? 0 : 1;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja rozgrywajaca mecze w liczbach staloprzecinkowych; skrot koncowych stanow musi byc
+** taki sam dla kazdego kompilatora, poziomu optymalizacji i procesora
+** options - parametry symulacji
+**------------------------------------------------------------------------------------------*/
+int runFixed(const SimOptions& options)
+{
+	const fixed_t dt = secondsToFixed(options.dt);
+
+	unsigned long long totalTicks = 0;
+	unsigned long long checksum = 0;
+	unsigned int winsForLeft = 0;
+	unsigned int winsForRight = 0;
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (unsigned int m = 0; m < options.matches; m++)
+	{
+		FixedWorld fixedWorld;
+		initFixedWorld(fixedWorld, options.seed + m);
+
+		while (fixedWorld.scoreForLeft < options.points && fixedWorld.scoreForRight < options.points && fixedWorld.tick < options.maxTicks)
+		{
+			// boty decyduja na podstawie kopii zmiennoprzecinkowej - do symulacji trafiaja tylko klawisze
+			World world;
+			fixedToWorld(fixedWorld, world);
+
+			Inputs inputs = { trackingBot(world, 0) | trackingBot(world, 1) };
+			stepFixed(fixedWorld, inputs, dt);
+		}
+
+		totalTicks += fixedWorld.tick;
+		checksum = checksum * 31 + hashFixedWorld(fixedWorld);
+		if (fixedWorld.scoreForLeft > fixedWorld.scoreForRight)
+			winsForLeft++;
+		else if (fixedWorld.scoreForRight > fixedWorld.scoreForLeft)
+			winsForRight++;
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << "mecze: " << options.matches << "\n"
+		<< "wygrane lewego: " << winsForLeft << ", wygrane prawego: " << winsForRight << "\n"
+		<< "kroki: " << totalTicks << "\n"
+		<< "skrot stanu: " << std::hex << checksum << std::dec << "\n"
+		<< "czas: " << seconds << " s\n"
+		<< "kroki/s: " << (seconds > 0.0 ? totalTicks / seconds : 0.0) << std::endl;
+
+	return 0;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zapisujaca powtorki meczow bot kontra bot, sprawdzajaca przewijanie do zapamietanych
+** krokow i mierzaca rozmiar plikow oraz czas przewijania
+** options - parametry symulacji
+**------------------------------------------------------------------------------------------*/
+int runReplay(const SimOptions& options)
+{
+	const unsigned long long checkInterval = 1000; // co ile krokow zapamietac stan do porownania
+
+	unsigned long long totalTicks = 0;
+	unsigned long long totalBytes = 0;
+	unsigned long long seeks = 0;
+	unsigned int mismatches = 0;
+	double seekSeconds = 0.0;
+
+	for (unsigned int m = 0; m < options.matches; m++)
+	{
+		unsigned int seed = options.seed + m;
+		std::string file = options.path + "/match_" + std::to_string(seed) + ".prpl";
+
+		ReplayWriter writer;
+		if (!openReplayWriter(writer, file.c_str(), seed, options.dt, 0))
+			return 1;
+
+		World world;
+		initWorld(world, seed);
+
+		std::vector<World> checkpoints;
+		while (world.scoreForLeft < options.points && world.scoreForRight < options.points && world.tick < options.maxTicks)
+		{
+			if (world.tick % checkInterval == 0)
+				checkpoints.push_back(world);
+
+			Inputs inputs = { trackingBot(world, 0) | trackingBot(world, 1) };
+			recordTick(writer, world, inputs.keys);
+			step(world, inputs, options.dt);
+		}
+		checkpoints.push_back(world);
+
+		if (!closeReplayWriter(writer))
+		{
+			std::cerr << "Blad zapisu powtorki: " << file << std::endl;
+			return 1;
+		}
+
+		// PRZEWIJANIE DO ZAPAMIETANYCH KROKOW
+		ReplayReader reader;
+		if (!openReplay(reader, file.c_str()))
+			return 1;
+
+		auto start = std::chrono::steady_clock::now();
+		for (const World& checkpoint : checkpoints)
+		{
+			World restored;
+			if (!seekReplay(reader, checkpoint.tick, restored) || memcmp(&restored, &checkpoint, sizeof(World)) != 0)
+				mismatches++;
+		}
+		seekSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		seeks += checkpoints.size();
+
+		totalTicks += replayTickCount(reader);
+		totalBytes += reader.size;
+		closeReplay(reader);
+	}
+
+	std::cout << "mecze: " << options.matches << ", kroki: " << totalTicks << "\n"
+		<< "bajty: " << totalBytes << " (" << (options.matches ? totalBytes / options.matches : 0) << " na mecz)\n"
+		<< "bity na krok: " << (totalTicks ? 8.0 * totalBytes / totalTicks : 0.0) << "\n"
+		<< "przewiniecia: " << seeks << ", sredni czas: " << (seeks ? seekSeconds / seeks * 1e6 : 0.0) << " us\n"
+		<< "niezgodne stany: " << mismatches << std::endl;
+
+	return mismatches == 0 ? 0 : 1;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja sprawdzajaca pierscien migawek tak, jak uzywa go rollback: co kilka krokow mecz
+** cofa sie o rollbackTicks krokow i symuluje je ponownie - stan musi byc identyczny
+** options - parametry symulacji
+**------------------------------------------------------------------------------------------*/
+int runSnapshots(const SimOptions& options)
+{
+	const unsigned int capacity = 64;
+	const unsigned int rollbackTicks = 8;
+	const unsigned int rollbackInterval = 16;
+
+	SnapshotRing ring;
+	initSnapshotRing(ring, capacity);
+
+	unsigned long long ticks = 0;
+	unsigned long long rollbacks = 0;
+	unsigned int mismatches = 0;
+	double saveSeconds = 0.0;
+
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned int m = 0; m < options.matches; m++)
+	{
+		World world;
+		initWorld(world, options.seed + m);
+		clearSnapshots(ring);
+
+		while (world.scoreForLeft < options.points && world.scoreForRight < options.points && world.tick < options.maxTicks)
+		{
+			saveSnapshot(ring, world);
+
+			Inputs inputs = { trackingBot(world, 0) | trackingBot(world, 1) };
+			step(world, inputs, options.dt);
+			ticks++;
+
+			if (world.tick % rollbackInterval == 0 && world.tick >= rollbackTicks)
+			{
+				World replayed;
+				if (!restoreSnapshot(ring, world.tick - rollbackTicks, replayed))
+				{
+					mismatches++;
+					continue;
+				}
+
+				while (replayed.tick < world.tick)
+				{
+					Inputs replayedInputs = { trackingBot(replayed, 0) | trackingBot(replayed, 1) };
+					step(replayed, replayedInputs, options.dt);
+				}
+
+				if (memcmp(&replayed, &world, sizeof(World)) != 0)
+					mismatches++;
+				rollbacks++;
+			}
+		}
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	// SAM ZAPIS I ODCZYT MIGAWEK
+	const unsigned int operations = 10000000;
+	World world;
+	initWorld(world, options.seed);
+
+	start = std::chrono::steady_clock::now();
+	for (unsigned int i = 0; i < operations; i++)
+	{
+		world.tick = i;
+		saveSnapshot(ring, world);
+	}
+	saveSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	unsigned long long found = 0;
+	start = std::chrono::steady_clock::now();
+	for (unsigned int i = 0; i < operations; i++)
+	{
+		found += restoreSnapshot(ring, operations - 1 - i % capacity, world);
+	}
+	double restoreSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	freeSnapshotRing(ring);
+
+	std::cout << "mecze: " << options.matches << ", kroki: " << ticks << ", cofniecia: " << rollbacks << "\n"
+		<< "czas meczow z cofaniem: " << seconds << " s\n"
+		<< "zapis migawki: " << saveSeconds / operations * 1e9 << " ns\n"
+		<< "odczyt migawki: " << restoreSeconds / operations * 1e9 << " ns (" << found << " trafien)\n"
+		<< "niezgodne stany: " << mismatches << std::endl;
+
+	return mismatches == 0 ? 0 : 1;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja rozgrywajaca mecz dwoch sesji z cofaniem w czasie wirtualnym (krok --dt na obrot
+** petli); kazda sesja steruje jedna rakietka botem patrzacym na wlasny, przewidywany stan
+** options - parametry symulacji i lacza (--ticks, --rtt, --jitter, --loss, --input-delay, --udp)
+**------------------------------------------------------------------------------------------*/
+int runNetplay(const SimOptions& options)
+{
+	const fixed_t dt = secondsToFixed(options.dt);
+
+	// LACZA: w pamieci albo prawdziwe gniazda UDP, w obu przypadkach przez symulator opoznien
+	LoopbackChannel channel;
+	UdpLink udp[2];
+	NetLink links[2];
+
+	if (options.udpPort)
+	{
+		for (int s = 0; s < 2; s++)
+		{
+			if (!openUdpLink(udp[s], (unsigned short)(options.udpPort + s), "127.0.0.1", (unsigned short)(options.udpPort + 1 - s)))
+				return 1;
+			links[s] = udpNetLink(udp[s]);
+		}
+	}
+	else
+	{
+		loopbackNetLinks(channel, links[0], links[1]);
+	}
+
+	NetShim shims[2];
+	RollbackSession sessions[2];
+	for (int s = 0; s < 2; s++)
+	{
+		initShim(shims[s], links[s], options.rtt / 2.0, options.jitter, options.loss, options.seed * 2 + s + 1);
+		initRollbackSession(sessions[s], shimNetLink(shims[s]), s, options.seed, dt, options.inputDelay);
+	}
+
+	// ROZGRYWKA
+	unsigned long long turns = 0;
+	const unsigned long long maxTurns = 4ull * options.ticks + 10000;
+
+	auto start = std::chrono::steady_clock::now();
+	while ((sessions[0].world.tick < options.ticks || sessions[1].world.tick < options.ticks
+		|| sessions[0].remoteTicks < options.ticks || sessions[1].remoteTicks < options.ticks) && turns < maxTurns)
+	{
+		double now = turns * options.dt;
+		turns++;
+
+		for (int s = 0; s < 2; s++)
+		{
+			pumpShim(shims[s], now);
+		}
+
+		for (int s = 0; s < 2; s++)
+		{
+			RollbackSession& session = sessions[s];
+			if (session.world.tick < options.ticks)
+			{
+				World world;
+				fixedToWorld(session.world, world);
+				advanceRollbackSession(session, trackingBot(world, s));
+			}
+			else
+			{
+				// koniec meczu - juz tylko wymiana klawiszy do pelnego potwierdzenia
+				pollRollbackSession(session);
+				sendRollbackInputs(session);
+			}
+		}
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	bool same = sessions[0].world.tick == sessions[1].world.tick && hashFixedWorld(sessions[0].world) == hashFixedWorld(sessions[1].world);
+	unsigned long long desyncs = 0;
+
+	std::cout << "lacze: " << (options.udpPort ? "udp" : "pamiec") << ", rtt " << options.rtt * 1000.0 << " ms"
+		<< ", rozrzut " << options.jitter * 1000.0 << " ms, straty " << options.loss * 100.0 << " %"
+		<< ", opoznienie klawiszy " << options.inputDelay << " krokow\n";
+	for (int s = 0; s < 2; s++)
+	{
+		const RollbackStats& stats = sessions[s].stats;
+		desyncs += stats.desyncs;
+
+		std::cout << "gracz " << s << ": kroki " << sessions[s].world.tick
+			<< ", cofniecia " << stats.rollbacks
+			<< " (srednio " << (stats.rollbacks ? (double)stats.resimulatedTicks / stats.rollbacks : 0.0)
+			<< ", najdluzsze " << stats.longestRollback << " krokow)"
+			<< ", wstrzymania " << stats.stalls
+			<< ", pakiety " << stats.packetsSent << "/" << stats.packetsReceived
+			<< ", zgubione " << shims[s].dropped
+			<< ", porownane skroty " << stats.checksumsCompared << "\n";
+	}
+	std::cout << "niezgodne skroty: " << desyncs << "\n"
+		<< "stan koncowy zgodny: " << (same ? "tak" : "nie") << "\n"
+		<< "czas: " << seconds << " s" << std::endl;
+
+	for (int s = 0; s < 2; s++)
+	{
+		freeRollbackSession(sessions[s]);
+		if (options.udpPort)
+			closeUdpLink(udp[s]);
+	}
+
+	return same && desyncs == 0 ? 0 : 1;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja kodujaca stany paczki meczow tak, jak serwer wysyla je graczom: co krok roznica
+** wzgledem stanu potwierdzonego --rtt wczesniej (gubione pakiety --loss nie sa baza);
+** kazdy stan jest dekodowany i porownywany ze skwantowanym oryginalem
+** options - parametry symulacji (--matches, --ticks, --dt, --rtt, --loss)
+**------------------------------------------------------------------------------------------*/
+int runCodec(const SimOptions& options)
+{
+	const unsigned int tickRate = (unsigned int)lround(1.0 / options.dt);
+	unsigned int ackAge = (unsigned int)lround(options.rtt / options.dt);
+	if (ackAge < 1)
+		ackAge = 1;
+
+	MatchBatch batch;
+	initBatch(batch, options.matches, options.seed);
+	unsigned int* keys = new unsigned int[batch.capacity]();
+
+	NetStateHistory* sent = new NetStateHistory[batch.count];
+	NetStateHistory* received = new NetStateHistory[batch.count];
+	for (unsigned int i = 0; i < batch.count; i++)
+	{
+		clearNetStateHistory(sent[i]);
+		clearNetStateHistory(received[i]);
+	}
+
+	NetState* states = new NetState[batch.count];
+	unsigned char* packets = new unsigned char[(size_t)batch.count * maxEncodedState];
+	unsigned int* sizes = new unsigned int[batch.count];
+
+	unsigned long long deltaBytes = 0, deltas = 0, fullBytes = 0, fulls = 0, lost = 0;
+	unsigned int mismatches = 0;
+	float maxError = 0.0f;
+	double encodeSeconds = 0.0, decodeSeconds = 0.0;
+	unsigned int random = 0x9E3779B9u;
+
+	for (unsigned int t = 0; t < options.ticks; t++)
+	{
+		trackingBotBatch(batch, keys);
+		stepBatch(batch, keys, options.dt, options.kernel);
+
+		unsigned int tick = (unsigned int)batch.tick;
+		for (unsigned int i = 0; i < batch.count; i++)
+		{
+			World world;
+			loadWorld(batch, i, world);
+			quantizeState(world, tick, states[i]);
+
+			World restored = world;
+			dequantizeState(states[i], restored);
+			maxError = std::max(maxError, std::max(fabsf(restored.ball.x - world.ball.x), fabsf(restored.ball.y - world.ball.y)));
+		}
+
+		// baza: najnowszy stan, ktory odbiorca mial juz ackAge krokow temu
+		auto start = std::chrono::steady_clock::now();
+		for (unsigned int i = 0; i < batch.count; i++)
+		{
+			const NetState* baseline = nullptr;
+			for (unsigned int age = ackAge; age < netStateHistory && age <= tick && !baseline; age++)
+			{
+				if (findNetState(received[i], tick - age))
+					baseline = findNetState(sent[i], tick - age);
+			}
+
+			sizes[i] = encodeState(states[i], baseline, tickRate, packets + (size_t)i * maxEncodedState, maxEncodedState);
+			storeNetState(sent[i], states[i]);
+
+			if (packets[(size_t)i * maxEncodedState] & 1)
+			{
+				deltaBytes += sizes[i];
+				deltas++;
+			}
+			else
+			{
+				fullBytes += sizes[i];
+				fulls++;
+			}
+		}
+		encodeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		start = std::chrono::steady_clock::now();
+		for (unsigned int i = 0; i < batch.count; i++)
+		{
+			random ^= random << 13;
+			random ^= random >> 17;
+			random ^= random << 5;
+			if (random < options.loss * 4294967296.0)
+			{
+				lost++;
+				continue;
+			}
+
+			NetState decoded;
+			if (!decodeState(packets + (size_t)i * maxEncodedState, sizes[i], received[i], tickRate, decoded) || memcmp(&decoded, &states[i], sizeof(NetState)) != 0)
+			{
+				mismatches++;
+				continue;
+			}
+			storeNetState(received[i], decoded);
+		}
+		decodeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	const unsigned int floatStateSize = 4 + 6 * sizeof(float) + 2 * 2; // krok, pileczka, predkosc, rakietki, punkty
+	unsigned long long encoded = deltas + fulls;
+	double bytesPerTick = (double)(deltaBytes + fullBytes) / encoded;
+
+	std::cout << "mecze: " << batch.count << ", kroki: " << options.ticks << ", wiek bazy: " << ackAge << " krokow, zgubione: " << lost << "\n"
+		<< "stan z liczbami float: " << floatStateSize << " B\n"
+		<< "stan pelny: " << (fulls ? (double)fullBytes / fulls : 0.0) << " B (" << fulls << " razy)\n"
+		<< "roznica: " << (deltas ? (double)deltaBytes / deltas : 0.0) << " B (" << deltas << " razy)\n"
+		<< "srednio: " << bytesPerTick << " B na krok, " << bytesPerTick * 8.0 * tickRate / 1000.0 << " kbit/s na odbiorce ("
+		<< floatStateSize / bytesPerTick << "x mniej)\n"
+		<< "najwiekszy blad pozycji: " << maxError << " px\n"
+		<< "kodowanie: " << encodeSeconds / encoded * 1e9 << " ns, dekodowanie: " << decodeSeconds / (encoded - lost) * 1e9 << " ns na stan\n"
+		<< "niezgodne stany: " << mismatches << std::endl;
+
+	delete[] sizes;
+	delete[] packets;
+	delete[] states;
+	delete[] received;
+	delete[] sent;
+	delete[] keys;
+	freeBatch(batch);
+
+	return mismatches == 0 ? 0 : 1;
+}
+
+// SERWER ZASTEPCZY DLA POLECENIA predict - jeden mecz z botem serwera, protokol jak w server.cpp
+struct StandInHost {
+	NetLink link;
+	World world;
+	unsigned int tickRate;
+	bool joined;
+	unsigned int nonce;
+	InputQueue inputs; // klawisze gracza - jedne na krok
+	unsigned int ackTick; // ostatni stan potwierdzony przez gracza
+	NetStateHistory history;
+};
+
+static void standInHostReceive(StandInHost& host)
+{
+	unsigned char packet[maxDatagramSize];
+	int size;
+	while ((size = host.link.receive(host.link.context, packet, sizeof(packet))) > 0)
+	{
+		if (packet[0] == PACKET_JOIN && size >= (int)joinPacketSize)
+		{
+			host.joined = true;
+			host.nonce = getU32(packet + 1);
+
+			unsigned char reply[joinedPacketSize];
+			reply[0] = PACKET_JOINED;
+			putU32(reply + 1, host.nonce);
+			putU32(reply + 5, 0);
+			reply[9] = 0;
+			putU32(reply + 10, host.world.seed);
+			putU16(reply + 14, (unsigned short)host.tickRate);
+			host.link.send(host.link.context, reply, sizeof(reply));
+		}
+		else if (packet[0] == PACKET_INPUT && size >= (int)inputPacketSize)
+		{
+			unsigned int ack = getU32(packet + 6);
+			if (ack > host.ackTick && ack <= host.world.tick)
+				host.ackTick = ack;
+
+			pushInput(host.inputs, getU32(packet + 11), packet[10] & sideKeys(0, true, true));
+		}
+	}
+}
+
+static void standInHostStep(StandInHost& host, float dt)
+{
+	Inputs inputs = { nextInput(host.inputs) | (trackingBot(host.world, 1) & sideKeys(1, true, true)) };
+	step(host.world, inputs, dt);
+
+	NetState state;
+	quantizeState(host.world, (unsigned int)host.world.tick, state);
+	storeNetState(host.history, state);
+
+	unsigned char packet[maxStatePacketSize];
+	packet[0] = PACKET_STATE;
+	putU32(packet + 1, 0);
+	packet[5] = 0;
+	putU32(packet + 6, host.inputs.used);
+	const NetState* baseline = host.ackTick ? findNetState(host.history, host.ackTick) : nullptr;
+	unsigned int size = encodeState(state, baseline, host.tickRate, packet + stateHeaderSize, maxEncodedState);
+	host.link.send(host.link.context, packet, stateHeaderSize + size);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja rozgrywajaca mecz gracza-bota z przewidywaniem wlasnej rakietki (netclient.cpp)
+** przeciw serwerowi zastepczemu w tym samym procesie; oba kierunki przez symulator opoznien,
+** czas wirtualny (krok --dt co obrot petli); bot gracza decyduje na podstawie przewidywanego
+** stanu, tak jak gracz patrzacy na ekran
+** options - parametry (--ticks, --dt, --rtt, --jitter, --loss, --seed)
+**------------------------------------------------------------------------------------------*/
+int runPredict(const SimOptions& options)
+{
+	LoopbackChannel channel;
+	NetLink links[2];
+	loopbackNetLinks(channel, links[0], links[1]);
+
+	NetShim shims[2];
+	for (int s = 0; s < 2; s++)
+	{
+		initShim(shims[s], links[s], options.rtt / 2.0, options.jitter, options.loss, options.seed * 2 + s + 1);
+	}
+
+	StandInHost host;
+	host.link = shimNetLink(shims[1]);
+	initWorld(host.world, options.seed);
+	host.tickRate = (unsigned int)lround(1.0 / options.dt);
+	host.joined = false;
+	host.nonce = 0;
+	initInputQueue(host.inputs);
+	host.ackTick = 0;
+	clearNetStateHistory(host.history);
+
+	ServerConnection connection;
+	initServerConnection(connection, shimNetLink(shims[0]), options.seed);
+
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned long long turn = 0; host.world.tick < options.ticks; turn++)
+	{
+		double now = turn * options.dt;
+		for (int s = 0; s < 2; s++)
+		{
+			pumpShim(shims[s], now);
+		}
+
+		standInHostReceive(host);
+		if (host.joined)
+			standInHostStep(host, options.dt);
+
+		pollServerConnection(connection, now);
+		if (connection.phase == CONNECTION_PLAYING)
+		{
+			const Prediction& prediction = connection.prediction;
+			unsigned int keys = trackingBot(prediction.world, prediction.side);
+			advanceServerConnection(connection, (keys & (INPUT_LEFT_UP | INPUT_RIGHT_UP)) != 0, (keys & (INPUT_LEFT_DOWN | INPUT_RIGHT_DOWN)) != 0);
+		}
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	const PredictionStats& stats = connection.prediction.stats;
+	const ConnectionStats& link = connection.stats;
+	double reconciles = stats.reconciles ? (double)stats.reconciles : 1.0;
+
+	std::cout << "lacze: rtt " << options.rtt * 1000.0 << " ms, rozrzut " << options.jitter * 1000.0
+		<< " ms, straty " << options.loss * 100.0 << " %, " << host.tickRate << " krokow/s\n"
+		<< "kroki serwera: " << host.world.tick << ", stany odebrane: " << link.statesReceived
+		<< " (nieczytelne " << link.undecodable << ", spoznione " << stats.staleStates << ")\n"
+		<< "klawisze widoczne w stanie serwera po srednio " << (link.statesReceived ? (double)link.inputLagTicks / link.statesReceived : 0.0)
+		<< " krokach - tyle trwaloby czekanie na wlasna rakietke bez przewidywania\n"
+		<< "powtorzone kroki na stan: " << stats.replayedTicks / reconciles
+		<< ", przepelnienia historii: " << stats.overflows << "\n"
+		<< "blad przewidzianej rakietki: sr " << stats.sumError / reconciles << " px, max " << stats.maxError
+		<< " px, poprawki > " << correctionThreshold << " px: " << stats.corrections
+		<< " (" << 100.0 * stats.corrections / reconciles << " % stanow)\n"
+		<< "wynik serwera " << host.world.scoreForLeft << ":" << host.world.scoreForRight
+		<< ", przewidywany " << connection.prediction.world.scoreForLeft << ":" << connection.prediction.world.scoreForRight << "\n"
+		<< "czas: " << seconds << " s" << std::endl;
+
+	return 0;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja przewidujaca miejsce przeciecia symulacja do przodu (tak liczylby bot z podgladem):
+** kopia meczu z rakietkami poza boiskiem krokowana co lookaheadDt (krocej, gdy pileczka
+** przelecialaby w kroku wiecej niz szerokosc rakietki - inaczej w tym samym kroku trafilaby
+** do bramki) do przeciecia plaszczyzny uderzenia rakietki side; wysokosc z interpolacji
+** funkcja zwraca false, jesli pileczka nie doleci w maxTime
+**------------------------------------------------------------------------------------------*/
+static bool lookaheadIntercept(const World& world, int side, float lookaheadDt, float maxTime, float& y, unsigned int& steps)
+{
+	const float planeX = side == 0 ? leftRacketX + halfRacketsWidth + ballRadius : rightRacketX - halfRacketsWidth - ballRadius;
+
+	World ahead = world;
+	ahead.rackets[0].y = ahead.rackets[1].y = -10.0f * WIN_HEIGHT;
+	Inputs none = { 0 };
+
+	float stepDt = lookaheadDt;
+	if (std::abs(world.ballVelocity.x) * stepDt > racketsWidth)
+		stepDt = racketsWidth / std::abs(world.ballVelocity.x);
+
+	steps = 0;
+	for (float t = 0.0f; t < maxTime; t += stepDt)
+	{
+		World before = ahead;
+		step(ahead, none, stepDt);
+		steps++;
+
+		bool crossed = side == 0 ? ahead.ball.x <= planeX : ahead.ball.x >= planeX;
+		if (crossed)
+		{
+			float fraction = (planeX - before.ball.x) / (ahead.ball.x - before.ball.x);
+			y = before.ball.y + (ahead.ball.y - before.ball.y) * fraction;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja sprawdzajaca bota przewidujacego miejsce przeciecia: stany z meczow botow sledzacych
+** (pileczka lecaca do rakietki), cel analityczny i z symulacji do przodu co --dt / 10,
+** czas decyzji obu metod, a na koniec mecze interceptBot (lewa) kontra trackingBot (prawa)
+** options - parametry (--matches, --ticks - liczba probek, --dt, --points, --max-ticks, --seed)
+**------------------------------------------------------------------------------------------*/
+int runIntercept(const SimOptions& options)
+{
+	const float planeX[2] = { leftRacketX + halfRacketsWidth + ballRadius, rightRacketX - halfRacketsWidth - ballRadius };
+
+	// PROBKI: pileczka przed plaszczyzna rakietki, do ktorej leci
+	std::vector<World> samples;
+	std::vector<int> sides;
+	World world;
+	initWorld(world, options.seed);
+	while (samples.size() < options.ticks)
+	{
+		Inputs inputs = { trackingBot(world, 0) | trackingBot(world, 1) };
+		step(world, inputs, options.dt);
+
+		int side = world.ballVelocity.x < 0.0f ? 0 : 1;
+		bool before = side == 0 ? world.ball.x > planeX[0] : world.ball.x < planeX[1];
+		if (world.tick % 7 == 0 && before && world.ballVelocity.x != 0.0f)
+		{
+			samples.push_back(world);
+			sides.push_back(side);
+		}
+	}
+
+	// DOKLADNOSC - cel bota wzgledem symulacji
+	const float lookaheadDt = options.dt / 10.0f;
+	double sumError = 0.0, maxError = 0.0;
+	unsigned long long compared = 0;
+	for (size_t i = 0; i < samples.size(); i++)
+	{
+		const World& sample = samples[i];
+		int side = sides[i];
+
+		float y;
+		unsigned int steps;
+		if (!lookaheadIntercept(sample, side, lookaheadDt, 10.0f, y, steps))
+			continue;
+
+		// cel bota jest ograniczony do zasiegu srodka rakietki
+		y = std::min(std::max(y, racketLimit), WIN_HEIGHT - racketLimit);
+		double error = std::abs(y - interceptBotTarget(sample, side));
+		compared++;
+		sumError += error;
+		if (error > maxError)
+			maxError = error;
+	}
+
+	// CZAS DECYZJI
+	unsigned int checksum = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int repeat = 0; repeat < 10; repeat++)
+	{
+		for (size_t i = 0; i < samples.size(); i++)
+		{
+			checksum += interceptBot(samples[i], sides[i]);
+		}
+	}
+	double analyticSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / 10.0;
+
+	unsigned long long lookaheadSteps = 0;
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < samples.size(); i++)
+	{
+		float y;
+		unsigned int steps;
+		checksum += lookaheadIntercept(samples[i], sides[i], options.dt, 10.0f, y, steps) ? (unsigned int)y : 0u;
+		lookaheadSteps += steps;
+	}
+	double lookaheadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	// MECZE - zaden bot nie puszcza pileczki, dopoki jest do dogonienia; punkty padaja dopiero, gdy
+	// pileczka jest tak szybka, ze w jednym kroku nie mieszcza sie wszystkie zderzenia
+	// (maxEventsPerStep), wiec wynik jest blisko remisu i liczy sie tez droga rakietek
+	unsigned int winsForIntercept = 0, winsForTracking = 0, unfinished = 0;
+	double travel[2] = { 0.0, 0.0 };
+	unsigned long long matchTicks = 0;
+	for (unsigned int m = 0; m < options.matches; m++)
+	{
+		World match;
+		initWorld(match, options.seed + m);
+		while (match.scoreForLeft < options.points && match.scoreForRight < options.points && match.tick < options.maxTicks)
+		{
+			Inputs inputs = { interceptBot(match, 0) | trackingBot(match, 1) };
+			step(match, inputs, options.dt);
+			travel[0] += std::abs(match.racketsVelocity[0]) * options.dt;
+			travel[1] += std::abs(match.racketsVelocity[1]) * options.dt;
+		}
+		matchTicks += match.tick;
+
+		if (match.scoreForLeft >= options.points)
+			winsForIntercept++;
+		else if (match.scoreForRight >= options.points)
+			winsForTracking++;
+		else
+			unfinished++;
+	}
+
+	std::cout << "probki: " << samples.size() << " (porownane " << compared << ")\n"
+		<< "cel analityczny wzgledem symulacji co " << lookaheadDt << " s: sr " << (compared ? sumError / compared : 0.0)
+		<< " px, max " << maxError << " px\n"
+		<< "decyzja: analitycznie " << analyticSeconds / samples.size() * 1e9 << " ns, symulacja co --dt "
+		<< lookaheadSeconds / samples.size() * 1e9 << " ns (" << (double)lookaheadSteps / samples.size()
+		<< " krokow), przyspieszenie " << (analyticSeconds > 0.0 ? lookaheadSeconds / analyticSeconds : 0.0) << "x\n"
+		<< "mecze intercept - tracking: " << winsForIntercept << " - " << winsForTracking << " (nieskonczone " << unfinished << ")\n"
+		<< "droga rakietki na krok: intercept " << (matchTicks ? travel[0] / matchTicks : 0.0) << " px, tracking "
+		<< (matchTicks ? travel[1] / matchTicks : 0.0) << " px\n"
+		<< "suma kontrolna: " << checksum << std::endl;
+
+	return 0;
+}
+
+// pseudolosowa akcja agenta (PongEnvAction) srodowiska i w kroku t
+static unsigned char envAction(unsigned int i, unsigned int t)
+{
+	unsigned int h = (i * 0x9E3779B9u) ^ (t * 0x85EBCA6Bu);
+	h ^= h >> 15;
+	h *= 0x2C1B3C6Du;
+	h ^= h >> 13;
+
+	return (unsigned char)(h % 3);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja sprawdzajaca srodowisko do uczenia: agent lewej rakietki z pseudolosowymi akcjami
+** przeciw trackingBot w --batch-size srodowiskach; te same mecze grane przez step() musza dac
+** te same obserwacje, nagrody i konce epizodow (z ziarnami kolejnych epizodow); potem kroki
+** srodowisk na sekunde z botem i dla dwoch agentow
+** options - parametry (--batch-size, --ticks, --points, --max-ticks, --dt, --seed)
+**------------------------------------------------------------------------------------------*/
+int runEnv(const SimOptions& options)
+{
+	const unsigned int count = options.batchSize;
+
+	PongEnvOptions envOptions;
+	pongEnvDefaultOptions(&envOptions);
+	envOptions.dt = options.dt;
+	envOptions.points = options.points;
+	envOptions.maxTicks = options.maxTicks < 0xFFFFFFFFull ? (unsigned int)options.maxTicks : 0;
+
+	std::vector<unsigned int> seeds(count);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		seeds[i] = options.seed + i;
+	}
+
+	std::vector<float> observations(2 * count * PONG_ENV_OBSERVATION_SIZE), finals(2 * count * PONG_ENV_OBSERVATION_SIZE);
+	std::vector<float> rewards(2 * count);
+	std::vector<unsigned char> actions(2 * count), dones(count);
+
+	// ZGODNOSC Z step()
+	PongEnv* env = pongEnvCreate(&envOptions);
+	if (!env || pongEnvReset(env, count, seeds.data(), observations.data()) != 0)
+	{
+		std::cerr << "Nie mozna utworzyc srodowiska" << std::endl;
+		pongEnvDestroy(env);
+		return 1;
+	}
+
+	std::vector<World> worlds(count);
+	std::vector<unsigned int> nextSeeds(count);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		initWorld(worlds[i], seeds[i]);
+		nextSeeds[i] = seeds[i] + count;
+	}
+
+	unsigned long long mismatches = 0, episodes = 0, points = 0;
+	for (unsigned int t = 0; t < options.ticks; t++)
+	{
+		for (unsigned int i = 0; i < count; i++)
+		{
+			actions[i] = envAction(i, t);
+		}
+		pongEnvStep(env, actions.data(), observations.data(), rewards.data(), dones.data(), finals.data());
+
+		for (unsigned int i = 0; i < count; i++)
+		{
+			World& world = worlds[i];
+			unsigned int left = world.scoreForLeft, right = world.scoreForRight;
+			unsigned int keys = (actions[i] == PONG_ENV_UP ? (unsigned int)INPUT_LEFT_UP : 0u) | (actions[i] == PONG_ENV_DOWN ? (unsigned int)INPUT_LEFT_DOWN : 0u);
+			Inputs inputs = { keys | trackingBot(world, 1) };
+			step(world, inputs, options.dt);
+
+			float reward = (float)(world.scoreForLeft - left) - (float)(world.scoreForRight - right);
+			unsigned char done = PONG_ENV_RUNNING;
+			if (world.scoreForLeft >= options.points || world.scoreForRight >= options.points)
+				done = PONG_ENV_TERMINATED;
+			else if (envOptions.maxTicks != 0 && world.tick >= envOptions.maxTicks)
+				done = PONG_ENV_TRUNCATED;
+
+			if (reward != rewards[i] || done != dones[i])
+				mismatches++;
+			if (reward != 0.0f)
+				points++;
+
+			const float* final = &finals[i * PONG_ENV_OBSERVATION_SIZE];
+			if (done != PONG_ENV_RUNNING)
+			{
+				if (final[4] != world.ball.x / WIN_WIDTH || final[5] != world.ball.y / WIN_HEIGHT)
+					mismatches++;
+				initWorld(world, nextSeeds[i]);
+				nextSeeds[i] += count;
+				episodes++;
+			}
+
+			const float* observation = &observations[i * PONG_ENV_OBSERVATION_SIZE];
+			if (observation[0] != world.rackets[0].y / WIN_HEIGHT || observation[2] != world.rackets[1].y / WIN_HEIGHT
+				|| observation[4] != world.ball.x / WIN_WIDTH || observation[5] != world.ball.y / WIN_HEIGHT)
+				mismatches++;
+		}
+	}
+	pongEnvDestroy(env);
+
+	std::cout << "srodowiska: " << count << ", akcje: " << options.ticks << "\n"
+		<< "epizody: " << episodes << ", punkty: " << points << "\n"
+		<< "niezgodnosci ze step(): " << mismatches << "\n";
+
+	// WYDAJNOSC
+	const int opponents[2] = { PONG_ENV_OPPONENT_TRACKING, PONG_ENV_OPPONENT_AGENT };
+	const char* names[2] = { "agent kontra trackingBot", "dwoch agentow" };
+	for (int o = 0; o < 2; o++)
+	{
+		envOptions.opponent = opponents[o];
+		env = pongEnvCreate(&envOptions);
+		pongEnvReset(env, count, seeds.data(), observations.data());
+		unsigned int agents = pongEnvAgents(env);
+		for (unsigned int i = 0; i < agents * count; i++)
+		{
+			actions[i] = envAction(i, 0);
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		for (unsigned int t = 0; t < options.ticks; t++)
+		{
+			actions[t % (agents * count)] = envAction(t, t);
+			pongEnvStep(env, actions.data(), observations.data(), rewards.data(), dones.data(), nullptr);
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		pongEnvDestroy(env);
+
+		double steps = (double)count * options.ticks;
+		std::cout << names[o] << ": " << (seconds > 0.0 ? steps / seconds : 0.0) << " krokow srodowisk/s ("
+			<< seconds / steps * 1e9 << " ns na krok)\n";
+	}
+
+	std::cout << "kernel paczki: " << batchKernelName(BATCH_KERNEL_BEST) << std::endl;
+
+	return mismatches == 0 ? 0 : 1;
+}
+
+// wypisanie przedzialu ufnosci: wartosc [dolna, gorna]
+static void printInterval(const Interval& interval, double scale)
+{
+	std::cout << interval.estimate * scale << " [" << interval.low * scale << ", " << interval.high * scale << "]";
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja rozgrywajaca --matches meczow --bot (lewa) kontra --right-bot (prawa) na --threads
+** watkach i wypisujaca statystyki z 95% przedzialami ufnosci; skrot statystyk jest ten sam
+** przy kazdej liczbie watkow i rozmiarze paczki
+** options - parametry (--matches, --points, --seed, --dt, --max-ticks, --threads, --batch-size)
+**------------------------------------------------------------------------------------------*/
+int runStats(const SimOptions& options)
+{
+	MonteCarloOptions monteCarlo;
+	monteCarlo.threads = options.threads;
+	monteCarlo.matches = options.matches;
+	monteCarlo.firstSeed = options.seed;
+	monteCarlo.points = options.points;
+	monteCarlo.batchSize = options.batchSize;
+	monteCarlo.maxTicks = options.maxTicks;
+	monteCarlo.dt = options.dt;
+	monteCarlo.bots[0] = options.botBatch;
+	monteCarlo.bots[1] = options.rightBotBatch ? options.rightBotBatch : options.botBatch;
+
+	MonteCarloStats stats;
+	std::vector<MonteCarloStats> parts;
+
+	bool tracing = !options.trace.empty() && startTrace(1024);
+	if (!options.trace.empty() && !tracing)
+	{
+		std::cerr << "Sledzenie niedostepne - zbuduj z PONG_TRACE\n";
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	runMonteCarlo(monteCarlo, stats, parts);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	if (tracing)
+	{
+		if (!writeTrace(options.trace.c_str()))
+			std::cerr << "Nie mozna zapisac " << options.trace << "\n";
+		stopTrace();
+	}
+
+	const double dt = options.dt;
+	unsigned long long finished = stats.matches - stats.unfinished;
+
+	std::cout << "mecze: " << stats.matches << " (nieskonczone " << stats.unfinished << "), watki: " << parts.size() << "\n";
+	std::cout << "wygrane lewego: ";
+	printInterval(proportionInterval(stats.winsForLeft, finished), 100.0);
+	std::cout << " %\npunkty lewego: ";
+	printInterval(proportionInterval(stats.pointsForLeft, stats.points), 100.0);
+	std::cout << " % z " << stats.points << "\ndlugosc meczu: ";
+	printInterval(meanInterval(finished, (double)stats.matchTicks, wideSumValue(stats.matchTicksSquared)), dt);
+	std::cout << " s\ndlugosc punktu: ";
+	printInterval(meanInterval(stats.points, (double)stats.pointTicks, wideSumValue(stats.pointTicksSquared)), dt);
+	std::cout << " s, najdluzszy " << stats.longestPoint * dt << " s\nodbicia w wymianie: ";
+	printInterval(meanInterval(stats.points, (double)stats.rallyHits, (double)stats.rallyHitsSquared), 1.0);
+	std::cout << ", mediana " << rallyPercentile(stats, 0.5) << ", p90 " << rallyPercentile(stats, 0.9)
+		<< ", p99 " << rallyPercentile(stats, 0.99) << " (poczatki kubelkow histogramu)\n";
+
+	std::cout << "rozklad odbic (od:wymiany):";
+	for (unsigned int b = 0; b < rallyHitBuckets; b++)
+	{
+		if (stats.rallyHistogram[b])
+			std::cout << " " << rallyBucketLow(b) << ":" << stats.rallyHistogram[b];
+	}
+	std::cout << "\n";
+
+	std::cout << "serw (pionowa predkosc) | serwy | punkt dla odbierajacego % [95%] | odbicia | dlugosc s\n";
+	for (unsigned int b = 0; b < serveAngleBuckets; b++)
+	{
+		const ServeBucket& serve = stats.serve[b];
+		float low = -ballServeMaxY + 2.0f * ballServeMaxY * b / serveAngleBuckets;
+		float high = low + 2.0f * ballServeMaxY / serveAngleBuckets;
+
+		std::cout << "  [" << low << ", " << high << ") | " << serve.serves << " | ";
+		printInterval(proportionInterval(serve.receiverWins, serve.serves), 100.0);
+		std::cout << " | " << (serve.serves ? (double)serve.hits / serve.serves : 0.0)
+			<< " | " << (serve.serves ? serve.ticks * dt / serve.serves : 0.0) << "\n";
+	}
+
+	char digest[32];
+	snprintf(digest, sizeof(digest), "%016llx", monteCarloDigest(stats));
+	std::cout << "skrot statystyk: " << digest << "\n"
+		<< "czas: " << seconds << " s, mecze/s: " << (seconds > 0.0 ? stats.matches / seconds : 0.0) << std::endl;
+
+	return 0;
+}
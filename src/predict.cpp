@@ -0,0 +1,168 @@
+#include <cmath>
+
+#include "predict.h"
+#include "rollback.h"
+
+/*------------------------------------------------------------------------------------------
+** funkcja przygotowujaca przewidywanie dla gracza
+** side - rakietka gracza (0 - lewa, 1 - prawa)
+** seed - ziarno meczu z PACKET_JOINED (serwy przewidywane tak jak na serwerze)
+** dt - dlugosc kroku serwera w sekundach
+**------------------------------------------------------------------------------------------*/
+void initPrediction(Prediction& prediction, int side, unsigned int seed, float dt)
+{
+	prediction.side = side;
+	prediction.dt = dt;
+
+	initWorld(prediction.world, seed);
+	prediction.inputTick = 0;
+	for (unsigned int i = 0; i < predictionInputs; i++)
+	{
+		prediction.keys[i] = 0;
+		prediction.racketY[i] = 0.0f;
+	}
+
+	prediction.synced = false;
+	prediction.stateTick = 0;
+	prediction.confirmedInput = 0;
+	prediction.opponentKeys = 0;
+	prediction.stats = PredictionStats();
+}
+
+// krok przewidywanej kopii meczu z wlasnymi klawiszami numer tick
+static void predictStep(Prediction& prediction, unsigned int tick)
+{
+	unsigned int slot = tick % predictionInputs;
+
+	Inputs inputs = { prediction.keys[slot] | prediction.opponentKeys };
+	step(prediction.world, inputs, prediction.dt);
+	prediction.racketY[slot] = prediction.world.rackets[prediction.side].y;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zapisujaca wlasne klawisze kolejnego kroku i od razu wykonujaca ten krok na
+** przewidywanej kopii meczu
+** keys - klawisze gracza (tylko jego rakietki)
+** funkcja zwraca numer klawiszy do wyslania w PACKET_INPUT
+**------------------------------------------------------------------------------------------*/
+unsigned int predictInput(Prediction& prediction, unsigned int keys)
+{
+	unsigned int tick = ++prediction.inputTick;
+	prediction.keys[tick % predictionInputs] = keys;
+	predictStep(prediction, tick);
+
+	return tick;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja nanoszaca stan serwera: przewidywana kopia meczu zaczyna od tego stanu i powtarza
+** wlasne klawisze, ktorych serwer jeszcze nie uzyl
+** state - zdekodowany stan meczu
+** confirmedInput - numer ostatnich klawiszy gracza uzytych przez serwer (z PACKET_STATE)
+**------------------------------------------------------------------------------------------*/
+void reconcilePrediction(Prediction& prediction, const NetState& state, unsigned int confirmedInput)
+{
+	PredictionStats& stats = prediction.stats;
+
+	if (prediction.synced && (state.tick <= prediction.stateTick || confirmedInput < prediction.confirmedInput))
+	{
+		stats.staleStates++;
+		return;
+	}
+
+	// klawisze przyszle wzgledem przewidywania - serwer nie mogl ich dostac (np. po ponownym dolaczeniu)
+	if (confirmedInput > prediction.inputTick)
+		confirmedInput = prediction.inputTick;
+
+	// blad przewidywania: gdzie byla wlasna rakietka po tych samych klawiszach u nas i na serwerze
+	World server = prediction.world;
+	dequantizeState(state, server);
+	bool known = confirmedInput > 0 && prediction.inputTick - confirmedInput < predictionInputs;
+	if (prediction.synced && known)
+	{
+		float error = fabsf(prediction.racketY[confirmedInput % predictionInputs] - server.rackets[prediction.side].y);
+		stats.sumError += error;
+		if (error > stats.maxError)
+			stats.maxError = error;
+		if (error > correctionThreshold)
+			stats.corrections++;
+	}
+
+	int opponent = 1 - prediction.side;
+	prediction.opponentKeys = sideKeys(opponent, state.racketDir[opponent] > 0, state.racketDir[opponent] < 0);
+
+	prediction.world = server;
+	prediction.stateTick = state.tick;
+	prediction.confirmedInput = confirmedInput;
+	prediction.synced = true;
+	stats.reconciles++;
+
+	// powtorka niepotwierdzonych klawiszy (starsze niz historia przepadly - przewidywanie od stanu serwera)
+	unsigned int first = confirmedInput + 1;
+	if (prediction.inputTick - confirmedInput >= predictionInputs)
+	{
+		first = prediction.inputTick - predictionInputs + 2;
+		stats.overflows++;
+	}
+
+	for (unsigned int tick = first; tick <= prediction.inputTick; tick++)
+	{
+		predictStep(prediction, tick);
+	}
+	stats.replayedTicks += prediction.inputTick + 1 - first;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja oprozniajaca kolejke klawiszy
+**------------------------------------------------------------------------------------------*/
+void initInputQueue(InputQueue& queue)
+{
+	for (unsigned int i = 0; i < inputQueueSize; i++)
+	{
+		queue.ticks[i] = 0;
+		queue.keys[i] = 0;
+	}
+	queue.newest = 0;
+	queue.used = 0;
+	queue.usedKeys = 0;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja dopisujaca odebrane klawisze (juz uzyte albo zbyt odlegle sa pomijane)
+** tick - numer klawiszy z PACKET_INPUT
+**------------------------------------------------------------------------------------------*/
+void pushInput(InputQueue& queue, unsigned int tick, unsigned int keys)
+{
+	if (tick <= queue.used)
+		return;
+
+	// klient daleko przed kolejka (pierwszy pakiet, dluga przerwa) - zaczyna od tych klawiszy
+	if (tick - queue.used > inputQueueSize)
+		queue.used = tick - 1;
+
+	queue.ticks[tick % inputQueueSize] = tick;
+	queue.keys[tick % inputQueueSize] = (unsigned char)keys;
+	if (tick > queue.newest)
+		queue.newest = tick;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja wybierajaca klawisze na jeden krok serwera: kolejne po ostatnio uzytych, gdy juz
+** przyszly (brakujace przed nowszymi uznane za zgubione - zostaja poprzednie klawisze);
+** przy zbyt dlugiej kolejce nadmiar jest zuzywany od razu
+** funkcja zwraca klawisze (queue.used - ich numer)
+**------------------------------------------------------------------------------------------*/
+unsigned int nextInput(InputQueue& queue)
+{
+	unsigned int backlog = queue.newest > queue.used ? queue.newest - queue.used : 0;
+	unsigned int take = backlog > maxInputBacklog ? backlog - maxInputBacklog + 1 : (backlog > 0 ? 1 : 0);
+
+	for (unsigned int i = 0; i < take; i++)
+	{
+		unsigned int tick = ++queue.used;
+		if (queue.ticks[tick % inputQueueSize] == tick)
+			queue.usedKeys = queue.keys[tick % inputQueueSize];
+	}
+
+	return queue.usedKeys;
+}
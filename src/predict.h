@@ -0,0 +1,63 @@
+#ifndef __PREDICT_H__
+#define __PREDICT_H__
+
+#include "sim.h"
+#include "statecodec.h"
+
+constexpr unsigned int predictionInputs = 256; // dlugosc historii wlasnych klawiszy (potega dwojki) - tyle krokow mozna wyprzedzic serwer
+constexpr float correctionThreshold = 0.5f; // mniejsze poprawki wlasnej rakietki to tylko kwantyzacja stanu (piksele)
+constexpr unsigned int inputQueueSize = 16; // klawisze czekajace na serwerze (potega dwojki)
+constexpr unsigned int maxInputBacklog = 4; // wiecej czekajacych klawiszy serwer zuzywa od razu (klient przyspieszyl)
+
+// STATYSTYKI PRZEWIDYWANIA
+struct PredictionStats {
+	unsigned long long reconciles; // stany serwera naniesione na przewidywanie
+	unsigned long long replayedTicks; // suma krokow symulowanych ponownie (niepotwierdzone klawisze)
+	unsigned long long corrections; // stany, w ktorych wlasna rakietka roznila sie od przewidzianej o wiecej niz correctionThreshold
+	double sumError; // suma bledow przewidzianej pozycji wlasnej rakietki (piksele)
+	double maxError;
+	unsigned long long overflows; // stany starsze niz historia klawiszy - przewidywanie od stanu serwera bez powtorki
+	unsigned long long staleStates; // stany starsze niz juz naniesione (pominiete)
+};
+
+// PRZEWIDYWANIE PO STRONIE KLIENTA - wlasne klawisze dzialaja od razu na lokalna kopie meczu,
+// a kazdy stan od serwera zastepuje ja i powtarza klawisze, ktorych serwer jeszcze nie uzyl
+// (numer ostatnich uzytych przychodzi w PACKET_STATE); klawisze przeciwnika sa zgadywane
+// z kierunku jego rakietki w ostatnim stanie
+struct Prediction {
+	int side; // 0 - lewa rakietka, 1 - prawa
+	float dt;
+
+	World world; // przewidywany stan po klawiszach inputTick
+	unsigned int inputTick; // numer ostatnich wlasnych klawiszy (0 - jeszcze zadnych)
+	unsigned int keys[predictionInputs]; // wlasne klawisze (miejsce = numer % predictionInputs)
+	float racketY[predictionInputs]; // przewidziana pozycja wlasnej rakietki po tych klawiszach
+
+	bool synced; // naniesiono juz stan serwera - world nadaje sie do rysowania
+	unsigned int stateTick; // krok meczu ostatniego naniesionego stanu
+	unsigned int confirmedInput; // numer ostatnich klawiszy uzytych przez serwer
+	unsigned int opponentKeys; // zgadywane klawisze przeciwnika
+
+	PredictionStats stats;
+};
+
+// KOLEJKA KLAWISZY GRACZA NA SERWERZE - kazdy krok uzywa kolejnych klawiszy, wiec przewidywanie
+// klienta (krok na numer klawiszy) zgadza sie z serwerem takze przy rozrzucie opoznien;
+// zgubione klawisze zastepuja poprzednie
+struct InputQueue {
+	unsigned int ticks[inputQueueSize]; // numery klawiszy w miejscach (numer % inputQueueSize)
+	unsigned char keys[inputQueueSize];
+	unsigned int newest; // najnowszy odebrany numer
+	unsigned int used; // numer klawiszy uzytych w ostatnim kroku
+	unsigned int usedKeys;
+};
+
+void initInputQueue(InputQueue& queue);
+void pushInput(InputQueue& queue, unsigned int tick, unsigned int keys);
+unsigned int nextInput(InputQueue& queue);
+
+void initPrediction(Prediction& prediction, int side, unsigned int seed, float dt);
+unsigned int predictInput(Prediction& prediction, unsigned int keys);
+void reconcilePrediction(Prediction& prediction, const NetState& state, unsigned int confirmedInput);
+
+#endif /* __PREDICT_H__ */
@@ -0,0 +1,30 @@
+#ifndef __PROTOCOL_H__
+#define __PROTOCOL_H__
+
+#include "statecodec.h"
+
+// RODZAJE PAKIETOW SERWERA MECZOW (pierwszy bajt pakietu, liczby little-endian - wire.h)
+enum ServerPacketType {
+	PACKET_JOIN = 1, // klient -> serwer: u32 identyfikator klienta
+	PACKET_INPUT = 2, // klient -> serwer: u32 mecz, u8 strona, u32 ostatni odebrany krok stanu (potwierdzenie), u8 klawisze, u32 numer klawiszy (kolejne kroki klienta)
+	PACKET_LEAVE = 3, // klient -> serwer: u32 mecz, u8 strona
+	PACKET_SPECTATE = 4, // widz -> serwer: u32 mecz (powtarzany co kilka sekund jako sygnal obecnosci)
+	PACKET_UNSPECTATE = 5, // widz -> serwer: u32 mecz
+	PACKET_JOINED = 10, // serwer -> klient: u32 identyfikator klienta, u32 mecz, u8 strona, u32 ziarno, u16 kroki na sekunde
+	PACKET_STATE = 11, // serwer -> klient: u32 mecz, u8 strona, u32 numer ostatnich uzytych klawiszy klienta, stan zakodowany roznicowo (statecodec.h)
+	PACKET_END = 12, // serwer -> klient: u32 mecz, u8 strona, 2 x u16 punkty
+	PACKET_FRAME = 13 // serwer -> widz: u32 mecz, stan zakodowany raz dla wszystkich widzow (roznica do poprzedniego kroku albo klatka kluczowa)
+};
+
+constexpr unsigned int joinPacketSize = 5;
+constexpr unsigned int inputPacketSize = 15;
+constexpr unsigned int leavePacketSize = 6;
+constexpr unsigned int joinedPacketSize = 16;
+constexpr unsigned int stateHeaderSize = 10;
+constexpr unsigned int maxStatePacketSize = stateHeaderSize + maxEncodedState;
+constexpr unsigned int endPacketSize = 10;
+constexpr unsigned int spectatePacketSize = 5;
+constexpr unsigned int frameHeaderSize = 5;
+constexpr unsigned int noMatch = ~0u;
+
+#endif /* __PROTOCOL_H__ */
@@ -0,0 +1,352 @@
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "replay.h"
+
+static const char headerMagic[4] = { 'P', 'R', 'P', 'L' };
+static const char trailerMagic[4] = { 'P', 'R', 'P', 'X' };
+
+/*------------------------------------------------------------------------------------------
+** funkcja zapisujaca bajty do pliku powtorki
+**------------------------------------------------------------------------------------------*/
+static void writeBytes(ReplayWriter& writer, const void* data, size_t size)
+{
+	fwrite(data, 1, size, writer.file);
+	writer.offset += size;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja dopisujaca niepelny bajt klawiszy (nieparzysta liczba krokow w bloku)
+**------------------------------------------------------------------------------------------*/
+static void flushPending(ReplayWriter& writer)
+{
+	if (writer.hasPending)
+	{
+		writeBytes(writer, &writer.pending, 1);
+		writer.hasPending = false;
+	}
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja otwierajaca plik powtorki do zapisu
+** path - sciezka pliku
+** seed - ziarno meczu
+** tickSeconds - dlugosc kroku symulacji
+** flags - ReplayFlags (REPLAY_FIXED przy fizyce staloprzecinkowej)
+** keyframeInterval - co ile krokow zapisywac pelny stan meczu
+** funkcja zwraca false jesli nie mozna utworzyc pliku
+**------------------------------------------------------------------------------------------*/
+bool openReplayWriter(ReplayWriter& writer, const char* path, unsigned int seed, double tickSeconds, unsigned int flags, unsigned int keyframeInterval)
+{
+	writer.file = fopen(path, "wb");
+	if (!writer.file)
+	{
+		std::cerr << "Nie mozna utworzyc pliku powtorki: " << path << std::endl;
+		return false;
+	}
+
+	memcpy(writer.header.magic, headerMagic, sizeof(headerMagic));
+	writer.header.version = replayVersion;
+	writer.header.flags = flags;
+	writer.header.seed = seed;
+	writer.header.keyframeInterval = keyframeInterval ? keyframeInterval : defaultKeyframeInterval;
+	writer.header.stateSize = (flags & REPLAY_FIXED) ? sizeof(FixedWorld) : sizeof(World);
+	writer.header.tickSeconds = tickSeconds;
+
+	writer.index.clear();
+	writer.offset = 0;
+	writer.tick = 0;
+	writer.pending = 0;
+	writer.hasPending = false;
+
+	writeBytes(writer, &writer.header, sizeof(ReplayHeader));
+
+	return true;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zapisujaca klawisze jednego kroku; na poczatku bloku zapisuje tez stan meczu
+** state - stan meczu przed wykonaniem kroku
+** keys - klawisze uzyte w kroku
+**------------------------------------------------------------------------------------------*/
+static void recordState(ReplayWriter& writer, const void* state, unsigned int keys)
+{
+	unsigned int position = (unsigned int)(writer.tick % writer.header.keyframeInterval);
+
+	if (position == 0)
+	{
+		flushPending(writer);
+
+		ReplayIndexEntry entry = { writer.tick, writer.offset };
+		writer.index.push_back(entry);
+		writeBytes(writer, state, writer.header.stateSize);
+	}
+
+	if (position % 2 == 0)
+	{
+		writer.pending = (unsigned char)(keys & 0xF);
+		writer.hasPending = true;
+	}
+	else
+	{
+		unsigned char packed = (unsigned char)(writer.pending | ((keys & 0xF) << 4));
+		writeBytes(writer, &packed, 1);
+		writer.hasPending = false;
+	}
+
+	writer.tick++;
+}
+
+void recordTick(ReplayWriter& writer, const World& world, unsigned int keys)
+{
+	recordState(writer, &world, keys);
+}
+
+void recordTick(ReplayWriter& writer, const FixedWorld& world, unsigned int keys)
+{
+	recordState(writer, &world, keys);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja dopisujaca indeks blokow i zamykajaca plik powtorki
+** funkcja zwraca false jesli zapis sie nie powiodl
+**------------------------------------------------------------------------------------------*/
+bool closeReplayWriter(ReplayWriter& writer)
+{
+	if (!writer.file)
+		return false;
+
+	flushPending(writer);
+
+	// indeks i zakonczenie wyrownane do 8 bajtow - czytelnik uzywa ich wprost z odwzorowanej pamieci
+	const unsigned char padding[8] = {};
+	if (writer.offset % 8)
+	{
+		writeBytes(writer, padding, 8 - writer.offset % 8);
+	}
+
+	ReplayTrailer trailer;
+	trailer.indexOffset = writer.offset;
+	trailer.tickCount = writer.tick;
+	trailer.entries = (unsigned int)writer.index.size();
+	memcpy(trailer.magic, trailerMagic, sizeof(trailerMagic));
+
+	if (!writer.index.empty())
+	{
+		writeBytes(writer, writer.index.data(), writer.index.size() * sizeof(ReplayIndexEntry));
+	}
+	writeBytes(writer, &trailer, sizeof(ReplayTrailer));
+
+	bool ok = !ferror(writer.file);
+	ok = fclose(writer.file) == 0 && ok;
+	writer.file = nullptr;
+
+	return ok;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja sprawdzajaca naglowek, indeks i granice blokow odwzorowanego pliku
+**------------------------------------------------------------------------------------------*/
+static bool validateReplay(ReplayReader& reader)
+{
+	if (reader.size < sizeof(ReplayHeader) + sizeof(ReplayTrailer))
+		return false;
+
+	reader.header = (const ReplayHeader*)reader.data;
+	reader.trailer = (const ReplayTrailer*)(reader.data + reader.size - sizeof(ReplayTrailer));
+
+	const ReplayHeader& header = *reader.header;
+	const ReplayTrailer& trailer = *reader.trailer;
+
+	if (memcmp(header.magic, headerMagic, sizeof(headerMagic)) || memcmp(trailer.magic, trailerMagic, sizeof(trailerMagic)))
+		return false;
+	if (header.version != replayVersion || header.keyframeInterval == 0 || trailer.indexOffset % 8)
+		return false;
+	if (header.stateSize != ((header.flags & REPLAY_FIXED) ? sizeof(FixedWorld) : sizeof(World)))
+		return false;
+
+	unsigned long long interval = header.keyframeInterval;
+	if (trailer.entries != (trailer.tickCount + interval - 1) / interval)
+		return false;
+	if (trailer.indexOffset > reader.size || trailer.indexOffset + (unsigned long long)trailer.entries * sizeof(ReplayIndexEntry) + sizeof(ReplayTrailer) != reader.size)
+		return false;
+
+	reader.index = (const ReplayIndexEntry*)(reader.data + trailer.indexOffset);
+
+	for (unsigned int b = 0; b < trailer.entries; b++)
+	{
+		unsigned long long ticks = trailer.tickCount - b * interval;
+		if (ticks > interval)
+			ticks = interval;
+
+		if (reader.index[b].tick != b * interval)
+			return false;
+		if (reader.index[b].offset + header.stateSize + (ticks + 1) / 2 > trailer.indexOffset)
+			return false;
+	}
+
+	return true;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja odwzorowujaca plik powtorki w pamieci
+** path - sciezka pliku
+** funkcja zwraca false jesli pliku nie mozna otworzyc lub jest uszkodzony
+**------------------------------------------------------------------------------------------*/
+bool openReplay(ReplayReader& reader, const char* path)
+{
+	reader.data = nullptr;
+	reader.size = 0;
+	reader.mapping = nullptr;
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		std::cerr << "Nie mozna otworzyc pliku powtorki: " << path << std::endl;
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	GetFileSizeEx(file, &size);
+	HANDLE mapping = size.QuadPart > 0 ? CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+	CloseHandle(file);
+
+	if (mapping)
+	{
+		reader.data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		reader.size = (unsigned long long)size.QuadPart;
+		reader.mapping = mapping;
+	}
+#else
+	int file = open(path, O_RDONLY);
+	if (file < 0)
+	{
+		std::cerr << "Nie mozna otworzyc pliku powtorki: " << path << std::endl;
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(file, &info) == 0 && info.st_size > 0)
+	{
+		void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		if (data != MAP_FAILED)
+		{
+			reader.data = (const unsigned char*)data;
+			reader.size = (unsigned long long)info.st_size;
+		}
+	}
+	close(file);
+#endif
+
+	if (!reader.data || !validateReplay(reader))
+	{
+		std::cerr << "Niepoprawny plik powtorki: " << path << std::endl;
+		closeReplay(reader);
+		return false;
+	}
+
+	return true;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwalniajaca odwzorowanie pliku powtorki
+**------------------------------------------------------------------------------------------*/
+void closeReplay(ReplayReader& reader)
+{
+#ifdef _WIN32
+	if (reader.data)
+		UnmapViewOfFile(reader.data);
+	if (reader.mapping)
+		CloseHandle((HANDLE)reader.mapping);
+#else
+	if (reader.data)
+		munmap((void*)reader.data, (size_t)reader.size);
+#endif
+
+	reader.data = nullptr;
+	reader.size = 0;
+	reader.mapping = nullptr;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwracajaca liczbe zapisanych krokow
+**------------------------------------------------------------------------------------------*/
+unsigned long long replayTickCount(const ReplayReader& reader)
+{
+	return reader.trailer->tickCount;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja odczytujaca klawisze zapisane dla kroku tick (tick < replayTickCount())
+**------------------------------------------------------------------------------------------*/
+unsigned int replayKeys(const ReplayReader& reader, unsigned long long tick)
+{
+	unsigned long long interval = reader.header->keyframeInterval;
+	unsigned long long position = tick % interval;
+
+	const unsigned char* keys = reader.data + reader.index[tick / interval].offset + reader.header->stateSize;
+	unsigned char packed = keys[position / 2];
+
+	return (position % 2) ? (packed >> 4) : (packed & 0xF);
+}
+
+static void replayStep(World& world, const Inputs& inputs, const ReplayHeader& header)
+{
+	step(world, inputs, (float)header.tickSeconds);
+}
+
+static void replayStep(FixedWorld& world, const Inputs& inputs, const ReplayHeader& header)
+{
+	stepFixed(world, inputs, secondsToFixed(header.tickSeconds));
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja odtwarzajaca stan meczu po tick krokach: najblizszy wczesniejszy keyframe
+** i ponowna symulacja zapisanych klawiszy (najwyzej keyframeInterval krokow)
+** funkcja zwraca false jesli tick jest poza powtorka lub typ stanu nie pasuje do pliku
+**------------------------------------------------------------------------------------------*/
+template <class State>
+static bool seekState(const ReplayReader& reader, unsigned long long tick, State& world, unsigned int flags)
+{
+	const ReplayHeader& header = *reader.header;
+	const ReplayTrailer& trailer = *reader.trailer;
+
+	if ((header.flags & REPLAY_FIXED) != flags || header.stateSize != sizeof(State))
+		return false;
+	if (trailer.entries == 0 || tick > trailer.tickCount)
+		return false;
+
+	unsigned long long block = tick / header.keyframeInterval;
+	if (block >= trailer.entries)
+		block = trailer.entries - 1; // stan po ostatnim kroku, gdy liczba krokow jest wielokrotnoscia bloku
+
+	memcpy(&world, reader.data + reader.index[block].offset, sizeof(State));
+
+	for (unsigned long long t = reader.index[block].tick; t < tick; t++)
+	{
+		Inputs inputs = { replayKeys(reader, t) };
+		replayStep(world, inputs, header);
+	}
+
+	return true;
+}
+
+bool seekReplay(const ReplayReader& reader, unsigned long long tick, World& world)
+{
+	return seekState(reader, tick, world, 0);
+}
+
+bool seekReplay(const ReplayReader& reader, unsigned long long tick, FixedWorld& world)
+{
+	return seekState(reader, tick, world, REPLAY_FIXED);
+}
@@ -0,0 +1,80 @@
+#ifndef __REPLAY_H__
+#define __REPLAY_H__
+
+#include <cstdio>
+#include <vector>
+
+#include "sim.h"
+#include "fixed.h"
+
+// UKLAD PLIKU POWTORKI (liczby zapisywane w kolejnosci bajtow procesora - little-endian):
+//   ReplayHeader
+//   blok 0: stan meczu (keyframe) + klawisze kolejnych keyframeInterval krokow, 4 bity na krok
+//   blok 1: ...
+//   indeks: ReplayIndexEntry dla kazdego bloku
+//   ReplayTrailer
+// stan z dowolnego kroku odtwarza sie z najblizszego wczesniejszego keyframe i ponownej symulacji
+
+enum ReplayFlags {
+	REPLAY_FIXED = 1 // fizyka staloprzecinkowa (keyframe to FixedWorld zamiast World)
+};
+
+constexpr unsigned int replayVersion = 1;
+constexpr unsigned int defaultKeyframeInterval = 600; // 5 s przy 120 krokach na sekunde
+
+struct ReplayHeader {
+	char magic[4]; // "PRPL"
+	unsigned int version;
+	unsigned int flags; // ReplayFlags
+	unsigned int seed; // ziarno meczu
+	unsigned int keyframeInterval; // liczba krokow w bloku
+	unsigned int stateSize; // rozmiar keyframe w bajtach
+	double tickSeconds; // dlugosc kroku symulacji
+};
+
+struct ReplayIndexEntry {
+	unsigned long long tick; // krok zapisany w keyframe
+	unsigned long long offset; // polozenie bloku od poczatku pliku
+};
+
+struct ReplayTrailer {
+	unsigned long long indexOffset; // polozenie indeksu od poczatku pliku
+	unsigned long long tickCount; // liczba zapisanych krokow
+	unsigned int entries; // liczba blokow
+	char magic[4]; // "PRPX"
+};
+
+// ZAPIS POWTORKI W TRAKCIE GRY
+struct ReplayWriter {
+	FILE* file;
+	ReplayHeader header;
+	std::vector<ReplayIndexEntry> index;
+	unsigned long long offset; // liczba zapisanych bajtow
+	unsigned long long tick; // liczba zapisanych krokow
+	unsigned char pending; // klawisze parzystego kroku czekajace na drugi polbajt
+	bool hasPending;
+};
+
+// ODCZYT POWTORKI Z PLIKU ODWZOROWANEGO W PAMIECI
+struct ReplayReader {
+	const unsigned char* data;
+	unsigned long long size;
+	const ReplayHeader* header;
+	const ReplayIndexEntry* index;
+	const ReplayTrailer* trailer;
+	void* mapping; // uchwyt odwzorowania (tylko Windows)
+};
+
+bool openReplayWriter(ReplayWriter& writer, const char* path, unsigned int seed, double tickSeconds, unsigned int flags, unsigned int keyframeInterval = defaultKeyframeInterval);
+void recordTick(ReplayWriter& writer, const World& world, unsigned int keys);
+void recordTick(ReplayWriter& writer, const FixedWorld& world, unsigned int keys);
+bool closeReplayWriter(ReplayWriter& writer);
+
+bool openReplay(ReplayReader& reader, const char* path);
+void closeReplay(ReplayReader& reader);
+unsigned long long replayTickCount(const ReplayReader& reader);
+unsigned int replayKeys(const ReplayReader& reader, unsigned long long tick);
+bool seekReplay(const ReplayReader& reader, unsigned long long tick, World& world);
+bool seekReplay(const ReplayReader& reader, unsigned long long tick, FixedWorld& world);
+
+#endif /* __REPLAY_H__ */
@@ -0,0 +1,308 @@
+#include <cstring>
+
+#include "rollback.h"
+#include "wire.h"
+
+static const unsigned char packetMagic[4] = { 'P', 'R', 'B', '1' };
+constexpr unsigned int packetHeaderSize = 26;
+constexpr unsigned long long noRollback = ~0ull;
+constexpr unsigned long long noChecksum = ~0ull;
+
+// UKLAD PAKIETU (liczby little-endian):
+//   0  magia "PRB1"
+//   4  u32 liczba potwierdzonych krokow drugiego gracza (ack)
+//   8  u32 pierwszy krok klawiszy w pakiecie
+//   12 u16 liczba krokow klawiszy
+//   14 u32 krok ostatniego wlasnego skrotu stanu (0xFFFFFFFF - brak)
+//   18 u64 skrot stanu
+//   26 klawisze, 4 bity na krok
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwracajaca maske klawiszy rakietki side
+** side - 0: lewa (W/S), 1: prawa (strzalki)
+** up, down - czy wcisnieto ruch w gore / w dol
+**------------------------------------------------------------------------------------------*/
+unsigned int sideKeys(int side, bool up, bool down)
+{
+	unsigned int keys = 0;
+	if (up)
+		keys |= side == 0 ? INPUT_LEFT_UP : INPUT_RIGHT_UP;
+	if (down)
+		keys |= side == 0 ? INPUT_LEFT_DOWN : INPUT_RIGHT_DOWN;
+
+	return keys;
+}
+
+static unsigned int sideMask(int side)
+{
+	return sideKeys(side, true, true);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja przygotowujaca sesje gry z cofaniem
+** link - lacze do drugiego gracza
+** localSide - rakietka sterowana lokalnie (0 - lewa, 1 - prawa)
+** seed - ziarno meczu (oba gracze musza podac to samo)
+** dt - dlugosc kroku (oba gracze musza podac to samo)
+** inputDelay - opoznienie wlasnych klawiszy w krokach (0 - natychmiast, cofanie nadrabia opoznienie sieci)
+**------------------------------------------------------------------------------------------*/
+void initRollbackSession(RollbackSession& session, const NetLink& link, int localSide, unsigned int seed, fixed_t dt, unsigned int inputDelay)
+{
+	session.link = link;
+	session.localSide = localSide;
+	session.inputDelay = inputDelay < maxRollbackTicks ? inputDelay : maxRollbackTicks - 1;
+	session.dt = dt;
+
+	initFixedWorld(session.world, seed);
+	initSnapshotRing(session.snapshots, maxRollbackTicks + 2, sizeof(FixedWorld));
+
+	memset(session.localKeys, 0, sizeof(session.localKeys));
+	memset(session.remoteKeys, 0, sizeof(session.remoteKeys));
+	memset(session.usedRemoteKeys, 0, sizeof(session.usedRemoteKeys));
+	session.localTicks = session.inputDelay; // pierwsze kroki opoznienia maja puste klawisze
+	session.remoteTicks = 0;
+	session.peerAck = 0;
+	session.rollbackTo = noRollback;
+
+	for (unsigned int i = 0; i < checksumHistory; i++)
+	{
+		session.checksumTicks[i] = noChecksum;
+		session.checksums[i] = 0;
+	}
+	session.nextChecksumTick = checksumInterval;
+	session.comparedChecksumTick = 0;
+
+	session.stats = RollbackStats();
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwalniajaca pamiec sesji
+**------------------------------------------------------------------------------------------*/
+void freeRollbackSession(RollbackSession& session)
+{
+	freeSnapshotRing(session.snapshots);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja wykonujaca krok world.tick z wlasnymi i (potwierdzonymi lub przewidywanymi)
+** klawiszami drugiego gracza; stan przed krokiem trafia do migawek
+**------------------------------------------------------------------------------------------*/
+static void simulateTick(RollbackSession& session)
+{
+	unsigned long long tick = session.world.tick;
+	unsigned int slot = (unsigned int)(tick % rollbackHistory);
+
+	// przewidywanie: drugi gracz trzyma te same klawisze co w ostatnim potwierdzonym kroku
+	unsigned int remote = 0;
+	if (tick < session.remoteTicks)
+		remote = session.remoteKeys[slot];
+	else if (session.remoteTicks > 0)
+		remote = session.remoteKeys[(session.remoteTicks - 1) % rollbackHistory];
+
+	saveSnapshot(session.snapshots, session.world);
+	session.usedRemoteKeys[slot] = (unsigned char)remote;
+
+	Inputs inputs = { session.localKeys[slot] | remote };
+	stepFixed(session.world, inputs, session.dt);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja odczytujaca pakiet drugiego gracza: potwierdzenie, klawisze i skrot stanu
+**------------------------------------------------------------------------------------------*/
+static void receivePacket(RollbackSession& session, const unsigned char* packet, unsigned int size)
+{
+	if (size < packetHeaderSize || memcmp(packet, packetMagic, sizeof(packetMagic)) != 0)
+		return;
+
+	unsigned long long ack = getU32(packet + 4);
+	unsigned long long first = getU32(packet + 8);
+	unsigned int count = getU16(packet + 12);
+	unsigned int checksumTick = getU32(packet + 14);
+	unsigned long long checksum = getU64(packet + 18);
+
+	if (size < packetHeaderSize + (count + 1) / 2)
+		return;
+
+	session.stats.packetsReceived++;
+
+	if (ack > session.peerAck && ack <= session.localTicks)
+		session.peerAck = ack;
+
+	// KLAWISZE - tylko ciagla kontynuacja juz znanych krokow
+	const unsigned char* keys = packet + packetHeaderSize;
+	const unsigned int remoteMask = sideMask(1 - session.localSide);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		unsigned long long tick = first + i;
+		if (tick < session.remoteTicks)
+			continue;
+		if (tick > session.remoteTicks)
+			break;
+
+		unsigned int value = ((i % 2) ? (keys[i / 2] >> 4) : keys[i / 2]) & remoteMask;
+		unsigned int slot = (unsigned int)(tick % rollbackHistory);
+
+		if (tick < session.world.tick && value != session.usedRemoteKeys[slot] && tick < session.rollbackTo)
+			session.rollbackTo = tick;
+
+		session.remoteKeys[slot] = (unsigned char)value;
+		session.remoteTicks++;
+	}
+
+	// SKROT STANU DRUGIEGO GRACZA
+	if (checksumTick != 0xFFFFFFFFu && checksumTick > session.comparedChecksumTick)
+	{
+		unsigned int index = (checksumTick / checksumInterval) % checksumHistory;
+		if (session.checksumTicks[index] == checksumTick)
+		{
+			session.stats.checksumsCompared++;
+			if (session.checksums[index] != checksum)
+				session.stats.desyncs++;
+			session.comparedChecksumTick = checksumTick;
+		}
+	}
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja liczaca skroty stanow, ktore juz sie nie zmienia (wszystkie klawisze przed nimi potwierdzone)
+**------------------------------------------------------------------------------------------*/
+static void updateChecksums(RollbackSession& session)
+{
+	unsigned long long confirmed = session.remoteTicks < session.world.tick ? session.remoteTicks : session.world.tick;
+
+	while (session.nextChecksumTick <= confirmed)
+	{
+		unsigned long long tick = session.nextChecksumTick;
+
+		FixedWorld state;
+		bool found = true;
+		if (tick == session.world.tick)
+			state = session.world;
+		else
+			found = restoreSnapshot(session.snapshots, tick, state);
+
+		if (found)
+		{
+			unsigned int index = (unsigned int)((tick / checksumInterval) % checksumHistory);
+			session.checksumTicks[index] = tick;
+			session.checksums[index] = hashFixedWorld(state);
+		}
+
+		session.nextChecksumTick += checksumInterval;
+	}
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja odbierajaca pakiety drugiego gracza i poprawiajaca stan po blednym przewidywaniu
+** (cofniecie do pierwszego blednego kroku i ponowna symulacja do biezacego)
+**------------------------------------------------------------------------------------------*/
+void pollRollbackSession(RollbackSession& session)
+{
+	unsigned char packet[maxDatagramSize];
+
+	int size;
+	while ((size = session.link.receive(session.link.context, packet, sizeof(packet))) > 0)
+	{
+		receivePacket(session, packet, (unsigned int)size);
+	}
+
+	if (session.rollbackTo < session.world.tick)
+	{
+		unsigned long long target = session.world.tick;
+
+		if (restoreSnapshot(session.snapshots, session.rollbackTo, session.world))
+		{
+			unsigned int depth = (unsigned int)(target - session.rollbackTo);
+
+			session.stats.rollbacks++;
+			session.stats.resimulatedTicks += depth;
+			if (depth > session.stats.longestRollback)
+				session.stats.longestRollback = depth;
+
+			while (session.world.tick < target)
+			{
+				simulateTick(session);
+			}
+		}
+	}
+	session.rollbackTo = noRollback;
+
+	updateChecksums(session);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja wysylajaca wlasne klawisze od ostatniego potwierdzonego kroku (powtarzane do
+** potwierdzenia, wiec zgubiony pakiet nie wymaga ponownego wysylania)
+**------------------------------------------------------------------------------------------*/
+void sendRollbackInputs(RollbackSession& session)
+{
+	unsigned char packet[packetHeaderSize + maxPacketInputs / 2];
+
+	unsigned long long first = session.peerAck;
+	unsigned int count = (unsigned int)(session.localTicks - first);
+	if (count > maxPacketInputs)
+		count = maxPacketInputs;
+
+	// najnowszy wlasny skrot
+	unsigned int checksumTick = 0xFFFFFFFFu;
+	unsigned long long checksum = 0;
+	if (session.nextChecksumTick > checksumInterval)
+	{
+		unsigned long long tick = session.nextChecksumTick - checksumInterval;
+		unsigned int index = (unsigned int)((tick / checksumInterval) % checksumHistory);
+		if (session.checksumTicks[index] == tick)
+		{
+			checksumTick = (unsigned int)tick;
+			checksum = session.checksums[index];
+		}
+	}
+
+	memcpy(packet, packetMagic, sizeof(packetMagic));
+	putU32(packet + 4, (unsigned int)session.remoteTicks);
+	putU32(packet + 8, (unsigned int)first);
+	putU16(packet + 12, count);
+	putU32(packet + 14, checksumTick);
+	putU64(packet + 18, checksum);
+
+	unsigned char* keys = packet + packetHeaderSize;
+	memset(keys, 0, (count + 1) / 2);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		unsigned int value = session.localKeys[(first + i) % rollbackHistory];
+		keys[i / 2] |= (unsigned char)((i % 2) ? (value << 4) : value);
+	}
+
+	if (session.link.send(session.link.context, packet, packetHeaderSize + (count + 1) / 2))
+		session.stats.packetsSent++;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja wykonujaca jeden krok gry sieciowej
+** session - sesja
+** keys - wlasne klawisze w tym kroku (klawisze drugiej rakietki sa pomijane)
+** funkcja zwraca false jesli krok zostal wstrzymany, bo klawisze drugiego gracza sa zbyt stare
+**------------------------------------------------------------------------------------------*/
+bool advanceRollbackSession(RollbackSession& session, unsigned int keys)
+{
+	pollRollbackSession(session);
+
+	bool stalled = session.world.tick >= session.remoteTicks + maxRollbackTicks
+		|| session.localTicks + 1 > session.peerAck + rollbackHistory / 2;
+
+	if (stalled)
+	{
+		session.stats.stalls++;
+	}
+	else
+	{
+		session.localKeys[session.localTicks % rollbackHistory] = (unsigned char)(keys & sideMask(session.localSide));
+		session.localTicks++;
+
+		simulateTick(session);
+		updateChecksums(session);
+	}
+
+	sendRollbackInputs(session);
+
+	return !stalled;
+}
@@ -0,0 +1,61 @@
+#ifndef __ROLLBACK_H__
+#define __ROLLBACK_H__
+
+#include "fixed.h"
+#include "snapshot.h"
+#include "netlink.h"
+
+constexpr unsigned int rollbackHistory = 256; // dlugosc pierscieni klawiszy (potega dwojki)
+constexpr unsigned int maxRollbackTicks = 32; // o tyle krokow mozna wyprzedzic potwierdzone klawisze drugiego gracza
+constexpr unsigned int maxPacketInputs = 128; // najwiecej krokow klawiszy w jednym pakiecie
+constexpr unsigned int checksumInterval = 60; // co ile krokow gracze porownuja skroty potwierdzonego stanu
+constexpr unsigned int checksumHistory = 8; // liczba zapamietanych wlasnych skrotow
+
+// STATYSTYKI SESJI
+struct RollbackStats {
+	unsigned long long rollbacks; // liczba cofniec po blednym przewidywaniu
+	unsigned long long resimulatedTicks; // suma krokow symulowanych ponownie
+	unsigned int longestRollback; // najdluzsze cofniecie w krokach
+	unsigned long long stalls; // kroki wstrzymane, bo klawisze drugiego gracza byly zbyt stare
+	unsigned long long packetsSent;
+	unsigned long long packetsReceived;
+	unsigned long long checksumsCompared;
+	unsigned long long desyncs; // niezgodne skroty stanu - symulacje sie rozjechaly
+};
+
+// SESJA GRY DWOCH GRACZY Z COFANIEM (ROLLBACK) - kazdy gracz symuluje mecz u siebie, klawisze
+// drugiego gracza sa przewidywane (powtorzenie ostatnich znanych), a gdy przyjda inne niz
+// przewidziane, stan jest odtwarzany z migawki i krok po kroku symulowany ponownie
+struct RollbackSession {
+	NetLink link;
+	int localSide; // 0 - lewa rakietka, 1 - prawa
+	unsigned int inputDelay; // o ile krokow opozniane sa wlasne klawisze (wiecej czasu na dotarcie do drugiego gracza)
+	fixed_t dt;
+
+	FixedWorld world; // stan przed krokiem world.tick (z przewidywanymi klawiszami drugiego gracza)
+	SnapshotRing snapshots; // stany przed ostatnimi krokami
+
+	unsigned char localKeys[rollbackHistory]; // wlasne klawisze kolejnych krokow
+	unsigned char remoteKeys[rollbackHistory]; // potwierdzone klawisze drugiego gracza
+	unsigned char usedRemoteKeys[rollbackHistory]; // klawisze drugiego gracza uzyte w symulacji (moze przewidywane)
+	unsigned long long localTicks; // liczba krokow z ustalonymi wlasnymi klawiszami
+	unsigned long long remoteTicks; // liczba krokow z potwierdzonymi klawiszami drugiego gracza
+	unsigned long long peerAck; // tyle naszych krokow drugi gracz juz potwierdzil
+	unsigned long long rollbackTo; // najwczesniejszy krok z blednym przewidywaniem (>= world.tick - brak)
+
+	unsigned long long checksumTicks[checksumHistory]; // wlasne skroty potwierdzonych stanow
+	unsigned long long checksums[checksumHistory];
+	unsigned long long nextChecksumTick; // najblizszy krok, dla ktorego liczony bedzie wlasny skrot
+	unsigned long long comparedChecksumTick; // ostatni krok, ktorego skrot porownano z drugim graczem
+
+	RollbackStats stats;
+};
+
+void initRollbackSession(RollbackSession& session, const NetLink& link, int localSide, unsigned int seed, fixed_t dt, unsigned int inputDelay = 0);
+void freeRollbackSession(RollbackSession& session);
+void pollRollbackSession(RollbackSession& session);
+bool advanceRollbackSession(RollbackSession& session, unsigned int keys);
+void sendRollbackInputs(RollbackSession& session);
+unsigned int sideKeys(int side, bool up, bool down);
+
+#endif /* __ROLLBACK_H__ */
@@ -0,0 +1,262 @@
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+#include "runner.h"
+#include "batch.h"
+#include "bots.h"
+
+// KOLEJKA NUMEROW MECZOW JEDNEGO WATKU - przedzial [begin, end) spakowany w jedno slowo,
+// zeby wlasciciel i zlodzieje mogli go zmieniac jednym compare_exchange bez blokad
+struct alignas(64) WorkQueue {
+	std::atomic<unsigned long long> range;
+};
+
+static unsigned long long packRange(unsigned int begin, unsigned int end)
+{
+	return ((unsigned long long)end << 32) | begin;
+}
+
+static unsigned int rangeBegin(unsigned long long range)
+{
+	return (unsigned int)range;
+}
+
+static unsigned int rangeEnd(unsigned long long range)
+{
+	return (unsigned int)(range >> 32);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja pobierajaca numer meczu z poczatku wlasnej kolejki
+** queue - kolejka watku
+** index - pobrany numer meczu
+** funkcja zwraca false jesli kolejka jest pusta
+**------------------------------------------------------------------------------------------*/
+static bool takeOwn(WorkQueue& queue, unsigned int& index)
+{
+	unsigned long long range = queue.range.load(std::memory_order_acquire);
+
+	while (rangeBegin(range) < rangeEnd(range))
+	{
+		if (queue.range.compare_exchange_weak(range, packRange(rangeBegin(range) + 1, rangeEnd(range)), std::memory_order_acq_rel))
+		{
+			index = rangeBegin(range);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja kradnaca polowe pracy z konca kolejki innego watku
+** queues - kolejki wszystkich watkow
+** count - liczba kolejek
+** self - numer watku kradnacego (jego kolejka musi byc pusta)
+** victimSeed - stan generatora wybierajacego pierwsza ofiare
+** funkcja zwraca true jesli cos zostalo przeniesione do wlasnej kolejki
+**------------------------------------------------------------------------------------------*/
+static bool steal(WorkQueue* queues, unsigned int count, unsigned int self, unsigned int& victimSeed)
+{
+	victimSeed ^= victimSeed << 13;
+	victimSeed ^= victimSeed >> 17;
+	victimSeed ^= victimSeed << 5;
+
+	for (unsigned int n = 0; n < count; n++)
+	{
+		unsigned int victim = (victimSeed + n) % count;
+		if (victim == self)
+			continue;
+
+		unsigned long long range = queues[victim].range.load(std::memory_order_acquire);
+		while (rangeBegin(range) < rangeEnd(range))
+		{
+			unsigned int size = rangeEnd(range) - rangeBegin(range);
+			unsigned int middle = rangeEnd(range) - (size + 1) / 2;
+
+			if (queues[victim].range.compare_exchange_weak(range, packRange(rangeBegin(range), middle), std::memory_order_acq_rel))
+			{
+				// nikt nie zmienia pustej kolejki, wiec wystarczy zwykly zapis
+				queues[self].range.store(packRange(middle, rangeEnd(range)), std::memory_order_release);
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja dodajaca wyniki czesciowe do sumy
+**------------------------------------------------------------------------------------------*/
+void mergeResults(MatchResults& total, const MatchResults& part)
+{
+	total.matches += part.matches;
+	total.winsForLeft += part.winsForLeft;
+	total.winsForRight += part.winsForRight;
+	total.unfinished += part.unfinished;
+	total.points += part.points;
+	total.hits += part.hits;
+	total.rallyTicks += part.rallyTicks;
+	if (part.longestRally > total.longestRally)
+		total.longestRally = part.longestRally;
+	total.ticks += part.ticks;
+}
+
+// STAN POJEDYNCZEGO MIEJSCA W PACZCE WATKU
+struct LaneState {
+	bool active; // czy w miejscu trwa mecz
+	unsigned long long startTick; // krok paczki, w ktorym zaczal sie mecz
+	unsigned long long rallyStart; // krok paczki, w ktorym zaczela sie wymiana
+	unsigned int points; // suma punktow po ostatnim kroku
+};
+
+/*------------------------------------------------------------------------------------------
+** funkcja watku - kroki paczki meczow, zbieranie wynikow i dobieranie nowych meczow
+**------------------------------------------------------------------------------------------*/
+static void workerLoop(const RunnerOptions& options, WorkQueue* queues, unsigned int count, unsigned int self, WorkerReport& report)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	MatchResults results = {};
+	unsigned long long steals = 0;
+	unsigned int victimSeed = 0x9E3779B9u * (self + 1);
+
+	MatchBatch batch;
+	initBatch(batch, options.batchSize, options.firstSeed);
+
+	unsigned int* keys = new unsigned int[batch.capacity];
+	LaneState* lanes = new LaneState[batch.count];
+
+	// pobranie kolejnego meczu: najpierw z wlasnej kolejki, potem kradziez
+	auto nextMatch = [&](unsigned int& index) {
+		while (!takeOwn(queues[self], index))
+		{
+			if (!steal(queues, count, self, victimSeed))
+				return false;
+			steals++;
+		}
+		return true;
+	};
+
+	unsigned int active = 0;
+	for (unsigned int i = 0; i < batch.count; i++)
+	{
+		unsigned int index;
+		lanes[i].active = nextMatch(index);
+		if (lanes[i].active)
+		{
+			resetMatch(batch, i, options.firstSeed + index);
+			lanes[i].startTick = lanes[i].rallyStart = 0;
+			lanes[i].points = 0;
+			active++;
+		}
+	}
+
+	while (active > 0)
+	{
+		options.bots(batch, keys);
+		stepBatch(batch, keys, options.dt);
+
+		for (unsigned int i = 0; i < batch.count; i++)
+		{
+			LaneState& lane = lanes[i];
+			if (!lane.active)
+				continue;
+
+			results.ticks++;
+
+			unsigned int points = batch.scoreForLeft[i] + batch.scoreForRight[i];
+			if (points != lane.points)
+			{
+				unsigned long long rally = batch.tick - lane.rallyStart;
+				results.points++;
+				results.rallyTicks += rally;
+				if (rally > results.longestRally)
+					results.longestRally = rally;
+
+				lane.rallyStart = batch.tick;
+				lane.points = points;
+			}
+
+			bool won = batch.scoreForLeft[i] >= options.points || batch.scoreForRight[i] >= options.points;
+			if (!won && batch.tick - lane.startTick < options.maxTicks)
+				continue;
+
+			// KONIEC MECZU
+			results.matches++;
+			results.hits += batch.hits[i];
+			if (!won)
+				results.unfinished++;
+			else if (batch.scoreForLeft[i] > batch.scoreForRight[i])
+				results.winsForLeft++;
+			else
+				results.winsForRight++;
+
+			unsigned int index;
+			if (nextMatch(index))
+			{
+				resetMatch(batch, i, options.firstSeed + index);
+				lane.startTick = lane.rallyStart = batch.tick;
+				lane.points = 0;
+			}
+			else
+			{
+				lane.active = false;
+				active--;
+			}
+		}
+	}
+
+	delete[] lanes;
+	delete[] keys;
+	freeBatch(batch);
+
+	report.results = results;
+	report.steals = steals;
+	report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja rozgrywajaca mecze na wszystkich rdzeniach z podkradaniem pracy
+** options - parametry rozgrywek
+** total - wyniki zsumowane po wszystkich watkach
+** reports - raporty poszczegolnych watkow
+**------------------------------------------------------------------------------------------*/
+void runMatchesParallel(const RunnerOptions& options, MatchResults& total, std::vector<WorkerReport>& reports)
+{
+	unsigned int threads = options.threads ? options.threads : std::thread::hardware_concurrency();
+	if (threads == 0)
+		threads = 1;
+
+	// poczatkowy podzial: rowne, ciagle przedzialy numerow meczow
+	WorkQueue* queues = new WorkQueue[threads];
+	for (unsigned int t = 0; t < threads; t++)
+	{
+		unsigned int begin = (unsigned int)((unsigned long long)options.matches * t / threads);
+		unsigned int end = (unsigned int)((unsigned long long)options.matches * (t + 1) / threads);
+		queues[t].range.store(packRange(begin, end), std::memory_order_relaxed);
+	}
+
+	reports.assign(threads, WorkerReport());
+
+	std::vector<std::thread> workers;
+	for (unsigned int t = 0; t < threads; t++)
+	{
+		workers.emplace_back(workerLoop, std::cref(options), queues, threads, t, std::ref(reports[t]));
+	}
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+
+	delete[] queues;
+
+	// sumy i maksimum nie zaleza od kolejnosci, wiec wynik nie zalezy od podzialu pracy
+	total = MatchResults();
+	for (const WorkerReport& report : reports)
+	{
+		mergeResults(total, report.results);
+	}
+}
@@ -0,0 +1,43 @@
+#ifndef __RUNNER_H__
+#define __RUNNER_H__
+
+#include <vector>
+
+#include "batch.h"
+
+// PARAMETRY WIELOWATKOWEGO ROZGRYWANIA MECZOW
+struct RunnerOptions {
+	unsigned int threads; // liczba watkow (0 - tyle ile rdzeni)
+	unsigned int matches; // liczba meczow do rozegrania
+	unsigned int firstSeed; // ziarno pierwszego meczu (kolejne mecze: firstSeed + i)
+	unsigned int points; // do ilu punktow gra sie mecz
+	unsigned int batchSize; // liczba meczow krokowanych naraz przez jeden watek
+	unsigned long long maxTicks; // limit krokow na mecz
+	float dt; // dlugosc kroku symulacji
+	void (*bots)(const MatchBatch& batch, unsigned int* keys); // decyzje botow obu rakietek dla calej paczki
+};
+
+// WYNIKI ZSUMOWANE PO ROZEGRANYCH MECZACH
+struct MatchResults {
+	unsigned long long matches; // rozegrane mecze
+	unsigned long long winsForLeft; // wygrane lewego gracza
+	unsigned long long winsForRight; // wygrane prawego gracza
+	unsigned long long unfinished; // mecze przerwane po maxTicks
+	unsigned long long points; // zdobyte punkty
+	unsigned long long hits; // odbicia pileczki od rakietek
+	unsigned long long rallyTicks; // suma dlugosci wymian (w krokach)
+	unsigned long long longestRally; // najdluzsza wymiana (w krokach)
+	unsigned long long ticks; // kroki rozegranych meczow
+};
+
+// RAPORT JEDNEGO WATKU
+struct WorkerReport {
+	MatchResults results; // wyniki meczow rozegranych przez watek
+	unsigned long long steals; // udane kradzieze pracy
+	double seconds; // czas pracy watku
+};
+
+void mergeResults(MatchResults& total, const MatchResults& part);
+void runMatchesParallel(const RunnerOptions& options, MatchResults& total, std::vector<WorkerReport>& reports);
+
+#endif /* __RUNNER_H__ */
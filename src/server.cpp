@@ -0,0 +1,617 @@
+#include <iostream>
+#include <cstdio>
+#include <cmath>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "server.h"
+#include "bots.h"
+#include "rollback.h"
+#include "wire.h"
+
+constexpr unsigned int maxCatchUpTicks = 4; // tyle krokow naraz nadrabia spozniona petla; reszta przepada
+constexpr unsigned int maxPacketsPerWakeup = 4096; // limit odbioru, zeby zegar krokow nie czekal na zalew pakietow
+constexpr int socketBufferSize = 8 << 20;
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwracajaca czas zegara monotonicznego w sekundach
+**------------------------------------------------------------------------------------------*/
+double monotonicSeconds()
+{
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static unsigned long long joinKey(unsigned int address, unsigned short port, unsigned int nonce)
+{
+	return ((unsigned long long)address << 32 | (unsigned long long)port << 16) ^ ((unsigned long long)nonce * 0x9E3779B97F4A7C15ull);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja kolejkujaca pakiet do gracza (wysylany paczka w flushPackets() po kroku lub odbiorze)
+**------------------------------------------------------------------------------------------*/
+static void sendToClient(MatchServer& server, const ServerClient& client, const unsigned char* packet, unsigned int size)
+{
+	unsigned char* data = allocPacket(server.io, size);
+	memcpy(data, packet, size);
+	queuePacket(server.io, client.address, client.port, data, size);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja otwierajaca nieblokujace gniazdo UDP serwera na porcie port
+** funkcja zwraca deskryptor albo -1
+**------------------------------------------------------------------------------------------*/
+int openServerSocket(unsigned short port)
+{
+	int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+	if (fd < 0)
+	{
+		std::cerr << "Nie mozna utworzyc gniazda UDP" << std::endl;
+		return -1;
+	}
+
+	// duze bufory - przy tysiacach klientow pakiety przychodza seriami co krok
+	// (SO_*BUFFORCE omija limit net.core.*mem_max, ale wymaga uprawnien)
+	int size = socketBufferSize;
+	if (setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)) != 0)
+		setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+	if (setsockopt(fd, SOL_SOCKET, SO_SNDBUFFORCE, &size, sizeof(size)) != 0)
+		setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+
+	sockaddr_in local = {};
+	local.sin_family = AF_INET;
+	local.sin_addr.s_addr = htonl(INADDR_ANY);
+	local.sin_port = htons(port);
+	if (bind(fd, (sockaddr*)&local, sizeof(local)) != 0)
+	{
+		std::cerr << "Nie mozna otworzyc portu UDP " << port << std::endl;
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja uruchamiajaca zegar krokow (timerfd) - deskryptor staje sie czytelny tickRate razy
+** na sekunde, a odczyt zwraca liczbe uplynietych okresow
+** funkcja zwraca -1 jesli nie mozna utworzyc lub uruchomic zegara
+**------------------------------------------------------------------------------------------*/
+int openTickTimer(double tickRate)
+{
+	int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+	if (fd < 0)
+		return -1;
+
+	long long period = (long long)(1e9 / tickRate);
+	itimerspec interval = {};
+	interval.it_interval.tv_sec = period / 1000000000;
+	interval.it_interval.tv_nsec = period % 1000000000;
+	interval.it_value = interval.it_interval;
+	if (timerfd_settime(fd, 0, &interval, nullptr) != 0)
+	{
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zamykajaca te z deskryptorow serwera (gniazdo, epoll, zegar), ktore udalo sie otworzyc
+**------------------------------------------------------------------------------------------*/
+static void closeServerDescriptors(MatchServer& server)
+{
+	if (server.socket >= 0)
+		close(server.socket);
+	if (server.epoll >= 0)
+		close(server.epoll);
+	if (server.timer >= 0)
+		close(server.timer);
+
+	server.socket = -1;
+	server.epoll = -1;
+	server.timer = -1;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja otwierajaca gniazdo, zegar krokow i paczke meczow serwera
+** funkcja zwraca false jesli nie mozna otworzyc gniazda, epoll, zegara lub warstwy pakietow
+** (zamyka wtedy wszystko, co zdazyla otworzyc)
+**------------------------------------------------------------------------------------------*/
+bool initServer(MatchServer& server, const ServerOptions& options)
+{
+	server.options = options;
+	server.socket = openServerSocket(options.port);
+	server.epoll = epoll_create1(0);
+	server.startTime = monotonicSeconds();
+	server.timer = openTickTimer(options.tickRate);
+	if (server.socket < 0 || server.epoll < 0 || server.timer < 0)
+	{
+		if (server.socket >= 0)
+			std::cerr << "Nie mozna utworzyc epoll lub zegara krokow (" << strerror(errno) << ")" << std::endl;
+		closeServerDescriptors(server);
+		return false;
+	}
+
+	if (!openPacketIo(server.io, server.socket, options.backend))
+	{
+		closeServerDescriptors(server);
+		return false;
+	}
+
+	epoll_event event = {};
+	event.events = EPOLLIN;
+	event.data.fd = server.io.readyFd;
+	bool added = epoll_ctl(server.epoll, EPOLL_CTL_ADD, server.io.readyFd, &event) == 0;
+	event.data.fd = server.timer;
+	if (!added || epoll_ctl(server.epoll, EPOLL_CTL_ADD, server.timer, &event) != 0)
+	{
+		std::cerr << "Nie mozna dodac gniazda lub zegara do epoll (" << strerror(errno) << ")" << std::endl;
+		closePacketIo(server.io);
+		closeServerDescriptors(server);
+		return false;
+	}
+
+	initBatch(server.batch, options.maxMatches, 1);
+	server.matches = new ServerMatch[server.batch.count]();
+	server.keys = new unsigned int[server.batch.capacity]();
+	server.botKeys = new unsigned int[server.batch.capacity]();
+
+	server.freeSlots.clear();
+	for (unsigned int i = server.batch.count; i > 0; i--)
+	{
+		server.freeSlots.push_back(i - 1);
+	}
+	server.waitingMatch = noMatch;
+	server.joined.clear();
+	server.nextSeed = (unsigned int)time(NULL);
+	server.playingMatches = 0;
+	server.connectedClients = 0;
+
+	server.lastTimeoutCheck = server.startTime;
+	server.lastReport = server.startTime;
+	server.scheduledTicks = 0;
+	server.stats = ServerStats();
+
+	return true;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zamykajaca gniazdo i zwalniajaca pamiec serwera
+**------------------------------------------------------------------------------------------*/
+void freeServer(MatchServer& server)
+{
+	closePacketIo(server.io);
+	close(server.socket);
+	close(server.timer);
+	close(server.epoll);
+
+	freeBatch(server.batch);
+	delete[] server.matches;
+	delete[] server.keys;
+	delete[] server.botKeys;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwalniajaca miejsce meczu
+**------------------------------------------------------------------------------------------*/
+static void freeMatch(MatchServer& server, unsigned int slot)
+{
+	ServerMatch& match = server.matches[slot];
+
+	if (match.playing)
+		server.playingMatches--;
+	if (server.waitingMatch == slot)
+		server.waitingMatch = noMatch;
+
+	match.used = false;
+	match.playing = false;
+	server.freeSlots.push_back(slot);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja odlaczajaca gracza; mecz bez graczy jest zwalniany, a rakietka gracza, ktory
+** wyszedl z trwajacego meczu, przechodzi pod kontrole bota
+**------------------------------------------------------------------------------------------*/
+static void disconnectClient(MatchServer& server, unsigned int slot, int side)
+{
+	ServerMatch& match = server.matches[slot];
+	ServerClient& client = match.clients[side];
+	if (!client.connected)
+		return;
+
+	server.joined.erase(joinKey(client.address, client.port, client.nonce));
+	client.connected = false;
+	client.keys = 0;
+	server.connectedClients--;
+
+	match.botKeysMask |= sideKeys(side, true, true);
+
+	if (!match.clients[0].connected && !match.clients[1].connected)
+		freeMatch(server, slot);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja rozpoczynajaca mecz w miejscu slot (obie strony obsadzone)
+**------------------------------------------------------------------------------------------*/
+static void startMatch(MatchServer& server, unsigned int slot)
+{
+	ServerMatch& match = server.matches[slot];
+
+	resetMatch(server.batch, slot, match.seed);
+	clearNetStateHistory(match.history);
+	match.startTick = server.batch.tick;
+	match.playing = true;
+	server.playingMatches++;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja obslugujaca zgloszenie gracza: nowy mecz z botem albo dolaczenie do czekajacego
+**------------------------------------------------------------------------------------------*/
+static void handleJoin(MatchServer& server, const ReceivedPacket& from, const unsigned char* packet, double now)
+{
+	unsigned int nonce = getU32(packet + 1);
+	unsigned long long key = joinKey(from.address, from.port, nonce);
+
+	unsigned int slot;
+	int side;
+
+	auto known = server.joined.find(key);
+	if (known != server.joined.end())
+	{
+		// powtorzony JOIN (zgubiona odpowiedz) - to samo miejsce
+		slot = known->second / 2;
+		side = known->second % 2;
+	}
+	else
+	{
+		if (!server.options.botOpponents && server.waitingMatch != noMatch)
+		{
+			slot = server.waitingMatch;
+			side = 1;
+			server.waitingMatch = noMatch;
+		}
+		else
+		{
+			if (server.freeSlots.empty())
+				return; // serwer pelny - klient powtorzy zgloszenie
+
+			slot = server.freeSlots.back();
+			server.freeSlots.pop_back();
+			side = 0;
+
+			ServerMatch& match = server.matches[slot];
+			match = ServerMatch();
+			match.used = true;
+			match.seed = server.nextSeed++;
+			match.botKeysMask = server.options.botOpponents ? sideKeys(1, true, true) : 0u;
+		}
+
+		ServerClient& client = server.matches[slot].clients[side];
+		client.connected = true;
+		client.nonce = nonce;
+		client.address = from.address;
+		client.port = from.port;
+		client.keys = 0;
+		initInputQueue(client.inputs);
+		client.ackTick = 0;
+		client.lastHeard = now;
+
+		server.joined[key] = slot * 2 + side;
+		server.connectedClients++;
+		server.stats.joins++;
+
+		if (server.options.botOpponents || side == 1)
+			startMatch(server, slot);
+		else
+			server.waitingMatch = slot;
+	}
+
+	unsigned char reply[joinedPacketSize];
+	reply[0] = PACKET_JOINED;
+	putU32(reply + 1, nonce);
+	putU32(reply + 5, slot);
+	reply[9] = (unsigned char)side;
+	putU32(reply + 10, server.matches[slot].seed);
+	putU16(reply + 14, (unsigned short)lround(server.options.tickRate));
+	sendToClient(server, server.matches[slot].clients[side], reply, sizeof(reply));
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja znajdujaca gracza, od ktorego przyszedl pakiet (mecz i strona musza pasowac do adresu)
+**------------------------------------------------------------------------------------------*/
+static ServerClient* findSender(MatchServer& server, const ReceivedPacket& from, unsigned int slot, int side)
+{
+	if (slot >= server.batch.count || side > 1 || !server.matches[slot].used)
+		return nullptr;
+
+	ServerClient& client = server.matches[slot].clients[side];
+	if (!client.connected || client.address != from.address || client.port != from.port)
+		return nullptr;
+
+	return &client;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja odbierajaca oczekujace pakiety graczy
+**------------------------------------------------------------------------------------------*/
+static void receivePackets(MatchServer& server, double now)
+{
+	unsigned int received = 0;
+	while (received < maxPacketsPerWakeup)
+	{
+		const ReceivedPacket* packets;
+		unsigned int count = receiveBatch(server.io, packets);
+		if (count == 0)
+			break;
+		received += count;
+
+		for (unsigned int n = 0; n < count; n++)
+		{
+			const ReceivedPacket& from = packets[n];
+			const unsigned char* packet = from.data;
+			unsigned int size = from.size;
+			if (size == 0)
+				continue;
+
+			if (packet[0] == PACKET_JOIN && size >= joinPacketSize)
+			{
+				handleJoin(server, from, packet, now);
+			}
+			else if (packet[0] == PACKET_INPUT && size >= inputPacketSize)
+			{
+				unsigned int slot = getU32(packet + 1);
+				int side = packet[5];
+				ServerClient* client = findSender(server, from, slot, side);
+				if (client)
+				{
+					// potwierdzenie tylko stanu, ktory serwer juz wyslal w tym meczu
+					unsigned int ack = getU32(packet + 6);
+					const ServerMatch& match = server.matches[slot];
+					if (ack > client->ackTick && match.playing && ack <= server.batch.tick - match.startTick)
+						client->ackTick = ack;
+
+					pushInput(client->inputs, getU32(packet + 11), packet[10] & sideKeys(side, true, true));
+					client->lastHeard = now;
+				}
+			}
+			else if (packet[0] == PACKET_LEAVE && size >= leavePacketSize)
+			{
+				unsigned int slot = getU32(packet + 1);
+				if (findSender(server, from, slot, packet[5]))
+					disconnectClient(server, slot, packet[5]);
+			}
+		}
+	}
+
+	// odpowiedzi JOINED wychodza jedna paczka
+	flushPackets(server.io);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja konczaca mecz: wynik do graczy i zwolnienie miejsca
+**------------------------------------------------------------------------------------------*/
+static void endMatch(MatchServer& server, unsigned int slot)
+{
+	ServerMatch& match = server.matches[slot];
+
+	unsigned char packet[endPacketSize];
+	packet[0] = PACKET_END;
+	putU32(packet + 1, slot);
+	putU16(packet + 6, server.batch.scoreForLeft[slot]);
+	putU16(packet + 8, server.batch.scoreForRight[slot]);
+
+	for (int side = 0; side < 2; side++)
+	{
+		if (match.clients[side].connected)
+		{
+			packet[5] = (unsigned char)side;
+			sendToClient(server, match.clients[side], packet, sizeof(packet));
+		}
+	}
+
+	server.stats.finishedMatches++;
+
+	for (int side = 0; side < 2; side++)
+	{
+		disconnectClient(server, slot, side); // ostatni odlaczony gracz zwalnia miejsce
+	}
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja wykonujaca jeden krok wszystkich meczow i rozsylajaca ich stan
+**------------------------------------------------------------------------------------------*/
+static void serverTick(MatchServer& server)
+{
+	MatchBatch& batch = server.batch;
+
+	trackingBotBatch(batch, server.botKeys);
+	for (unsigned int i = 0; i < batch.count; i++)
+	{
+		ServerMatch& match = server.matches[i];
+		if (!match.playing)
+		{
+			server.keys[i] = 0;
+			continue;
+		}
+
+		// kolejne klawisze graczy (te same kroki co w ich przewidywaniu)
+		for (int side = 0; side < 2; side++)
+		{
+			ServerClient& client = match.clients[side];
+			if (client.connected)
+				client.keys = nextInput(client.inputs);
+		}
+		server.keys[i] = (server.botKeys[i] & match.botKeysMask) | match.clients[0].keys | match.clients[1].keys;
+	}
+
+	stepBatch(batch, server.keys, (float)(1.0 / server.options.tickRate));
+
+	bool sendState = batch.tick % server.options.stateInterval == 0;
+	unsigned int tickRate = (unsigned int)lround(server.options.tickRate);
+
+	unsigned char packet[maxStatePacketSize];
+	packet[0] = PACKET_STATE;
+
+	for (unsigned int i = 0; i < batch.count; i++)
+	{
+		ServerMatch& match = server.matches[i];
+		if (!match.playing)
+			continue;
+
+		if (batch.scoreForLeft[i] >= server.options.points || batch.scoreForRight[i] >= server.options.points)
+		{
+			endMatch(server, i);
+			continue;
+		}
+
+		if (!sendState)
+			continue;
+
+		World world;
+		NetState state;
+		loadWorld(batch, i, world);
+		quantizeState(world, (unsigned int)(batch.tick - match.startTick), state);
+		storeNetState(match.history, state);
+
+		// kazdy gracz dostaje roznice wzgledem stanu, ktory sam potwierdzil
+		putU32(packet + 1, i);
+		for (int side = 0; side < 2; side++)
+		{
+			const ServerClient& client = match.clients[side];
+			if (!client.connected)
+				continue;
+
+			const NetState* baseline = client.ackTick ? findNetState(match.history, client.ackTick) : nullptr;
+			unsigned int size = encodeState(state, baseline, tickRate, packet + stateHeaderSize, maxEncodedState);
+
+			packet[5] = (unsigned char)side;
+			putU32(packet + 6, client.inputs.used); // te klawisze sa juz w stanie - klient przewiduje od nastepnych
+			sendToClient(server, client, packet, stateHeaderSize + size);
+			server.stats.statesSent++;
+			server.stats.stateBytes += size;
+		}
+	}
+
+	flushPackets(server.io);
+	server.stats.ticks++;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja odlaczajaca graczy, ktorzy zbyt dlugo nie przyslali pakietu
+**------------------------------------------------------------------------------------------*/
+static void dropSilentClients(MatchServer& server, double now)
+{
+	for (unsigned int i = 0; i < server.batch.count; i++)
+	{
+		if (!server.matches[i].used)
+			continue;
+
+		for (int side = 0; side < 2; side++)
+		{
+			const ServerClient& client = server.matches[i].clients[side];
+			if (client.connected && now - client.lastHeard > server.options.clientTimeout)
+				disconnectClient(server, i, side);
+		}
+	}
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja wypisujaca statystyki od ostatniego raportu
+**------------------------------------------------------------------------------------------*/
+static void printReport(MatchServer& server, double now)
+{
+	const ServerStats& stats = server.stats;
+	const PacketIoStats& io = server.io.stats;
+	double seconds = now - server.lastReport;
+	double ticks = stats.ticks ? (double)stats.ticks : 1.0;
+
+	printf("mecze %u, gracze %u | krok: sr %.3f ms, max %.3f ms | spoznienie: sr %.3f ms, max %.3f ms, nadrobione %llu"
+		" | pakiety/s: we %.0f, wy %.0f (bledy %llu), wywolania/s %.0f, stan sr %.2f B | dolaczenia %llu, zakonczone %llu\n",
+		server.playingMatches, server.connectedClients,
+		stats.sumTickSeconds / ticks * 1e3, stats.maxTickSeconds * 1e3,
+		stats.sumLateness / ticks * 1e3, stats.maxLateness * 1e3, stats.missedTicks,
+		io.packetsIn / seconds, io.packetsOut / seconds, io.sendFailures, io.syscalls / seconds,
+		stats.statesSent ? (double)stats.stateBytes / stats.statesSent : 0.0,
+		stats.joins, stats.finishedMatches);
+	fflush(stdout);
+
+	server.stats = ServerStats();
+	server.io.stats = PacketIoStats();
+	server.lastReport = now;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja petli serwera: pakiety graczy i kroki meczow w stalym rytmie zegara
+** stop - flaga zakonczenia ustawiana np. przez obsluge sygnalu (moze byc nullptr)
+**------------------------------------------------------------------------------------------*/
+void runServer(MatchServer& server, const volatile int* stop)
+{
+	const double period = 1.0 / server.options.tickRate;
+	epoll_event events[4];
+
+	while (!(stop && *stop))
+	{
+		int count = epoll_wait(server.epoll, events, 4, 100);
+		double now = monotonicSeconds();
+
+		for (int e = 0; e < count; e++)
+		{
+			if (events[e].data.fd == server.io.readyFd)
+			{
+				receivePackets(server, now);
+			}
+			else if (events[e].data.fd == server.timer)
+			{
+				unsigned long long expirations = 0;
+				if (read(server.timer, &expirations, sizeof(expirations)) != sizeof(expirations) || expirations == 0)
+					continue;
+
+				// spoznienie wzgledem planowanego czasu najstarszego oczekujacego kroku
+				double lateness = now - (server.startTime + (server.scheduledTicks + 1) * period);
+				if (lateness < 0.0)
+					lateness = 0.0;
+				server.scheduledTicks += expirations;
+
+				unsigned int ticks = expirations < maxCatchUpTicks ? (unsigned int)expirations : maxCatchUpTicks;
+				server.stats.missedTicks += expirations - 1;
+
+				for (unsigned int t = 0; t < ticks; t++)
+				{
+					serverTick(server);
+				}
+
+				double tickSeconds = (monotonicSeconds() - now) / ticks;
+				server.stats.sumTickSeconds += tickSeconds * ticks;
+				if (tickSeconds > server.stats.maxTickSeconds)
+					server.stats.maxTickSeconds = tickSeconds;
+				server.stats.sumLateness += lateness * ticks;
+				if (lateness > server.stats.maxLateness)
+					server.stats.maxLateness = lateness;
+			}
+		}
+
+		if (now - server.lastTimeoutCheck >= 1.0)
+		{
+			dropSilentClients(server, now);
+			server.lastTimeoutCheck = now;
+		}
+
+		if (server.options.reportInterval > 0.0 && now - server.lastReport >= server.options.reportInterval)
+			printReport(server, now);
+
+		if (server.options.seconds > 0.0 && now - server.startTime >= server.options.seconds)
+			break;
+	}
+}
@@ -0,0 +1,97 @@
+#ifndef __SERVER_H__
+#define __SERVER_H__
+
+#include <vector>
+#include <unordered_map>
+
+#include "batch.h"
+#include "statecodec.h"
+#include "packetio.h"
+#include "protocol.h"
+#include "predict.h"
+
+// PARAMETRY SERWERA
+struct ServerOptions {
+	unsigned short port = 7000; // port UDP
+	unsigned int maxMatches = 16384; // liczba miejsc na mecze (wszystkie krokowane jedna paczka)
+	double tickRate = 60.0; // kroki na sekunde
+	unsigned int points = 11; // do ilu punktow gra sie mecz
+	bool botOpponents = true; // kazdy klient gra z botem serwera (false - klienci lacza sie w pary)
+	unsigned int stateInterval = 1; // co ile krokow wysylac stan meczu
+	double clientTimeout = 10.0; // po ilu sekundach ciszy klient jest rozlaczany
+	double reportInterval = 5.0; // co ile sekund wypisywac statystyki (0 - wcale)
+	double seconds = 0.0; // czas pracy serwera (0 - bez konca)
+	PacketBackend backend = PACKET_IO_MMSG; // sposob wysylania i odbioru pakietow
+};
+
+// GRACZ PODLACZONY DO MECZU
+struct ServerClient {
+	bool connected;
+	unsigned int nonce; // identyfikator nadany przez klienta w PACKET_JOIN
+	unsigned int address; // IPv4 (kolejnosc bajtow sieci)
+	unsigned short port; // port (kolejnosc bajtow sieci)
+	unsigned int keys; // klawisze gracza w biezacym kroku (tylko jego rakietki)
+	InputQueue inputs; // odebrane klawisze - jedne na krok; numer uzytych odsylany w PACKET_STATE
+	unsigned int ackTick; // ostatni stan potwierdzony przez gracza - baza roznicy (0 - brak)
+	double lastHeard; // czas ostatniego pakietu
+};
+
+// MIEJSCE NA MECZ W PACZCE
+struct ServerMatch {
+	bool used; // miejsce zajete (mecz trwa albo czeka na drugiego gracza)
+	bool playing; // obie strony obsadzone - mecz jest krokowany i rozsylany
+	unsigned long long startTick; // krok paczki, w ktorym zaczal sie mecz
+	unsigned int seed; // ziarno meczu
+	ServerClient clients[2];
+	unsigned int botKeysMask; // klawisze rakietek sterowanych przez bota serwera
+	NetStateHistory history; // ostatnie wyslane stany (bazy roznic)
+};
+
+// STATYSTYKI OD OSTATNIEGO RAPORTU
+struct ServerStats {
+	unsigned long long ticks;
+	unsigned long long missedTicks; // kroki nadrabiane, bo petla nie zdazyla na czas
+	double maxLateness; // najwieksze spoznienie kroku wzgledem planu (s)
+	double sumLateness;
+	double maxTickSeconds; // najdluzszy czas obslugi kroku (symulacja + wysylanie)
+	double sumTickSeconds;
+	unsigned long long statesSent;
+	unsigned long long stateBytes; // bajty zakodowanych stanow (bez naglowka pakietu)
+	unsigned long long joins;
+	unsigned long long finishedMatches;
+};
+
+// SERWER MECZOW - jedna petla epoll: gniazdo UDP i zegar krokow (timerfd)
+struct MatchServer {
+	ServerOptions options;
+	int socket;
+	PacketIo io; // pakiety graczy (liczniki pakietow i wywolan systemowych w io.stats)
+	int epoll;
+	int timer;
+
+	MatchBatch batch;
+	ServerMatch* matches;
+	unsigned int* keys; // klawisze paczki w biezacym kroku
+	unsigned int* botKeys; // decyzje botow dla calej paczki
+	std::vector<unsigned int> freeSlots;
+	unsigned int waitingMatch; // mecz z jednym graczem czekajacym na drugiego (noMatch - brak)
+	std::unordered_map<unsigned long long, unsigned int> joined; // (adres, port, identyfikator) -> mecz * 2 + strona; powtorzony JOIN dostaje to samo miejsce
+	unsigned int nextSeed;
+	unsigned int playingMatches;
+	unsigned int connectedClients;
+
+	double startTime; // czas uruchomienia zegara krokow
+	double lastTimeoutCheck;
+	double lastReport;
+	unsigned long long scheduledTicks; // liczba krokow, ktore powinny juz byc wykonane
+	ServerStats stats;
+};
+
+bool initServer(MatchServer& server, const ServerOptions& options);
+void runServer(MatchServer& server, const volatile int* stop = nullptr);
+void freeServer(MatchServer& server);
+double monotonicSeconds();
+int openServerSocket(unsigned short port);
+int openTickTimer(double tickRate);
+
+#endif /* __SERVER_H__ */
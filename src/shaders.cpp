@@ -4,6 +4,7 @@
 #include <sstream>
 
 #include "shaders.h"
+#include "trace.h"
 
 /*------------------------------------------------------------------------------------------
 ** funkcja wczytujaca z pliku kod zrodlowy shadera
@@ -12,6 +13,8 @@
 **------------------------------------------------------------------------------------------*/
 std::string loadShaderSource( const std::string& shaderPath )
 {
+	TRACE_ZONE("loadShaderSource");
+
 	std::ifstream file;
 	file.open( shaderPath, std::ios::in );
 
@@ -49,7 +52,10 @@ bool createShader(const std::string& shaderPath, GLenum shaderType, GLuint &shad
 		const char* shaderSource = source.c_str();
 		glShaderSource( shaderID, 1, &shaderSource, nullptr ); // ustawienie kodu zrodlowego shadera
 
-		glCompileShader( shaderID ); // kompilacja shadera
+		{
+			TRACE_ZONE("glCompileShader");
+			glCompileShader( shaderID ); // kompilacja shadera
+		}
 
 		GLint compileStatus;
 		glGetShaderiv( shaderID, GL_COMPILE_STATUS, &compileStatus );
@@ -148,7 +154,10 @@ bool setupShaders(const std::string& vertexShaderPath, const std::string& fragme
 	glAttachShader( shaderProgram, vertexShader ); // dolaczenie shadera wierzcholkow
 	glAttachShader( shaderProgram, fragmentShader ); // dolaczenie shadera fragmentow
 
-    glLinkProgram( shaderProgram ); // linkowanie programu cieniowania
+	{
+		TRACE_ZONE("glLinkProgram");
+		glLinkProgram( shaderProgram ); // linkowanie programu cieniowania
+	}
 
 	GLint linkStatus;
 	glGetProgramiv( shaderProgram, GL_LINK_STATUS, &linkStatus );
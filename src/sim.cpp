@@ -0,0 +1,389 @@
+#include <cmath>
+
+#include "sim.h"
+
+/*------------------------------------------------------------------------------------------
+** funkcja losujaca liczby dla serwu generatorem Philox2x32-10 (licznik: numer serwu, klucz: ziarno)
+** seed - ziarno meczu
+** serve - numer serwu w meczu (0 - pierwszy serw, potem liczba rozegranych punktow)
+** random - dwie losowe liczby 32-bitowe: [0] - strona serwu, [1] - kat serwu
+**------------------------------------------------------------------------------------------*/
+void serveRandom(unsigned int seed, unsigned int serve, unsigned int random[2])
+{
+	unsigned int counter0 = serve;
+	unsigned int counter1 = 0;
+	unsigned int key = seed;
+
+	for (int r = 0; r < philoxRounds; r++)
+	{
+		unsigned long long product = (unsigned long long)philoxMultiplier * counter0;
+		counter0 = (unsigned int)(product >> 32) ^ key ^ counter1;
+		counter1 = (unsigned int)product;
+		key += philoxWeyl;
+	}
+
+	random[0] = counter0;
+	random[1] = counter1;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zamieniajaca losowa liczbe 32-bitowa na liczbe z przedzialu [0, 1)
+**------------------------------------------------------------------------------------------*/
+static float randomFloat(unsigned int random)
+{
+	return (float)(random >> 8) / (float)(1u << 24);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja ustawiajaca stan poczatkowy meczu
+** world - inicjowany stan meczu
+** seed - ziarno generatora liczb losowych
+**------------------------------------------------------------------------------------------*/
+void initWorld(World& world, unsigned int seed)
+{
+	world.ball = { WIN_WIDTH / 2.0f, WIN_HEIGHT / 2.0f };
+	world.ballVelocity = { 0.0f, 0.0f };
+	world.rackets[0] = { leftRacketX, WIN_HEIGHT / 2.0f };
+	world.rackets[1] = { rightRacketX, WIN_HEIGHT / 2.0f };
+	world.racketsVelocity[0] = 0.0f;
+	world.racketsVelocity[1] = 0.0f;
+	world.scoreForLeft = 0;
+	world.scoreForRight = 0;
+	world.hits = 0;
+	world.seed = seed;
+	world.tick = 0;
+
+	ballDirection(world, 0, ballServeSpeed, -ballServeMaxY, ballServeMaxY);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja nadajaca predkosci rakietkom na podstawie wcisnietych klawiszy
+** world - stan meczu
+** keys - maska bitowa klawiszy (InputKeys)
+**------------------------------------------------------------------------------------------*/
+void applyInputs(World& world, unsigned int keys)
+{
+	const unsigned int upKeys[2] = { INPUT_LEFT_UP, INPUT_RIGHT_UP };
+	const unsigned int downKeys[2] = { INPUT_LEFT_DOWN, INPUT_RIGHT_DOWN };
+
+	for (int i = 0; i < 2; i++)
+	{
+		// RESETOWANIE SZYBKOSCI RAKIETEK
+		world.racketsVelocity[i] = 0.0f;
+
+		// STEROWANIE RAKIETKAMI, NADAWNIE IM PREDKOSCI
+		if (keys & upKeys[i])
+		{
+			if (world.rackets[i].y < WIN_HEIGHT - racketLimit)
+			{
+				world.racketsVelocity[i] = racketsSpeed;
+			}
+			else
+			{
+				world.rackets[i].y = WIN_HEIGHT - racketLimit;
+			}
+		}
+
+		if (keys & downKeys[i])
+		{
+			if (world.rackets[i].y > racketLimit)
+			{
+				world.racketsVelocity[i] = -racketsSpeed;
+			}
+			else
+			{
+				world.rackets[i].y = halfRacketsHeight;
+			}
+		}
+	}
+}
+
+// RODZAJE ZDARZEN W TRAKCIE KROKU
+enum StepEvent {
+	EVENT_NONE = 0, // koniec kroku bez zderzenia
+	EVENT_WALL, // pileczka dotyka gory lub dolu boiska
+	EVENT_RACKET_FACE, // pileczka uderza w pionowy bok rakietki
+	EVENT_RACKET_EDGE, // pileczka uderza w gorna lub dolna krawedz rakietki
+	EVENT_GOAL // pileczka dociera do lewej lub prawej sciany
+};
+
+const float noEvent = 1e30f; // czas zdarzenia, ktore nie nastapi
+
+/*------------------------------------------------------------------------------------------
+** funkcja liczaca czas do dotkniecia gory lub dolu boiska
+** funkcja zwraca 0 jesli pileczka juz dotyka sciany i leci w jej strone
+**------------------------------------------------------------------------------------------*/
+static float timeToWall(float y, float vy)
+{
+	float t;
+	if (vy < 0)
+		t = (ballRadius - y) / vy;
+	else if (vy > 0)
+		t = (WIN_HEIGHT - ballRadius - y) / vy;
+	else
+		return noEvent;
+
+	return t < 0 ? 0.0f : t;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja liczaca czas do dotarcia pileczki do lewej lub prawej sciany
+**------------------------------------------------------------------------------------------*/
+static float timeToGoal(float x, float vx)
+{
+	float t;
+	if (vx < 0)
+		t = (ballRadius - x) / vx;
+	else if (vx > 0)
+		t = (WIN_WIDTH - ballRadius - x) / vx;
+	else
+		return noEvent;
+
+	return t < 0 ? 0.0f : t;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja liczaca czas zderzenia pileczki (okregu) z rakietka (prostokatem) metoda przemiatania:
+** prostokat powiekszony o promien pileczki, pileczka jako punkt poruszajacy sie wzgledem rakietki
+** dx, dy - polozenie pileczki wzgledem srodka rakietki
+** vx, vy - predkosc pileczki wzgledem rakietki
+** edge - ustawiane na true jesli pierwsze trafienie jest w gorna/dolna krawedz
+** funkcja zwraca noEvent jesli w ruchu jednostajnym nie dojdzie do zderzenia
+**------------------------------------------------------------------------------------------*/
+float timeToRacket(float dx, float dy, float vx, float vy, bool& edge)
+{
+	const float extentX = halfRacketsWidth + ballRadius;
+	const float extentY = halfRacketsHeight + ballRadius;
+
+	float distanceX = std::abs(dx);
+	float distanceY = std::abs(dy);
+	float closingX = dx >= 0 ? -vx : vx; // predkosc zblizania sie do bliskiego boku
+	float closingY = dy >= 0 ? -vy : vy;
+
+	float t = noEvent;
+	edge = false;
+
+	// BOK RAKIETKI
+	if (distanceX >= extentX && closingX > 0)
+	{
+		float tx = (distanceX - extentX) / closingX;
+		if (std::abs(dy + vy * tx) <= extentY)
+		{
+			t = tx;
+		}
+	}
+
+	// GORNA LUB DOLNA KRAWEDZ RAKIETKI
+	if (distanceY >= extentY && closingY > 0)
+	{
+		float ty = (distanceY - extentY) / closingY;
+		if (std::abs(dx + vx * ty) <= extentX && ty < t)
+		{
+			t = ty;
+			edge = true;
+		}
+	}
+
+	return t;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja liczaca czas do najblizszego zderzenia pileczki (sciana, rakietka, bramka) przy
+** obecnych predkosciach; miedzy zderzeniami ruch jest jednostajny, wiec step() z takim dt
+** konczy sie dokladnie na zdarzeniu
+**------------------------------------------------------------------------------------------*/
+float timeToNextEvent(const World& world)
+{
+	const float racketsX[2] = { leftRacketX, rightRacketX };
+
+	float t = timeToWall(world.ball.y, world.ballVelocity.y);
+
+	for (int i = 0; i < 2; i++)
+	{
+		bool edge;
+		float tRacket = timeToRacket(world.ball.x - racketsX[i], world.ball.y - world.rackets[i].y,
+			world.ballVelocity.x, world.ballVelocity.y - world.racketsVelocity[i], edge);
+		if (tRacket < t)
+			t = tRacket;
+	}
+
+	float tGoal = timeToGoal(world.ball.x, world.ballVelocity.x);
+	if (tGoal < t)
+		t = tGoal;
+
+	return t;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja wykonujaca jeden krok symulacji meczu; zderzenia sa rozwiazywane dokladnie
+** w chwili kontaktu (do maxEventsPerStep zdarzen na krok), wiec wynik nie zalezy od dlugosci kroku
+** world - stan meczu
+** inputs - klawisze wcisniete w tym kroku
+** dt - dlugosc kroku w sekundach
+** funkcja zwraca 0 jesli nikt nie zdobyl punktu, 1 - punkt dla prawego, 2 - punkt dla lewego
+**------------------------------------------------------------------------------------------*/
+unsigned int step(World& world, const Inputs& inputs, float dt)
+{
+	const float racketsX[2] = { leftRacketX, rightRacketX };
+
+	unsigned int reset = 0; // zmienna informujaca, kto zdobyl punkt
+
+	applyInputs(world, inputs.keys);
+
+	float remaining = dt;
+	for (int e = 0; e < maxEventsPerStep && remaining > 0; e++)
+	{
+		// NAJBLIZSZE ZDARZENIE W POZOSTALEJ CZESCI KROKU
+		float t = remaining;
+		StepEvent event = EVENT_NONE;
+		int side = 0;
+
+		float tWall = timeToWall(world.ball.y, world.ballVelocity.y);
+		if (tWall <= t)
+		{
+			t = tWall;
+			event = EVENT_WALL;
+		}
+
+		for (int i = 0; i < 2; i++)
+		{
+			bool edge;
+			float tRacket = timeToRacket(world.ball.x - racketsX[i], world.ball.y - world.rackets[i].y,
+				world.ballVelocity.x, world.ballVelocity.y - world.racketsVelocity[i], edge);
+			if (tRacket <= t)
+			{
+				t = tRacket;
+				event = edge ? EVENT_RACKET_EDGE : EVENT_RACKET_FACE;
+				side = i;
+			}
+		}
+
+		float tGoal = timeToGoal(world.ball.x, world.ballVelocity.x);
+		if (tGoal < t)
+		{
+			t = tGoal;
+			event = EVENT_GOAL;
+		}
+
+		// RUCH DO CHWILI ZDARZENIA
+		world.rackets[0].y += world.racketsVelocity[0] * t;
+		world.rackets[1].y += world.racketsVelocity[1] * t;
+		world.ball.x += world.ballVelocity.x * t;
+		world.ball.y += world.ballVelocity.y * t;
+		remaining -= t;
+
+		switch (event)
+		{
+		case EVENT_WALL:
+			world.ballVelocity.y *= -1;
+			break;
+
+		case EVENT_RACKET_FACE:
+			world.ballVelocity.x *= -1;
+			world.ballVelocity.x *= ballSpeedup;
+			world.hits++;
+			break;
+
+		case EVENT_RACKET_EDGE:
+			// odbicie wzgledem poruszajacej sie rakietki, zeby pileczka zawsze od niej odlatywala
+			world.ballVelocity.y = world.racketsVelocity[side] + world.racketsVelocity[side] - world.ballVelocity.y;
+			world.ballVelocity.x *= ballSpeedup;
+			world.hits++;
+			break;
+
+		case EVENT_GOAL:
+			// RESET POZYCJI I KIERUNKU RUCHU PILECZKI PO ZDOBYCIU PUNKTU
+			if (world.ballVelocity.x < 0)
+			{
+				world.scoreForRight++;
+				reset = 1;
+			}
+			else
+			{
+				world.scoreForLeft++;
+				reset = 2;
+			}
+
+			world.ball.x = WIN_WIDTH / 2.0f;
+			world.ball.y = WIN_HEIGHT / 2.0f;
+
+			ballDirection(world, reset, ballServeSpeed, -ballServeMaxY, ballServeMaxY);
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	// przy nadmiarze zdarzen reszta kroku bez sprawdzania zderzen
+	if (remaining > 0)
+	{
+		world.rackets[0].y += world.racketsVelocity[0] * remaining;
+		world.rackets[1].y += world.racketsVelocity[1] * remaining;
+		world.ball.x += world.ballVelocity.x * remaining;
+		world.ball.y += world.ballVelocity.y * remaining;
+	}
+
+	world.tick++;
+
+	return reset;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja liczaca pozycje do narysowania pomiedzy dwoma kolejnymi krokami
+** previous, current - stany z dwoch ostatnich krokow
+** alpha - czesc kroku, ktora uplynela od current (0..1)
+** ball, rackets - wyliczone pozycje pileczki i rakietek
+**------------------------------------------------------------------------------------------*/
+void interpolatePositions(const World& previous, const World& current, float alpha, vec2& ball, vec2 rackets[2])
+{
+	// po zdobyciu punktu pileczka przeskakuje na srodek - bez interpolacji przez cale boisko
+	if (previous.scoreForLeft != current.scoreForLeft || previous.scoreForRight != current.scoreForRight)
+	{
+		ball = current.ball;
+	}
+	else
+	{
+		ball.x = previous.ball.x + (current.ball.x - previous.ball.x) * alpha;
+		ball.y = previous.ball.y + (current.ball.y - previous.ball.y) * alpha;
+	}
+
+	for (int i = 0; i < 2; i++)
+	{
+		rackets[i].x = current.rackets[i].x;
+		rackets[i].y = previous.rackets[i].y + (current.rackets[i].y - previous.rackets[i].y) * alpha;
+	}
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja ustalajaca kierunek pileczki
+** direction - 1: w prawo, 2: w lewo, inna wartosc: losowo
+** x - pozioma predkosc pileczki
+** yMin, yMax - przedzial losowanej pionowej predkosci pileczki
+**------------------------------------------------------------------------------------------*/
+void ballDirection(World& world, unsigned int direction, float x, float yMin, float yMax) {
+
+	unsigned int random[2];
+	serveRandom(world.seed, world.scoreForLeft + world.scoreForRight, random);
+
+	if (direction == 1) {
+		world.ballVelocity.x = x;
+	}
+	else if (direction == 2)
+	{
+		world.ballVelocity.x = -x;
+	}
+	else
+	{
+		if (randomFloat(random[0]) < 0.5f)
+		{
+			world.ballVelocity.x = x;
+		}
+		else
+		{
+			world.ballVelocity.x = -x;
+		}
+	}
+
+	world.ballVelocity.y = ((yMax - yMin) * randomFloat(random[1])) + yMin;
+}
@@ -0,0 +1,72 @@
+#ifndef __SIM_H__
+#define __SIM_H__
+
+constexpr int WIN_WIDTH = 800; // SZEROKOSC BOISKA (OKNA)
+constexpr int WIN_HEIGHT = 600; // WYSOKOSC BOISKA (OKNA)
+
+// DEKLARACJA STRUKTURY WEKTORA DWUWYMIAROWEGO
+struct vec2 {
+	float x;
+	float y;
+};
+
+// ZMIENNE OKRESLAJACE STALE WLASCIWOSCI OBIEKTOW
+const float racketsSpeed = 300.0f; // SZYBKOSC PORUSZANIA SIE RAKIETEK
+const float racketsHeight = 75.0f; // WYSOKOSC RAKIETEK
+const float halfRacketsHeight = racketsHeight / 2.0f; // POLOWA WYSOKOSCI RAKIETEK
+const float racketsWidth = 10.0f; // SZEROKOSC RAKIETEK
+const float halfRacketsWidth = racketsWidth / 2.0f; // POLOWA SZEROKOSCI RAKIETEK
+const float ballDiameter = 5.0f; // SREDNICA PILECZKI
+const float ballRadius = 2.5f; // PROMIEN PILECZKI
+const float racketLimit = halfRacketsHeight + ballRadius; // GRANICA PRZESUWANIA SIE RAKIETEK DO GORY I W DOL EKRANU
+const float leftRacketX = 20.0f; // POZIOME POLOZENIE LEWEJ RAKIETKI
+const float rightRacketX = WIN_WIDTH - 20.0f; // POZIOME POLOZENIE PRAWEJ RAKIETKI
+
+const float ballServeSpeed = 200.0f; // POZIOMA PREDKOSC PILECZKI PO SERWIE
+const float ballServeMaxY = 200.0f; // MAKSYMALNA PIONOWA PREDKOSC PILECZKI PO SERWIE
+const float ballSpeedup = 1.01f; // PRZYSPIESZENIE PILECZKI PRZY KAZDYM ODBICIU
+
+const int maxEventsPerStep = 8; // ile zderzen (sciany, rakietki, bramki) rozwiazywanych jest dokladnie w jednym kroku
+
+// KLAWISZE STERUJACE RAKIETKAMI (MASKA BITOWA)
+enum InputKeys {
+	INPUT_LEFT_UP = 1, // W
+	INPUT_LEFT_DOWN = 2, // S
+	INPUT_RIGHT_UP = 4, // STRZALKA W GORE
+	INPUT_RIGHT_DOWN = 8 // STRZALKA W DOL
+};
+
+// WEJSCIE DLA JEDNEGO KROKU SYMULACJI
+struct Inputs {
+	unsigned int keys;
+};
+
+// GENERATOR LICZNIKOWY PHILOX2x32-10 - liczby dla serwu zaleza tylko od (ziarno meczu, numer serwu),
+// wiec mecze na roznych watkach i w paczkach SIMD nie dziela zadnego stanu
+constexpr unsigned int philoxMultiplier = 0xD256D193u;
+constexpr unsigned int philoxWeyl = 0x9E3779B9u; // przyrost klucza po kazdej rundzie
+constexpr int philoxRounds = 10;
+
+// PELNY STAN MECZU - BEZ ZALEZNOSCI OD GLFW/GL
+struct World {
+	vec2 ball; // pozycja pileczki
+	vec2 ballVelocity; // predkosc pileczki
+	vec2 rackets[2]; // pozycje rakietek (lewa, prawa)
+	float racketsVelocity[2]; // predkosci rakietek
+	unsigned int scoreForLeft; // punkty lewego gracza
+	unsigned int scoreForRight; // punkty prawego gracza
+	unsigned int hits; // liczba odbic pileczki od rakietek w meczu
+	unsigned int seed; // ziarno meczu - klucz generatora losujacego kierunek serwu
+	unsigned long long tick; // numer kroku symulacji
+};
+
+void initWorld(World& world, unsigned int seed);
+void serveRandom(unsigned int seed, unsigned int serve, unsigned int random[2]);
+void applyInputs(World& world, unsigned int keys);
+unsigned int step(World& world, const Inputs& inputs, float dt);
+float timeToNextEvent(const World& world);
+float timeToRacket(float dx, float dy, float vx, float vy, bool& edge);
+void interpolatePositions(const World& previous, const World& current, float alpha, vec2& ball, vec2 rackets[2]);
+void ballDirection(World& world, unsigned int direction, float x, float yMin, float yMax);
+
+#endif /* __SIM_H__ */
@@ -0,0 +1,111 @@
+#include <cstring>
+
+#include "snapshot.h"
+
+/*------------------------------------------------------------------------------------------
+** funkcja przydzielajaca pamiec pierscienia migawek
+** ring - pierscien
+** capacity - liczba migawek (np. liczba krokow, o ile mozna sie cofnac)
+** stateSize - rozmiar stanu: sizeof(World) lub sizeof(FixedWorld)
+**------------------------------------------------------------------------------------------*/
+void initSnapshotRing(SnapshotRing& ring, unsigned int capacity, unsigned int stateSize)
+{
+	ring.capacity = capacity ? capacity : 1;
+	ring.stateSize = stateSize;
+	ring.slots = new unsigned char[(size_t)ring.capacity * stateSize];
+	ring.ticks = new unsigned long long[ring.capacity];
+
+	clearSnapshots(ring);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwalniajaca pamiec pierscienia migawek
+**------------------------------------------------------------------------------------------*/
+void freeSnapshotRing(SnapshotRing& ring)
+{
+	delete[] ring.slots;
+	delete[] ring.ticks;
+
+	ring.slots = nullptr;
+	ring.ticks = nullptr;
+	ring.capacity = 0;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja oznaczajaca wszystkie miejsca jako puste (np. po przewinieciu powtorki)
+**------------------------------------------------------------------------------------------*/
+void clearSnapshots(SnapshotRing& ring)
+{
+	for (unsigned int i = 0; i < ring.capacity; i++)
+	{
+		ring.ticks[i] = noSnapshot;
+	}
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zapisujaca stan w miejscu tick % capacity (nadpisuje najstarsza migawke)
+**------------------------------------------------------------------------------------------*/
+static void saveState(SnapshotRing& ring, const void* state, unsigned long long tick)
+{
+	unsigned int slot = (unsigned int)(tick % ring.capacity);
+
+	memcpy(ring.slots + (size_t)slot * ring.stateSize, state, ring.stateSize);
+	ring.ticks[slot] = tick;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja odczytujaca stan zapisany dla kroku tick
+** funkcja zwraca false jesli migawka zostala juz nadpisana lub nigdy nie powstala
+**------------------------------------------------------------------------------------------*/
+static bool restoreState(const SnapshotRing& ring, unsigned long long tick, void* state)
+{
+	unsigned int slot = (unsigned int)(tick % ring.capacity);
+	if (ring.ticks[slot] != tick)
+		return false;
+
+	memcpy(state, ring.slots + (size_t)slot * ring.stateSize, ring.stateSize);
+
+	return true;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcje zapisujace i odczytujace migawke stanu World lub FixedWorld
+** funkcje zwracaja false jesli pierscien przechowuje stan innego typu (inne stateSize)
+**------------------------------------------------------------------------------------------*/
+bool saveSnapshot(SnapshotRing& ring, const World& world)
+{
+	if (ring.stateSize != sizeof(World))
+		return false;
+
+	saveState(ring, &world, world.tick);
+
+	return true;
+}
+
+bool saveSnapshot(SnapshotRing& ring, const FixedWorld& world)
+{
+	if (ring.stateSize != sizeof(FixedWorld))
+		return false;
+
+	saveState(ring, &world, world.tick);
+
+	return true;
+}
+
+bool restoreSnapshot(const SnapshotRing& ring, unsigned long long tick, World& world)
+{
+	return ring.stateSize == sizeof(World) && restoreState(ring, tick, &world);
+}
+
+bool restoreSnapshot(const SnapshotRing& ring, unsigned long long tick, FixedWorld& world)
+{
+	return ring.stateSize == sizeof(FixedWorld) && restoreState(ring, tick, &world);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja sprawdzajaca, czy pierscien zawiera jeszcze migawke kroku tick
+**------------------------------------------------------------------------------------------*/
+bool hasSnapshot(const SnapshotRing& ring, unsigned long long tick)
+{
+	return ring.ticks[tick % ring.capacity] == tick;
+}
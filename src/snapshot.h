@@ -0,0 +1,27 @@
+#ifndef __SNAPSHOT_H__
+#define __SNAPSHOT_H__
+
+#include "sim.h"
+#include "fixed.h"
+
+constexpr unsigned long long noSnapshot = ~0ull; // numer kroku pustego miejsca
+
+// PIERSCIEN MIGAWEK STANU MECZU - cala pamiec przydzielana raz w initSnapshotRing(),
+// zapis i odczyt to kopiowanie struktury (World i FixedWorld nie maja wskaznikow)
+struct SnapshotRing {
+	unsigned char* slots; // capacity miejsc po stateSize bajtow
+	unsigned long long* ticks; // numer kroku zapisanego w miejscu (noSnapshot - puste)
+	unsigned int capacity; // liczba miejsc
+	unsigned int stateSize; // sizeof(World) lub sizeof(FixedWorld)
+};
+
+void initSnapshotRing(SnapshotRing& ring, unsigned int capacity, unsigned int stateSize = sizeof(World));
+void freeSnapshotRing(SnapshotRing& ring);
+void clearSnapshots(SnapshotRing& ring);
+bool saveSnapshot(SnapshotRing& ring, const World& world);
+bool saveSnapshot(SnapshotRing& ring, const FixedWorld& world);
+bool restoreSnapshot(const SnapshotRing& ring, unsigned long long tick, World& world);
+bool restoreSnapshot(const SnapshotRing& ring, unsigned long long tick, FixedWorld& world);
+bool hasSnapshot(const SnapshotRing& ring, unsigned long long tick);
+
+#endif /* __SNAPSHOT_H__ */
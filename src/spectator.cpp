@@ -0,0 +1,260 @@
+#include "spectator.h"
+#include "wire.h"
+
+static unsigned long long spectatorKey(unsigned int address, unsigned short port)
+{
+	return (unsigned long long)address << 16 | port;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja przygotowujaca rozsylanie meczu do widzow
+** io - warstwa pakietow gniazda UDP serwera
+** match - numer meczu w naglowku klatek
+** tickRate - kroki na sekunde (widzowie dekoduja z ta sama wartoscia)
+** keyframeInterval - co ile krokow stan pelny (mniej niz spectatorQueueSize)
+**------------------------------------------------------------------------------------------*/
+void initSpectatorHub(SpectatorHub& hub, PacketIo* io, unsigned int match, unsigned int tickRate, unsigned int keyframeInterval)
+{
+	hub.io = io;
+	hub.match = match;
+	hub.tickRate = tickRate;
+	hub.keyframeInterval = keyframeInterval < spectatorQueueSize - spectatorBurst ? keyframeInterval : spectatorQueueSize - spectatorBurst;
+	if (hub.keyframeInterval == 0)
+		hub.keyframeInterval = 1;
+
+	hub.frames = new SpectatorFrame[spectatorFramePool];
+	hub.freeFrames = nullptr;
+	for (unsigned int i = 0; i < spectatorFramePool; i++)
+	{
+		hub.frames[i].refs = 0;
+		hub.frames[i].nextFree = hub.freeFrames;
+		hub.freeFrames = &hub.frames[i];
+	}
+	hub.framesInUse = 0;
+
+	hub.chainLength = 0;
+	hub.hasPrevious = false;
+	hub.spectators.clear();
+	hub.index.clear();
+	hub.stats = SpectatorStats();
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwalniajaca pamiec rozsylania (gniazdo i warstwa pakietow naleza do wywolujacego)
+**------------------------------------------------------------------------------------------*/
+void freeSpectatorHub(SpectatorHub& hub)
+{
+	delete[] hub.frames;
+	hub.frames = nullptr;
+	hub.spectators.clear();
+	hub.index.clear();
+}
+
+static void retainFrame(SpectatorFrame* frame)
+{
+	frame->refs++;
+}
+
+static void releaseFrame(SpectatorHub& hub, SpectatorFrame* frame)
+{
+	if (--frame->refs == 0)
+	{
+		frame->nextFree = hub.freeFrames;
+		hub.freeFrames = frame;
+		hub.framesInUse--;
+	}
+}
+
+static void clearQueue(SpectatorHub& hub, Spectator& spectator)
+{
+	for (unsigned int i = 0; i < spectator.count; i++)
+	{
+		releaseFrame(hub, spectator.queue[(spectator.head + i) % spectatorQueueSize]);
+	}
+	spectator.head = 0;
+	spectator.count = 0;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja dopisujaca klatke do kolejki widza; przepelniona kolejka jest oprozniana, a widz
+** czeka na najblizsza klatke kluczowa (roznice bez bazy i tak bylyby nieczytelne)
+**------------------------------------------------------------------------------------------*/
+static void enqueueFrame(SpectatorHub& hub, Spectator& spectator, SpectatorFrame* frame)
+{
+	if (spectator.waitingForKeyframe && !frame->keyframe)
+		return;
+
+	if (spectator.count == spectatorQueueSize)
+	{
+		clearQueue(hub, spectator);
+		hub.stats.resyncs++;
+		if (!frame->keyframe)
+		{
+			spectator.waitingForKeyframe = true;
+			return;
+		}
+	}
+
+	spectator.waitingForKeyframe = false;
+	retainFrame(frame);
+	spectator.queue[(spectator.head + spectator.count) % spectatorQueueSize] = frame;
+	spectator.count++;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja kodujaca stan meczu raz dla wszystkich widzow i dopisujaca klatke do ich kolejek
+** state - stan po kroku (kolejne wywolania z kolejnymi krokami)
+**------------------------------------------------------------------------------------------*/
+void publishState(SpectatorHub& hub, const NetState& state)
+{
+	if (!hub.freeFrames)
+	{
+		hub.stats.poolExhausted++;
+		hub.hasPrevious = false; // nastepna klatka musi byc kluczowa
+		return;
+	}
+
+	SpectatorFrame* frame = hub.freeFrames;
+	hub.freeFrames = frame->nextFree;
+	hub.framesInUse++;
+
+	bool keyframe = !hub.hasPrevious || hub.chainLength == 0 || state.tick % hub.keyframeInterval == 0
+		|| hub.chainLength >= spectatorQueueSize || state.tick != hub.previous.tick + 1;
+
+	frame->refs = 0;
+	frame->tick = state.tick;
+	frame->keyframe = keyframe;
+	frame->data[0] = PACKET_FRAME;
+	putU32(frame->data + 1, hub.match);
+	frame->size = frameHeaderSize + encodeState(state, keyframe ? nullptr : &hub.previous, hub.tickRate, frame->data + frameHeaderSize, maxEncodedState);
+
+	hub.previous = state;
+	hub.hasPrevious = true;
+	hub.stats.frames++;
+
+	// lancuch dla nowych widzow: klatka kluczowa zaczyna go od nowa
+	if (keyframe)
+	{
+		for (unsigned int i = 0; i < hub.chainLength; i++)
+		{
+			releaseFrame(hub, hub.chain[i]);
+		}
+		hub.chainLength = 0;
+		hub.stats.keyframes++;
+	}
+	retainFrame(frame);
+	hub.chain[hub.chainLength++] = frame;
+
+	for (Spectator& spectator : hub.spectators)
+	{
+		enqueueFrame(hub, spectator, frame);
+	}
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja dopisujaca widza (albo odswiezajaca obecnego); nowy widz dostaje w kolejce
+** ostatnia klatke kluczowa i roznice po niej
+**------------------------------------------------------------------------------------------*/
+void addSpectator(SpectatorHub& hub, unsigned int address, unsigned short port, double now)
+{
+	unsigned long long key = spectatorKey(address, port);
+
+	auto known = hub.index.find(key);
+	if (known != hub.index.end())
+	{
+		hub.spectators[known->second].lastHeard = now;
+		return;
+	}
+
+	hub.index[key] = (unsigned int)hub.spectators.size();
+	hub.spectators.emplace_back();
+
+	Spectator& spectator = hub.spectators.back();
+	spectator.address = address;
+	spectator.port = port;
+	spectator.head = 0;
+	spectator.count = 0;
+	spectator.waitingForKeyframe = hub.chainLength == 0;
+	spectator.lastHeard = now;
+
+	for (unsigned int i = 0; i < hub.chainLength; i++)
+	{
+		enqueueFrame(hub, spectator, hub.chain[i]);
+	}
+
+	hub.stats.joins++;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja usuwajaca widza o indeksie i (ostatni widz zajmuje jego miejsce)
+**------------------------------------------------------------------------------------------*/
+static void removeAt(SpectatorHub& hub, unsigned int i)
+{
+	Spectator& spectator = hub.spectators[i];
+	clearQueue(hub, spectator);
+	hub.index.erase(spectatorKey(spectator.address, spectator.port));
+
+	unsigned int last = (unsigned int)hub.spectators.size() - 1;
+	if (i != last)
+	{
+		hub.spectators[i] = hub.spectators[last];
+		hub.index[spectatorKey(hub.spectators[i].address, hub.spectators[i].port)] = i;
+	}
+	hub.spectators.pop_back();
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja usuwajaca widza o podanym adresie
+**------------------------------------------------------------------------------------------*/
+void removeSpectator(SpectatorHub& hub, unsigned int address, unsigned short port)
+{
+	auto known = hub.index.find(spectatorKey(address, port));
+	if (known != hub.index.end())
+		removeAt(hub, known->second);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja wysylajaca widzom klatki z ich kolejek (najwyzej spectatorBurst na widza) - pakiety
+** wskazuja wprost na bufory klatek i wychodza paczkami warstwy pakietow; zwolniona klatka
+** wraca do puli dopiero w publishState(), czyli po flushPackets() na koncu tej funkcji
+**------------------------------------------------------------------------------------------*/
+void flushSpectators(SpectatorHub& hub)
+{
+	// pelna paczka wychodzi juz w queuePacket(), wiec bledy liczone z licznikow warstwy
+	unsigned long long failuresBefore = hub.io->stats.sendFailures;
+
+	for (Spectator& spectator : hub.spectators)
+	{
+		for (unsigned int n = 0; n < spectatorBurst && spectator.count > 0; n++)
+		{
+			SpectatorFrame* frame = spectator.queue[spectator.head];
+			queuePacket(*hub.io, spectator.address, spectator.port, frame->data, frame->size);
+
+			hub.stats.packetsOut++;
+			hub.stats.bytesOut += frame->size;
+
+			spectator.head = (spectator.head + 1) % spectatorQueueSize;
+			spectator.count--;
+			releaseFrame(hub, frame);
+		}
+	}
+
+	flushPackets(*hub.io);
+	unsigned long long failures = hub.io->stats.sendFailures - failuresBefore;
+	hub.stats.packetsOut -= failures;
+	hub.stats.sendFailures += failures;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja usuwajaca widzow, ktorzy nie odezwali sie od timeout sekund
+**------------------------------------------------------------------------------------------*/
+void dropSilentSpectators(SpectatorHub& hub, double now, double timeout)
+{
+	for (unsigned int i = 0; i < hub.spectators.size();)
+	{
+		if (now - hub.spectators[i].lastHeard > timeout)
+			removeAt(hub, i);
+		else
+			i++;
+	}
+}
@@ -0,0 +1,82 @@
+#ifndef __SPECTATOR_H__
+#define __SPECTATOR_H__
+
+#include <vector>
+#include <unordered_map>
+
+#include "server.h"
+#include "statecodec.h"
+
+constexpr unsigned int spectatorKeyframeInterval = 60; // co ile krokow klatka kluczowa (stan pelny)
+constexpr unsigned int spectatorQueueSize = 128; // najwiecej klatek czekajacych na wyslanie do jednego widza (> odstep klatek kluczowych)
+constexpr unsigned int spectatorBurst = 8; // najwiecej klatek wysylanych widzowi w jednym kroku (nadrabianie po dolaczeniu)
+constexpr unsigned int spectatorFramePool = 2 * spectatorQueueSize; // zywe klatki: ostatnie spectatorQueueSize krokow
+
+// KLATKA DLA WIDZOW - pakiet PACKET_FRAME kodowany raz i wysylany z tego samego bufora do
+// kazdego widza; refs liczy kolejki widzow i lancuch od ostatniej klatki kluczowej, ktore
+// na nia wskazuja (hub jest jednowatkowy, wiec zwykly licznik)
+struct SpectatorFrame {
+	unsigned int refs;
+	unsigned int tick;
+	bool keyframe;
+	unsigned int size; // bajty pakietu
+	unsigned char data[frameHeaderSize + maxEncodedState];
+	SpectatorFrame* nextFree;
+};
+
+// WIDZ - adres i kolejka klatek do wyslania
+struct Spectator {
+	unsigned int address; // IPv4 (kolejnosc bajtow sieci)
+	unsigned short port; // port (kolejnosc bajtow sieci)
+	SpectatorFrame* queue[spectatorQueueSize];
+	unsigned int head; // pierwsza klatka do wyslania
+	unsigned int count; // liczba klatek w kolejce
+	bool waitingForKeyframe; // kolejka przepelniona - roznice pomijane do najblizszej klatki kluczowej
+	double lastHeard;
+};
+
+// STATYSTYKI OD OSTATNIEGO RAPORTU
+struct SpectatorStats {
+	unsigned long long frames; // opublikowane klatki (= liczba kodowan stanu)
+	unsigned long long keyframes;
+	unsigned long long packetsOut;
+	unsigned long long bytesOut;
+	unsigned long long sendFailures; // pakiety odrzucone przez gniazdo (widz czeka na klatke kluczowa)
+	unsigned long long joins;
+	unsigned long long resyncs; // przepelnione kolejki widzow
+	unsigned long long poolExhausted; // kroki bez klatki, bo zabraklo wolnych buforow
+};
+
+// ROZSYLANIE JEDNEGO MECZU DO WIDZOW - kazdy krok kodowany jest raz (roznica do poprzedniego
+// kroku, co spectatorKeyframeInterval krokow stan pelny), a nowy widz dostaje ostatnia klatke
+// kluczowa i wszystkie roznice po niej
+struct SpectatorHub {
+	PacketIo* io; // warstwa pakietow gniazda UDP, z ktorego wysylane sa klatki
+	unsigned int match; // numer meczu w naglowku klatek
+	unsigned int tickRate; // kroki na sekunde (przewidywanie pozycji w kodowaniu roznic)
+	unsigned int keyframeInterval;
+
+	SpectatorFrame* frames; // pula spectatorFramePool klatek
+	SpectatorFrame* freeFrames;
+	unsigned int framesInUse;
+
+	SpectatorFrame* chain[spectatorQueueSize]; // ostatnia klatka kluczowa i roznice po niej
+	unsigned int chainLength;
+
+	NetState previous; // stan z poprzedniej klatki (baza roznicy)
+	bool hasPrevious;
+
+	std::vector<Spectator> spectators;
+	std::unordered_map<unsigned long long, unsigned int> index; // (adres, port) -> indeks w spectators
+	SpectatorStats stats;
+};
+
+void initSpectatorHub(SpectatorHub& hub, PacketIo* io, unsigned int match, unsigned int tickRate, unsigned int keyframeInterval = spectatorKeyframeInterval);
+void freeSpectatorHub(SpectatorHub& hub);
+void publishState(SpectatorHub& hub, const NetState& state);
+void addSpectator(SpectatorHub& hub, unsigned int address, unsigned short port, double now);
+void removeSpectator(SpectatorHub& hub, unsigned int address, unsigned short port);
+void flushSpectators(SpectatorHub& hub);
+void dropSilentSpectators(SpectatorHub& hub, double now, double timeout);
+
+#endif /* __SPECTATOR_H__ */
@@ -0,0 +1,317 @@
+#include <cmath>
+
+#include "statecodec.h"
+#include "wire.h"
+
+// UKLAD ZAKODOWANEGO STANU (bity od najmlodszego):
+//   1 bit   baza: 0 - stan pelny, 1 - roznica wzgledem potwierdzonego stanu
+//   pelny:   32 bity krok, potem wszystkie pola w pelnej szerokosci
+//   roznica: 5 bitow wiek bazy w krokach, 8 mlodszych bitow kroku bazy, potem reszty pol:
+//            wartosc pola jest przewidywana z bazy (pozycje przesuniete o predkosc bazy * wiek),
+//            a zapisywana jest tylko reszta: 0 | 01+4 bity | 011+10 bitow | 111+pelne pole
+//            (reszty ze znakiem zapisywane zygzakiem: 0, -1, 1, -2, 2...)
+constexpr unsigned int ageBits = 5;
+constexpr unsigned int baselineTickBits = 8;
+
+static int clampToBits(long long value, unsigned int bits, bool isSigned)
+{
+	long long low = isSigned ? -(1ll << (bits - 1)) : 0;
+	long long high = isSigned ? (1ll << (bits - 1)) - 1 : (1ll << bits) - 1;
+
+	return (int)(value < low ? low : value > high ? high : value);
+}
+
+static int quantizePosition(float value)
+{
+	return clampToBits(llroundf((value + positionOffset) * positionScale), positionBits, false);
+}
+
+static int quantizeVelocity(float value)
+{
+	return clampToBits(llroundf(value * velocityScale), velocityBits, true);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja kwantujaca stan meczu do wyslania przez siec
+** world - stan meczu
+** tick - krok meczu zapisywany w stanie
+** state - wynik
+**------------------------------------------------------------------------------------------*/
+void quantizeState(const World& world, unsigned int tick, NetState& state)
+{
+	state.tick = tick;
+	state.ballX = quantizePosition(world.ball.x);
+	state.ballY = quantizePosition(world.ball.y);
+	state.ballVX = quantizeVelocity(world.ballVelocity.x);
+	state.ballVY = quantizeVelocity(world.ballVelocity.y);
+
+	for (int i = 0; i < 2; i++)
+	{
+		state.racketY[i] = quantizePosition(world.rackets[i].y);
+		state.racketDir[i] = world.racketsVelocity[i] > 0.0f ? 1 : world.racketsVelocity[i] < 0.0f ? -1 : 0;
+	}
+
+	state.scoreForLeft = clampToBits(world.scoreForLeft, scoreBits, false);
+	state.scoreForRight = clampToBits(world.scoreForRight, scoreBits, false);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja odtwarzajaca stan meczu ze stanu skwantowanego (liczba odbic i ziarno nie sa
+** przesylane, wiec zostaja bez zmian)
+**------------------------------------------------------------------------------------------*/
+void dequantizeState(const NetState& state, World& world)
+{
+	world.ball.x = (float)state.ballX / positionScale - positionOffset;
+	world.ball.y = (float)state.ballY / positionScale - positionOffset;
+	world.ballVelocity.x = (float)state.ballVX / velocityScale;
+	world.ballVelocity.y = (float)state.ballVY / velocityScale;
+
+	world.rackets[0] = { leftRacketX, (float)state.racketY[0] / positionScale - positionOffset };
+	world.rackets[1] = { rightRacketX, (float)state.racketY[1] / positionScale - positionOffset };
+	world.racketsVelocity[0] = state.racketDir[0] * racketsSpeed;
+	world.racketsVelocity[1] = state.racketDir[1] * racketsSpeed;
+
+	world.scoreForLeft = state.scoreForLeft;
+	world.scoreForRight = state.scoreForRight;
+	world.tick = state.tick;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja oprozniajaca historie stanow
+**------------------------------------------------------------------------------------------*/
+void clearNetStateHistory(NetStateHistory& history)
+{
+	for (unsigned int i = 0; i < netStateHistory; i++)
+	{
+		history.states[i].tick = noNetState;
+	}
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zapisujaca stan w historii (nadpisuje stan sprzed netStateHistory krokow)
+**------------------------------------------------------------------------------------------*/
+void storeNetState(NetStateHistory& history, const NetState& state)
+{
+	history.states[state.tick % netStateHistory] = state;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwracajaca stan z kroku tick albo nullptr, jesli nie ma go juz w historii
+**------------------------------------------------------------------------------------------*/
+const NetState* findNetState(const NetStateHistory& history, unsigned int tick)
+{
+	const NetState& state = history.states[tick % netStateHistory];
+
+	return state.tick == tick && tick != noNetState ? &state : nullptr;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja przewidujaca pozycje po age krokach ruchu z predkoscia velocity (w jednostkach
+** kwantyzacji, liczby calkowite - wynik identyczny u nadawcy i odbiorcy)
+**------------------------------------------------------------------------------------------*/
+static int predictPosition(int position, long long velocity, unsigned int age, unsigned int tickRate)
+{
+	long long distance = velocity * positionScale * age;
+	long long divisor = (long long)velocityScale * tickRate;
+	long long rounded = distance >= 0 ? (distance + divisor / 2) / divisor : -((-distance + divisor / 2) / divisor);
+
+	return (int)(position + rounded);
+}
+
+static void putField(BitWriter& writer, int value, int predicted, unsigned int bits)
+{
+	int residual = value - predicted;
+	unsigned int zigzag = residual >= 0 ? 2u * residual : 2u * (unsigned int)(-residual) - 1;
+
+	if (zigzag == 0)
+	{
+		putBits(writer, 0, 1);
+	}
+	else if (zigzag < 16)
+	{
+		putBits(writer, 1, 2); // bity 1, 0
+		putBits(writer, zigzag, 4);
+	}
+	else if (zigzag < 1024)
+	{
+		putBits(writer, 3, 3); // bity 1, 1, 0
+		putBits(writer, zigzag, 10);
+	}
+	else
+	{
+		putBits(writer, 7, 3);
+		putBits(writer, (unsigned int)value, bits);
+	}
+}
+
+static int signExtend(unsigned int value, unsigned int bits)
+{
+	unsigned int sign = 1u << (bits - 1);
+	return (int)((value ^ sign) - sign);
+}
+
+static int getField(BitReader& reader, int predicted, unsigned int bits, bool isSigned)
+{
+	if (getBits(reader, 1) == 0)
+		return predicted;
+
+	unsigned int zigzag;
+	if (getBits(reader, 1) == 0)
+	{
+		zigzag = getBits(reader, 4);
+	}
+	else if (getBits(reader, 1) == 0)
+	{
+		zigzag = getBits(reader, 10);
+	}
+	else
+	{
+		unsigned int value = getBits(reader, bits);
+		return isSigned ? signExtend(value, bits) : (int)value;
+	}
+
+	int residual = (zigzag & 1) ? -(int)((zigzag + 1) / 2) : (int)(zigzag / 2);
+	return predicted + residual;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja kodujaca stan meczu
+** state - stan do wyslania
+** baseline - stan potwierdzony przez odbiorce (nullptr lub zbyt stary - stan pelny)
+** tickRate - kroki na sekunde (do przewidywania pozycji, odbiorca musi podac to samo)
+** out, capacity - bufor wyniku (maxEncodedState bajtow wystarcza zawsze)
+** funkcja zwraca liczbe bajtow albo 0, jesli bufor jest za maly
+**------------------------------------------------------------------------------------------*/
+unsigned int encodeState(const NetState& state, const NetState* baseline, unsigned int tickRate, unsigned char* out, unsigned int capacity)
+{
+	BitWriter writer;
+	initBitWriter(writer, out, capacity);
+
+	if (baseline && (baseline->tick >= state.tick || state.tick - baseline->tick >= netStateHistory))
+		baseline = nullptr;
+
+	if (!baseline)
+	{
+		putBits(writer, 0, 1);
+		putBits(writer, state.tick, 32);
+		putBits(writer, (unsigned int)state.ballX, positionBits);
+		putBits(writer, (unsigned int)state.ballY, positionBits);
+		putBits(writer, (unsigned int)state.ballVX, velocityBits);
+		putBits(writer, (unsigned int)state.ballVY, velocityBits);
+		for (int i = 0; i < 2; i++)
+		{
+			putBits(writer, (unsigned int)state.racketY[i], positionBits);
+			putBits(writer, (unsigned int)(state.racketDir[i] + 1), 2);
+		}
+		putBits(writer, state.scoreForLeft, scoreBits);
+		putBits(writer, state.scoreForRight, scoreBits);
+
+		return flushBits(writer);
+	}
+
+	unsigned int age = state.tick - baseline->tick;
+	putBits(writer, 1, 1);
+	putBits(writer, age, ageBits);
+	putBits(writer, baseline->tick, baselineTickBits);
+
+	putField(writer, state.ballVX, baseline->ballVX, velocityBits);
+	putField(writer, state.ballVY, baseline->ballVY, velocityBits);
+	putField(writer, state.ballX, predictPosition(baseline->ballX, baseline->ballVX, age, tickRate), positionBits);
+	putField(writer, state.ballY, predictPosition(baseline->ballY, baseline->ballVY, age, tickRate), positionBits);
+
+	for (int i = 0; i < 2; i++)
+	{
+		if (state.racketDir[i] == baseline->racketDir[i])
+		{
+			putBits(writer, 0, 1);
+		}
+		else
+		{
+			putBits(writer, 1, 1);
+			putBits(writer, (unsigned int)(state.racketDir[i] + 1), 2);
+		}
+
+		long long velocity = (long long)baseline->racketDir[i] * (long long)(racketsSpeed * velocityScale);
+		putField(writer, state.racketY[i], predictPosition(baseline->racketY[i], velocity, age, tickRate), positionBits);
+	}
+
+	if (state.scoreForLeft == baseline->scoreForLeft && state.scoreForRight == baseline->scoreForRight)
+	{
+		putBits(writer, 0, 1);
+	}
+	else
+	{
+		putBits(writer, 1, 1);
+		putBits(writer, state.scoreForLeft, scoreBits);
+		putBits(writer, state.scoreForRight, scoreBits);
+	}
+
+	return flushBits(writer);
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja dekodujaca stan meczu
+** data, size - zakodowany stan
+** history - stany odebrane wczesniej (baza roznicy musi w niej byc)
+** tickRate - kroki na sekunde (to samo co u nadawcy)
+** state - wynik
+** funkcja zwraca false, jesli dane sa uszkodzone albo bazy nie ma juz w historii
+**------------------------------------------------------------------------------------------*/
+bool decodeState(const unsigned char* data, unsigned int size, const NetStateHistory& history, unsigned int tickRate, NetState& state)
+{
+	BitReader reader;
+	initBitReader(reader, data, size);
+
+	if (getBits(reader, 1) == 0)
+	{
+		state.tick = getBits(reader, 32);
+		state.ballX = (int)getBits(reader, positionBits);
+		state.ballY = (int)getBits(reader, positionBits);
+		state.ballVX = signExtend(getBits(reader, velocityBits), velocityBits);
+		state.ballVY = signExtend(getBits(reader, velocityBits), velocityBits);
+		for (int i = 0; i < 2; i++)
+		{
+			state.racketY[i] = (int)getBits(reader, positionBits);
+			state.racketDir[i] = (int)getBits(reader, 2) - 1;
+		}
+		state.scoreForLeft = getBits(reader, scoreBits);
+		state.scoreForRight = getBits(reader, scoreBits);
+
+		return !reader.overrun;
+	}
+
+	unsigned int age = getBits(reader, ageBits);
+	unsigned int baselineTick = getBits(reader, baselineTickBits);
+
+	// historia obejmuje mniej krokow niz 2^baselineTickBits, wiec mlodsze bity wskazuja jedno miejsce
+	const NetState& baseline = history.states[baselineTick % netStateHistory];
+	if (reader.overrun || age == 0 || baseline.tick == noNetState || (baseline.tick & ((1u << baselineTickBits) - 1)) != baselineTick)
+		return false;
+
+	state.tick = baseline.tick + age;
+	state.ballVX = getField(reader, baseline.ballVX, velocityBits, true);
+	state.ballVY = getField(reader, baseline.ballVY, velocityBits, true);
+	state.ballX = getField(reader, predictPosition(baseline.ballX, baseline.ballVX, age, tickRate), positionBits, false);
+	state.ballY = getField(reader, predictPosition(baseline.ballY, baseline.ballVY, age, tickRate), positionBits, false);
+
+	for (int i = 0; i < 2; i++)
+	{
+		state.racketDir[i] = getBits(reader, 1) ? (int)getBits(reader, 2) - 1 : baseline.racketDir[i];
+
+		long long velocity = (long long)baseline.racketDir[i] * (long long)(racketsSpeed * velocityScale);
+		state.racketY[i] = getField(reader, predictPosition(baseline.racketY[i], velocity, age, tickRate), positionBits, false);
+	}
+
+	if (getBits(reader, 1))
+	{
+		state.scoreForLeft = getBits(reader, scoreBits);
+		state.scoreForRight = getBits(reader, scoreBits);
+	}
+	else
+	{
+		state.scoreForLeft = baseline.scoreForLeft;
+		state.scoreForRight = baseline.scoreForRight;
+	}
+
+	return !reader.overrun;
+}
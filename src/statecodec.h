@@ -0,0 +1,47 @@
+#ifndef __STATECODEC_H__
+#define __STATECODEC_H__
+
+#include "sim.h"
+
+// KWANTYZACJA STANU MECZU DO WYSYLANIA PRZEZ SIEC
+// pozycje co 1/8 piksela z przesunieciem o 16 pikseli (13 bitow obejmuje -16..1008),
+// predkosci pileczki co 1/8 piksela na sekunde (20 bitow ze znakiem),
+// predkosc rakietki to tylko kierunek (racketsSpeed w gore, w dol albo stop)
+constexpr int positionScale = 8;
+constexpr int positionOffset = 16;
+constexpr unsigned int positionBits = 13;
+constexpr int velocityScale = 8;
+constexpr unsigned int velocityBits = 20;
+constexpr unsigned int scoreBits = 16;
+
+constexpr unsigned int netStateHistory = 32; // ile ostatnich stanow pamieta nadawca i odbiorca (potega dwojki)
+constexpr unsigned int maxEncodedState = 32; // najwiekszy zakodowany stan w bajtach
+constexpr unsigned int noNetState = ~0u;
+
+// SKWANTOWANY STAN MECZU - te same liczby po obu stronach lacza
+struct NetState {
+	unsigned int tick; // krok meczu (noNetState - puste miejsce historii)
+	int ballX; // pozycja pileczki w 1/8 piksela (z przesunieciem)
+	int ballY;
+	int ballVX; // predkosc pileczki w 1/8 piksela na sekunde
+	int ballVY;
+	int racketY[2]; // pozycje rakietek w 1/8 piksela (z przesunieciem)
+	int racketDir[2]; // kierunek ruchu rakietek: 1 - w gore, -1 - w dol, 0 - stop
+	unsigned int scoreForLeft;
+	unsigned int scoreForRight;
+};
+
+// OSTATNIE STANY MECZU (miejsce = tick % netStateHistory) - baza dla kodowania roznicowego
+struct NetStateHistory {
+	NetState states[netStateHistory];
+};
+
+void quantizeState(const World& world, unsigned int tick, NetState& state);
+void dequantizeState(const NetState& state, World& world);
+void clearNetStateHistory(NetStateHistory& history);
+void storeNetState(NetStateHistory& history, const NetState& state);
+const NetState* findNetState(const NetStateHistory& history, unsigned int tick);
+unsigned int encodeState(const NetState& state, const NetState* baseline, unsigned int tickRate, unsigned char* out, unsigned int capacity);
+bool decodeState(const unsigned char* data, unsigned int size, const NetStateHistory& history, unsigned int tickRate, NetState& state);
+
+#endif /* __STATECODEC_H__ */
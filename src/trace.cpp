@@ -0,0 +1,133 @@
+#ifdef PONG_TRACE
+
+#include <cstdio>
+
+#include "trace.h"
+
+std::atomic<bool> traceActive(false);
+unsigned long long traceOrigin = 0;
+
+static std::atomic<TraceBuffer*> traceBuffers(nullptr); // bufory wszystkich watkow
+static std::atomic<unsigned int> traceThreads(0);
+static std::atomic<unsigned int> traceGeneration(0); // zmieniane przez startTrace() i stopTrace()
+static unsigned int traceCapacity = 0;
+
+static thread_local TraceBuffer* threadBuffer = nullptr;
+static thread_local unsigned int threadGeneration = 0;
+
+/*------------------------------------------------------------------------------------------
+** funkcja zwracajaca bufor biezacego watku - przy pierwszej strefie watku bufor jest
+** przydzielany i dopisywany do listy bez blokad
+**------------------------------------------------------------------------------------------*/
+TraceBuffer* traceThreadBuffer()
+{
+	unsigned int generation = traceGeneration.load(std::memory_order_acquire);
+	if (threadBuffer && threadGeneration == generation)
+		return threadBuffer;
+
+	TraceBuffer* buffer = new TraceBuffer;
+	buffer->events = new TraceEvent[traceCapacity];
+	buffer->capacity = traceCapacity;
+	buffer->count.store(0, std::memory_order_relaxed);
+	buffer->dropped = 0;
+	buffer->thread = traceThreads.fetch_add(1, std::memory_order_relaxed) + 1;
+	buffer->threadName = nullptr;
+
+	buffer->next = traceBuffers.load(std::memory_order_relaxed);
+	while (!traceBuffers.compare_exchange_weak(buffer->next, buffer, std::memory_order_release, std::memory_order_relaxed))
+	{
+	}
+
+	threadBuffer = buffer;
+	threadGeneration = generation;
+
+	return buffer;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja nadajaca nazwe biezacemu watkowi w pliku sladu (name - napis staly)
+**------------------------------------------------------------------------------------------*/
+void traceThreadName(const char* name)
+{
+	if (traceActive.load(std::memory_order_relaxed))
+	{
+		traceThreadBuffer()->threadName = name;
+	}
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja wlaczajaca sledzenie
+** eventsPerThread - pojemnosc bufora kazdego watku (po zapelnieniu strefy sa pomijane)
+** funkcja zwraca false jesli sledzenie juz trwa
+**------------------------------------------------------------------------------------------*/
+bool startTrace(unsigned int eventsPerThread)
+{
+	if (traceActive.load(std::memory_order_relaxed))
+		return false;
+
+	traceCapacity = eventsPerThread ? eventsPerThread : 1;
+	traceOrigin = timingNow();
+	traceGeneration.fetch_add(1, std::memory_order_release);
+	traceActive.store(true, std::memory_order_release);
+
+	return true;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja zapisujaca zebrane strefy w formacie Chrome trace-event (JSON)
+** path - plik wynikowy
+**------------------------------------------------------------------------------------------*/
+bool writeTrace(const char* path)
+{
+	FILE* file = fopen(path, "w");
+	if (!file)
+		return false;
+
+	fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+	fprintf(file, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 0, \"args\": {\"name\": \"pong\"}}");
+
+	unsigned long long dropped = 0;
+	for (TraceBuffer* buffer = traceBuffers.load(std::memory_order_acquire); buffer; buffer = buffer->next)
+	{
+		if (buffer->threadName)
+		{
+			fprintf(file, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"%s\"}}",
+				buffer->thread, buffer->threadName);
+		}
+
+		unsigned int count = buffer->count.load(std::memory_order_acquire);
+		for (unsigned int i = 0; i < count; i++)
+		{
+			const TraceEvent& event = buffer->events[i];
+			fprintf(file, ",\n{\"name\": \"%s\", \"cat\": \"pong\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f}",
+				event.name, buffer->thread, event.start / 1e3, event.duration / 1e3);
+		}
+		dropped += buffer->dropped;
+	}
+
+	fprintf(file, "\n], \"otherData\": {\"dropped_events\": %llu}}\n", dropped);
+
+	return fclose(file) == 0;
+}
+
+/*------------------------------------------------------------------------------------------
+** funkcja wylaczajaca sledzenie i zwalniajaca bufory (zaden watek nie moze byc juz
+** wewnatrz strefy)
+**------------------------------------------------------------------------------------------*/
+void stopTrace()
+{
+	traceActive.store(false, std::memory_order_release);
+	traceGeneration.fetch_add(1, std::memory_order_release);
+
+	TraceBuffer* buffer = traceBuffers.exchange(nullptr, std::memory_order_acq_rel);
+	while (buffer)
+	{
+		TraceBuffer* next = buffer->next;
+		delete[] buffer->events;
+		delete buffer;
+		buffer = next;
+	}
+	traceThreads.store(0, std::memory_order_relaxed);
+}
+
+#endif /* PONG_TRACE */
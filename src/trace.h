@@ -0,0 +1,100 @@
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+// SLEDZENIE STREF CZASOWYCH (format Chrome trace-event - chrome://tracing, ui.perfetto.dev)
+// Strefy sa kompilowane tylko z PONG_TRACE (opcja CMake PONG_TRACE lub /D PONG_TRACE w projekcie);
+// bez tej definicji TRACE_ZONE i TRACE_THREAD nie generuja zadnego kodu.
+
+#ifdef PONG_TRACE
+
+#include <atomic>
+
+#include "frametiming.h"
+
+// JEDNA ZMIERZONA STREFA (czasy w nanosekundach od startTrace())
+struct TraceEvent {
+	const char* name; // napis staly (literal) - zapisywany dopiero w writeTrace()
+	unsigned long long start;
+	unsigned long long duration;
+};
+
+// BUFOR ZDARZEN JEDNEGO WATKU - pisze tylko jego watek, wiec zapis nie potrzebuje blokad;
+// writeTrace() czyta tylko zdarzenia ponizej count (zapis z memory_order_release)
+struct TraceBuffer {
+	TraceEvent* events;
+	unsigned int capacity;
+	std::atomic<unsigned int> count;
+	unsigned long long dropped; // zdarzenia pominiete po zapelnieniu bufora
+	unsigned int thread; // numer watku w pliku (tid)
+	const char* threadName;
+	TraceBuffer* next; // lista wszystkich buforow (dopisywanie przez compare_exchange)
+};
+
+extern std::atomic<bool> traceActive;
+extern unsigned long long traceOrigin;
+
+TraceBuffer* traceThreadBuffer();
+void traceThreadName(const char* name);
+
+/*------------------------------------------------------------------------------------------
+** funkcja dopisujaca strefe do bufora biezacego watku
+**------------------------------------------------------------------------------------------*/
+inline void traceRecord(const char* name, unsigned long long start, unsigned long long end)
+{
+	TraceBuffer* buffer = traceThreadBuffer();
+	unsigned int count = buffer->count.load(std::memory_order_relaxed);
+	if (count >= buffer->capacity)
+	{
+		buffer->dropped++;
+		return;
+	}
+
+	buffer->events[count].name = name;
+	buffer->events[count].start = start - traceOrigin;
+	buffer->events[count].duration = end - start;
+	buffer->count.store(count + 1, std::memory_order_release);
+}
+
+// STREFA OD KONSTRUKTORA DO KONCA ZASIEGU
+struct TraceZone {
+	const char* name;
+	unsigned long long start;
+
+	explicit TraceZone(const char* zoneName) : name(zoneName), start(0)
+	{
+		if (traceActive.load(std::memory_order_relaxed))
+		{
+			start = timingNow();
+		}
+	}
+
+	~TraceZone()
+	{
+		if (start && traceActive.load(std::memory_order_relaxed))
+		{
+			traceRecord(name, start, timingNow());
+		}
+	}
+};
+
+bool startTrace(unsigned int eventsPerThread);
+bool writeTrace(const char* path);
+void stopTrace();
+
+#define TRACE_JOIN2(a, b) a##b
+#define TRACE_JOIN(a, b) TRACE_JOIN2(a, b)
+#define TRACE_ZONE(name) TraceZone TRACE_JOIN(traceZone, __LINE__)(name)
+#define TRACE_THREAD(name) traceThreadName(name)
+
+#else
+
+inline bool startTrace(unsigned int) { return false; }
+inline bool writeTrace(const char*) { return false; }
+inline void stopTrace() {}
+
+#define TRACE_ZONE(name) ((void)0)
+#define TRACE_THREAD(name) ((void)0)
+
+#endif /* PONG_TRACE */
+
+#endif /* __TRACE_H__ */
@@ -0,0 +1,145 @@
+#ifndef __WIRE_H__
+#define __WIRE_H__
+
+#include <cstring>
+
+// ZAPIS I ODCZYT LICZB W PAKIETACH SIECIOWYCH (little-endian niezaleznie od procesora)
+
+inline void putU16(unsigned char* p, unsigned int value)
+{
+	p[0] = (unsigned char)value;
+	p[1] = (unsigned char)(value >> 8);
+}
+
+inline void putU32(unsigned char* p, unsigned int value)
+{
+	for (int b = 0; b < 4; b++)
+		p[b] = (unsigned char)(value >> (8 * b));
+}
+
+inline void putU64(unsigned char* p, unsigned long long value)
+{
+	for (int b = 0; b < 8; b++)
+		p[b] = (unsigned char)(value >> (8 * b));
+}
+
+inline void putF32(unsigned char* p, float value)
+{
+	unsigned int bits;
+	memcpy(&bits, &value, sizeof(bits));
+	putU32(p, bits);
+}
+
+inline unsigned int getU16(const unsigned char* p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+inline unsigned int getU32(const unsigned char* p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+inline unsigned long long getU64(const unsigned char* p)
+{
+	return getU32(p) | ((unsigned long long)getU32(p + 4) << 32);
+}
+
+inline float getF32(const unsigned char* p)
+{
+	unsigned int bits = getU32(p);
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+// ZAPIS BITOWY - kolejne pola dopisywane od najmlodszego bitu, bez wyrownania do bajtow
+struct BitWriter {
+	unsigned char* data;
+	unsigned int capacity; // rozmiar bufora w bajtach
+	unsigned int size; // zapisane pelne bajty
+	unsigned long long pending; // bity czekajace na zapis
+	unsigned int pendingBits;
+	bool overflow; // zabraklo miejsca w buforze
+};
+
+inline void initBitWriter(BitWriter& writer, unsigned char* data, unsigned int capacity)
+{
+	writer.data = data;
+	writer.capacity = capacity;
+	writer.size = 0;
+	writer.pending = 0;
+	writer.pendingBits = 0;
+	writer.overflow = false;
+}
+
+// bits <= 32
+inline void putBits(BitWriter& writer, unsigned int value, unsigned int bits)
+{
+	if (bits < 32)
+		value &= (1u << bits) - 1;
+	writer.pending |= (unsigned long long)value << writer.pendingBits;
+	writer.pendingBits += bits;
+
+	while (writer.pendingBits >= 8)
+	{
+		if (writer.size < writer.capacity)
+			writer.data[writer.size++] = (unsigned char)writer.pending;
+		else
+			writer.overflow = true;
+		writer.pending >>= 8;
+		writer.pendingBits -= 8;
+	}
+}
+
+// dopisuje niepelny ostatni bajt; zwraca liczbe bajtow (0 - przepelnienie)
+inline unsigned int flushBits(BitWriter& writer)
+{
+	if (writer.pendingBits > 0)
+		putBits(writer, 0, 8 - writer.pendingBits);
+
+	return writer.overflow ? 0 : writer.size;
+}
+
+// ODCZYT BITOWY - odwrotnosc BitWriter
+struct BitReader {
+	const unsigned char* data;
+	unsigned int size;
+	unsigned int position; // nastepny bajt do wczytania
+	unsigned long long pending;
+	unsigned int pendingBits;
+	bool overrun; // odczyt za koncem danych
+};
+
+inline void initBitReader(BitReader& reader, const unsigned char* data, unsigned int size)
+{
+	reader.data = data;
+	reader.size = size;
+	reader.position = 0;
+	reader.pending = 0;
+	reader.pendingBits = 0;
+	reader.overrun = false;
+}
+
+// bits <= 32
+inline unsigned int getBits(BitReader& reader, unsigned int bits)
+{
+	while (reader.pendingBits < bits)
+	{
+		unsigned long long byte = 0;
+		if (reader.position < reader.size)
+			byte = reader.data[reader.position++];
+		else
+			reader.overrun = true;
+		reader.pending |= byte << reader.pendingBits;
+		reader.pendingBits += 8;
+	}
+
+	unsigned int value = (unsigned int)(reader.pending & ((1ull << bits) - 1));
+	reader.pending >>= bits;
+	reader.pendingBits -= bits;
+
+	return value;
+}
+
+#endif /* __WIRE_H__ */